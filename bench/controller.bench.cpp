@@ -0,0 +1,174 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "controller.h"
+#include "event.h"
+#include "event_sink.h"
+#include "parallel_controller.h"
+#include "scenario.h"
+#include "timing.h"
+
+namespace {
+// Completed events: each mine, each trip's two travels and unload, and
+// each wait in a station queue
+int64_t CountEvents(const std::vector<TruckMetrics>& trucks) {
+  int64_t events = 0;
+  for (const auto& t : trucks) {
+    events += static_cast<int64_t>(t.mines_completed + 3 * t.trips_completed +
+                                   t.queues_completed);
+  }
+  return events;
+}
+
+int64_t CountEvents(const MetricsStore& metrics) {
+  const auto& trucks = metrics.trucks();
+  return SumColumn(trucks.mines_completed) +
+         3 * SumColumn(trucks.trips_completed) +
+         SumColumn(trucks.queues_completed);
+}
+
+// num_trucks and num_stations in one class and group of the default timing,
+// or split in two of different timing if mixed
+Scenario BenchScenario(size_t num_trucks, size_t num_stations, bool mixed) {
+  Scenario scenario;
+  if (!mixed) {
+    scenario.truck_classes = {{"default", num_trucks}};
+    scenario.station_groups = {{num_stations}};
+    return scenario;
+  }
+  scenario.truck_classes = {{"near", num_trucks / 2},
+                            {"far", num_trucks - num_trucks / 2, 40min}};
+  scenario.station_groups = {{num_stations / 2},
+                             {num_stations - num_stations / 2, 6min}};
+  return scenario;
+}
+}  // namespace
+
+// One 24h run with metrics only: the simulation loop itself
+static void BM_ControllerSimulate(benchmark::State& state) {
+  const auto num_trucks = static_cast<size_t>(state.range(0));
+  const size_t num_stations =
+      std::max<size_t>(1, num_trucks / static_cast<size_t>(state.range(1)));
+  int64_t events = 0;
+  for (auto _ : state) {
+    BasicController<NullEventSink> controller(num_trucks, num_stations);
+    controller.Simulate(24 * 60min);
+    events += CountEvents(controller.truck_metrics());
+  }
+  state.SetItemsProcessed(events);
+}
+BENCHMARK(BM_ControllerSimulate)
+    ->ArgsProduct({{10, 1000, 100000, 1000000}, {5, 20, 100}})
+    ->ArgNames({"trucks", "trucks_per_station"})
+    ->Unit(benchmark::kMillisecond);
+
+// The same run with every event going through an EventLogger, as
+// Controller::Run does (the metrics report export is left out)
+static void BM_ControllerSimulateLogged(benchmark::State& state) {
+  const auto num_trucks = static_cast<size_t>(state.range(0));
+  const size_t num_stations =
+      std::max<size_t>(1, num_trucks / static_cast<size_t>(state.range(1)));
+  const LogFormat format = static_cast<LogFormat>(state.range(2));
+  EventLogger logger("bench.events", format);
+  int64_t events = 0;
+  for (auto _ : state) {
+    BasicController<FileEventSink> controller(num_trucks, num_stations, 0xBEEF,
+                                              FileEventSink(&logger));
+    controller.Simulate(24 * 60min);
+    logger.WaitUntilFlushed();
+    events += CountEvents(controller.truck_metrics());
+
+    state.PauseTiming();
+    logger.ClearEvents();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(events);
+}
+BENCHMARK(BM_ControllerSimulateLogged)
+    ->ArgsProduct({{10, 1000, 100000},
+                   {20},
+                   {static_cast<int64_t>(LogFormat::JsonLines),
+                    static_cast<int64_t>(LogFormat::Binary)}})
+    ->ArgNames({"trucks", "trucks_per_station", "binary"})
+    ->Unit(benchmark::kMillisecond);
+
+// A 72h run on the parallel engine as the number of threads grows; compare
+// with threads=1 for scaling and with BM_ControllerSimulate for overhead
+static void BM_ParallelControllerSimulate(benchmark::State& state) {
+  const auto num_trucks = static_cast<size_t>(state.range(0));
+  const size_t num_stations = std::max<size_t>(1, num_trucks / 20);
+  ParallelController controller(num_trucks, num_stations, 0xBEEF,
+                                static_cast<size_t>(state.range(1)));
+  int64_t events = 0;
+  for (auto _ : state) {
+    controller.Simulate(72 * 60min);
+    events += CountEvents(controller.metrics());
+  }
+  state.SetItemsProcessed(events);
+}
+BENCHMARK(BM_ParallelControllerSimulate)
+    ->ArgsProduct({{100000, 1000000}, {1, 2, 4, 8, 16}})
+    ->ArgNames({"trucks", "threads"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// The BM_ControllerSimulate run with each timing policy: 0 is the default
+// FixedTiming, 1 the same homogeneous fleet through ScenarioTiming's tables,
+// 2 a mixed fleet (half the trucks travel 40 minutes, half the stations
+// unload in 6). 0 must not be slower than BM_ControllerSimulate.
+static void BM_ControllerSimulateTiming(benchmark::State& state) {
+  const auto num_trucks = static_cast<size_t>(state.range(0));
+  const size_t num_stations = std::max<size_t>(1, num_trucks / 20);
+  const int64_t timing = state.range(1);
+  const ScenarioTiming tables(
+      BenchScenario(num_trucks, num_stations, timing == 2));
+  int64_t events = 0;
+  for (auto _ : state) {
+    if (timing == 0) {
+      BasicController<NullEventSink> controller(num_trucks, num_stations);
+      controller.Simulate(24 * 60min);
+      events += CountEvents(controller.metrics());
+    } else {
+      BasicController<NullEventSink, TimingWheelScheduler, ScenarioTiming>
+          controller(num_trucks, num_stations);
+      controller.SetTiming(tables);
+      controller.Simulate(24 * 60min);
+      events += CountEvents(controller.metrics());
+    }
+  }
+  state.SetItemsProcessed(events);
+}
+BENCHMARK(BM_ControllerSimulateTiming)
+    ->ArgsProduct({{1000, 100000, 1000000}, {0, 1, 2}})
+    ->ArgNames({"trucks", "timing"})
+    ->Unit(benchmark::kMillisecond);
+
+// A 72h run monitored for steady state: 0 is unmonitored, 1 monitored to the
+// end (the cost of the observations and stages), 2 stopped once the
+// estimates are within 5%. The simulated minutes are reported as a counter.
+static void BM_ControllerSimulateSteadyState(benchmark::State& state) {
+  const auto num_trucks = static_cast<size_t>(state.range(0));
+  const size_t num_stations = std::max<size_t>(1, num_trucks / 20);
+  const int64_t mode = state.range(1);
+  int64_t events = 0;
+  minutes_t simulated = 0min;
+  for (auto _ : state) {
+    BasicController<NullEventSink> controller(num_trucks, num_stations);
+    if (mode > 0) {
+      controller.SetSteadyState(
+          {.interval = 12min, .relative_precision = mode == 2 ? 0.05 : 0.0});
+    }
+    controller.Simulate(72 * 60min);
+    events += CountEvents(controller.metrics());
+    simulated = controller.sim_time();
+  }
+  state.SetItemsProcessed(events);
+  state.counters["sim_minutes"] = static_cast<double>(simulated.count());
+}
+BENCHMARK(BM_ControllerSimulateSteadyState)
+    ->ArgsProduct({{1000, 100000}, {0, 1, 2}})
+    ->ArgNames({"trucks", "mode"})
+    ->Unit(benchmark::kMillisecond);
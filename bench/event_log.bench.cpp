@@ -0,0 +1,216 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+
+#include "analyze.h"
+#include "event.h"
+#include "event_export.h"
+#include "event_index.h"
+#include "event_log.h"
+
+namespace {
+constexpr char kLogFile[] = "bench.events";
+
+// The i-th event of a synthetic log: 1000 trucks cycling through the five
+// event types at realistic durations
+Event SampleEvent(size_t i) {
+  const size_t truck_id = i % 1000;
+  const auto start = minutes_t(i / 1000 * 60);
+  switch (i / 1000 % 5) {
+    case 0:
+      return {EventType::Mine, truck_id, std::nullopt, start, start + 180min};
+    case 1:
+      return {EventType::TravelToStation, truck_id, std::nullopt, start,
+              start + 30min};
+    case 2:
+      return {EventType::Queue, truck_id, truck_id % 50, start, start + 10min};
+    case 3:
+      return {EventType::Unload, truck_id, truck_id % 50, start, start + 5min};
+    default:
+      return {EventType::TravelToMine, truck_id, std::nullopt, start,
+              start + 30min};
+  }
+}
+
+// Writes a log of num_events sample events in the given format, and its
+// sidecar index if indexed
+void WriteSampleLog(size_t num_events, LogFormat format,
+                    bool indexed = false) {
+  EventLogger logger(kLogFile, format);
+  logger.ClearEvents();
+  logger.SetIndexing(indexed);
+  logger.SetRunParameters({1000, 50, minutes_t(num_events / 1000 * 60), 0});
+  for (size_t i = 0; i < num_events; ++i) logger.LogEvent(SampleEvent(i));
+  logger.WaitUntilFlushed();
+}
+
+constexpr int64_t kFormats[] = {static_cast<int64_t>(LogFormat::JsonLines),
+                                static_cast<int64_t>(LogFormat::Binary)};
+}  // namespace
+
+// End-to-end logging throughput: events handed to LogEvent in batches, each
+// followed by FlushBuffer, until the writer thread has put them on disk
+// (and into the sidecar index if indexed)
+static void BM_EventLoggerLogAndFlush(benchmark::State& state) {
+  const auto format = static_cast<LogFormat>(state.range(0));
+  const auto batch = static_cast<size_t>(state.range(1));
+  EventLogger logger(kLogFile, format);
+  logger.ClearEvents();
+  logger.SetIndexing(state.range(2) != 0);
+
+  size_t next = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < batch; ++i) logger.LogEvent(SampleEvent(next++));
+    logger.FlushBuffer();
+    logger.WaitUntilFlushed();
+
+    state.PauseTiming();
+    logger.ClearEvents();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_EventLoggerLogAndFlush)
+    ->ArgsProduct(
+        {{kFormats[0], kFormats[1]}, {1 << 10, 1 << 16, 1 << 20}, {0, 1}})
+    ->ArgNames({"binary", "batch", "indexed"})
+    ->Unit(benchmark::kMillisecond);
+
+// Logging throughput of compressed JSON Lines by level (0: uncompressed),
+// with the resulting log size per event
+static void BM_EventLoggerCompressed(benchmark::State& state) {
+  const auto level = static_cast<int>(state.range(0));
+  constexpr size_t kBatch = 1 << 16;
+  EventLogger logger(kLogFile);
+  logger.Reopen(kLogFile, LogFormat::JsonLines, false, level);
+
+  size_t next = 0;
+  uint64_t bytes = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < kBatch; ++i) logger.LogEvent(SampleEvent(next++));
+    logger.FlushBuffer();
+    logger.WaitUntilFlushed();
+
+    state.PauseTiming();
+    bytes += std::filesystem::file_size(kLogFile);
+    logger.ClearEvents();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+  state.counters["bytes_per_event"] =
+      static_cast<double>(bytes) / static_cast<double>(next);
+}
+BENCHMARK(BM_EventLoggerCompressed)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(6)
+    ->Arg(9)
+    ->ArgNames({"level"})
+    ->Unit(benchmark::kMillisecond);
+
+// Sequential read-back rate of ReadNextEvent
+static void BM_EventLoggerReadNextEvent(benchmark::State& state) {
+  const auto format = static_cast<LogFormat>(state.range(0));
+  const auto num_events = static_cast<size_t>(state.range(1));
+  WriteSampleLog(num_events, format);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    EventLogger logger(kLogFile, format);  // Fresh read position
+    state.ResumeTiming();
+
+    Event event;
+    size_t read = 0;
+    while (logger.ReadNextEvent(&event)) ++read;
+    if (read != num_events) state.SkipWithError("Short read");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<int64_t>(std::filesystem::file_size(kLogFile)));
+}
+BENCHMARK(BM_EventLoggerReadNextEvent)
+    ->ArgsProduct({{kFormats[0], kFormats[1]}, {1 << 16, 1 << 20}})
+    ->ArgNames({"binary", "events"})
+    ->Unit(benchmark::kMillisecond);
+
+// The native analyzer over the same logs, for comparison with the
+// sequential reader
+static void BM_AnalyzeEventLog(benchmark::State& state) {
+  const auto format = static_cast<LogFormat>(state.range(0));
+  const auto num_events = static_cast<size_t>(state.range(1));
+  WriteSampleLog(num_events, format);
+
+  for (auto _ : state) {
+    const EventLogSummary summary = AnalyzeEventLog(kLogFile);
+    if (summary.num_events != num_events) state.SkipWithError("Short read");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<int64_t>(std::filesystem::file_size(kLogFile)));
+}
+BENCHMARK(BM_AnalyzeEventLog)
+    ->ArgsProduct({{kFormats[0], kFormats[1]}, {1 << 16, 1 << 20}})
+    ->ArgNames({"binary", "events"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Exporting the same logs as a JSON array, CSV or an Arrow file
+static void BM_ExportEventLog(benchmark::State& state) {
+  const auto format = static_cast<LogFormat>(state.range(0));
+  const auto num_events = static_cast<size_t>(state.range(1));
+  WriteSampleLog(num_events, format);
+  EventExportOptions options;
+  options.format = static_cast<EventExportFormat>(state.range(2));
+  options.path = "bench.export";
+
+  for (auto _ : state) {
+    const EventExportResult result = ExportEventLog(kLogFile, options);
+    if (result.num_events != num_events) state.SkipWithError("Short read");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<int64_t>(std::filesystem::file_size(options.path)));
+  std::filesystem::remove(options.path);
+}
+BENCHMARK(BM_ExportEventLog)
+    ->ArgsProduct({{kFormats[0], kFormats[1]},
+                   {1 << 16, 1 << 20},
+                   {static_cast<int64_t>(EventExportFormat::Json),
+                    static_cast<int64_t>(EventExportFormat::Csv),
+                    static_cast<int64_t>(EventExportFormat::Arrow)}})
+    ->ArgNames({"binary", "events", "format"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// "Queue events at station 7 over 1000 minutes" through the sidecar index,
+// which reads only the blocks that can hold them; compare with
+// BM_EventLoggerReadNextEvent, which has to read the whole log
+static void BM_EventIndexQuery(benchmark::State& state) {
+  const auto format = static_cast<LogFormat>(state.range(0));
+  const auto num_events = static_cast<size_t>(state.range(1));
+  WriteSampleLog(num_events, format, /*indexed=*/true);
+  const minutes_t middle(num_events / 2000 * 60);
+  const EventQuery query{.type = EventType::Queue,
+                         .station_id = 7,
+                         .from = middle,
+                         .to = middle + 1000min};
+
+  size_t matches = 0;
+  for (auto _ : state) {
+    const EventIndex index(kLogFile);
+    matches = index.Query(query).size();
+    benchmark::DoNotOptimize(matches);
+  }
+  state.counters["matches"] = static_cast<double>(matches);
+  state.counters["blocks_read"] = static_cast<double>(
+      EventIndex(kLogFile).MatchingBlocks(query).size());
+  std::filesystem::remove(EventIndexPath(kLogFile));
+}
+BENCHMARK(BM_EventIndexQuery)
+    ->ArgsProduct({{kFormats[0], kFormats[1]}, {1 << 16, 1 << 20}})
+    ->ArgNames({"binary", "events"})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include "metrics_export.h"
+#include "metrics_store.h"
+#include "report.h"
+
+namespace {
+// Metrics of a 3-day run at 20 trucks per station; the analytic estimate
+// fills them in without simulating the fleet
+void SampleMetrics(size_t num_trucks, std::vector<TruckMetrics>* trucks,
+                   std::vector<StationMetrics>* stations) {
+  EstimateMetrics(num_trucks, std::max<size_t>(1, num_trucks / 20), 4320min,
+                  trucks, stations);
+}
+}  // namespace
+
+static void BM_GenerateMetrics(benchmark::State& state) {
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+  SampleMetrics(static_cast<size_t>(state.range(0)), &trucks, &stations);
+  for (auto _ : state) {
+    GenerateMetrics(4320min, &trucks, &stations);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GenerateMetrics)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// Writes metrics.<params>.json into the working directory
+static void BM_ExportMetricsToJson(benchmark::State& state) {
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+  SampleMetrics(static_cast<size_t>(state.range(0)), &trucks, &stations);
+  for (auto _ : state) {
+    ExportMetricsToJson(4320min, trucks, stations);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ExportMetricsToJson)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
+// The report alone in each format, from the columns a run ends with
+static void BM_WriteMetricsReport(benchmark::State& state) {
+  const auto format = static_cast<MetricsFormat>(state.range(0));
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+  SampleMetrics(static_cast<size_t>(state.range(1)), &trucks, &stations);
+  const MetricsStore metrics = MetricsStore::FromMetrics(trucks, stations);
+  const MetricsExportOptions options{format, "bench.metrics"};
+  for (auto _ : state) WriteMetricsReport(4320min, metrics, options);
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<int64_t>(std::filesystem::file_size(options.path)));
+}
+BENCHMARK(BM_WriteMetricsReport)
+    ->ArgsProduct({{static_cast<int64_t>(MetricsFormat::Json),
+                    static_cast<int64_t>(MetricsFormat::CompactJson),
+                    static_cast<int64_t>(MetricsFormat::Csv),
+                    static_cast<int64_t>(MetricsFormat::Columnar)},
+                   {1000, 1000000}})
+    ->ArgNames({"format", "trucks"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "controller.h"
+#include "scheduler.h"
+
+// Hold model: keep N events pending and, for every pop, push a new event a
+// random 1-300 minutes ahead (the simulator's typical lookahead). This is
+// the scheduler's steady state with N trucks.
+template <EventScheduler Scheduler>
+static void BM_SchedulerHold(benchmark::State& state) {
+  const auto pending = static_cast<size_t>(state.range(0));
+  Scheduler scheduler(Controller::kMaxDuration);
+  std::mt19937 rng(0xBEEF);
+  std::uniform_int_distribution<int> delay(1, Controller::kMaxDuration.count());
+
+  for (size_t i = 0; i < pending; ++i) {
+    scheduler.Push({EventType::Mine, i, PackedEvent::kNoStation, 0min,
+                    minutes_t(delay(rng))});
+  }
+
+  for (auto _ : state) {
+    const auto event = scheduler.Pop();
+    const auto start = event.end_time();
+    scheduler.Push({event.type(), event.truck_id(), event.station_id(), start,
+                    start + minutes_t(delay(rng))});
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SchedulerHold<BinaryHeapScheduler>)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK(BM_SchedulerHold<TimingWheelScheduler>)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+
+// Full metrics-only simulation (24h) with a 20:1 truck to station ratio
+template <EventScheduler Scheduler>
+static void BM_ControllerRunByScheduler(benchmark::State& state) {
+  const auto num_trucks = static_cast<size_t>(state.range(0));
+  const size_t num_stations = std::max<size_t>(1, num_trucks / 20);
+  size_t events = 0;
+  for (auto _ : state) {
+    BasicController<NullEventSink, Scheduler> controller(num_trucks,
+                                                         num_stations);
+    controller.Simulate(24 * 60min);
+    for (const auto& t : controller.truck_metrics()) {
+      events += t.mines_completed + 2 * t.trips_completed;
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(events));
+}
+BENCHMARK(BM_ControllerRunByScheduler<BinaryHeapScheduler>)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ControllerRunByScheduler<TimingWheelScheduler>)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000)
+    ->Unit(benchmark::kMillisecond);
+
+// Repeated runs sharing one EventArena, so pending-event buckets are
+// recycled between runs instead of reallocated
+static void BM_ControllerRunReusingArena(benchmark::State& state) {
+  const auto num_trucks = static_cast<size_t>(state.range(0));
+  const size_t num_stations = std::max<size_t>(1, num_trucks / 20);
+  EventArena arena;
+  for (auto _ : state) {
+    BasicController<NullEventSink> controller(
+        num_trucks, num_stations, 0xBEEF, NullEventSink(), &arena);
+    controller.Simulate(24 * 60min);
+  }
+}
+BENCHMARK(BM_ControllerRunReusingArena)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000)
+    ->Unit(benchmark::kMillisecond);
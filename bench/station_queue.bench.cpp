@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include "controller.h"
+
+// Hold model: every station is booked back to back, so each pop of the next
+// available station is followed by marking it available one unload later
+static void BM_StationQueuePopPush(benchmark::State& state) {
+  const auto num_stations = static_cast<size_t>(state.range(0));
+  StationQueue queue;
+  queue.Initialize(num_stations);
+
+  for (auto _ : state) {
+    const auto [available, station_id] = queue.PopNextAvailable();
+    queue.MarkAvailable(available + Controller::kUnloadTime, station_id);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StationQueuePopPush)->RangeMultiplier(10)->Range(1, 100000);
+
+// Building the queue for a run
+static void BM_StationQueueInitialize(benchmark::State& state) {
+  const auto num_stations = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    StationQueue queue;
+    queue.Initialize(num_stations);
+    benchmark::DoNotOptimize(queue.Empty());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StationQueueInitialize)->RangeMultiplier(10)->Range(1, 100000);
+
+// The same hold model through each dispatcher's Assign, as the number of
+// stations grows. AffinityDispatch has a single mine, so every query spans
+// all stations.
+template <StationDispatcher Dispatch>
+static void BM_StationDispatch(benchmark::State& state) {
+  const auto num_stations = static_cast<size_t>(state.range(0));
+  Dispatch dispatcher;
+  dispatcher.Initialize(num_stations);
+
+  size_t truck_id = 0;
+  for (auto _ : state) {
+    const auto [available, station_id] = dispatcher.Assign(truck_id++, 0min);
+    dispatcher.MarkAvailable(available + Controller::kUnloadTime, station_id);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_StationDispatch, StationQueue)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_StationDispatch, StationHeap)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_StationDispatch, LeastLoadedDispatch)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_StationDispatch, RoundRobinDispatch)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_StationDispatch, AffinityDispatch)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+
+// Building each dispatcher for a run
+template <StationDispatcher Dispatch>
+static void BM_StationDispatchInitialize(benchmark::State& state) {
+  const auto num_stations = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    Dispatch dispatcher;
+    dispatcher.Initialize(num_stations);
+    benchmark::DoNotOptimize(dispatcher.Empty());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_StationDispatchInitialize, StationHeap)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_StationDispatchInitialize, LeastLoadedDispatch)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_StationDispatchInitialize, RoundRobinDispatch)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+BENCHMARK_TEMPLATE(BM_StationDispatchInitialize, AffinityDispatch)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
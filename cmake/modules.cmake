@@ -7,7 +7,8 @@ if(CPPLINT)
     "${CMAKE_CURRENT_SOURCE_DIR}/include/*.h"
     "${CMAKE_CURRENT_SOURCE_DIR}/source/*.cpp"
     "${CMAKE_CURRENT_SOURCE_DIR}/test/*.cpp"
-    "${CMAKE_CURRENT_SOURCE_DIR}/test/*.h")
+    "${CMAKE_CURRENT_SOURCE_DIR}/test/*.h"
+    "${CMAKE_CURRENT_SOURCE_DIR}/bench/*.cpp")
 
   add_custom_target(cpplint
     COMMAND ${CPPLINT}
@@ -39,6 +40,26 @@ if (NOT GTest_FOUND)
 endif()
 include(GoogleTest)
 
+option(BUILD_BENCHMARKS "Build the vast-mining-bench target" OFF)
+
+if (BUILD_BENCHMARKS)
+  find_package(benchmark CONFIG)
+
+  if (NOT benchmark_FOUND)
+    message(STATUS "Downloading google benchmark...")
+    set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+    set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+
+    FetchContent_Declare(
+      googlebenchmark
+      GIT_REPOSITORY https://github.com/google/benchmark.git
+      GIT_TAG v1.8.3
+    )
+
+    FetchContent_MakeAvailable(googlebenchmark)
+  endif()
+endif()
+
 find_package(nlohmann_json CONFIG)
 
 if (NOT nlohmann_json_FOUND)
@@ -53,6 +74,9 @@ if (NOT nlohmann_json_FOUND)
   FetchContent_MakeAvailable(nlohmann_json)
 endif()
 
+# Compressed event logs (see include/event_log.h)
+find_package(ZLIB REQUIRED)
+
 # Find clang-format if available
 find_program(CLANG_FORMAT_EXE NAMES clang-format)
 
@@ -60,7 +84,8 @@ if(CLANG_FORMAT_EXE)
   file(GLOB_RECURSE ALL_SOURCE_FILES
     "${CMAKE_CURRENT_SOURCE_DIR}/source/*.cpp"
     "${CMAKE_CURRENT_SOURCE_DIR}/include/*.h"
-    "${CMAKE_CURRENT_SOURCE_DIR}/test/*.cpp")
+    "${CMAKE_CURRENT_SOURCE_DIR}/test/*.cpp"
+    "${CMAKE_CURRENT_SOURCE_DIR}/bench/*.cpp")
 
   add_custom_target(format
     COMMAND ${CLANG_FORMAT_EXE} -i ${ALL_SOURCE_FILES}
@@ -0,0 +1,65 @@
+#ifndef INCLUDE_ANALYZE_H_
+#define INCLUDE_ANALYZE_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "event.h"
+#include "event_log.h"
+#include "minutes.h"
+
+// Time a truck spent in each activity over the whole log
+struct TruckActivity {
+  minutes_t mine = 0min;
+  minutes_t travel = 0min;
+  minutes_t queue = 0min;
+  minutes_t unload = 0min;
+  size_t trips_completed = 0;
+};
+
+struct StationActivity {
+  minutes_t unload = 0min;
+  size_t unload_count = 0;
+};
+
+// Per-truck and per-station totals of an event log: the numbers
+// scripts/plot_report.py plots, computed without loading the log into Python.
+struct EventLogSummary {
+  size_t num_events = 0;
+  size_t skipped_lines = 0;  // JSON Lines records that could not be parsed
+  minutes_t duration = 0min;  // Latest end time of any event
+
+  // Indexed by id; ids that never appear in the log are left at zero
+  std::vector<TruckActivity> trucks;
+  std::vector<StationActivity> stations;
+
+  void Add(const EventRecord& record);
+
+  // Folds in the summary of another part of the same log
+  void Merge(const EventLogSummary& other);
+
+  // (mine + travel + unload) / duration
+  double TruckEfficiency(size_t truck_id) const;
+  // unload / duration
+  double StationEfficiency(size_t station_id) const;
+};
+
+// Parses one JSON Lines record as written by EventToJsonLine. Unlike
+// EventFromJsonLine this does not build a JSON document, and it reports bad
+// input by returning false instead of throwing.
+bool ParseEventRecord(std::string_view line, EventRecord* record);
+
+// Summarizes a JSON Lines or binary event log. The file is memory-mapped and
+// split into one chunk per thread (at line boundaries for JSON Lines); chunks
+// are summarized in parallel and merged. A compressed JSON Lines log is
+// decompressed into memory first. 0 threads = all cores.
+EventLogSummary AnalyzeEventLog(const std::string& filename,
+                                size_t num_threads = 0);
+
+// Writes the summary as JSON for plot_report.py --summary
+void WriteEventLogSummary(const std::string& filename,
+                          const EventLogSummary& summary);
+
+#endif  // INCLUDE_ANALYZE_H_
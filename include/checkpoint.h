@@ -0,0 +1,81 @@
+#ifndef INCLUDE_CHECKPOINT_H_
+#define INCLUDE_CHECKPOINT_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "event.h"
+#include "metrics_store.h"
+#include "minutes.h"
+
+// Checkpoint file format.
+//
+// A checkpoint is a CheckpointHeader followed by the sections of a
+// Checkpoint in declaration order, each a uint64 element count and the
+// packed elements. Like the binary event log, everything is stored in host
+// (little-endian) byte order.
+
+inline constexpr char kCheckpointMagic[4] = {'V', 'M', 'C', 'K'};
+inline constexpr uint32_t kCheckpointVersion = 5;
+
+// File header written once at offset 0 (80 bytes).
+struct CheckpointHeader {
+  char magic[4];     // kCheckpointMagic
+  uint32_t version;  // kCheckpointVersion
+  uint64_t num_trucks;
+  uint64_t num_stations;
+  uint64_t random_seed;
+  int64_t sim_minutes;  // Length of the run that was checkpointed
+  int64_t time;         // Minutes simulated so far
+  uint64_t events_emitted;
+  int64_t time_series_interval;
+  int64_t station_last_popped;
+  int64_t station_last_marked;
+};
+static_assert(sizeof(CheckpointHeader) == 80);
+
+// Contents of a StationQueue (see station_dispatch.h): entries from the
+// front, by time, and the times of the last pop and mark. Other dispatchers
+// save their stations by id, and counters of their own.
+struct StationQueueState {
+  std::vector<std::pair<minutes_t, size_t>> entries;
+  minutes_t last_popped = minutes_t::min();
+  minutes_t last_marked = minutes_t::min();
+  std::vector<int64_t> counters;
+};
+
+// Full state of a BasicController part way through (or at the end of) a
+// run; continuing from it gives the same events and metrics as never having
+// stopped.
+struct Checkpoint {
+  RunParameters params;  // sim_time is the length of the checkpointed run
+  minutes_t time = 0min;  // Every event ending by then has been processed
+  uint64_t events_emitted = 0;  // Events sent to the sink up to time
+  std::string mining_distribution;  // Or the scenario timing (Describe())
+
+  std::vector<PackedEvent> pending;   // In the order they would be popped
+  std::vector<PackedEvent> deferred;  // Transitions past the end of the run
+  StationQueueState station_queue;
+  MetricsStore metrics;  // Accumulated columns only
+
+  // Raw bins of the time series (see TimeSeries), empty when it was off
+  minutes_t time_series_interval = 0min;
+  std::vector<int64_t> truck_minutes;
+  std::vector<int64_t> busy_minutes;
+  std::vector<int64_t> queue_minutes;
+};
+
+// Writes a checkpoint to filename. The file is written under a temporary
+// name and renamed, so an interrupted write leaves the previous one intact.
+void WriteCheckpoint(const std::string& filename, const Checkpoint& checkpoint);
+
+// Reads only the header of a checkpoint; throws like ReadCheckpoint.
+CheckpointHeader ReadCheckpointHeader(const std::string& filename);
+
+// Reads a checkpoint written by WriteCheckpoint. Throws if the file is not a
+// checkpoint this build can read or is cut short.
+Checkpoint ReadCheckpoint(const std::string& filename);
+
+#endif  // INCLUDE_CHECKPOINT_H_
@@ -1,50 +1,209 @@
 #ifndef INCLUDE_CONTROLLER_H_
 #define INCLUDE_CONTROLLER_H_
 
+#include <array>
 #include <functional>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <queue>
-#include <random>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "checkpoint.h"
+#include "counter_rng.h"
 #include "event.h"
+#include "event_sink.h"
+#include "metrics_export.h"
+#include "metrics_store.h"
+#include "mining_distribution.h"
 #include "report.h"
+#include "scheduler.h"
+#include "station_dispatch.h"
+#include "stats.h"
+#include "steady_state.h"
+#include "time_series.h"
+#include "timing.h"
 
-// StationQueue manages station availability scheduling using a min-heap
-class StationQueue {
+// What the last Simulate (or Run) did; all zero when stats are compiled out
+// (see stats.h). Queue events only go to the sink, so they are counted as
+// emitted but never dispatched.
+struct EngineStats {
+  std::array<uint64_t, kNumEventTypes> events_by_type{};  // Emitted
+  uint64_t events_processed = 0;   // Dispatched by the main loop
+  size_t peak_pending_events = 0;  // High-water mark of the scheduler
+  size_t peak_queued_trucks = 0;   // Most trucks waiting for a station
+  uint64_t random_draws = 0;       // Mining durations drawn
+  uint64_t trace_messages = 0;     // Time-limit traces (trace level only)
+  double trace_ms = 0.0;
+
+  // Wall time per phase
+  double setup_ms = 0.0;    // Reset state and dispatch every truck
+  double loop_ms = 0.0;     // Main event loop
+  double metrics_ms = 0.0;  // Derived metrics
+  double export_ms = 0.0;   // Report export (Run only)
+
+  // ParallelController only: epochs run, and the part of loop_ms spent in
+  // the serial phase (station assignment)
+  uint64_t epochs = 0;
+  double serial_ms = 0.0;
+
+  // Dispatch rate of the main loop
+  double EventsPerSecond() const;
+};
+
+// Prints engine statistics to the console.
+void PrintEngineStats(const EngineStats& stats);
+
+// The trucks waiting for a station, as the times their waits end, for
+// EngineStats::peak_queued_trucks. Arrivals must come in time order.
+class WaitingTrucks {
  public:
-  void Initialize(size_t num_stations);
+  void Clear() { wait_ends_ = {}; }
 
-  bool Empty() const;
-  std::pair<minutes_t, size_t> PopNextAvailable();
-  void MarkAvailable(minutes_t time, size_t station_id);
+  // A truck arriving at arrival gets a station free at available; returns
+  // how many trucks, it included, are waiting then
+  size_t Arrive(minutes_t arrival, minutes_t available) {
+    while (!wait_ends_.empty() && wait_ends_.top() <= arrival) {
+      wait_ends_.pop();
+    }
+    if (available > arrival) wait_ends_.push(available);
+    return wait_ends_.size();
+  }
 
  private:
-  std::priority_queue<std::pair<minutes_t, size_t>,
-                      std::vector<std::pair<minutes_t, size_t>>, std::greater<>>
-      queue_;
+  std::priority_queue<minutes_t, std::vector<minutes_t>, std::greater<>>
+      wait_ends_;
 };
 
+// The default dispatcher: the station available first. Stations free up in
+// time order when they all take the same time to unload, which StationQueue
+// relies on.
+template <TimingPolicy Timing>
+using EarliestAvailable =
+    std::conditional_t<Timing::kFixedUnloadTime, StationQueue, StationHeap>;
+
 // Controls the simulation by coordinating truck, mine, and station behavior.
 // Owns the main loop and delegates work to handlers per event type.
-class Controller {
+//
+// Emitted events go to the Sink policy (see event_sink.h). Controller, the
+// default, writes them to the global event log. Pending events are ordered
+// by the Scheduler policy (see scheduler.h), travel, unload and mining
+// times come from the Timing policy (see timing.h), and arriving trucks are
+// given stations by the Dispatch policy (see station_dispatch.h).
+template <EventSink Sink = FileEventSink,
+          EventScheduler Scheduler = TimingWheelScheduler,
+          TimingPolicy Timing = FixedTiming,
+          StationDispatcher Dispatch = EarliestAvailable<Timing>>
+class BasicController {
  public:
-  // Constants controlling simulation timing
-  static constexpr minutes_t kTravelTime = 30min;
-  static constexpr minutes_t kUnloadTime = 5min;
-  static constexpr minutes_t kMinDuration = 60min;
-  static constexpr minutes_t kMaxDuration = 300min;
+  // Constants controlling simulation timing with FixedTiming
+  static constexpr minutes_t kTravelTime = FixedTiming::kTravelTime;
+  static constexpr minutes_t kUnloadTime = FixedTiming::kUnloadTime;
+  static constexpr minutes_t kMinDuration = FixedTiming::kMinDuration;
+  static constexpr minutes_t kMaxDuration = FixedTiming::kMaxDuration;
 
-  Controller(size_t num_trucks, size_t num_stations,
-             size_t random_seed = 0xBEEF);
+  // Pending events are allocated from arena; pass an EventArena that
+  // outlives the controller to reuse memory across runs.
+  BasicController(
+      size_t num_trucks, size_t num_stations, size_t random_seed = 0xBEEF,
+      Sink sink = Sink(),
+      std::pmr::memory_resource* arena = std::pmr::get_default_resource());
 
   // Runs the simulation for the given amount of simulated time (in minutes)
+  // and exports the metrics report
   void Run(minutes_t sim_time);
 
+  // Runs the simulation and computes metrics without writing any report
+  void Simulate(minutes_t sim_time);
+
+  // Records per-interval activity (see time_series.h) during later runs;
+  // Run also exports it. An interval of 0 (the default) turns it off.
+  void SetTimeSeriesInterval(minutes_t interval) {
+    time_series_interval_ = interval;
+  }
+
+  // Monitors later runs for steady state (see steady_state.h). A monitored
+  // run goes in stages and stops at the first stage end where the
+  // estimates have converged, or at sim_time; its metrics and time series
+  // are then those of a run of that length, and so is the set of events it
+  // logs, but not their order: transitions deferred at a stage end are
+  // logged when they are scheduled again, so the log is not sorted by time
+  // around stage ends. Run also prints and exports the estimates. An
+  // interval of 0 (the default) turns it off; it cannot be combined with
+  // checkpoints.
+  void SetSteadyState(SteadyStateOptions options) {
+    steady_state_options_ = options;
+  }
+
+  // Format and path of the metrics report Run writes (see metrics_export.h)
+  void SetMetricsExport(MetricsExportOptions options) {
+    metrics_export_ = std::move(options);
+  }
+
+  // Draws the mining durations of later runs from distribution instead of
+  // uniformly over [kMinDuration, kMaxDuration]. Unused when the timing has
+  // distributions of its own (ScenarioTiming).
+  void SetMiningDistribution(MiningDistribution distribution) {
+    mining_distribution_ = std::move(distribution);
+  }
+
+  // Timing of later runs; Simulate throws std::invalid_argument if it does
+  // not cover the controller's trucks and stations
+  void SetTiming(Timing timing) { timing_ = std::move(timing); }
+
+  // Dispatcher of later runs, with its settings (see AffinityDispatch)
+  void SetDispatch(Dispatch dispatch) { station_queue_ = std::move(dispatch); }
+
+  // Writes the full state of later runs to filename (see checkpoint.h) every
+  // interval of simulated time, and once more when a run ends so that it
+  // can be extended. An interval of 0 (the default) turns it off.
+  void SetCheckpointInterval(minutes_t interval, std::string filename) {
+    checkpoint_interval_ = interval;
+    checkpoint_filename_ = std::move(filename);
+  }
+
+  // Makes the next Run or Simulate continue the run saved in filename
+  // instead of starting at minute 0, with the same results as if it had
+  // never stopped. Its sim_time may be longer than the saved run's, to
+  // extend it; the time series keeps the saved run's interval. Throws
+  // std::invalid_argument if the saved run had other trucks, stations, seed,
+  // mining distribution, timing or dispatcher.
+  void LoadCheckpoint(const std::string& filename);
+
+  // State at the end of the last run
+  Checkpoint SaveCheckpoint() const {
+    return MakeCheckpoint(sim_duration_, nullptr);
+  }
+
+  const Sink& sink() const { return sink_; }
+  // Metrics of the last run, one column per field
+  const MetricsStore& metrics() const { return metrics_; }
+
+  // The same metrics as one object per truck/station, converted on first
+  // access after a run (so not safe to call concurrently)
+  const std::vector<TruckMetrics>& truck_metrics() const {
+    ConvertMetrics();
+    return trucks_metrics_;
+  }
+  const std::vector<StationMetrics>& station_metrics() const {
+    ConvertMetrics();
+    return station_metrics_;
+  }
+  const TimeSeries& time_series() const { return time_series_; }
+  // Estimates of the last monitored run
+  const SteadyStateResult& steady_state() const {
+    return steady_state_.result();
+  }
+  // Simulated time of the last run, shorter than asked if it converged
+  minutes_t sim_time() const { return sim_duration_; }
+  const EngineStats& stats() const { return stats_; }
+
  private:
   // Event processing entry point
-  void ProcessEvent(minutes_t start_time, const Event& event);
+  void ProcessEvent(const PackedEvent& event);
 
   // Core simulation transitions
   void Mine(size_t truck_id, minutes_t start_time);
@@ -52,34 +211,137 @@ class Controller {
   void UnloadTruck(size_t truck_id, minutes_t start_time);
   void TravelToMine(size_t truck_id, minutes_t start_time);
 
+  // Emits and records the event a transition starts, or defers it if it
+  // ends past the end of the run. The start of an Unload is the truck's
+  // arrival; any wait before the unload itself is recorded as queueing.
+  void Schedule(const PackedEvent& event);
+
   // Queue tracking and metric recording
   void RecordQueueing(size_t truck_id, size_t station_id, minutes_t start_time,
                       minutes_t end_time);
 
-  // Utility to create/log/queue a simulation event
+  // Utility to create/emit/queue a simulation event
   void EmitEvent(EventType type, size_t truck_id,
                  std::optional<size_t> station_id, minutes_t start,
                  minutes_t end);
 
+  // Moves the end of a monitored run to its next stage: the transitions
+  // deferred past the old end are scheduled as in a longer run
+  void ExtendRun(minutes_t sim_time);
+
   // Support functions
-  bool ExceedsSimTime(minutes_t time) const;
-  minutes_t RandomMiningDuration();
+  bool ExceedsSimTime(minutes_t time);
+  minutes_t RandomMiningDuration(size_t truck_id);
+  std::string Configuration() const;  // For checkpoints
+  void ConvertMetrics() const;  // Fills trucks_metrics_/station_metrics_
+
+  // Checkpoints: the state as of time, when every event ending by then has
+  // been processed; front, if any, was popped but not processed yet
+  Checkpoint MakeCheckpoint(minutes_t time, const PackedEvent* front) const;
+  void WriteCheckpointBefore(const PackedEvent& front);
+  void Restore(const Checkpoint& checkpoint);
 
   // Configuration and state
   size_t num_trucks_ = 0;
   size_t num_stations_ = 0;
+  size_t random_seed_ = 0;
   minutes_t sim_duration_ = 0min;
-  std::default_random_engine engine_;
+  CounterRng rng_;  // Stream truck_id, index: mines the truck has started
+  MiningDistribution mining_distribution_ =
+      MiningDistribution::Uniform(kMinDuration, kMaxDuration);
+  [[no_unique_address]] Timing timing_;
+  [[no_unique_address]] Sink sink_;
 
   // Scheduling and event management
-  std::priority_queue<std::pair<minutes_t, Event>,
-                      std::vector<std::pair<minutes_t, Event>>, std::greater<>>
-      event_queue_;
-  StationQueue station_queue_;
-
-  // Metrics for trucks and stations
-  std::vector<TruckMetrics> trucks_metrics_;
-  std::vector<StationMetrics> station_metrics_;
+  Scheduler event_queue_;
+  Dispatch station_queue_;
+
+  // Metrics for trucks and stations, and their per-object form for
+  // truck_metrics()/station_metrics()
+  MetricsStore metrics_;
+  mutable std::vector<TruckMetrics> trucks_metrics_;
+  mutable std::vector<StationMetrics> station_metrics_;
+  mutable bool metrics_converted_ = false;
+  MetricsExportOptions metrics_export_;
+
+  // Per-interval activity, when enabled
+  minutes_t time_series_interval_ = 0min;
+  TimeSeries time_series_;
+
+  // Steady-state monitoring, when enabled
+  SteadyStateOptions steady_state_options_;
+  SteadyStateMonitor steady_state_;
+
+  // Transitions deferred by Schedule, in order. The station of a deferred
+  // Unload is still marked busy until its end, so a checkpoint of this run
+  // can be extended by replaying them: a longer run would have scheduled
+  // them at the same point.
+  std::vector<PackedEvent> deferred_;
+  uint64_t events_emitted_ = 0;  // Sent to the sink this run
+
+  minutes_t checkpoint_interval_ = 0min;
+  std::string checkpoint_filename_;
+  minutes_t next_checkpoint_ = minutes_t::max();
+  std::optional<Checkpoint> resume_from_;  // Set by LoadCheckpoint
+
+  EngineStats stats_;
+  WaitingTrucks waiting_trucks_;  // Only with stats
 };
 
+// Instantiated in controller.cpp for the sinks in event_sink.h, for the
+// binary heap scheduler with the sinks that benchmarks and tests compare,
+// and for scenario timing and the other dispatchers with the sinks main
+// uses
+extern template class BasicController<NullEventSink>;
+extern template class BasicController<VectorEventSink>;
+extern template class BasicController<FileEventSink>;
+extern template class BasicController<CallbackEventSink>;
+extern template class BasicController<NullEventSink, BinaryHeapScheduler>;
+extern template class BasicController<VectorEventSink, BinaryHeapScheduler>;
+extern template class BasicController<FileEventSink, BinaryHeapScheduler>;
+extern template class BasicController<NullEventSink, TimingWheelScheduler,
+                                      ScenarioTiming>;
+extern template class BasicController<VectorEventSink, TimingWheelScheduler,
+                                      ScenarioTiming>;
+extern template class BasicController<FileEventSink, TimingWheelScheduler,
+                                      ScenarioTiming>;
+extern template class BasicController<NullEventSink, TimingWheelScheduler,
+                                      FixedTiming, LeastLoadedDispatch>;
+extern template class BasicController<VectorEventSink, TimingWheelScheduler,
+                                      FixedTiming, LeastLoadedDispatch>;
+extern template class BasicController<FileEventSink, TimingWheelScheduler,
+                                      FixedTiming, LeastLoadedDispatch>;
+extern template class BasicController<NullEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, LeastLoadedDispatch>;
+extern template class BasicController<VectorEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, LeastLoadedDispatch>;
+extern template class BasicController<FileEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, LeastLoadedDispatch>;
+extern template class BasicController<NullEventSink, TimingWheelScheduler,
+                                      FixedTiming, RoundRobinDispatch>;
+extern template class BasicController<VectorEventSink, TimingWheelScheduler,
+                                      FixedTiming, RoundRobinDispatch>;
+extern template class BasicController<FileEventSink, TimingWheelScheduler,
+                                      FixedTiming, RoundRobinDispatch>;
+extern template class BasicController<NullEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, RoundRobinDispatch>;
+extern template class BasicController<VectorEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, RoundRobinDispatch>;
+extern template class BasicController<FileEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, RoundRobinDispatch>;
+extern template class BasicController<NullEventSink, TimingWheelScheduler,
+                                      FixedTiming, AffinityDispatch>;
+extern template class BasicController<VectorEventSink, TimingWheelScheduler,
+                                      FixedTiming, AffinityDispatch>;
+extern template class BasicController<FileEventSink, TimingWheelScheduler,
+                                      FixedTiming, AffinityDispatch>;
+extern template class BasicController<NullEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, AffinityDispatch>;
+extern template class BasicController<VectorEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, AffinityDispatch>;
+extern template class BasicController<FileEventSink, TimingWheelScheduler,
+                                      ScenarioTiming, AffinityDispatch>;
+
+using Controller = BasicController<>;
+
 #endif  // INCLUDE_CONTROLLER_H_
@@ -0,0 +1,79 @@
+#ifndef INCLUDE_COUNTER_RNG_H_
+#define INCLUDE_COUNTER_RNG_H_
+
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3", SC'11): a keyed bijection of 128-bit counters that passes BigCrush.
+// Any output can be computed directly from its counter, without generating
+// the ones before it.
+class Philox4x32 {
+ public:
+  using Counter = std::array<uint32_t, 4>;
+  using Key = std::array<uint32_t, 2>;
+
+  static constexpr Counter Generate(Counter counter, Key key) {
+    for (int round = 0; round < kRounds; ++round) {
+      if (round > 0) {
+        key[0] += kWeyl0;
+        key[1] += kWeyl1;
+      }
+      const uint64_t product0 = uint64_t{kMultiplier0} * counter[0];
+      const uint64_t product1 = uint64_t{kMultiplier1} * counter[2];
+      counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                 static_cast<uint32_t>(product1),
+                 static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                 static_cast<uint32_t>(product0)};
+    }
+    return counter;
+  }
+
+ private:
+  static constexpr int kRounds = 10;
+  static constexpr uint32_t kMultiplier0 = 0xD2511F53;
+  static constexpr uint32_t kMultiplier1 = 0xCD9E8D57;
+  static constexpr uint32_t kWeyl0 = 0x9E3779B9;  // Golden ratio
+  static constexpr uint32_t kWeyl1 = 0xBB67AE85;  // sqrt(3) - 1
+};
+
+// Random numbers addressed by (seed, stream, index) instead of drawn from a
+// shared sequence: draw index of a stream is a pure function of the three,
+// so it does not depend on the order in which streams are drawn from. The
+// simulation uses one stream per truck and one index per mining cycle, so a
+// truck mines for the same durations whatever the rest of the fleet does
+// (common random numbers across configurations) and on any thread.
+class CounterRng {
+ public:
+  explicit constexpr CounterRng(uint64_t seed)
+      : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)} {}
+
+  // The four words of counter block block of draw index of stream; a draw
+  // that needs more than four words continues in the next block
+  constexpr Philox4x32::Counter Block(uint32_t stream, uint32_t index,
+                                      uint32_t block) const {
+    return Philox4x32::Generate({stream, index, block, 0}, key_);
+  }
+
+  // Uniform integer in [low, high] (high - low < 2^32 - 1), without bias:
+  // Lemire's multiply-shift with rejection, over as many counter blocks as
+  // it takes (for small ranges a second block is practically never needed)
+  constexpr uint32_t UniformInt(uint32_t stream, uint32_t index, uint32_t low,
+                                uint32_t high) const {
+    const uint32_t range = high - low + 1;
+    const uint32_t threshold = (0u - range) % range;
+    for (uint32_t block = 0;; ++block) {
+      for (const uint32_t bits : Block(stream, index, block)) {
+        const uint64_t product = uint64_t{bits} * range;
+        if (static_cast<uint32_t>(product) >= threshold) {
+          return low + static_cast<uint32_t>(product >> 32);
+        }
+      }
+    }
+  }
+
+ private:
+  Philox4x32::Key key_;
+};
+
+#endif  // INCLUDE_COUNTER_RNG_H_
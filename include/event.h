@@ -1,18 +1,28 @@
 #ifndef INCLUDE_EVENT_H_
 #define INCLUDE_EVENT_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "minutes.h"
+#include "ring_buffer.h"
+#include "stats.h"
 
 // Defines the types of events that can occur in the simulation.
 enum class EventType { TravelToStation, Mine, TravelToMine, Queue, Unload };
+inline constexpr size_t kNumEventTypes = 5;
 
 // Converts an EventType enum to a string for logging or serialization.
 std::string EventTypeToString(EventType type);
@@ -32,43 +42,251 @@ struct Event {
   std::string to_string() const;  // Human-readable summary
 };
 
+// Compact (16-byte) internal event representation used wherever many events
+// are held at once: the scheduler's pending events and the event logger's
+// buffers. Event remains the public, readable form; convert at the edges.
+//
+// The event type lives in the top bits of the truck id, a sentinel replaces
+// std::optional for the station, and times are 32-bit minutes since the
+// start of the run (about 8000 years).
+class PackedEvent {
+ public:
+  static constexpr uint32_t kTypeBits = 3;
+  static constexpr uint32_t kTruckBits = 32 - kTypeBits;
+  static constexpr uint32_t kMaxTruckId = (1u << kTruckBits) - 1;
+  static constexpr uint32_t kNoStation = std::numeric_limits<uint32_t>::max();
+
+  PackedEvent() = default;
+  PackedEvent(EventType type, size_t truck_id, uint32_t station_id,
+              minutes_t start_time, minutes_t end_time)
+      : truck_and_type_(static_cast<uint32_t>(truck_id) |
+                        (static_cast<uint32_t>(type) << kTruckBits)),
+        station_id_(station_id),
+        start_time_(static_cast<uint32_t>(start_time.count())),
+        end_time_(static_cast<uint32_t>(end_time.count())) {}
+
+  explicit PackedEvent(const Event& event)
+      : PackedEvent(event.type, event.truck_id,
+                    event.station_id.has_value()
+                        ? static_cast<uint32_t>(event.station_id.value())
+                        : kNoStation,
+                    event.start_time, event.end_time) {}
+
+  EventType type() const {
+    return static_cast<EventType>(truck_and_type_ >> kTruckBits);
+  }
+  size_t truck_id() const { return truck_and_type_ & kMaxTruckId; }
+  bool has_station() const { return station_id_ != kNoStation; }
+  uint32_t station_id() const { return station_id_; }
+  minutes_t start_time() const { return minutes_t(start_time_); }
+  minutes_t end_time() const { return minutes_t(end_time_); }
+
+  // Expands to the public representation
+  Event ToEvent() const {
+    Event event{type(), truck_id(), std::nullopt, start_time(), end_time()};
+    if (has_station()) event.station_id = station_id_;
+    return event;
+  }
+
+ private:
+  uint32_t truck_and_type_ = 0;
+  uint32_t station_id_ = kNoStation;
+  uint32_t start_time_ = 0;
+  uint32_t end_time_ = 0;
+};
+static_assert(sizeof(PackedEvent) == 16);
+
+// Memory pool for event storage. A Controller allocates its pending-event
+// buckets from an arena; handing the same arena to consecutive controllers
+// (e.g. one per worker thread) lets later runs reuse the memory of earlier
+// ones instead of going back to the global allocator. Not thread-safe.
+class EventArena : public std::pmr::unsynchronized_pool_resource {
+ public:
+  EventArena()
+      : std::pmr::unsynchronized_pool_resource(std::pmr::pool_options{
+            .max_blocks_per_chunk = 0,
+            .largest_required_pool_block = kLargestPooledBlock}) {}
+
+ private:
+  // Bucket vectors up to this size are pooled; larger ones go upstream
+  static constexpr size_t kLargestPooledBlock = 1 << 22;
+};
+
 // Orders events by start time for use in priority queues.
 bool operator<(const Event& lhs, const Event& rhs);
 
 // Stream operator for readable debug output.
 std::ostream& operator<<(std::ostream& os, const Event& event);
 
+// Serializes an event to a single JSON Lines record (without the newline).
+std::string EventToJsonLine(const Event& event);
+
+// Parses a single JSON Lines record back into an event. Throws on bad input.
+Event EventFromJsonLine(const std::string& line);
+
+// On-disk encodings supported by the EventLogger.
+enum class LogFormat { JsonLines, Binary };
+
+// Parameters of the run that produced an event log. Stored in the header of
+// binary logs so a log file is self-describing.
+struct RunParameters {
+  size_t num_trucks = 0;
+  size_t num_stations = 0;
+  minutes_t sim_time = 0min;
+  size_t random_seed = 0;
+};
+
+// What EventLogger::LogEvent does when the writer thread falls behind and
+// the event ring is full.
+enum class OverflowPolicy {
+  Block,  // Wait for the writer thread to make room (lossless)
+  Drop,   // Discard the event and count it (never stalls the simulation)
+  Grow,   // Spill into an unbounded overflow buffer (lossless, unbounded)
+};
+
+// What an EventLogger has done since it was constructed (see stats.h).
+// Flushes are the writer thread's batches: serialization plus the write.
+struct LoggerStats {
+  uint64_t events_logged = 0;
+  uint64_t events_dropped = 0;
+  uint64_t flushes = 0;
+  uint64_t bytes_written = 0;
+  double flush_ms = 0.0;      // Summed over flushes
+  double max_flush_ms = 0.0;  // Slowest single flush
+  // Time LogEvent spent waiting for the writer to free ring space
+  // (OverflowPolicy::Block with a full ring)
+  uint64_t blocked_waits = 0;
+  double blocked_ms = 0.0;
+};
+
+// Prints logger statistics to the console.
+void PrintLoggerStats(const LoggerStats& stats);
+
+class BlockCompressor;
+class EventIndexWriter;
+class EventLogLineReader;
+struct EventRecord;
+
 // Manages logging of simulation events to a file and reading them back.
+//
+// Events travel from LogEvent to a background writer thread through a
+// bounded single-producer/single-consumer ring, so the simulation thread
+// never waits on serialization or disk I/O (except under
+// OverflowPolicy::Block with a full ring). LogEvent must only be called from
+// one thread at a time. JSON Lines output can be compressed (see
+// event_log.h), and a sidecar index of the log kept (see event_index.h),
+// which the writer thread does too.
 class EventLogger {
  public:
-  explicit EventLogger(const std::string& filename);
+  static constexpr size_t kDefaultBufferCapacity = 1 << 16;
+
+  explicit EventLogger(const std::string& filename,
+                       LogFormat format = LogFormat::JsonLines,
+                       size_t buffer_capacity = kDefaultBufferCapacity,
+                       OverflowPolicy overflow = OverflowPolicy::Block);
   ~EventLogger();
 
-  // Appends a single event to the log (in JSON Lines format).
+  // Appends a single event to the log.
   void LogEvent(const Event& event);
 
-  // Writes buffered events to disk and clears the buffer
+  // Records the parameters of the current run. For binary logs the file
+  // header is rewritten in place.
+  void SetRunParameters(const RunParameters& params);
+
+  // Wakes the writer thread to write buffered events now (does not wait).
   void FlushBuffer();
 
-  // Waits for the background flush thread to finish flushing
+  // Blocks until every event logged so far has been written to disk.
   void WaitUntilFlushed();
 
-  // Reads the next event from the log (returns false if no more).
+  // Reads the next event from the log (returns false if no more). A
+  // compressed JSON Lines log is decompressed as it is read.
   bool ReadNextEvent(Event* event);
 
   // Clears the log file by truncating it.
   void ClearEvents();
 
+  // Closes the current log and continues at filename, starting it fresh
+  // (truncated) unless append is set. A compression_level from 1 to 9
+  // compresses JSON Lines output (0: none); throws std::invalid_argument
+  // for other levels or for binary logs.
+  void Reopen(const std::string& filename, LogFormat format,
+              bool append = false, int compression_level = 0);
+
+  // Starts or stops keeping the sidecar index of the log (EventIndexPath),
+  // through this and later logs. Starting indexes what the log already
+  // holds; a log written without indexing loses its sidecar, which would
+  // go stale.
+  void SetIndexing(bool enabled);
+
+  void SetOverflowPolicy(OverflowPolicy overflow) { overflow_ = overflow; }
+
+  const std::string& filename() const { return filename_; }
+  LogFormat format() const { return format_; }
+  int compression_level() const { return compression_level_; }
+  bool indexing() const { return indexing_; }
+  OverflowPolicy overflow_policy() const { return overflow_; }
+  size_t buffer_capacity() const { return ring_.capacity(); }
+
+  // Events discarded under OverflowPolicy::Drop since construction.
+  size_t dropped_events() const { return dropped_.load(); }
+
+  // Counters since construction; all zero when stats are compiled out. Call
+  // from the thread that logs events.
+  LoggerStats stats();
+
  private:
   std::string filename_;
+  LogFormat format_;
+  RunParameters params_;
   std::ofstream ofs_;
-  std::ifstream ifs_;
-  std::vector<Event> buffer_;
+  std::ifstream ifs_;  // Binary logs
+  std::unique_ptr<EventLogLineReader> line_reader_;  // JSON Lines logs
+  std::mutex stream_mutex_;  // Guards ofs_/format_ against the writer thread
+
+  // JSON Lines compression, and the writer thread's reusable buffers
+  int compression_level_ = 0;
+  std::unique_ptr<BlockCompressor> compressor_;
+  std::string batch_text_;
+  std::string batch_block_;
+  std::vector<EventRecord> batch_records_;
+
+  // Sidecar index, and the size of the log its block offsets follow
+  bool indexing_ = false;
+  std::unique_ptr<EventIndexWriter> index_;
+  uint64_t log_bytes_ = 0;
+
+  // Producer -> writer thread hand-off
+  SpscRingBuffer<PackedEvent> ring_;
+  std::atomic<OverflowPolicy> overflow_;
+  std::vector<PackedEvent> spill_;  // OverflowPolicy::Grow overflow
+  std::mutex spill_mutex_;
+  std::atomic<bool> spilled_{false};  // Producer writes go to spill_ only
+  std::atomic<size_t> dropped_{0};
+
+  // Statistics: the writer's fields are guarded by stream_mutex_, the
+  // blocked_* fields belong to the producer
+  LoggerStats stats_;
+
+  // Sequence numbers: events accepted by LogEvent / written by the writer
+  std::atomic<uint64_t> logged_seq_{0};
+  std::atomic<uint64_t> flushed_seq_{0};
+
+  // Writer thread wake-up
   std::thread flush_thread_;
-  std::mutex buffer_mutex_;
-  std::atomic<bool> done_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  bool flush_requested_ = false;  // Guarded by wake_mutex_
+  std::atomic<bool> done_{false};
 
-  void CloseStreams();  // Internal cleanup
+  void WriterLoop();                                 // Body of flush_thread_
+  void WriteBatch(const std::vector<PackedEvent>&);  // Serializes to ofs_
+  uint64_t WriteBlock(std::span<const PackedEvent>);  // One block (indexed)
+  void SpillEvent(const PackedEvent& event);         // Grow overflow path
+  void OpenOutput(std::ios::openmode mode);          // Opens ofs_ (and header)
+  void WriteHeader();                                // Binary header at 0
+  void OpenIndex();                                  // Starts index_
+  void CloseStreams();                               // Internal cleanup
 };
 
 // Access the global logger instance.
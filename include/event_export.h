@@ -0,0 +1,58 @@
+#ifndef INCLUDE_EVENT_EXPORT_H_
+#define INCLUDE_EVENT_EXPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "minutes.h"
+
+// Encodings an event log can be exported to for analysis tools.
+enum class EventExportFormat {
+  Json,   // A JSON array of the events, one EventToJsonLine object per line
+  Csv,    // type,truck_id,station_id,start_time,end_time rows
+  Arrow,  // Arrow IPC file (Feather v2); see ExportEventLog
+};
+
+// Parses json, csv or arrow. Throws std::invalid_argument.
+EventExportFormat EventExportFormatFromString(const std::string& name);
+
+struct EventExportOptions {
+  EventExportFormat format = EventExportFormat::Json;
+  std::string path;        // Empty: DefaultEventExportPath
+  size_t num_threads = 0;  // Threads converting chunks (0: all cores)
+};
+
+// events.<N>truck_<M>station_<T>min_minutes.<json|csv|arrow>
+std::string DefaultEventExportPath(size_t num_trucks, size_t num_stations,
+                                   minutes_t sim_time,
+                                   EventExportFormat format);
+
+struct EventExportResult {
+  std::string path;
+  uint64_t num_events = 0;
+  // JSON Lines records that could not be parsed, and binary records of no
+  // known event type; they are left out of the export
+  uint64_t skipped = 0;
+};
+
+// Converts an event log of any format (binary, JSON Lines, compressed or
+// not) to options.path, which must be given and must not be the log.
+//
+// The log is read in chunks, which a pool of threads parses and formats a
+// chunk each; the chunks are written out in log order a round at a time,
+// while the next round is read, so memory stays bounded by two rounds of
+// chunks whatever the size of the log.
+//
+// The Arrow file has a record batch per chunk and the columns type
+// (dictionary-encoded string, int8 indices), truck_id, station_id (null for
+// travel and mining), start_time and end_time, all uint32. Buffers are
+// uncompressed and 8-byte aligned, so pyarrow and pandas can memory-map the
+// file and use the columns in place.
+//
+// Throws std::invalid_argument for a missing path and std::runtime_error
+// if the log cannot be read or the export written.
+EventExportResult ExportEventLog(const std::string& log_path,
+                                 const EventExportOptions& options);
+
+#endif  // INCLUDE_EVENT_EXPORT_H_
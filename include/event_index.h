@@ -0,0 +1,161 @@
+#ifndef INCLUDE_EVENT_INDEX_H_
+#define INCLUDE_EVENT_INDEX_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "event.h"
+#include "event_log.h"
+#include "minutes.h"
+
+// Sidecar index of an event log.
+//
+// The index of <log> lives in <log>.idx and splits the log into blocks of
+// consecutive events: kIndexBlockEvents records of a binary log, as many
+// lines of a JSON Lines log, or one gzip member of a compressed one. Each
+// block is described by an EventIndexEntry (where it is, the events it
+// holds, their time range and types) followed by the distinct trucks and
+// stations it mentions. Entries are only ever appended, so the EventLogger
+// writer thread keeps the index as it flushes (EventLogger::SetIndexing)
+// and a crash leaves at worst a partial last entry, which is ignored.
+//
+// An EventIndex loads the entries, inverts them into per-truck and
+// per-station posting lists of blocks, and answers an EventQuery by reading
+// only the blocks that can hold a match.
+
+inline constexpr char kEventIndexMagic[4] = {'V', 'M', 'E', 'I'};
+inline constexpr uint32_t kEventIndexVersion = 1;
+
+// Events per block written by the EventLogger and BuildEventIndex
+inline constexpr size_t kIndexBlockEvents = 4096;
+
+// File header written once at offset 0 (8 bytes).
+struct EventIndexHeader {
+  char magic[4];     // kEventIndexMagic
+  uint32_t version;  // kEventIndexVersion
+};
+static_assert(sizeof(EventIndexHeader) == 8);
+
+// One block on disk (48 bytes), followed by num_trucks truck ids and then
+// num_stations station ids, each a sorted uint32 array.
+struct EventIndexEntry {
+  uint64_t offset;       // Where the block starts in the log
+  uint64_t size;         // Bytes of the block in the log
+  uint64_t first_event;  // Events in the log before the block
+  uint32_t num_events;
+  uint32_t type_mask;  // Bit 1 << type for each EventType in the block
+  uint32_t min_start;  // Earliest start_time in the block
+  uint32_t max_end;    // Latest end_time in the block
+  uint32_t num_trucks;
+  uint32_t num_stations;
+};
+static_assert(sizeof(EventIndexEntry) == 48);
+
+// <log_path>.idx
+std::string EventIndexPath(const std::string& log_path);
+
+// Appends the entries of blocks as they are written to a log.
+class EventIndexWriter {
+ public:
+  // Continues the index at path, which already covers the log's first
+  // first_event events, or starts it afresh (truncated) if first_event is 0
+  EventIndexWriter(const std::string& path, uint64_t first_event);
+
+  EventIndexWriter(const EventIndexWriter&) = delete;
+  EventIndexWriter& operator=(const EventIndexWriter&) = delete;
+
+  // Records the block of the log at [offset, offset + size) holding records
+  void AddBlock(std::span<const EventRecord> records, uint64_t offset,
+                uint64_t size);
+
+  void Flush() { out_.flush(); }
+
+  uint64_t num_events() const { return next_event_; }
+
+ private:
+  // Appends id to ids unless already seen in this block
+  void AddId(uint32_t id, std::vector<uint64_t>* seen,
+             std::vector<uint32_t>* ids);
+
+  std::string path_;
+  std::ofstream out_;
+  uint64_t next_event_;
+  // Distinct ids of the current block, and the last block each id was in
+  uint64_t block_ = 0;
+  std::vector<uint32_t> trucks_;
+  std::vector<uint32_t> stations_;
+  std::vector<uint64_t> truck_seen_;
+  std::vector<uint64_t> station_seen_;
+};
+
+// Indexes an existing log of any format into EventIndexPath(log_path),
+// replacing any index there, and returns the number of events indexed.
+// A compressed log is indexed a gzip member at a time, whatever its members
+// hold. Lines that do not parse are left out.
+uint64_t BuildEventIndex(const std::string& log_path);
+
+// Selects events; unset fields match everything. An event matches the time
+// range if it overlaps it: start_time <= to and end_time >= from.
+struct EventQuery {
+  std::optional<EventType> type = std::nullopt;
+  std::optional<size_t> truck_id = std::nullopt;
+  std::optional<size_t> station_id = std::nullopt;
+  minutes_t from = 0min;
+  minutes_t to = minutes_t::max();
+};
+
+// Read-only view of a log through its index.
+class EventIndex {
+ public:
+  // Loads EventIndexPath(log_path) and maps the log. Throws
+  // std::runtime_error if the index is missing or describes more of the log
+  // than there is (e.g. a log rewritten since). Events flushed after the
+  // index was loaded are not seen.
+  explicit EventIndex(const std::string& log_path);
+
+  EventIndex(const EventIndex&) = delete;
+  EventIndex& operator=(const EventIndex&) = delete;
+
+  uint64_t num_events() const { return num_events_; }
+  const std::vector<EventIndexEntry>& blocks() const { return blocks_; }
+
+  // Blocks that may hold events matching query, in log order
+  std::vector<uint32_t> MatchingBlocks(const EventQuery& query) const;
+
+  // Events matching query, in log order, read from MatchingBlocks only
+  std::vector<Event> Query(const EventQuery& query) const;
+
+ private:
+  // Block ids of a posting list; empty for ids beyond the index
+  std::span<const uint32_t> Postings(const std::vector<uint32_t>& starts,
+                                     const std::vector<uint32_t>& blocks,
+                                     size_t id) const;
+  // Replaces records with the events of a block
+  void ReadBlock(const EventIndexEntry& block,
+                 std::vector<EventRecord>* records) const;
+
+  std::string log_path_;
+  std::unique_ptr<MappedFile> log_;
+  bool binary_ = false;
+  bool compressed_ = false;
+  uint64_t num_events_ = 0;
+  std::vector<EventIndexEntry> blocks_;
+
+  // Posting lists in compressed sparse row form: the blocks holding truck
+  // t are truck_blocks_[truck_starts_[t], truck_starts_[t + 1])
+  std::vector<uint32_t> truck_starts_;
+  std::vector<uint32_t> truck_blocks_;
+  std::vector<uint32_t> station_starts_;
+  std::vector<uint32_t> station_blocks_;
+};
+
+// Queries the global logger's log once every event logged so far is on
+// disk. Its index must be kept (EventLogger::SetIndexing).
+std::vector<Event> QueryEvents(const EventQuery& query);
+
+#endif  // INCLUDE_EVENT_INDEX_H_
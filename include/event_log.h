@@ -0,0 +1,195 @@
+#ifndef INCLUDE_EVENT_LOG_H_
+#define INCLUDE_EVENT_LOG_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "event.h"
+
+// Binary event log format.
+//
+// A binary log is an EventLogHeader followed by a packed array of
+// fixed-width EventRecords in emission order. All fields are stored in host
+// (little-endian) byte order so the file can be memory-mapped and read as a
+// span without any parsing.
+
+inline constexpr char kEventLogMagic[4] = {'V', 'M', 'E', 'L'};
+inline constexpr uint32_t kEventLogVersion = 1;
+
+// Station id stored for events that have no station.
+inline constexpr uint32_t kNoStation = std::numeric_limits<uint32_t>::max();
+
+// One event on disk (20 bytes).
+struct EventRecord {
+  uint32_t type;        // EventType
+  uint32_t truck_id;    // Truck that owns the event
+  uint32_t station_id;  // kNoStation if the event has no station
+  uint32_t start_time;  // Minutes since the start of the run
+  uint32_t end_time;    // Minutes since the start of the run
+};
+static_assert(sizeof(EventRecord) == 20);
+
+// File header written once at offset 0 (48 bytes).
+struct EventLogHeader {
+  char magic[4];         // kEventLogMagic
+  uint32_t version;      // kEventLogVersion
+  uint32_t record_size;  // sizeof(EventRecord)
+  uint32_t reserved;
+  uint64_t num_trucks;
+  uint64_t num_stations;
+  int64_t sim_minutes;
+  uint64_t random_seed;
+};
+static_assert(sizeof(EventLogHeader) == 48);
+
+// Conversions between the in-memory and on-disk representations.
+EventRecord ToRecord(const Event& event);
+EventRecord ToRecord(const PackedEvent& event);
+Event FromRecord(const EventRecord& record);
+EventLogHeader MakeHeader(const RunParameters& params);
+RunParameters ParamsFromHeader(const EventLogHeader& header);
+
+// Throws if the header does not describe a log this build can read.
+void ValidateHeader(const EventLogHeader& header, const std::string& filename);
+
+// Returns true if the file starts with the binary event log magic.
+bool IsBinaryEventLog(const std::string& filename);
+
+// Read-only view of a whole file, memory-mapped where the platform supports
+// it and read into memory otherwise.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Valid for the lifetime of this object
+  std::span<const char> bytes() const { return bytes_; }
+
+ private:
+  std::span<const char> bytes_;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  std::vector<char> fallback_;  // Used where mmap is unavailable
+};
+
+// Read-only view of a binary event log backed by a memory mapping.
+class MappedEventLog {
+ public:
+  explicit MappedEventLog(const std::string& filename);
+
+  MappedEventLog(const MappedEventLog&) = delete;
+  MappedEventLog& operator=(const MappedEventLog&) = delete;
+
+  const EventLogHeader& header() const { return header_; }
+  RunParameters params() const { return ParamsFromHeader(header_); }
+
+  // All records in emission order. Valid for the lifetime of this object.
+  std::span<const EventRecord> records() const { return records_; }
+
+ private:
+  MappedFile file_;
+  EventLogHeader header_{};
+  std::span<const EventRecord> records_;
+};
+
+// Compressed JSON Lines logs.
+//
+// A compressed log is a series of gzip members, one per batch the writer
+// thread flushes, so a resumed run can append to it and gzip, zcat or
+// Python's gzip module read it as a single stream. Compression trades the
+// memory-mapped reads of the binary format for a much smaller file.
+
+inline constexpr int kDefaultCompressionLevel = 6;
+
+// Returns true if the file starts with the gzip magic.
+bool IsCompressedEventLog(const std::string& filename);
+
+struct z_stream_s;
+struct gzFile_s;
+
+// Compresses blocks of text into gzip members, reusing one deflate state.
+class BlockCompressor {
+ public:
+  // level runs from 1 (fastest) to 9 (smallest); throws
+  // std::invalid_argument otherwise
+  explicit BlockCompressor(int level = kDefaultCompressionLevel);
+  ~BlockCompressor();
+
+  BlockCompressor(const BlockCompressor&) = delete;
+  BlockCompressor& operator=(const BlockCompressor&) = delete;
+
+  // Replaces out with text compressed as one gzip member (several for
+  // text beyond 1 GiB)
+  void Compress(std::string_view text, std::string* out);
+
+  int level() const { return level_; }
+
+ private:
+  int level_;
+  std::unique_ptr<z_stream_s> stream_;
+};
+
+// Reads the lines of a JSON Lines log, decompressing it if compressed.
+class EventLogLineReader {
+ public:
+  explicit EventLogLineReader(const std::string& filename);
+  ~EventLogLineReader();
+
+  EventLogLineReader(const EventLogLineReader&) = delete;
+  EventLogLineReader& operator=(const EventLogLineReader&) = delete;
+
+  // Reads the next line without its newline (returns false if no more). A
+  // compressed log cut off mid-member (e.g. crash mid-flush) ends at its
+  // last whole line.
+  bool ReadLine(std::string* line);
+
+  // Replaces text with the next whole lines, about max_bytes of them (more
+  // if a single line is longer), newlines included; returns false if no
+  // more. For reading a log in chunks; do not mix with ReadLine.
+  bool ReadLines(size_t max_bytes, std::string* text);
+
+ private:
+  // Reads into text until it holds size bytes; returns false at the end of
+  // the log
+  bool Fill(size_t size, std::string* text);
+
+  std::string filename_;
+  gzFile_s* file_;
+  std::string pending_;  // Start of the line ReadLines stopped in
+};
+
+// Decompresses the gzip member bytes starts with into text (replacing it).
+// Returns the compressed size of the member, or 0 if bytes ends first (a
+// member cut off mid-flush); throws if it is corrupt.
+size_t DecompressMember(std::span<const char> bytes, std::string* text);
+
+// Decompresses a whole compressed log into memory, ending at its last whole
+// line like EventLogLineReader.
+std::string DecompressEventLog(const std::string& filename);
+
+// Converts a JSON Lines log (compressed or not) to the binary format. The
+// run parameters are not part of the JSON Lines format, so the caller
+// supplies them.
+void ConvertJsonLinesToBinary(const std::string& jsonl_path,
+                              const std::string& binary_path,
+                              const RunParameters& params = {});
+
+// Converts a binary log back to JSON Lines (e.g. for plot_report.py).
+void ConvertBinaryToJsonLines(const std::string& binary_path,
+                              const std::string& jsonl_path);
+
+// Cuts a log of either format, compressed or not, back to its first count
+// events, e.g. when a run is resumed from a checkpoint taken before the log
+// ends. A compressed log is rewritten, and a sidecar index (see
+// event_index.h) removed. Throws if it holds fewer.
+void TruncateEventLog(const std::string& filename, uint64_t count);
+
+#endif  // INCLUDE_EVENT_LOG_H_
@@ -0,0 +1,86 @@
+#ifndef INCLUDE_EVENT_SINK_H_
+#define INCLUDE_EVENT_SINK_H_
+
+#include <concepts>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "event.h"
+
+// Receives the events emitted by a Controller. The sink is a template
+// parameter of the controller, so calls are resolved (and usually inlined)
+// at compile time; an empty sink such as NullEventSink costs nothing.
+// OnRunStart begins each run; OnRunEnd corrects its parameters when it
+// stopped before sim_time (see BasicController::SetSteadyState).
+template <typename S>
+concept EventSink = requires(S sink, const Event& event,
+                             const RunParameters& params) {
+  sink.OnRunStart(params);
+  sink.OnEvent(event);
+  sink.OnRunEnd(params);
+};
+
+// Discards every event. Use when only the metrics are needed.
+struct NullEventSink {
+  void OnRunStart(const RunParameters&) {}
+  void OnEvent(const Event&) {}
+  void OnRunEnd(const RunParameters&) {}
+};
+
+// Collects the events of the latest run in memory, in emission order.
+class VectorEventSink {
+ public:
+  void OnRunStart(const RunParameters& params) {
+    params_ = params;
+    events_.clear();
+  }
+  void OnEvent(const Event& event) { events_.push_back(event); }
+  void OnRunEnd(const RunParameters& params) { params_ = params; }
+
+  const RunParameters& params() const { return params_; }
+  const std::vector<Event>& events() const { return events_; }
+
+ private:
+  RunParameters params_;
+  std::vector<Event> events_;
+};
+
+// Forwards events to an EventLogger (the global events.json by default).
+class FileEventSink {
+ public:
+  FileEventSink() : logger_(&GetEventLogger()) {}
+  explicit FileEventSink(EventLogger* logger) : logger_(logger) {}
+
+  void OnRunStart(const RunParameters& params) {
+    logger_->SetRunParameters(params);
+  }
+  void OnEvent(const Event& event) { logger_->LogEvent(event); }
+  void OnRunEnd(const RunParameters& params) {
+    logger_->SetRunParameters(params);
+  }
+
+ private:
+  EventLogger* logger_;
+};
+
+// Invokes a user-supplied callback for every event.
+class CallbackEventSink {
+ public:
+  using Callback = std::function<void(const Event&)>;
+
+  CallbackEventSink() = default;
+  explicit CallbackEventSink(Callback callback)
+      : callback_(std::move(callback)) {}
+
+  void OnRunStart(const RunParameters&) {}
+  void OnEvent(const Event& event) {
+    if (callback_) callback_(event);
+  }
+  void OnRunEnd(const RunParameters&) {}
+
+ private:
+  Callback callback_;
+};
+
+#endif  // INCLUDE_EVENT_SINK_H_
@@ -13,6 +13,12 @@ class Logger {
  public:
   static void Init(std::string filename = "");
 
+  // True if trace messages are currently emitted. Check this before building
+  // an expensive trace message.
+  static bool TraceEnabled() {
+    return spdlog::should_log(spdlog::level::trace);
+  }
+
   template <typename T>
   static void LogTrace(const T& msg) {
     spdlog::trace("{}", msg);
@@ -0,0 +1,72 @@
+#ifndef INCLUDE_METRICS_EXPORT_H_
+#define INCLUDE_METRICS_EXPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "minutes.h"
+
+class MetricsStore;  // metrics_store.h
+
+// Encodings of the metrics report.
+enum class MetricsFormat {
+  Json,         // Indented JSON, one object per truck and station
+  CompactJson,  // The same document without whitespace
+  Csv,          // One row per truck and station (see WriteMetricsReport)
+  Columnar,     // Binary columns (see MetricsColumnsHeader)
+};
+
+// Parses json, compact, csv or columnar. Throws std::invalid_argument.
+MetricsFormat MetricsFormatFromString(const std::string& name);
+
+// Where and how a controller writes its metrics report.
+struct MetricsExportOptions {
+  MetricsFormat format = MetricsFormat::Json;
+  std::string path;        // Empty: DefaultMetricsPath
+  size_t num_threads = 0;  // Threads formatting text rows (0: all cores)
+};
+
+// metrics.<N>truck_<M>station_<T>min_minutes.<json|csv|bin>
+std::string DefaultMetricsPath(size_t num_trucks, size_t num_stations,
+                               minutes_t sim_time, MetricsFormat format);
+
+// Binary columnar report: this header, then a MetricsColumnDescriptor per
+// column, then the columns themselves, each a packed little-endian array of
+// num_trucks or num_stations values. Columns are the derived MetricsStore
+// columns the JSON report holds, truck columns first.
+inline constexpr char kMetricsColumnsMagic[4] = {'V', 'M', 'M', 'C'};
+inline constexpr uint32_t kMetricsColumnsVersion = 2;
+
+struct MetricsColumnsHeader {
+  char magic[4];         // kMetricsColumnsMagic
+  uint32_t version;      // kMetricsColumnsVersion
+  uint32_t num_columns;  // Descriptors that follow
+  uint32_t reserved;
+  uint64_t num_trucks;
+  uint64_t num_stations;
+  int64_t sim_minutes;
+};
+static_assert(sizeof(MetricsColumnsHeader) == 40);
+
+struct MetricsColumnDescriptor {
+  char name[24];    // NUL-padded field name, as in the JSON report
+  uint32_t table;   // 0: trucks, 1: stations
+  uint32_t type;    // 0: int32, 1: float64, 2: int64
+  uint64_t offset;  // Of the column's first value, from the file start
+};
+static_assert(sizeof(MetricsColumnDescriptor) == 40);
+
+// Writes the report of a finished run (the derived columns must be filled,
+// see MetricsStore::Derive) and returns the path written.
+//
+// Text rows are formatted straight from the columns, without building a
+// document, by a pool of threads a chunk each, and written out chunk by
+// chunk in order, so memory stays bounded by one round of chunks. CSV has a
+// "table" column (truck or station) and the union of both tables' fields,
+// empty where a field does not apply. Throws std::runtime_error if the file
+// cannot be written.
+std::string WriteMetricsReport(minutes_t sim_time, const MetricsStore& metrics,
+                               const MetricsExportOptions& options = {});
+
+#endif  // INCLUDE_METRICS_EXPORT_H_
@@ -0,0 +1,125 @@
+#ifndef INCLUDE_METRICS_STORE_H_
+#define INCLUDE_METRICS_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "minutes.h"
+#include "report.h"
+
+// Struct-of-arrays form of TruckMetrics/StationMetrics: one contiguous
+// column per field, so an event touches only the one or two columns it
+// updates and the derivation and summary passes stream through the columns
+// they read.
+//
+// Times and counts are 32-bit (a run is limited to 2^31 minutes), which lets
+// the per-element loops in Derive and the reductions compile to SIMD
+// instructions (they are written without branches for that reason). A
+// station's times are 64-bit: its queueing time adds up the waits of every
+// truck queued there, which grows with the trucks per station as well as
+// the run, and its other times follow it.
+class MetricsStore {
+ public:
+  struct TruckColumns {
+    std::vector<int32_t> mining_time;
+    std::vector<int32_t> travel_time;
+    std::vector<int32_t> queueing_time;
+    std::vector<int32_t> unloading_time;
+    std::vector<int32_t> trips_completed;
+    std::vector<int32_t> mines_completed;
+    std::vector<int32_t> queues_completed;
+
+    // Derived by Derive()
+    std::vector<int32_t> idle_time;
+    std::vector<double> utilization;
+    std::vector<double> avg_trip_time;
+    std::vector<double> avg_queueing_time;
+  };
+
+  struct StationColumns {
+    std::vector<int64_t> unloading_time;
+    std::vector<int64_t> queueing_time;
+    std::vector<int32_t> throughput;
+    std::vector<int32_t> queues_completed;
+
+    // Derived by Derive()
+    std::vector<int64_t> idle_time;
+    std::vector<double> utilization;
+    std::vector<double> avg_queueing_time;
+  };
+
+  // Longest run the 32-bit columns can hold
+  static constexpr minutes_t kMaxSimTime = minutes_t(INT32_MAX);
+
+  // Zeroes every column for a new run
+  void Reset(size_t num_trucks, size_t num_stations);
+
+  size_t num_trucks() const { return trucks_.mining_time.size(); }
+  size_t num_stations() const { return stations_.unloading_time.size(); }
+  const TruckColumns& trucks() const { return trucks_; }
+  const StationColumns& stations() const { return stations_; }
+
+  // Per-event updates
+  void AddMining(size_t truck_id, minutes_t duration) {
+    trucks_.mining_time[truck_id] += static_cast<int32_t>(duration.count());
+    ++trucks_.mines_completed[truck_id];
+  }
+  void AddTravel(size_t truck_id, minutes_t duration) {
+    trucks_.travel_time[truck_id] += static_cast<int32_t>(duration.count());
+  }
+  void AddQueueing(size_t truck_id, size_t station_id, minutes_t duration) {
+    AddTruckQueueing(truck_id, duration);
+    AddStationQueueing(station_id, duration);
+  }
+  void AddUnloading(size_t truck_id, size_t station_id, minutes_t duration) {
+    AddTruckUnloading(truck_id, duration);
+    AddStationUnloading(station_id, duration);
+  }
+
+  // The truck and station halves of the above, for callers that update the
+  // two sides from different threads (see ParallelController)
+  void AddTruckQueueing(size_t truck_id, minutes_t duration) {
+    trucks_.queueing_time[truck_id] += static_cast<int32_t>(duration.count());
+    ++trucks_.queues_completed[truck_id];
+  }
+  void AddStationQueueing(size_t station_id, minutes_t duration) {
+    stations_.queueing_time[station_id] += duration.count();
+    ++stations_.queues_completed[station_id];
+  }
+  void AddTruckUnloading(size_t truck_id, minutes_t duration) {
+    trucks_.unloading_time[truck_id] += static_cast<int32_t>(duration.count());
+    ++trucks_.trips_completed[truck_id];
+  }
+  void AddStationUnloading(size_t station_id, minutes_t duration) {
+    stations_.unloading_time[station_id] += duration.count();
+    ++stations_.throughput[station_id];
+  }
+
+  // Fills the derived columns; the column form of GenerateMetrics
+  void Derive(minutes_t sim_time);
+
+  // Fleet-wide means of the derived utilization columns (in %)
+  double AverageTruckUtilization() const;
+  double AverageStationUtilization() const;
+
+  // Adapters to and from the per-object representation
+  void ToMetrics(std::vector<TruckMetrics>* trucks,
+                 std::vector<StationMetrics>* stations) const;
+  static MetricsStore FromMetrics(const std::vector<TruckMetrics>& trucks,
+                                  const std::vector<StationMetrics>& stations);
+
+  // Adopts accumulated columns (e.g. read from a checkpoint); the derived
+  // columns are sized to match and left for Derive
+  static MetricsStore FromColumns(TruckColumns trucks, StationColumns stations);
+
+ private:
+  TruckColumns trucks_;
+  StationColumns stations_;
+};
+
+// Column sums, accumulated in independent lanes so they vectorize
+int64_t SumColumn(const std::vector<int32_t>& column);
+double SumColumn(const std::vector<double>& column);
+
+#endif  // INCLUDE_METRICS_STORE_H_
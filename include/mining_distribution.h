@@ -0,0 +1,116 @@
+#ifndef INCLUDE_MINING_DISTRIBUTION_H_
+#define INCLUDE_MINING_DISTRIBUTION_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "counter_rng.h"
+#include "minutes.h"
+
+// Distribution of mining durations over whole minutes in [min, max],
+// configured at runtime and sampled from a CounterRng stream.
+//
+// Every shape except Uniform is discretized once, when it is built, into a
+// probability per minute of the range (a continuous shape is rounded to the
+// nearest minute and truncated to the range), and then sampled with Walker's
+// alias method: one Philox block picks a minute of the range and decides
+// between it and its alias, so a draw costs the same two table reads
+// whatever the shape. Uniform draws with CounterRng::UniformInt directly.
+class MiningDistribution {
+ public:
+  enum class Kind { Uniform, Triangular, Lognormal, Empirical };
+
+  // Equally likely whole minutes (the default)
+  static MiningDistribution Uniform(minutes_t min, minutes_t max);
+
+  // Triangular with the given mode, min <= mode <= max
+  static MiningDistribution Triangular(minutes_t min, minutes_t mode,
+                                       minutes_t max);
+
+  // Lognormal with the given median (e^mu) and shape sigma > 0, truncated
+  // to [min, max]
+  static MiningDistribution Lognormal(double median, double sigma,
+                                      minutes_t min, minutes_t max);
+
+  // Histogram of field data: each bin's weight is spread evenly over the
+  // minutes from..to (inclusive). The range is that of the bins.
+  struct Bin {
+    minutes_t from;
+    minutes_t to;
+    double weight;
+  };
+  static MiningDistribution Empirical(const std::vector<Bin>& bins);
+
+  // Reads Empirical bins from a text file with one "<from> <to> <weight>"
+  // or "<minutes> <weight>" line per bin; '#' starts a comment
+  static MiningDistribution FromHistogramFile(const std::string& filename);
+
+  // Parses a --mining option value; min and max are the defaults of the
+  // range where the spec does not give one:
+  //   uniform[:<min>:<max>]
+  //   triangular:<mode>[:<min>:<max>]
+  //   lognormal:<median>:<sigma>[:<min>:<max>]
+  //   empirical:<histogram file>
+  // Throws std::invalid_argument on anything else.
+  static MiningDistribution Parse(const std::string& spec, minutes_t min,
+                                  minutes_t max);
+
+  // Draw index of stream, as CounterRng::UniformInt
+  minutes_t Sample(const CounterRng& rng, uint32_t stream,
+                   uint32_t index) const {
+    if (columns_.empty()) {
+      return minutes_t(rng.UniformInt(stream, index, min_, max_));
+    }
+    const auto range = static_cast<uint32_t>(columns_.size());
+    const uint32_t threshold = (0u - range) % range;
+    // Lemire's multiply-shift (as in UniformInt) on the first three words
+    // for the column, the fourth for the coin
+    for (uint32_t block = 0;; ++block) {
+      const auto words = rng.Block(stream, index, block);
+      for (size_t i = 0; i < 3; ++i) {
+        const uint64_t product = uint64_t{words[i]} * range;
+        if (static_cast<uint32_t>(product) >= threshold) {
+          const auto offset = static_cast<uint32_t>(product >> 32);
+          const Column& column = columns_[offset];
+          return minutes_t(
+              min_ + (words[3] < column.threshold ? offset : column.alias));
+        }
+      }
+    }
+  }
+
+  Kind kind() const { return kind_; }
+  minutes_t min() const { return minutes_t(min_); }
+  minutes_t max() const { return minutes_t(max_); }
+
+  // Probability of each minute of [min, max]
+  std::vector<double> Probabilities() const;
+
+  // Spec that Parse reads back into the same distribution; an Empirical one
+  // names its histogram file ("empirical" alone if it was built from bins)
+  std::string Describe() const;
+
+ private:
+  // Alias table entry: the column's own minute is kept if the coin is below
+  // threshold (out of 2^32), otherwise it is replaced by alias
+  struct Column {
+    uint64_t threshold;
+    uint32_t alias;
+  };
+
+  MiningDistribution(Kind kind, uint32_t min, uint32_t max)
+      : kind_(kind), min_(min), max_(max) {}
+
+  // Builds the alias table from a weight per minute of the range
+  void BuildAliasTable(const std::vector<double>& weights);
+
+  Kind kind_ = Kind::Uniform;
+  uint32_t min_ = 0;
+  uint32_t max_ = 0;
+  std::vector<Column> columns_;  // Empty for Uniform
+  std::vector<double> probabilities_;  // Empty for Uniform
+  std::string parameters_;  // Describe() after the kind
+};
+
+#endif  // INCLUDE_MINING_DISTRIBUTION_H_
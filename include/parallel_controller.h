@@ -0,0 +1,161 @@
+#ifndef INCLUDE_PARALLEL_CONTROLLER_H_
+#define INCLUDE_PARALLEL_CONTROLLER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "controller.h"
+#include "counter_rng.h"
+#include "metrics_export.h"
+#include "metrics_store.h"
+#include "mining_distribution.h"
+#include "thread_pool.h"
+#include "time_series.h"
+
+// Multi-threaded engine for a single run. For the same seed it produces
+// metrics and a time series identical, bit for bit, to Controller's; events
+// are not logged (as with NullEventSink).
+//
+// Trucks are split into contiguous groups, one per worker thread, and each
+// group advances its trucks on its own scheduler. Mining durations come from
+// each truck's own random stream (see CounterRng), so trucks only interact
+// through the station queue, which is only used at the end of a kTravelTime
+// leg that was scheduled at least kTravelTime earlier. Simulated time is
+// therefore processed in epochs of kTravelTime:
+//   1. In parallel, each group applies the outcome of the previous epoch's
+//      step 3 to its trucks, then advances them to the end of the epoch. It
+//      handles finished mining and unloading itself and sets aside the
+//      trucks that arrive at a station or return to the mine.
+//   2. In parallel, one task per minute of the epoch, the set-aside trucks
+//      are put in the order the sequential engine handles them.
+//   3. Serially, the arrivals are assigned stations and the returns
+//      numbered, in that order.
+//
+// That order is time first, then scheduling order. Each truck carries the
+// sequence number of the return to the mine (while mining and travelling to
+// a station) or station assignment (while unloading and travelling back)
+// that started its current cycle half; those numbers are handed out in
+// processing order, so sorting the set-aside trucks by (time, sequence
+// number) reproduces the sequential order exactly. Each group sets its
+// trucks aside in that order already, so step 2 only merges one run per
+// group.
+class ParallelController {
+ public:
+  using Timing = Controller;  // Source of the timing constants
+  static constexpr minutes_t kEpoch = Timing::kTravelTime;
+  static constexpr size_t kEpochMinutes = static_cast<size_t>(kEpoch.count());
+
+  // 0 threads = std::thread::hardware_concurrency()
+  ParallelController(size_t num_trucks, size_t num_stations,
+                     size_t random_seed = 0xBEEF, size_t num_threads = 0);
+  ~ParallelController();
+
+  // As in BasicController
+  void Run(minutes_t sim_time);
+  void Simulate(minutes_t sim_time);
+  void SetTimeSeriesInterval(minutes_t interval) {
+    time_series_interval_ = interval;
+  }
+  void SetMetricsExport(MetricsExportOptions options) {
+    metrics_export_ = std::move(options);
+  }
+
+  // As in BasicController, except that mining must take at least kEpoch:
+  // a truck that returns to the mine in one epoch cannot finish mining
+  // before the next. Throws std::invalid_argument otherwise.
+  void SetMiningDistribution(MiningDistribution distribution);
+
+  size_t num_threads() const { return pool_.num_threads(); }
+  const MetricsStore& metrics() const { return metrics_; }
+  const TimeSeries& time_series() const { return time_series_; }
+  const EngineStats& stats() const { return stats_; }
+
+ private:
+  // A truck set aside by its group for step 3: an arrival at a
+  // station or a return to the mine, at time, with the truck's sequence
+  // number
+  struct Request {
+    uint32_t truck_id;
+    uint32_t time;
+    uint64_t sequence;
+  };
+
+  // Outcomes of step 3, handed back to the truck's group
+  struct MiningStart {
+    uint32_t truck_id;
+    uint32_t start_time;
+    uint64_t draw;  // Sequence number
+  };
+  struct UnloadStart {
+    uint32_t truck_id;
+    uint32_t station_id;
+    uint32_t arrival_time;  // Queued until start_time if earlier
+    uint32_t start_time;
+    uint64_t assignment;  // Sequence number
+  };
+
+  struct Group;  // The trucks of one worker, defined in the .cpp
+
+  // Step 1 for one group, up to (not including) limit
+  void AdvanceGroup(Group* group, minutes_t limit);
+
+  // Step 2, into arrivals_ and returns_
+  void OrderRequests();
+
+  // Step 3
+  void AssignStations();
+  void NumberReturns();
+
+  // Truck transitions, as in BasicController; the group's stats count the
+  // events emitted and processed
+  void StartMining(Group* group, const MiningStart& start);
+  void StartUnloading(Group* group, const UnloadStart& start,
+                      minutes_t epoch_start);
+  void TravelToStation(Group* group, size_t truck_id, minutes_t start_time);
+  void TravelToMine(Group* group, size_t truck_id, minutes_t start_time);
+  void EmitEvent(Group* group, EventType type, size_t truck_id,
+                 uint32_t station_id, minutes_t start, minutes_t end);
+
+  bool ExceedsSimTime(minutes_t time, EngineStats* stats) const;
+  Group& GroupOf(size_t truck_id) { return *groups_[truck_id / group_size_]; }
+
+  // Configuration and state
+  size_t num_trucks_ = 0;
+  size_t num_stations_ = 0;
+  size_t random_seed_ = 0;
+  minutes_t sim_duration_ = 0min;
+  CounterRng rng_;
+  MiningDistribution mining_distribution_ =
+      MiningDistribution::Uniform(Timing::kMinDuration, Timing::kMaxDuration);
+
+  WorkStealingPool pool_;
+  size_t group_size_ = 1;  // Trucks per group
+  std::vector<std::unique_ptr<Group>> groups_;
+
+  // The epoch's set-aside trucks in sequential order
+  std::vector<Request> arrivals_;
+  std::vector<Request> returns_;
+
+  // Shared state, only touched in step 3
+  StationQueue station_queue_;
+  uint64_t next_draw_ = 0;
+  uint64_t next_assignment_ = 0;
+
+  // Sequence number of each truck's current cycle half. Trucks are written
+  // by their group only; the groups share the truck columns of metrics_ the
+  // same way, while the station columns are written in step 3.
+  std::vector<uint64_t> sequence_;
+  MetricsStore metrics_;
+  MetricsExportOptions metrics_export_;
+
+  // Station activity is recorded here in step 3, truck activity per group
+  // and added at the end of the run
+  minutes_t time_series_interval_ = 0min;
+  TimeSeries time_series_;
+
+  EngineStats stats_;
+  WaitingTrucks waiting_trucks_;  // Only with stats
+};
+
+#endif  // INCLUDE_PARALLEL_CONTROLLER_H_
@@ -0,0 +1,188 @@
+#ifndef INCLUDE_REPLICATION_H_
+#define INCLUDE_REPLICATION_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "minutes.h"
+#include "mining_distribution.h"
+#include "report.h"
+#include "shard.h"
+
+// Running mean and variance of one metric across replications (Welford).
+class RunningStat {
+ public:
+  void Add(double value);
+
+  size_t count() const { return count_; }
+  double mean() const { return mean_; }
+
+  // Sample variance (n - 1 denominator); 0 with fewer than two samples
+  double variance() const;
+
+  // Half-width of the 95% confidence interval for the mean (Student's t);
+  // infinite with fewer than two samples
+  double HalfWidth() const;
+
+  // Sum of squared deviations from the mean
+  double m2() const { return m2_; }
+
+  // The stat of count values with this mean and m2, e.g. as read back from
+  // a shard's partial result
+  static RunningStat FromMoments(size_t count, double mean, double m2);
+
+  // Adds the values other has seen (Chan et al.'s pairwise update), which
+  // gives the same moments up to rounding
+  void Merge(const RunningStat& other);
+
+ private:
+  size_t count_ = 0;
+  double mean_ = 0.0;
+  double m2_ = 0.0;  // Sum of squared deviations from the mean
+};
+
+// Counts of values in equal-width bins over [min, max]; values outside are
+// counted in the first or last bin. Histograms with the same bins merge by
+// adding counts.
+class Histogram {
+ public:
+  Histogram(double min, double max, size_t num_bins);
+  Histogram(double min, double max, std::vector<uint64_t> counts);
+
+  void Add(double value);
+
+  // Throws std::invalid_argument if other has other bins
+  void Merge(const Histogram& other);
+
+  double min() const { return min_; }
+  double max() const { return max_; }
+  const std::vector<uint64_t>& counts() const { return counts_; }
+
+ private:
+  double min_;
+  double max_;
+  std::vector<uint64_t> counts_;
+};
+
+// Per-truck metrics aggregated across replications, field for field.
+struct TruckReplicationStats {
+  RunningStat utilization;
+  RunningStat trips_completed;
+  RunningStat mines_completed;
+  RunningStat queues_completed;
+  RunningStat idle_time;
+  RunningStat mining_time;
+  RunningStat queueing_time;
+  RunningStat unloading_time;
+  RunningStat travel_time;
+  RunningStat avg_trip_time;
+  RunningStat avg_queueing_time;
+
+  void Add(const TruckMetrics& metrics);
+};
+
+// Per-station metrics aggregated across replications, field for field.
+struct StationReplicationStats {
+  RunningStat utilization;
+  RunningStat throughput;
+  RunningStat queues_completed;
+  RunningStat idle_time;
+  RunningStat unloading_time;
+  RunningStat queueing_time;
+  RunningStat avg_queueing_time;
+
+  void Add(const StationMetrics& metrics);
+};
+
+struct ReplicationOptions {
+  size_t num_trucks = 0;
+  size_t num_stations = 0;
+  minutes_t sim_time = 72 * 60min;
+
+  size_t min_replications = 5;   // Never stop before this many
+  size_t max_replications = 30;  // Upper bound on replications run
+  uint64_t base_seed = 0xBEEF;   // Seeds derive from this, see below
+  size_t num_threads = 0;        // 0 = std::thread::hardware_concurrency()
+
+  // Unset: the controller's default, uniform mining durations
+  std::optional<MiningDistribution> mining_distribution;
+
+  // Stop once the 95% CI half-widths of the fleet-average truck and station
+  // utilization (in percentage points) are both at most this. 0 disables
+  // early stopping, so exactly max_replications are run.
+  double target_half_width = 0.0;
+
+  // Run only this shard's share of the max_replications replications (see
+  // shard.h); early stopping needs them all, so is not allowed with shards
+  ShardSpec shard;
+};
+
+// Utilization histograms have a bin per percentage point
+inline constexpr size_t kUtilizationBins = 100;
+
+struct ReplicationResult {
+  size_t replications = 0;  // Replications aggregated
+  bool converged = false;   // Stopped early on target_half_width
+
+  // Describe() of the mining distribution; empty for the default
+  std::string mining_distribution;
+
+  // Fleet averages of each replication (the early-stopping criterion), and
+  // their distribution
+  RunningStat truck_utilization;
+  RunningStat station_utilization;
+  Histogram truck_utilization_histogram{0.0, 100.0, kUtilizationBins};
+  Histogram station_utilization_histogram{0.0, 100.0, kUtilizationBins};
+
+  std::vector<TruckReplicationStats> trucks;
+  std::vector<StationReplicationStats> stations;
+};
+
+// Seed of replication k: SplitMix64 of (base_seed + k). Depends only on the
+// base seed and k, so any replication can be rerun on its own.
+uint64_t ReplicationSeed(uint64_t base_seed, size_t replication);
+
+// Runs independent metrics-only simulations with ReplicationSeed seeds on a
+// pool of worker threads and aggregates their metrics. Replications are
+// aggregated, and checked against the stopping rule, in index order, so the
+// result does not depend on the number of threads. With a shard, only the
+// shard's replications are run, with the seeds they have in the whole
+// batch. Throws std::invalid_argument if options are inconsistent.
+ReplicationResult RunReplications(const ReplicationOptions& options);
+
+// Prints the fleet-level means and confidence intervals to stdout.
+void PrintReplicationSummary(const ReplicationOptions& options,
+                             const ReplicationResult& result);
+
+// Writes the aggregated metrics (mean, variance and CI half-width of every
+// field) to a JSON file and returns its name.
+std::string ExportReplicationsToJson(const ReplicationOptions& options,
+                                     const ReplicationResult& result);
+
+// A shard's partial result: the options it was run with (the mining
+// distribution only by name, in result) and its mergeable statistics.
+struct ReplicationShard {
+  ReplicationOptions options;
+  ReplicationResult result;
+};
+
+// Writes the result of a sharded batch as a partial result
+// (replications.<...>_minutes.shard<i>of<n>.json) with the count, mean and
+// sum of squared deviations of every statistic, and returns its name.
+std::string WriteReplicationShard(const ReplicationOptions& options,
+                                  const ReplicationResult& result);
+
+// Reads a file written by WriteReplicationShard. Throws std::runtime_error
+// if it is not one.
+ReplicationShard ReadReplicationShard(const std::string& filename);
+
+// Combines shards of one batch, in shard order, into the result of the
+// replications they ran; with every shard, that of the unsharded batch up
+// to rounding. options becomes the batch's. Throws std::invalid_argument if
+// there are none, one is repeated, or they come from different batches.
+ReplicationResult MergeReplicationShards(
+    const std::vector<ReplicationShard>& shards, ReplicationOptions* options);
+
+#endif  // INCLUDE_REPLICATION_H_
@@ -5,6 +5,8 @@
 
 #include <vector>
 
+#include "event_export.h"
+#include "metrics_export.h"
 #include "minutes.h"
 
 // Aggregated performance statistics for a single truck over the simulation.
@@ -41,18 +43,56 @@ struct StationMetrics {
 void GenerateMetrics(minutes_t sim_time, std::vector<TruckMetrics>* trucks,
                      std::vector<StationMetrics>* stations);
 
+// Steady-state solution of the closed queueing network formed by the truck
+// cycle (mine -> travel -> unload at one of c stations -> travel).
+struct QueueingEstimate {
+  double throughput = 0.0;           // Unloads per minute, whole fleet
+  double cycle_time = 0.0;           // Minutes per truck cycle
+  double station_utilization = 0.0;  // Fraction of time a station is busy
+  double wait_probability = 0.0;     // Fraction of arrivals that queue
+  double mean_wait = 0.0;            // Minutes queued per arrival
+};
+
+// Solves the network with mean value analysis: mining and travel are
+// infinite-server delays, and the c deterministic stations are approximated
+// by one server of rate c (Seidmann) with a deterministic residual service
+// time. The wait is capped by the open M/D/c value, which is tighter at
+// light load. O(num_trucks + num_stations).
+QueueingEstimate EstimateQueueing(size_t num_trucks, size_t num_stations);
+
+// Fills in expected truck and station metrics for a run of sim_time from
+// EstimateQueueing, without simulating. Counts and times are rounded to the
+// nearest unit, and derived fields come from GenerateMetrics, so the result
+// has the same shape as a simulation's.
+void EstimateMetrics(size_t num_trucks, size_t num_stations,
+                     minutes_t sim_time, std::vector<TruckMetrics>* trucks,
+                     std::vector<StationMetrics>* stations);
+
+class MetricsStore;  // metrics_store.h
+
 // Outputs an overall summary (e.g., average utilization) to stdout.
 void PrintMetricsSummary(const std::vector<TruckMetrics>& trucks,
                          const std::vector<StationMetrics>& stations,
                          minutes_t sim_time);
+void PrintMetricsSummary(const MetricsStore& metrics, minutes_t sim_time);
 
 // Exports a detailed report to a JSON file (1 truck/station entry per object).
 void ExportMetricsToJson(minutes_t sim_time,
                          const std::vector<TruckMetrics>& trucks,
                          const std::vector<StationMetrics>& stations);
+void ExportMetricsToJson(minutes_t sim_time, const MetricsStore& metrics);
+
+// Writes the report as options say (see WriteMetricsReport), then prints
+// the summary and where the report went.
+void ExportMetrics(minutes_t sim_time, const MetricsStore& metrics,
+                   const MetricsExportOptions& options = {});
 
-// Optional: dump all raw events to a JSON file (not used in your main code).
+// Converts the global event log (see GetEventLogger), once every event
+// logged so far is written, as options say (see ExportEventLog), then
+// prints where the export went. An empty options.path means
+// DefaultEventExportPath.
 void ExportAllEventsToJson(size_t num_trucks, size_t num_stations,
-                           minutes_t sim_time);
+                           minutes_t sim_time,
+                           const EventExportOptions& options = {});
 
 #endif  // INCLUDE_REPORT_H_
@@ -0,0 +1,83 @@
+#ifndef INCLUDE_RING_BUFFER_H_
+#define INCLUDE_RING_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer/single-consumer ring buffer.
+//
+// Exactly one thread may call TryPush/WaitForSpace and exactly one (other)
+// thread may call PopBatch. Head and tail are free-running counters, so the
+// number of elements pushed so far doubles as a sequence number.
+template <typename T>
+class SpscRingBuffer {
+ public:
+  // Capacity is rounded up to the next power of two.
+  explicit SpscRingBuffer(size_t capacity)
+      : slots_(std::bit_ceil(std::max<size_t>(capacity, 2))),
+        mask_(slots_.size() - 1) {}
+
+  size_t capacity() const { return slots_.size(); }
+
+  size_t Size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  // Producer: appends a value, or returns false if the ring is full.
+  bool TryPush(const T& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == slots_.size()) return false;
+    }
+    slots_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer: blocks until the consumer has made room for one element.
+  void WaitForSpace() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    while (tail_.load(std::memory_order_relaxed) - head == slots_.size()) {
+      head_.wait(head, std::memory_order_acquire);
+      head = head_.load(std::memory_order_acquire);
+    }
+  }
+
+  // Consumer: moves up to max_count elements to the end of out and returns
+  // how many were moved.
+  size_t PopBatch(std::vector<T>* out, size_t max_count) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t count = std::min(tail - head, max_count);
+    for (size_t i = 0; i < count; ++i) {
+      out->push_back(slots_[(head + i) & mask_]);
+    }
+    if (count > 0) {
+      head_.store(head + count, std::memory_order_release);
+      head_.notify_all();  // Wake a producer blocked in WaitForSpace
+    }
+    return count;
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::vector<T> slots_;
+  const size_t mask_;
+
+  // Consumer-owned read position
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+
+  // Producer-owned write position and its last observed read position
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+};
+
+#endif  // INCLUDE_RING_BUFFER_H_
@@ -0,0 +1,59 @@
+#ifndef INCLUDE_SCENARIO_H_
+#define INCLUDE_SCENARIO_H_
+
+#include <string>
+#include <vector>
+
+#include "minutes.h"
+#include "mining_distribution.h"
+#include "timing.h"
+
+// A fleet described by classes of trucks and groups of stations, each with
+// its own timing. Truck ids are handed out class by class in order (the
+// first class gets ids 0 to count - 1, and so on), and station ids group by
+// group.
+struct Scenario {
+  struct TruckClass {
+    std::string name;
+    size_t count = 0;
+    minutes_t travel_time = FixedTiming::kTravelTime;  // Each way
+    MiningDistribution mining = MiningDistribution::Uniform(
+        FixedTiming::kMinDuration, FixedTiming::kMaxDuration);
+  };
+  struct StationGroup {
+    size_t count = 0;
+    minutes_t unload_time = FixedTiming::kUnloadTime;
+  };
+
+  std::vector<TruckClass> truck_classes;
+  std::vector<StationGroup> station_groups;
+
+  size_t num_trucks() const;
+  size_t num_stations() const;
+
+  // True if every truck travels and every station unloads in FixedTiming's
+  // times, and all trucks mine from the same distribution: the scenario
+  // then runs on the default controller with that distribution.
+  bool UsesFixedTiming() const;
+};
+
+// Reads a scenario from a JSON file:
+//   {
+//     "trucks": [
+//       {"class": "haul-200", "count": 800, "travel_time": 30,
+//        "mining": "uniform"},
+//       {"class": "haul-400", "count": 200, "travel_time": 45,
+//        "mining": "triangular:150"}
+//     ],
+//     "stations": [
+//       {"count": 40, "unload_time": 5},
+//       {"count": 10, "unload_time": 8}
+//     ]
+//   }
+// Times are in minutes; "mining" takes a --mining spec (see
+// MiningDistribution::Parse). Everything but the counts defaults to
+// FixedTiming. Throws std::invalid_argument if the file cannot be read or
+// is not a valid scenario.
+Scenario ReadScenario(const std::string& filename);
+
+#endif  // INCLUDE_SCENARIO_H_
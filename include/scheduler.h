@@ -0,0 +1,125 @@
+#ifndef INCLUDE_SCHEDULER_H_
+#define INCLUDE_SCHEDULER_H_
+
+#include <concepts>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "event.h"
+#include "minutes.h"
+
+// Pending-event queue used by the Controller. Events are keyed by their end
+// time. Pop returns events in time order; events for the same time come out
+// in the order they were pushed (FIFO), which keeps runs deterministic.
+// Pending lists the events in the order Pop would return them, so pushing
+// them into an empty scheduler restores it (e.g. from a checkpoint).
+// Schedulers are constructed from (horizon, memory resource).
+template <typename S>
+concept EventScheduler = requires(S scheduler, const S& const_scheduler,
+                                  const PackedEvent& event) {
+  scheduler.Push(event);
+  { scheduler.Pop() } -> std::same_as<PackedEvent>;
+  { const_scheduler.Empty() } -> std::same_as<bool>;
+  { const_scheduler.Size() } -> std::same_as<size_t>;
+  { const_scheduler.Pending() } -> std::same_as<std::vector<PackedEvent>>;
+  scheduler.Clear();
+};
+
+// Binary min-heap ordered by (time, insertion sequence). O(log N) per
+// operation, independent of how far in the future events are scheduled.
+class BinaryHeapScheduler {
+ public:
+  // The horizon is only meaningful for the timing wheel; accepted so both
+  // schedulers can be constructed the same way.
+  explicit BinaryHeapScheduler(
+      minutes_t /*horizon*/ = 0min,
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : heap_(resource) {}
+
+  void Push(const PackedEvent& event);
+  PackedEvent Pop();
+
+  bool Empty() const { return heap_.empty(); }
+  size_t Size() const { return heap_.size(); }
+  std::vector<PackedEvent> Pending() const;
+  void Clear();
+
+  // Time of the earliest pending event. Requires !Empty().
+  minutes_t NextTime() const { return heap_.front().event.end_time(); }
+
+ private:
+  struct Entry {
+    PackedEvent event;
+    uint64_t sequence;
+  };
+
+  // Min-heap on (end time, sequence), maintained with std::push_heap
+  std::pmr::vector<Entry> heap_;
+  uint64_t next_sequence_ = 0;
+};
+
+// Timing wheel (calendar queue) with one bucket per minute over a fixed
+// lookahead horizon. Push and Pop are O(1) for events scheduled within the
+// horizon of the current time. Events further out (e.g. unloads behind a
+// long station queue) wait in an overflow heap and are moved onto the wheel
+// once they come within the horizon, ahead of any later pushes for the same
+// minute, so FIFO order is preserved.
+class TimingWheelScheduler {
+ public:
+  static constexpr minutes_t kDefaultHorizon = 512min;
+
+  explicit TimingWheelScheduler(
+      minutes_t horizon = kDefaultHorizon,
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+  void Push(const PackedEvent& event) {
+    const minutes_t time = event.end_time();
+    if (time - now_ <= horizon_) {
+      buckets_[time.count() & mask_].push_back(event);
+      ++wheel_size_;
+    } else {
+      overflow_.Push(event);
+    }
+  }
+
+  PackedEvent Pop() {
+    auto* bucket = &buckets_[now_.count() & mask_];
+    if (read_index_ == bucket->size()) bucket = AdvanceToNextEvent();
+    --wheel_size_;
+    return (*bucket)[read_index_++];
+  }
+
+  // Pops the next event if it ends before limit. Unlike Pop, the cursor
+  // never moves past limit - 1min, so events ending at or after limit may
+  // still be pushed afterwards.
+  bool PopBefore(minutes_t limit, PackedEvent* event);
+
+  bool Empty() const { return wheel_size_ == 0 && overflow_.Empty(); }
+  size_t Size() const { return wheel_size_ + overflow_.Size(); }
+  std::vector<PackedEvent> Pending() const;
+  void Clear();
+
+  minutes_t horizon() const { return horizon_; }
+
+ private:
+  // Moves the cursor to the next minute with pending events and returns its
+  // bucket. Only called when the current bucket is exhausted.
+  std::pmr::vector<PackedEvent>* AdvanceToNextEvent();
+
+  // Moves overflow events that are now within the horizon onto the wheel.
+  void MigrateOverflow();
+
+  minutes_t horizon_;
+  uint64_t mask_;
+  std::pmr::vector<std::pmr::vector<PackedEvent>> buckets_;
+  minutes_t now_ = 0min;   // Time of the bucket currently being drained
+  size_t read_index_ = 0;  // Next unread event in the current bucket
+  size_t wheel_size_ = 0;  // Unread events on the wheel
+  BinaryHeapScheduler overflow_;
+};
+
+static_assert(EventScheduler<BinaryHeapScheduler>);
+static_assert(EventScheduler<TimingWheelScheduler>);
+
+#endif  // INCLUDE_SCHEDULER_H_
@@ -0,0 +1,39 @@
+#ifndef INCLUDE_SHARD_H_
+#define INCLUDE_SHARD_H_
+
+#include <cstddef>
+#include <string>
+
+// One of count shards of a batch of independent work items (replications,
+// sweep cells). Items are dealt out round-robin, so shard index gets items
+// index, index + count, index + 2 * count, ... and shards of a sweep mix
+// cheap and expensive cells alike. Each shard writes a partial result file
+// (JSON, "kind" says of what) that the merge tool combines.
+struct ShardSpec {
+  size_t index = 0;  // 0-based
+  size_t count = 1;
+
+  bool sharded() const { return count > 1; }
+  bool Owns(size_t item) const { return item % count == index; }
+
+  // Items of the shard among the first num_items
+  size_t NumItems(size_t num_items) const {
+    return num_items > index ? (num_items - index + count - 1) / count : 0;
+  }
+
+  // "<i>of<n>", 1-based, for file names
+  std::string Suffix() const;
+};
+
+// Format version of the partial result files
+inline constexpr int kShardFileVersion = 1;
+
+// Parses "<i>/<n>" with 1 <= i <= n (1-based, as on the command line).
+// Throws std::invalid_argument on anything else.
+ShardSpec ParseShardSpec(const std::string& spec);
+
+// The "kind" of a partial result file ("replications" or "sweep"). Throws
+// std::runtime_error if it cannot be read or is not a partial result.
+std::string ReadShardKind(const std::string& filename);
+
+#endif  // INCLUDE_SHARD_H_
@@ -0,0 +1,208 @@
+#ifndef INCLUDE_STATION_DISPATCH_H_
+#define INCLUDE_STATION_DISPATCH_H_
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "checkpoint.h"
+#include "minutes.h"
+
+// How a truck arriving to unload is given a station. The dispatcher is a
+// template parameter of the controller like the sink and the scheduler, so
+// the policy is inlined into the event handlers.
+//
+// Assign(truck_id, arrival_time) returns the station the truck unloads at
+// and the time that station is free for it; the controller then calls
+// MarkAvailable with the end of the unload before assigning another truck.
+// Save and Restore are for checkpoints. Describe identifies the policy in
+// checkpoints; it is empty for the default, earliest-available one.
+template <typename T>
+concept StationDispatcher =
+    requires(T dispatcher, const T& const_dispatcher, size_t id,
+             minutes_t time, const StationQueueState& state) {
+      dispatcher.Initialize(id);
+      { const_dispatcher.Empty() } -> std::same_as<bool>;
+      { const_dispatcher.Size() } -> std::convertible_to<size_t>;
+      {
+        dispatcher.Assign(id, time)
+      } -> std::same_as<std::pair<minutes_t, size_t>>;
+      dispatcher.MarkAvailable(time, id);
+      { const_dispatcher.Save() } -> std::same_as<StationQueueState>;
+      dispatcher.Restore(state);
+      { const_dispatcher.Describe() } -> std::same_as<std::string>;
+    };
+
+// StationQueue hands out the station that becomes available first, the
+// lowest id first among stations available at the same time.
+//
+// A station is only marked available after it was popped, at a time later
+// than the time it was popped and no earlier than any time marked before
+// (arrivals are handled in time order, and every unload takes the same
+// time; see StationHeap otherwise).
+// The queue is therefore a FIFO of times rather than a heap: the stations of
+// one time are sorted by id when that time reaches the front, at which point
+// no more stations can join it.
+class StationQueue {
+ public:
+  void Initialize(size_t num_stations);
+
+  bool Empty() const;
+  size_t Size() const { return entries_.size() - head_; }
+  std::pair<minutes_t, size_t> PopNextAvailable();
+  std::pair<minutes_t, size_t> Assign(size_t /*truck_id*/,
+                                      minutes_t /*arrival_time*/) {
+    return PopNextAvailable();
+  }
+
+  // Throws std::logic_error if time breaks the ordering described above
+  void MarkAvailable(minutes_t time, size_t station_id);
+
+  // For checkpoints; Restore replaces the contents with saved ones
+  StationQueueState Save() const;
+  void Restore(const StationQueueState& state);
+  static std::string Describe() { return ""; }
+
+ private:
+  // In the order marked, so by time; [head_, sorted_end_) is the front time
+  // sorted by id
+  std::vector<std::pair<minutes_t, size_t>> entries_;
+  size_t head_ = 0;
+  size_t sorted_end_ = 0;
+  minutes_t last_popped_ = minutes_t::min();
+  minutes_t last_marked_ = minutes_t::min();
+};
+
+// StationQueue for stations that take different times to unload, which
+// are no longer marked available in time order: a min-heap on (time, id),
+// O(log S) per operation instead of O(1).
+class StationHeap {
+ public:
+  void Initialize(size_t num_stations);
+
+  bool Empty() const { return heap_.empty(); }
+  size_t Size() const { return heap_.size(); }
+  std::pair<minutes_t, size_t> PopNextAvailable();
+  std::pair<minutes_t, size_t> Assign(size_t /*truck_id*/,
+                                      minutes_t /*arrival_time*/) {
+    return PopNextAvailable();
+  }
+  void MarkAvailable(minutes_t time, size_t station_id);
+
+  // As in StationQueue; the saved entries are sorted by (time, id)
+  StationQueueState Save() const;
+  void Restore(const StationQueueState& state);
+  static std::string Describe() { return ""; }
+
+ private:
+  std::vector<std::pair<minutes_t, size_t>> heap_;  // std::greater order
+};
+
+// The dispatchers below keep every station's available time and let a
+// truck wait at the station it is given even if another one is free. Their
+// saved entries are (available time, id) by id, followed by counters of
+// their own.
+
+// Station with the fewest unload minutes given out so far, the lowest id on
+// ties; evens out the work of stations that unload at different speeds.
+// An indexed 4-ary min-heap on (load, id): O(1) to assign, O(log S) to
+// mark, and initialized in O(S) (all loads are 0, so ids in order are
+// already a heap).
+class LeastLoadedDispatch {
+ public:
+  void Initialize(size_t num_stations);
+
+  bool Empty() const { return heap_.empty(); }
+  size_t Size() const { return heap_.size(); }
+  std::pair<minutes_t, size_t> Assign(size_t /*truck_id*/,
+                                      minutes_t arrival_time) {
+    const uint32_t station_id = heap_.front();
+    arrival_time_ = arrival_time;
+    return {available_[station_id], station_id};
+  }
+  void MarkAvailable(minutes_t time, size_t station_id);
+
+  StationQueueState Save() const;  // Counters: the loads by id
+  void Restore(const StationQueueState& state);
+  static std::string Describe() { return "least-loaded"; }
+
+ private:
+  static constexpr size_t kArity = 4;
+
+  bool Less(uint32_t a, uint32_t b) const {
+    return load_[a] != load_[b] ? load_[a] < load_[b] : a < b;
+  }
+  void SiftDown(size_t index);
+
+  std::vector<uint32_t> heap_;      // Station ids
+  std::vector<uint32_t> position_;  // Index in heap_ by station id
+  std::vector<minutes_t> available_;
+  std::vector<int64_t> load_;  // Unload minutes given out, by station id
+  minutes_t arrival_time_ = 0min;  // Of the last assigned truck
+};
+
+// Stations in turn, whatever their queues: O(1) per operation.
+class RoundRobinDispatch {
+ public:
+  void Initialize(size_t num_stations);
+
+  bool Empty() const { return available_.empty(); }
+  size_t Size() const { return available_.size(); }
+  std::pair<minutes_t, size_t> Assign(size_t /*truck_id*/,
+                                      minutes_t /*arrival_time*/) {
+    const size_t station_id = next_;
+    next_ = next_ + 1 == available_.size() ? 0 : next_ + 1;
+    return {available_[station_id], station_id};
+  }
+  void MarkAvailable(minutes_t time, size_t station_id) {
+    available_[station_id] = time;
+  }
+
+  StationQueueState Save() const;  // Counters: the next station
+  void Restore(const StationQueueState& state);
+  static std::string Describe() { return "round-robin"; }
+
+ private:
+  std::vector<minutes_t> available_;  // By station id
+  size_t next_ = 0;
+};
+
+// Stations split among num_mines mines, each with its own contiguous range
+// of ids; a truck works mine truck_id % num_mines and unloads at that
+// mine's station available first (lowest id on ties). A tournament tree
+// over all stations answers the earliest-available query for any range in
+// O(log S), and is updated in O(log S) when a station is marked.
+class AffinityDispatch {
+ public:
+  explicit AffinityDispatch(size_t num_mines = 1) : num_mines_(num_mines) {}
+
+  // Throws std::invalid_argument if there are fewer stations than mines
+  void Initialize(size_t num_stations);
+
+  bool Empty() const { return available_.empty(); }
+  size_t Size() const { return available_.size(); }
+  std::pair<minutes_t, size_t> Assign(size_t truck_id,
+                                      minutes_t /*arrival_time*/);
+  void MarkAvailable(minutes_t time, size_t station_id);
+
+  StationQueueState Save() const;
+  void Restore(const StationQueueState& state);
+  std::string Describe() const {
+    return "affinity:" + std::to_string(num_mines_);
+  }
+
+ private:
+  static constexpr uint32_t kNoStation = UINT32_MAX;
+
+  // Earlier (time, id) of two stations; kNoStation loses
+  uint32_t Winner(uint32_t a, uint32_t b) const;
+
+  size_t num_mines_;
+  size_t leaves_ = 0;  // Power of two >= stations
+  std::vector<uint32_t> tree_;  // Winner of each node; leaves at leaves_
+  std::vector<minutes_t> available_;  // By station id
+};
+
+#endif  // INCLUDE_STATION_DISPATCH_H_
@@ -0,0 +1,41 @@
+#ifndef INCLUDE_STATS_H_
+#define INCLUDE_STATS_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+
+// Runtime statistics (EngineStats in controller.h, LoggerStats in event.h)
+// are compiled in when VAST_ENABLE_STATS is defined, which the CMake option
+// of the same name does. Recording sites are guarded by
+// `if constexpr (kStatsEnabled)`, so with the option off the counters are
+// never touched and the clock is never read.
+#ifdef VAST_ENABLE_STATS
+inline constexpr bool kStatsEnabled = true;
+#else
+inline constexpr bool kStatsEnabled = false;
+#endif
+
+// Wall-clock stopwatch for statistics; a no-op when stats are compiled out
+class StatsTimer {
+ public:
+  StatsTimer() {
+    if constexpr (kStatsEnabled) start_ = Clock::now();
+  }
+
+  // Milliseconds since construction or the previous Lap
+  double Lap() {
+    if constexpr (kStatsEnabled) {
+      const auto now = Clock::now();
+      const double ms =
+          std::chrono::duration<double, std::milli>(now - start_).count();
+      start_ = now;
+      return ms;
+    }
+    return 0.0;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start_;
+};
+
+#endif  // INCLUDE_STATS_H_
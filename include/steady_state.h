@@ -0,0 +1,110 @@
+#ifndef INCLUDE_STEADY_STATE_H_
+#define INCLUDE_STEADY_STATE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "minutes.h"
+
+// Steady-state estimation of a single run.
+//
+// Every truck starts mining at minute 0, so the start of a run is a
+// transient that whole-run metrics average in. A SteadyStateMonitor splits
+// the run into fixed observation intervals and records, per interval, the
+// unloads that ended in it: their count, station-minutes and queueing
+// minutes. From those it estimates three fleet metrics (station
+// utilization, average queueing time per unload and throughput per hour):
+// MSER-5 picks the end of the warm-up, and batch means of what follows give
+// each metric's steady-state mean and 95% confidence interval.
+
+struct SteadyStateOptions {
+  minutes_t interval = 0min;  // Observation length; 0 turns monitoring off
+  // Stop once every steady-state CI half-width is at most this fraction of
+  // its mean (see SteadyStateMonitor::Update). 0 never stops early.
+  double relative_precision = 0.05;
+  size_t num_batches = 20;  // Batch means after the warm-up
+};
+
+// Observations are grouped in fives for MSER-5
+inline constexpr size_t kMserBatch = 5;
+
+// One fleet metric over the whole run and after the warm-up
+struct SteadyStateMetric {
+  double whole_run = 0.0;
+  double mean = 0.0;        // Mean of the batch means
+  double half_width = 0.0;  // 95% CI of the mean; infinite if not estimated
+};
+
+struct SteadyStateResult {
+  bool converged = false;  // Every metric met the relative precision
+  // End of the warm-up: the latest MSER-5 cutoff of the three metrics,
+  // moved up to where the equal batches that follow start
+  minutes_t warmup = 0min;
+  minutes_t end = 0min;           // Observed up to here
+  size_t batches = 0;             // Batch means after the warm-up
+  size_t batch_observations = 0;  // Intervals per batch
+
+  SteadyStateMetric station_utilization;  // Percent
+  SteadyStateMetric avg_queueing_time;    // Minutes per unload
+  SteadyStateMetric throughput;           // Unloads per hour, whole fleet
+};
+
+class SteadyStateMonitor {
+ public:
+  // Sizes the observations for a run of up to sim_time; discards previous
+  // ones. Throws std::invalid_argument for a negative interval or too few
+  // batches.
+  void Reset(const SteadyStateOptions& options, minutes_t sim_time,
+             size_t num_stations);
+
+  bool enabled() const { return options_.interval > 0min; }
+  const SteadyStateOptions& options() const { return options_; }
+
+  // Records an unload ending at end (at most the sim_time of Reset) after
+  // waiting wait; it counts toward the interval it ends in
+  void AddUnload(minutes_t end, minutes_t unload_time, minutes_t wait) {
+    const size_t i = static_cast<size_t>(
+        std::max<int64_t>(end.count() - 1, 0) / options_.interval.count());
+    Observation& observation = observations_[i];
+    ++observation.unloads;
+    observation.busy_minutes += unload_time.count();
+    observation.queue_minutes += wait.count();
+  }
+
+  // Estimates from the intervals that end by time, every unload ending by
+  // then having been added, and returns whether they have converged: each
+  // metric's CI half-width is at most relative_precision of its mean, or
+  // for the queueing time of the mean time at a station (queueing plus
+  // unloading), so that a fleet that hardly queues still converges.
+  // Needs num_batches x kMserBatch intervals after the warm-up, which is
+  // at most half of them.
+  bool Update(minutes_t time);
+
+  const SteadyStateResult& result() const { return result_; }
+
+ private:
+  struct Observation {
+    int64_t unloads = 0;
+    int64_t busy_minutes = 0;
+    int64_t queue_minutes = 0;
+  };
+
+  SteadyStateOptions options_;
+  size_t num_stations_ = 0;
+  std::vector<Observation> observations_;
+  SteadyStateResult result_;
+};
+
+// Prints the warm-up cutoff and steady-state estimates next to the
+// whole-run values to stdout.
+void PrintSteadyStateSummary(const SteadyStateResult& result);
+
+// Writes the result to a JSON file named after the metrics report
+// (steadystate.<trucks>truck_<stations>station_<minutes>_minutes.json) and
+// returns its name.
+std::string ExportSteadyStateToJson(size_t num_trucks, size_t num_stations,
+                                    const SteadyStateResult& result);
+
+#endif  // INCLUDE_STEADY_STATE_H_
@@ -0,0 +1,111 @@
+#ifndef INCLUDE_SWEEP_H_
+#define INCLUDE_SWEEP_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "minutes.h"
+#include "mining_distribution.h"
+#include "shard.h"
+
+// Grid of fleet configurations; every combination of the three axes is run.
+struct SweepOptions {
+  std::vector<size_t> trucks;
+  std::vector<size_t> stations;
+  std::vector<minutes_t> sim_times;
+
+  uint64_t random_seed = 0xBEEF;  // Same seed for every cell
+  size_t num_threads = 0;         // 0 = std::thread::hardware_concurrency()
+
+  // Unset: the controller's default, uniform mining durations
+  std::optional<MiningDistribution> mining_distribution;
+
+  // Fill cells from the analytic EstimateMetrics instead of simulating
+  bool estimate = false;
+
+  // Run only this shard's cells, by grid index (see shard.h)
+  ShardSpec shard;
+};
+
+// Fleet-level results of one sweep cell. Trivially copyable, so the binary
+// table is the raw array of these.
+struct SweepResult {
+  uint64_t num_trucks = 0;
+  uint64_t num_stations = 0;
+  int64_t sim_minutes = 0;
+
+  double avg_truck_utilization = 0.0;    // % (mean over trucks)
+  double avg_station_utilization = 0.0;  // % (mean over stations)
+  uint64_t trips_completed = 0;          // Sum over trucks
+  uint64_t throughput = 0;               // Trucks unloaded, all stations
+  uint64_t queues_completed = 0;         // Times any truck queued
+  double avg_queueing_time = 0.0;        // Minutes per queueing truck
+  double avg_trip_time = 0.0;            // Minutes (mean over trucks)
+
+  double elapsed_ms = 0.0;  // Wall-clock time of the cell
+};
+static_assert(sizeof(SweepResult) == 88);
+
+// Binary sweep table: a SweepTableHeader followed by a packed array of
+// SweepResults in host byte order, like the binary event log.
+inline constexpr char kSweepTableMagic[4] = {'V', 'M', 'S', 'W'};
+inline constexpr uint32_t kSweepTableVersion = 1;
+
+// File header at offset 0 (24 bytes).
+struct SweepTableHeader {
+  char magic[4];         // kSweepTableMagic
+  uint32_t version;      // kSweepTableVersion
+  uint32_t record_size;  // sizeof(SweepResult)
+  uint32_t reserved;
+  uint64_t count;  // Number of SweepResults that follow
+};
+static_assert(sizeof(SweepTableHeader) == 24);
+
+// Parses a list of values: "n", "first:last" or "first:last:step"
+// (inclusive, step defaults to 1), or several of those separated by commas,
+// e.g. "10:100:10,200". Throws std::invalid_argument on malformed input.
+std::vector<size_t> ParseSweepRange(const std::string& spec);
+
+// Runs every configuration of the grid in-process on a work-stealing pool,
+// metrics only. Results are in grid order: trucks, then stations, then sim
+// times, the last varying fastest. With a shard, only the shard's cells
+// are run, in the same order.
+std::vector<SweepResult> RunSweep(const SweepOptions& options);
+
+// Write the consolidated table as CSV (one header row) or binary.
+void WriteSweepCsv(const std::string& filename,
+                   const std::vector<SweepResult>& results);
+void WriteSweepBinary(const std::string& filename,
+                      const std::vector<SweepResult>& results);
+
+// Reads a table written by WriteSweepBinary.
+std::vector<SweepResult> ReadSweepBinary(const std::string& filename);
+
+// A shard's partial sweep: the grid it is part of (the mining distribution
+// only by name) and the cells it ran, by grid index.
+struct SweepShard {
+  SweepOptions options;
+  std::string mining_distribution;  // Describe(); empty for the default
+  std::vector<size_t> cells;
+  std::vector<SweepResult> results;
+};
+
+// Writes the results of RunSweep(options) for a shard as a partial result
+// (JSON, with the grid's axes).
+void WriteSweepShard(const std::string& filename, const SweepOptions& options,
+                     const std::vector<SweepResult>& results);
+
+// Reads a file written by WriteSweepShard. Throws std::runtime_error if it
+// is not one.
+SweepShard ReadSweepShard(const std::string& filename);
+
+// Combines shards of one grid into its table, in grid order; cells of
+// shards not given are left out. options becomes the grid's. Throws
+// std::invalid_argument if there are no shards, one is repeated, or they
+// come from different grids.
+std::vector<SweepResult> MergeSweepShards(const std::vector<SweepShard>& shards,
+                                          SweepOptions* options);
+
+#endif  // INCLUDE_SWEEP_H_
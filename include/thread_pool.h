@@ -0,0 +1,65 @@
+#ifndef INCLUDE_THREAD_POOL_H_
+#define INCLUDE_THREAD_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker and work stealing.
+//
+// Submitted tasks are dealt round-robin onto the workers' deques (a task
+// submitted from inside a task goes to the current worker's own deque).
+// A worker takes tasks from the back of its own deque and, once that is
+// empty, steals from the front of the others, so workers that drew cheap
+// tasks help out with the expensive ones instead of going idle.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  // 0 threads = std::thread::hardware_concurrency()
+  explicit WorkStealingPool(size_t num_threads = 0);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  size_t num_threads() const { return threads_.size(); }
+
+  void Submit(Task task);
+
+  // Blocks until every submitted task has finished. If any task threw, the
+  // first exception is rethrown here (the remaining tasks still run).
+  void Wait();
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(size_t index);
+
+  // Pops a task from the worker's own deque, or steals one from another
+  std::optional<Task> TakeTask(size_t index);
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_queue_{0};  // Round-robin target for Submit
+
+  // Workers sleep on queued_ while it is 0; Wait() sleeps on unfinished_
+  std::atomic<size_t> queued_{0};      // Tasks sitting in deques
+  std::atomic<size_t> unfinished_{0};  // Tasks submitted but not finished
+  std::atomic<bool> done_{false};
+
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+#endif  // INCLUDE_THREAD_POOL_H_
@@ -0,0 +1,103 @@
+#ifndef INCLUDE_TIME_SERIES_H_
+#define INCLUDE_TIME_SERIES_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "minutes.h"
+
+// What a truck is doing during a span of time. Idle time is whatever is left
+// of the fleet's time in a bin.
+enum class TruckState { Mining, Traveling, Queueing, Unloading };
+inline constexpr size_t kNumTruckStates = 4;
+
+// Fixed-interval bins of fleet and station activity, filled in while the
+// simulation runs so that utilization and queue length over time never need
+// the event log. Each bin holds the minutes spent in each truck state (summed
+// over trucks) and, per station, the minutes busy unloading and the minutes
+// trucks spent waiting for it. Memory is O(bins x stations).
+class TimeSeries {
+ public:
+  TimeSeries() = default;
+
+  // Sizes the bins for a run of sim_time; discards previous contents.
+  // An interval of 0 disables recording.
+  void Reset(minutes_t interval, minutes_t sim_time, size_t num_stations);
+
+  // Drops the bins past a shorter sim_time, e.g. for a run that stopped
+  // early; no span may have been added past it
+  void Truncate(minutes_t sim_time);
+
+  bool enabled() const { return interval_ > 0min; }
+  minutes_t interval() const { return interval_; }
+  minutes_t sim_time() const { return sim_time_; }
+  size_t num_bins() const { return num_bins_; }
+  size_t num_stations() const { return num_stations_; }
+
+  // Length of a bin; the last one may be cut short by the end of the run
+  minutes_t BinLength(size_t bin) const;
+
+  // Spread the span [start, end) over the bins it overlaps
+  void AddTruckSpan(TruckState state, minutes_t start, minutes_t end);
+  void AddStationBusy(size_t station_id, minutes_t start, minutes_t end);
+  void AddStationQueue(size_t station_id, minutes_t start, minutes_t end);
+
+  // Adds the truck minutes of another series with the same bins (e.g. one
+  // recorded by a worker thread for its share of the fleet)
+  void AddTruckMinutes(const TimeSeries& other);
+
+  // Raw bins, laid out as below (e.g. for checkpoints)
+  const std::vector<int64_t>& truck_minutes() const { return truck_minutes_; }
+  const std::vector<int64_t>& busy_minutes() const { return busy_minutes_; }
+  const std::vector<int64_t>& queue_minutes() const { return queue_minutes_; }
+
+  // Adds raw bins of a series with the same interval and stations and at
+  // most as many bins, e.g. the start of a run restored from a checkpoint.
+  // Throws std::invalid_argument if they do not fit.
+  void AddBins(const std::vector<int64_t>& truck_minutes,
+               const std::vector<int64_t>& busy_minutes,
+               const std::vector<int64_t>& queue_minutes);
+
+  // Truck-minutes spent in a state during a bin, summed over the fleet
+  int64_t TruckMinutes(size_t bin, TruckState state) const {
+    return truck_minutes_[bin * kNumTruckStates + static_cast<size_t>(state)];
+  }
+
+  // Minutes a station spent unloading during a bin
+  int64_t BusyMinutes(size_t bin, size_t station_id) const {
+    return busy_minutes_[bin * num_stations_ + station_id];
+  }
+
+  // Truck-minutes spent queueing for a station during a bin; divided by the
+  // bin length this is the station's average queue length
+  int64_t QueueMinutes(size_t bin, size_t station_id) const {
+    return queue_minutes_[bin * num_stations_ + station_id];
+  }
+
+ private:
+  // Adds the overlap of [start, end) with each bin to
+  // values[bin * stride + offset]
+  void Spread(std::vector<int64_t>* values, size_t stride, size_t offset,
+              minutes_t start, minutes_t end);
+
+  minutes_t interval_ = 0min;
+  minutes_t sim_time_ = 0min;
+  size_t num_bins_ = 0;
+  size_t num_stations_ = 0;
+
+  // Row-major by bin
+  std::vector<int64_t> truck_minutes_;  // bins x kNumTruckStates
+  std::vector<int64_t> busy_minutes_;   // bins x stations
+  std::vector<int64_t> queue_minutes_;  // bins x stations
+};
+
+// Writes the bins as column arrays to a JSON file named after the metrics
+// report (timeseries.<trucks>truck_<stations>station_<minutes>_minutes.json)
+// and returns its name.
+std::string ExportTimeSeriesToJson(size_t num_trucks,
+                                   const TimeSeries& series);
+
+#endif  // INCLUDE_TIME_SERIES_H_
@@ -0,0 +1,88 @@
+#ifndef INCLUDE_TIMING_H_
+#define INCLUDE_TIMING_H_
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "minutes.h"
+#include "mining_distribution.h"
+
+struct Scenario;
+
+// How long trucks travel, stations unload and trucks mine. The timing is a
+// template parameter of the controller like the sink and the scheduler, so
+// the default FixedTiming's constants are folded into the event handlers,
+// while ScenarioTiming looks them up per truck and station.
+//
+// Mining returns the distribution a truck mines from, or nullptr for the
+// controller's own (see BasicController::SetMiningDistribution).
+// kFixedUnloadTime tells the controller that every station takes the same
+// time to unload, which keeps stations available in the order they were
+// taken (see StationQueue). Validate throws std::invalid_argument if the
+// timing does not cover a fleet of that size. Describe identifies the
+// timing in checkpoints.
+template <typename T>
+concept TimingPolicy = requires(const T& timing, size_t id, size_t count) {
+  { timing.TravelTime(id) } -> std::same_as<minutes_t>;
+  { timing.UnloadTime(id) } -> std::same_as<minutes_t>;
+  { timing.Mining(id) } -> std::same_as<const MiningDistribution*>;
+  timing.Validate(count, count);
+  { timing.Describe() } -> std::same_as<std::string>;
+  { T::kFixedUnloadTime } -> std::convertible_to<bool>;
+};
+
+// The same compile-time constants for every truck and station (the
+// default)
+struct FixedTiming {
+  static constexpr minutes_t kTravelTime = 30min;
+  static constexpr minutes_t kUnloadTime = 5min;
+  static constexpr minutes_t kMinDuration = 60min;
+  static constexpr minutes_t kMaxDuration = 300min;
+  static constexpr bool kFixedUnloadTime = true;
+
+  static constexpr minutes_t TravelTime(size_t) { return kTravelTime; }
+  static constexpr minutes_t UnloadTime(size_t) { return kUnloadTime; }
+  static constexpr const MiningDistribution* Mining(size_t) {
+    return nullptr;
+  }
+  static void Validate(size_t, size_t) {}
+  static std::string Describe() { return ""; }
+};
+
+// Timing tables of a Scenario (see scenario.h): a travel time and mining
+// distribution per truck class, and an unload time per station. Default
+// constructed, it covers no trucks or stations.
+class ScenarioTiming {
+ public:
+  static constexpr bool kFixedUnloadTime = false;
+
+  ScenarioTiming() = default;
+  explicit ScenarioTiming(const Scenario& scenario);
+
+  minutes_t TravelTime(size_t truck_id) const {
+    return classes_[truck_class_[truck_id]].travel_time;
+  }
+  minutes_t UnloadTime(size_t station_id) const {
+    return unload_time_[station_id];
+  }
+  const MiningDistribution* Mining(size_t truck_id) const {
+    return &classes_[truck_class_[truck_id]].mining;
+  }
+  void Validate(size_t num_trucks, size_t num_stations) const;
+  std::string Describe() const { return description_; }
+
+ private:
+  struct TruckClass {
+    minutes_t travel_time;
+    MiningDistribution mining;
+  };
+
+  std::vector<TruckClass> classes_;
+  std::vector<uint16_t> truck_class_;  // Index into classes_, per truck
+  std::vector<minutes_t> unload_time_;  // Per station
+  std::string description_;
+};
+
+#endif  // INCLUDE_TIMING_H_
@@ -1,3 +1,4 @@
+import gzip
 import json
 import matplotlib.pyplot as plt
 import numpy as np
@@ -10,11 +11,52 @@ COLOR_SCHEME = {
     "unload": "#D79E42",
 }
 
+# Binary event log layout (see include/event_log.h)
+BINARY_LOG_MAGIC = b"VMEL"
+GZIP_MAGIC = b"\x1f\x8b"
+BINARY_LOG_HEADER_SIZE = 48
+BINARY_EVENT_TYPES = ["TravelToStation", "Mine", "TravelToMine", "Queue", "Unload"]
+BINARY_NO_STATION = 0xFFFFFFFF
+BINARY_RECORD_DTYPE = np.dtype(
+    [
+        ("type", "<u4"),
+        ("truck_id", "<u4"),
+        ("station_id", "<u4"),
+        ("start_time", "<u4"),
+        ("end_time", "<u4"),
+    ]
+)
+
+
+def load_binary_events(path):
+    """Load events from a binary event log written with --binary-events."""
+    records = np.fromfile(path, dtype=BINARY_RECORD_DTYPE, offset=BINARY_LOG_HEADER_SIZE)
+    events = []
+    for r in records:
+        station_id = int(r["station_id"])
+        events.append(
+            {
+                "type": BINARY_EVENT_TYPES[r["type"]],
+                "truck_id": int(r["truck_id"]),
+                "station_id": None if station_id == BINARY_NO_STATION else station_id,
+                "start_time": int(r["start_time"]),
+                "end_time": int(r["end_time"]),
+            }
+        )
+    return events
+
 
 def load_events(path):
-    """Load events from a JSON Lines file."""
+    """Load events from a JSON Lines file, compressed or not (or a binary event log)."""
+    with open(path, "rb") as f:
+        magic = f.read(len(BINARY_LOG_MAGIC))
+    if magic == BINARY_LOG_MAGIC:
+        return load_binary_events(path)
+
+    # Compressed logs are concatenated gzip members, which gzip reads as one
+    opener = gzip.open if magic[:len(GZIP_MAGIC)] == GZIP_MAGIC else open
     events = []
-    with open(path, "r") as f:
+    with opener(path, "rt") as f:
         for line in f:
             line = line.strip()
             if line:  # skip empty lines
@@ -71,6 +113,34 @@ def process_events(events, simulation_duration):
     return truck_stats, station_stats, truck_efficiency, station_efficiency
 
 
+def load_summary(path):
+    """Load the stats process_events computes from a summary written by the
+    native analyzer (analyze <events> <summary.json>)."""
+    with open(path, "r") as f:
+        summary = json.load(f)
+
+    trucks = summary["trucks"]
+    truck_stats = {
+        truck_id: {
+            "mine": trucks["mine"][truck_id],
+            "travel": trucks["travel"][truck_id],
+            "queue": trucks["queue"][truck_id],
+            "unload": trucks["unload"][truck_id],
+            "trips_completed": trucks["trips_completed"][truck_id],
+        }
+        for truck_id in range(len(trucks["mine"]))
+    }
+    stations = summary["stations"]
+    station_stats = {
+        station_id: {
+            "unload": stations["unload"][station_id],
+            "unload_count": stations["unload_count"][station_id],
+        }
+        for station_id in range(len(stations["unload"]))
+    }
+    return truck_stats, station_stats, trucks["efficiency"], stations["efficiency"]
+
+
 def plot_truck_efficiency_histogram(truck_efficiency, ax):
     """Plot truck efficiency histogram."""
     ax.hist(truck_efficiency, bins=20, edgecolor="black", color=COLOR_SCHEME["mining"])
@@ -109,22 +179,73 @@ def plot_station_performance(station_stats, ax):
     ax.grid(True, axis="y", linestyle="--", alpha=0.4)
 
 
+def plot_time_series(path):
+    """Plot fleet state, station utilization and queue length per interval
+    from a time series report (main --interval=<m>), without the event log."""
+    with open(path, "r") as f:
+        series = json.load(f)
+
+    bin_minutes = np.array(series["bin_minutes"], dtype=float)
+    bin_starts = np.concatenate(([0.0], np.cumsum(bin_minutes)[:-1])) / 60.0
+    trucks = series["trucks"]
+
+    fig, axs = plt.subplots(3, 1, figsize=(14, 12), sharex=True)
+
+    # Average number of trucks in each state
+    states = ["mining", "traveling", "queueing", "unloading", "idle"]
+    counts = [np.array(trucks[state]) / bin_minutes for state in states]
+    axs[0].stackplot(bin_starts, counts, labels=[s.capitalize() for s in states], step="post")
+    axs[0].set_title("Truck States")
+    axs[0].set_ylabel("Trucks")
+    axs[0].legend(loc="upper right")
+
+    # Station utilization and average queue length
+    for station in series["stations"]:
+        label = f"Station {station['id']}"
+        axs[1].step(bin_starts, np.array(station["busy"]) / bin_minutes * 100.0, where="post", label=label)
+        axs[2].step(bin_starts, np.array(station["queue"]) / bin_minutes, where="post", label=label)
+    axs[1].set_title("Station Utilization")
+    axs[1].set_ylabel("Utilization (%)")
+    axs[2].set_title("Average Queue Length")
+    axs[2].set_ylabel("Trucks Waiting")
+    axs[2].set_xlabel("Time (hours)")
+    if len(series["stations"]) <= 10:
+        axs[1].legend(loc="upper right")
+
+    for ax in axs:
+        ax.grid(True, axis="y", linestyle="--", alpha=0.4)
+
+    plt.tight_layout()
+    plt.show()
+
+
 def main():
     """Main function to load data, process events, and plot results."""
     parser = argparse.ArgumentParser()
-    parser.add_argument("--events", help="Path to events.jsonl", required=True)
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument("--events", help="Path to events.json, events.json.gz or events.bin")
+    group.add_argument("--summary", help="Path to a summary.json written by analyze")
+    group.add_argument("--timeseries", help="Path to a timeseries.*.json report")
     args = parser.parse_args()
 
-    # Load events from the JSON Lines file
-    events = load_events(args.events)
-    if not events:
-        raise ValueError("No events loaded from file.")
+    if args.timeseries:
+        plot_time_series(args.timeseries)
+        return
+
+    if args.summary:
+        # Aggregated natively; much faster than process_events on large logs
+        truck_stats, station_stats, truck_efficiency, station_efficiency = load_summary(args.summary)
+    else:
+        # Load events from the JSON Lines file
+        events = load_events(args.events)
+        if not events:
+            raise ValueError("No events loaded from file.")
 
-    # Determine simulation_duration as the maximum end_time among all events
-    simulation_duration = max(e["end_time"] for e in events)
+        # Determine simulation_duration as the maximum end_time among all events
+        simulation_duration = max(e["end_time"] for e in events)
 
-    # Process events and gather stats
-    truck_stats, station_stats, truck_efficiency, station_efficiency = process_events(events, simulation_duration)
+        # Process events and gather stats
+        truck_stats, station_stats, truck_efficiency, station_efficiency = process_events(events, simulation_duration)
 
     # Create a 2x2 subplot layout
     fig, axs = plt.subplots(2, 2, figsize=(14, 12))
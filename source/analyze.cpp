@@ -0,0 +1,336 @@
+#include "analyze.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+
+#include "logger.h"
+#include "thread_pool.h"
+
+using json = nlohmann::json;
+
+namespace {
+// Chunks smaller than this are not worth a task of their own
+constexpr size_t kMinChunkBytes = 1 << 20;
+
+size_t NumChunks(size_t bytes, size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return std::clamp<size_t>(bytes / kMinChunkBytes, 1, num_threads);
+}
+
+const char* SkipSpace(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+  return p;
+}
+
+// Reads a quoted string without escapes; returns nullptr if there is none
+const char* ParseString(const char* p, const char* end, std::string_view* s) {
+  if (p == end || *p != '"') return nullptr;
+  const char* start = ++p;
+  while (p < end && *p != '"') {
+    if (*p == '\\') return nullptr;  // Never written by EventToJsonLine
+    ++p;
+  }
+  if (p == end) return nullptr;
+  *s = std::string_view(start, p - start);
+  return p + 1;
+}
+
+bool ParseType(std::string_view s, uint32_t* type) {
+  EventType value;
+  if (s == "Mine") {
+    value = EventType::Mine;
+  } else if (s == "Unload") {
+    value = EventType::Unload;
+  } else if (s == "Queue") {
+    value = EventType::Queue;
+  } else if (s == "TravelToStation" || s == "Travel") {
+    value = EventType::TravelToStation;
+  } else if (s == "TravelToMine") {
+    value = EventType::TravelToMine;
+  } else {
+    return false;
+  }
+  *type = static_cast<uint32_t>(value);
+  return true;
+}
+
+// Summarizes the whole lines in [begin, end)
+void SummarizeLines(const char* begin, const char* end,
+                    EventLogSummary* summary) {
+  EventRecord record;
+  while (begin < end) {
+    const char* newline =
+        static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    const char* line_end = newline != nullptr ? newline : end;
+    const std::string_view line(begin, line_end - begin);
+    if (line.find_first_not_of(" \t\r") != std::string_view::npos) {
+      if (ParseEventRecord(line, &record)) {
+        summary->Add(record);
+      } else {
+        ++summary->skipped_lines;
+      }
+    }
+    begin = line_end + 1;
+  }
+}
+
+// Start of the first line at or after offset
+size_t NextLineStart(std::span<const char> bytes, size_t offset) {
+  if (offset == 0 || offset >= bytes.size()) {
+    return std::min(offset, bytes.size());
+  }
+  const void* newline =
+      std::memchr(bytes.data() + offset - 1, '\n', bytes.size() - offset + 1);
+  if (newline == nullptr) return bytes.size();
+  return static_cast<const char*>(newline) - bytes.data() + 1;
+}
+}  // namespace
+
+void EventLogSummary::Add(const EventRecord& record) {
+  ++num_events;
+  duration = std::max(duration, minutes_t(record.end_time));
+  if (record.truck_id >= trucks.size()) trucks.resize(record.truck_id + 1);
+
+  const minutes_t span = minutes_t(record.end_time) -
+                         minutes_t(record.start_time);
+  TruckActivity& truck = trucks[record.truck_id];
+  switch (static_cast<EventType>(record.type)) {
+    case EventType::Mine:
+      truck.mine += span;
+      break;
+    case EventType::TravelToStation:
+    case EventType::TravelToMine:
+      truck.travel += span;
+      break;
+    case EventType::Queue:
+      truck.queue += span;
+      break;
+    case EventType::Unload:
+      truck.unload += span;
+      ++truck.trips_completed;
+      if (record.station_id != kNoStation) {
+        if (record.station_id >= stations.size()) {
+          stations.resize(record.station_id + 1);
+        }
+        stations[record.station_id].unload += span;
+        ++stations[record.station_id].unload_count;
+      }
+      break;
+  }
+}
+
+void EventLogSummary::Merge(const EventLogSummary& other) {
+  num_events += other.num_events;
+  skipped_lines += other.skipped_lines;
+  duration = std::max(duration, other.duration);
+  if (other.trucks.size() > trucks.size()) trucks.resize(other.trucks.size());
+  for (size_t i = 0; i < other.trucks.size(); ++i) {
+    trucks[i].mine += other.trucks[i].mine;
+    trucks[i].travel += other.trucks[i].travel;
+    trucks[i].queue += other.trucks[i].queue;
+    trucks[i].unload += other.trucks[i].unload;
+    trucks[i].trips_completed += other.trucks[i].trips_completed;
+  }
+  if (other.stations.size() > stations.size()) {
+    stations.resize(other.stations.size());
+  }
+  for (size_t i = 0; i < other.stations.size(); ++i) {
+    stations[i].unload += other.stations[i].unload;
+    stations[i].unload_count += other.stations[i].unload_count;
+  }
+}
+
+double EventLogSummary::TruckEfficiency(size_t truck_id) const {
+  if (duration <= 0min) return 0.0;
+  const TruckActivity& t = trucks[truck_id];
+  return static_cast<double>((t.mine + t.travel + t.unload).count()) /
+         duration.count();
+}
+
+double EventLogSummary::StationEfficiency(size_t station_id) const {
+  if (duration <= 0min) return 0.0;
+  return static_cast<double>(stations[station_id].unload.count()) /
+         duration.count();
+}
+
+// Walks the "key": value pairs of a flat object. Keys may come in any order;
+// unknown keys are ignored as long as their value is a string, an unsigned
+// integer or null.
+bool ParseEventRecord(std::string_view line, EventRecord* record) {
+  const char* p = line.data();
+  const char* end = p + line.size();
+  enum : unsigned { kType = 1, kTruck = 2, kStart = 4, kEnd = 8 };
+  unsigned seen = 0;
+  record->station_id = kNoStation;
+
+  p = SkipSpace(p, end);
+  if (p == end || *p++ != '{') return false;
+  while (true) {
+    p = SkipSpace(p, end);
+    if (p < end && *p == '}') break;
+
+    std::string_view key;
+    if ((p = ParseString(p, end, &key)) == nullptr) return false;
+    p = SkipSpace(p, end);
+    if (p == end || *p++ != ':') return false;
+    p = SkipSpace(p, end);
+    if (p == end) return false;
+
+    if (*p == '"') {
+      std::string_view value;
+      if ((p = ParseString(p, end, &value)) == nullptr) return false;
+      if (key == "type") {
+        if (!ParseType(value, &record->type)) return false;
+        seen |= kType;
+      }
+    } else if (*p == 'n') {
+      if (end - p < 4 || std::string_view(p, 4) != "null") return false;
+      p += 4;
+    } else {
+      uint32_t value = 0;
+      const auto [next, error] = std::from_chars(p, end, value);
+      if (error != std::errc()) return false;
+      p = next;
+      if (key == "truck_id") {
+        record->truck_id = value;
+        seen |= kTruck;
+      } else if (key == "station_id") {
+        record->station_id = value;
+      } else if (key == "start_time") {
+        record->start_time = value;
+        seen |= kStart;
+      } else if (key == "end_time") {
+        record->end_time = value;
+        seen |= kEnd;
+      }
+    }
+
+    p = SkipSpace(p, end);
+    if (p < end && *p == ',') {
+      ++p;
+    } else if (p == end || *p != '}') {
+      return false;
+    }
+  }
+  return seen == (kType | kTruck | kStart | kEnd) &&
+         SkipSpace(p + 1, end) == end;
+}
+
+// Each chunk gets its own partial summary so the tasks share nothing; the
+// partials are merged afterwards. Chunks follow the number of threads rather
+// than a fixed size because every partial holds a slot per truck.
+EventLogSummary AnalyzeEventLog(const std::string& filename,
+                                size_t num_threads) {
+  const bool binary = IsBinaryEventLog(filename);
+  std::vector<EventLogSummary> partials;
+  WorkStealingPool pool(num_threads);
+
+  std::optional<MappedEventLog> log;
+  std::optional<MappedFile> file;
+  std::string decompressed;  // Compressed logs are analyzed in memory
+  if (binary) {
+    log.emplace(filename);
+    const std::span<const EventRecord> records = log->records();
+    const size_t chunks = NumChunks(records.size_bytes(), pool.num_threads());
+    partials.resize(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+      EventLogSummary* partial = &partials[c];
+      partial->trucks.resize(log->header().num_trucks);
+      partial->stations.resize(log->header().num_stations);
+      const auto part = records.subspan(
+          records.size() * c / chunks,
+          records.size() * (c + 1) / chunks - records.size() * c / chunks);
+      pool.Submit([partial, part] {
+        for (const auto& record : part) partial->Add(record);
+      });
+    }
+  } else {
+    std::span<const char> bytes;
+    if (IsCompressedEventLog(filename)) {
+      decompressed = DecompressEventLog(filename);
+      bytes = decompressed;
+    } else {
+      file.emplace(filename);
+      bytes = file->bytes();
+    }
+    const size_t chunks = NumChunks(bytes.size(), pool.num_threads());
+    partials.resize(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+      EventLogSummary* partial = &partials[c];
+      const size_t begin = NextLineStart(bytes, bytes.size() * c / chunks);
+      const size_t end = NextLineStart(bytes, bytes.size() * (c + 1) / chunks);
+      const char* data = bytes.data();
+      pool.Submit([partial, data, begin, end] {
+        SummarizeLines(data + begin, data + end, partial);
+      });
+    }
+  }
+  pool.Wait();
+
+  EventLogSummary summary = std::move(partials[0]);
+  for (size_t c = 1; c < partials.size(); ++c) summary.Merge(partials[c]);
+  return summary;
+}
+
+void WriteEventLogSummary(const std::string& filename,
+                          const EventLogSummary& summary) {
+  std::ofstream out(filename);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open summary file for writing: " +
+                             filename);
+  }
+
+  const size_t num_trucks = summary.trucks.size();
+  std::vector<int64_t> mine(num_trucks), travel(num_trucks);
+  std::vector<int64_t> queue(num_trucks), unload(num_trucks);
+  std::vector<size_t> trips(num_trucks);
+  std::vector<double> truck_efficiency(num_trucks);
+  for (size_t i = 0; i < num_trucks; ++i) {
+    const TruckActivity& t = summary.trucks[i];
+    mine[i] = t.mine.count();
+    travel[i] = t.travel.count();
+    queue[i] = t.queue.count();
+    unload[i] = t.unload.count();
+    trips[i] = t.trips_completed;
+    truck_efficiency[i] = summary.TruckEfficiency(i);
+  }
+
+  const size_t num_stations = summary.stations.size();
+  std::vector<int64_t> station_unload(num_stations);
+  std::vector<size_t> unload_count(num_stations);
+  std::vector<double> station_efficiency(num_stations);
+  for (size_t i = 0; i < num_stations; ++i) {
+    station_unload[i] = summary.stations[i].unload.count();
+    unload_count[i] = summary.stations[i].unload_count;
+    station_efficiency[i] = summary.StationEfficiency(i);
+  }
+
+  // Column arrays indexed by id, like the time series report
+  json j;
+  j["events"] = summary.num_events;
+  j["skipped_lines"] = summary.skipped_lines;
+  j["simulation_duration"] = summary.duration.count();
+  j["trucks"] = {
+      {"mine", mine},
+      {"travel", travel},
+      {"queue", queue},
+      {"unload", unload},
+      {"trips_completed", trips},
+      {"efficiency", truck_efficiency},
+  };
+  j["stations"] = {
+      {"unload", station_unload},
+      {"unload_count", unload_count},
+      {"efficiency", station_efficiency},
+  };
+  out << j.dump() << std::endl;
+}
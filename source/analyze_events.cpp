@@ -0,0 +1,72 @@
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "analyze.h"
+
+void PrintUsage(const char* program_name) {
+  std::cerr << "Usage: " << program_name << " [options] <events> [summary]\n"
+            << "  Summarizes a JSON Lines or binary event log into the "
+               "per-truck and per-station\n"
+            << "  totals plot_report.py plots (summary default: "
+               "summary.json).\n"
+            << "Options:\n"
+            << "  --threads=<n>      Worker threads (default: all cores)\n";
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> args;
+  size_t num_threads = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--threads=", 0) == 0) {
+      try {
+        num_threads = std::stoul(arg.substr(10));
+      } catch (const std::exception&) {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Error: Unknown option " << arg << "\n";
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (args.empty() || args.size() > 2) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const std::string output = args.size() > 1 ? args[1] : "summary.json";
+
+  try {
+    auto start_time = std::chrono::steady_clock::now();
+    const EventLogSummary summary = AnalyzeEventLog(args[0], num_threads);
+    auto end_time = std::chrono::steady_clock::now();
+    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           end_time - start_time)
+                           .count();
+
+    WriteEventLogSummary(output, summary);
+    std::cout << "Analyzed " << summary.num_events << " events ("
+              << summary.trucks.size() << " trucks, "
+              << summary.stations.size() << " stations) in " << duration_ms
+              << " ms\n";
+    if (summary.skipped_lines > 0) {
+      std::cout << "Skipped " << summary.skipped_lines
+                << " invalid JSON lines\n";
+    }
+    std::cout << "Summary: " << output << "\n";
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "logger.h"
+
+namespace {
+// One StationQueue entry on disk
+struct StationRecord {
+  int64_t time;
+  uint64_t station_id;
+};
+
+template <typename T>
+void WriteSection(std::ofstream* out, const std::vector<T>& values) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  const uint64_t count = values.size();
+  out->write(reinterpret_cast<const char*>(&count), sizeof(count));
+  out->write(reinterpret_cast<const char*>(values.data()),
+             static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+std::vector<T> ReadSection(std::ifstream* in, const std::string& filename) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  uint64_t count = 0;
+  in->read(reinterpret_cast<char*>(&count), sizeof(count));
+  std::vector<T> values;
+  // The count is checked against the bytes left before allocating, so a
+  // corrupt one fails as a short file
+  const auto position = in->tellg();
+  in->seekg(0, std::ios::end);
+  const auto remaining = static_cast<uint64_t>(in->tellg() - position);
+  in->seekg(position);
+  if (!*in || count > remaining / sizeof(T)) {
+    Logger::LogAndThrowError("Checkpoint is cut short: " + filename);
+  }
+  values.resize(count);
+  in->read(reinterpret_cast<char*>(values.data()),
+           static_cast<std::streamsize>(count * sizeof(T)));
+  return values;
+}
+
+// Reads and validates the header at the start of in
+CheckpointHeader ReadHeader(std::ifstream* in, const std::string& filename) {
+  if (!in->is_open()) {
+    Logger::LogAndThrowError("Unable to open checkpoint for reading: " +
+                             filename);
+  }
+  CheckpointHeader header{};
+  if (!in->read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kCheckpointMagic, sizeof(header.magic)) !=
+          0) {
+    Logger::LogAndThrowError("Not a checkpoint: " + filename);
+  }
+  if (header.version != kCheckpointVersion) {
+    Logger::LogAndThrowError("Unsupported checkpoint version in " + filename);
+  }
+  return header;
+}
+}  // namespace
+
+void WriteCheckpoint(const std::string& filename,
+                     const Checkpoint& checkpoint) {
+  CheckpointHeader header{};
+  std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+  header.version = kCheckpointVersion;
+  header.num_trucks = checkpoint.params.num_trucks;
+  header.num_stations = checkpoint.params.num_stations;
+  header.random_seed = checkpoint.params.random_seed;
+  header.sim_minutes = checkpoint.params.sim_time.count();
+  header.time = checkpoint.time.count();
+  header.events_emitted = checkpoint.events_emitted;
+  header.time_series_interval = checkpoint.time_series_interval.count();
+  header.station_last_popped = checkpoint.station_queue.last_popped.count();
+  header.station_last_marked = checkpoint.station_queue.last_marked.count();
+
+  std::vector<StationRecord> stations;
+  stations.reserve(checkpoint.station_queue.entries.size());
+  for (const auto& [time, station_id] : checkpoint.station_queue.entries) {
+    stations.push_back({time.count(), station_id});
+  }
+
+  const std::string temporary = filename + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      Logger::LogAndThrowError("Unable to open checkpoint for writing: " +
+                               temporary);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteSection(&out, std::vector<char>(checkpoint.mining_distribution.begin(),
+                                         checkpoint.mining_distribution.end()));
+    WriteSection(&out, checkpoint.pending);
+    WriteSection(&out, checkpoint.deferred);
+    WriteSection(&out, stations);
+    WriteSection(&out, checkpoint.station_queue.counters);
+
+    const auto& trucks = checkpoint.metrics.trucks();
+    for (const auto* column :
+         {&trucks.mining_time, &trucks.travel_time, &trucks.queueing_time,
+          &trucks.unloading_time, &trucks.trips_completed,
+          &trucks.mines_completed, &trucks.queues_completed}) {
+      WriteSection(&out, *column);
+    }
+    const auto& station_columns = checkpoint.metrics.stations();
+    WriteSection(&out, station_columns.unloading_time);
+    WriteSection(&out, station_columns.queueing_time);
+    WriteSection(&out, station_columns.throughput);
+    WriteSection(&out, station_columns.queues_completed);
+
+    WriteSection(&out, checkpoint.truck_minutes);
+    WriteSection(&out, checkpoint.busy_minutes);
+    WriteSection(&out, checkpoint.queue_minutes);
+    out.flush();
+    if (!out) {
+      Logger::LogAndThrowError("Unable to write checkpoint: " + temporary);
+    }
+  }
+  if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+    Logger::LogAndThrowError("Unable to replace checkpoint: " + filename);
+  }
+}
+
+CheckpointHeader ReadCheckpointHeader(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  return ReadHeader(&in, filename);
+}
+
+Checkpoint ReadCheckpoint(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  const CheckpointHeader header = ReadHeader(&in, filename);
+
+  Checkpoint checkpoint;
+  checkpoint.params = {header.num_trucks, header.num_stations,
+                       minutes_t(header.sim_minutes), header.random_seed};
+  checkpoint.time = minutes_t(header.time);
+  checkpoint.events_emitted = header.events_emitted;
+  checkpoint.time_series_interval = minutes_t(header.time_series_interval);
+  checkpoint.station_queue.last_popped = minutes_t(header.station_last_popped);
+  checkpoint.station_queue.last_marked = minutes_t(header.station_last_marked);
+
+  const auto mining_distribution = ReadSection<char>(&in, filename);
+  checkpoint.mining_distribution.assign(mining_distribution.begin(),
+                                        mining_distribution.end());
+  checkpoint.pending = ReadSection<PackedEvent>(&in, filename);
+  checkpoint.deferred = ReadSection<PackedEvent>(&in, filename);
+  const auto stations_queued = ReadSection<StationRecord>(&in, filename);
+  for (const StationRecord& record : stations_queued) {
+    checkpoint.station_queue.entries.emplace_back(minutes_t(record.time),
+                                                  record.station_id);
+  }
+  checkpoint.station_queue.counters = ReadSection<int64_t>(&in, filename);
+
+  MetricsStore::TruckColumns trucks;
+  for (auto* column :
+       {&trucks.mining_time, &trucks.travel_time, &trucks.queueing_time,
+        &trucks.unloading_time, &trucks.trips_completed,
+        &trucks.mines_completed, &trucks.queues_completed}) {
+    *column = ReadSection<int32_t>(&in, filename);
+    if (column->size() != header.num_trucks) {
+      Logger::LogAndThrowError("Corrupt truck metrics in " + filename);
+    }
+  }
+  MetricsStore::StationColumns stations;
+  stations.unloading_time = ReadSection<int64_t>(&in, filename);
+  stations.queueing_time = ReadSection<int64_t>(&in, filename);
+  stations.throughput = ReadSection<int32_t>(&in, filename);
+  stations.queues_completed = ReadSection<int32_t>(&in, filename);
+  for (const size_t size :
+       {stations.unloading_time.size(), stations.queueing_time.size(),
+        stations.throughput.size(), stations.queues_completed.size()}) {
+    if (size != header.num_stations) {
+      Logger::LogAndThrowError("Corrupt station metrics in " + filename);
+    }
+  }
+  checkpoint.metrics =
+      MetricsStore::FromColumns(std::move(trucks), std::move(stations));
+
+  checkpoint.truck_minutes = ReadSection<int64_t>(&in, filename);
+  checkpoint.busy_minutes = ReadSection<int64_t>(&in, filename);
+  checkpoint.queue_minutes = ReadSection<int64_t>(&in, filename);
+  return checkpoint;
+}
@@ -1,77 +1,248 @@
 #include "controller.h"
 
 #include <algorithm>
-#include <cassert>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 #include "logger.h"
 
-void StationQueue::Initialize(size_t num_stations) {
-  for (size_t i = 0; i < num_stations; ++i) {
-    queue_.emplace(0min, i);
-  }
+namespace {
+
+// End of the stage of a monitored run after the one ending at end: the
+// first once there are enough observation groups for the batch means, then
+// a tenth of the run so far (at least a group) at a time, so that the
+// transitions rescheduled at each stage end add little work. Stages end on
+// whole groups, and at sim_time at the latest.
+minutes_t NextStage(minutes_t end, minutes_t sim_time,
+                    const SteadyStateOptions& options) {
+  const minutes_t group = options.interval * int64_t{kMserBatch};
+  const minutes_t step =
+      end == 0min
+          ? group * static_cast<int64_t>(options.num_batches)
+          : std::max(group, (end / 10 + group - 1min) / group * group);
+  return std::min(end + step, sim_time);
 }
 
-bool StationQueue::Empty() const { return queue_.empty(); }
+}  // namespace
 
-std::pair<minutes_t, size_t> StationQueue::PopNextAvailable() {
-  auto entry = queue_.top();
-  queue_.pop();
-  return entry;
+double EngineStats::EventsPerSecond() const {
+  return loop_ms > 0.0 ? events_processed / (loop_ms / 1000.0) : 0.0;
+}
+
+void PrintEngineStats(const EngineStats& stats) {
+  if constexpr (!kStatsEnabled) {
+    std::cout << "\nStatistics are compiled out (VAST_ENABLE_STATS=OFF)\n";
+    return;
+  }
+  std::cout << "\n=== Engine Statistics ===\n"
+            << std::fixed << std::setprecision(3)
+            << "Events Processed: " << stats.events_processed << "\n"
+            << "Events Emitted:";
+  for (size_t i = 0; i < kNumEventTypes; ++i) {
+    std::cout << (i > 0 ? ", " : " ")
+              << EventTypeToString(static_cast<EventType>(i)) << " "
+              << stats.events_by_type[i];
+  }
+  std::cout << "\n"
+            << "Events/sec: " << std::setprecision(0)
+            << stats.EventsPerSecond() << std::setprecision(3) << "\n"
+            << "Peak Pending Events: " << stats.peak_pending_events << "\n"
+            << "Peak Queued Trucks: " << stats.peak_queued_trucks << "\n"
+            << "Random Draws: " << stats.random_draws << "\n"
+            << "Trace Messages: " << stats.trace_messages << " ("
+            << stats.trace_ms << " ms)\n"
+            << "Phase Times: setup " << stats.setup_ms << " ms, loop "
+            << stats.loop_ms << " ms, metrics " << stats.metrics_ms
+            << " ms, export " << stats.export_ms << " ms\n";
+  if (stats.epochs > 0) {
+    std::cout << "Epochs: " << stats.epochs << " (serial phase "
+              << stats.serial_ms << " ms)\n";
+  }
 }
 
-void StationQueue::MarkAvailable(minutes_t time, size_t station_id) {
-  queue_.emplace(time, station_id);
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void
+BasicController<Sink, Scheduler, Timing, Dispatch>::ConvertMetrics() const {
+  if (metrics_converted_) return;
+  metrics_.ToMetrics(&trucks_metrics_, &station_metrics_);
+  metrics_converted_ = true;
 }
 
-// Constructor initializes number of trucks, stations, and RNG seed
-Controller::Controller(size_t num_trucks, size_t num_stations,
-                       size_t random_seed)
+// Constructor initializes number of trucks, stations, RNG seed and sink
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+BasicController<Sink, Scheduler, Timing, Dispatch>::BasicController(
+    size_t num_trucks, size_t num_stations, size_t random_seed, Sink sink,
+    std::pmr::memory_resource* arena)
     : num_trucks_(num_trucks),
       num_stations_(num_stations),
-      engine_(random_seed) {}
+      random_seed_(random_seed),
+      rng_(random_seed),
+      sink_(std::move(sink)),
+      event_queue_(kMaxDuration, arena) {}
+
+// Utility to create, emit, and enqueue an event
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::EmitEvent(
+    EventType type, size_t truck_id, std::optional<size_t> station_id,
+    minutes_t start, minutes_t end) {
+  const PackedEvent event(
+      type, truck_id,
+      station_id.has_value() ? static_cast<uint32_t>(station_id.value())
+                             : PackedEvent::kNoStation,
+      start, end);
+  sink_.OnEvent(event.ToEvent());  // Optimized away for NullEventSink
+  ++events_emitted_;
+  event_queue_.Push(event);
+  if constexpr (kStatsEnabled) {
+    ++stats_.events_by_type[static_cast<size_t>(type)];
+  }
+}
 
-// Utility to create, log, and enqueue an event
-void Controller::EmitEvent(EventType type, size_t truck_id,
-                           std::optional<size_t> station_id, minutes_t start,
-                           minutes_t end) {
-  const Event event{type, truck_id, station_id, start, end};
-  LogEvent(event);
-  event_queue_.push({end, event});
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::Run(
+    minutes_t sim_time) {
+  Simulate(sim_time);
+  if (num_trucks_ == 0 || num_stations_ == 0) return;
+  StatsTimer timer;
+  ExportMetrics(sim_duration_, metrics_, metrics_export_);
+  if (time_series_.enabled()) {
+    std::cout << "Time series report: "
+              << ExportTimeSeriesToJson(num_trucks_, time_series_) << "\n";
+  }
+  if (steady_state_.enabled()) {
+    PrintSteadyStateSummary(steady_state_.result());
+    std::cout << "\nSteady-state report: "
+              << ExportSteadyStateToJson(num_trucks_, num_stations_,
+                                         steady_state_.result())
+              << "\n";
+  }
+  if constexpr (kStatsEnabled) stats_.export_ms = timer.Lap();
 }
 
-void Controller::Run(minutes_t sim_time) {
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::Simulate(
+    minutes_t sim_time) {
   if (num_trucks_ == 0 || num_stations_ == 0) {
     Logger::LogError("No trucks or stations.");
     return;
   }
 
+  if (num_trucks_ > size_t{PackedEvent::kMaxTruckId} + 1) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Too many trucks: at most " +
+        std::to_string(size_t{PackedEvent::kMaxTruckId} + 1) + " supported");
+  }
+  if (sim_time > MetricsStore::kMaxSimTime) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Simulation time too long: at most " +
+        std::to_string(MetricsStore::kMaxSimTime.count()) +
+        " minutes supported");
+  }
+  timing_.Validate(num_trucks_, num_stations_);
+  if (steady_state_options_.interval > 0min &&
+      (checkpoint_interval_ > 0min || resume_from_.has_value())) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "A run monitored for steady state cannot be checkpointed or "
+        "resumed");
+  }
+
+  StatsTimer timer;
+  stats_ = {};
   sim_duration_ = sim_time;
-  trucks_metrics_.assign(num_trucks_, {});
-  station_metrics_.assign(num_stations_, {});
-  station_queue_.Initialize(num_stations_);
+  sink_.OnRunStart({num_trucks_, num_stations_, sim_time, random_seed_});
+  metrics_converted_ = false;
+  next_checkpoint_ =
+      checkpoint_interval_ > 0min ? checkpoint_interval_ : minutes_t::max();
+
+  if (resume_from_.has_value()) {
+    const Checkpoint checkpoint = std::move(*resume_from_);
+    resume_from_.reset();
+    Restore(checkpoint);
+  } else {
+    metrics_.Reset(num_trucks_, num_stations_);
+    station_queue_.Initialize(num_stations_);
+    event_queue_.Clear();
+    time_series_.Reset(time_series_interval_, sim_time, num_stations_);
+    steady_state_.Reset(steady_state_options_, sim_time, num_stations_);
+    deferred_.clear();
+    events_emitted_ = 0;
+    if (steady_state_.enabled()) {
+      sim_duration_ = NextStage(0min, sim_time, steady_state_options_);
+    }
+
+    // Dispatch all trucks to start mining
+    for (size_t i = 0; i < num_trucks_; i++) {
+      Mine(i, 0min);
+    }
+  }
 
-  // Dispatch all trucks to start mining
-  for (size_t i = 0; i < num_trucks_; i++) {
-    Mine(i, 0min);
+  if constexpr (kStatsEnabled) {
+    waiting_trucks_.Clear();
+    stats_.setup_ms = timer.Lap();
   }
 
-  // Main simulation loop: handle events until no more remain
-  while (!event_queue_.empty()) {
-    const auto [start_time, previous_event] = event_queue_.top();
-    event_queue_.pop();
-    ProcessEvent(start_time, previous_event);
+  // Main simulation loop: handle events until no more remain. A monitored
+  // run ends a stage when they do, and goes on to the next unless the
+  // estimates have converged.
+  while (true) {
+    while (!event_queue_.Empty()) {
+      if constexpr (kStatsEnabled) {
+        stats_.peak_pending_events =
+            std::max(stats_.peak_pending_events, event_queue_.Size());
+        ++stats_.events_processed;
+      }
+      const PackedEvent event = event_queue_.Pop();
+      if (event.end_time() > next_checkpoint_) [[unlikely]] {
+        WriteCheckpointBefore(event);
+      }
+      ProcessEvent(event);
+    }
+    if (!steady_state_.enabled() || steady_state_.Update(sim_duration_) ||
+        sim_duration_ >= sim_time) {
+      break;
+    }
+    ExtendRun(NextStage(sim_duration_, sim_time, steady_state_options_));
+  }
+  if (checkpoint_interval_ > 0min) {
+    WriteCheckpoint(checkpoint_filename_, SaveCheckpoint());
   }
+  if (sim_duration_ < sim_time) {
+    time_series_.Truncate(sim_duration_);
+    sink_.OnRunEnd({num_trucks_, num_stations_, sim_duration_, random_seed_});
+  }
+  if constexpr (kStatsEnabled) stats_.loop_ms = timer.Lap();
+
+  // Collect simulation metrics
+  metrics_.Derive(sim_duration_);
+  if constexpr (kStatsEnabled) stats_.metrics_ms = timer.Lap();
+}
 
-  // Collect and export simulation metrics
-  GenerateMetrics(sim_time, &trucks_metrics_, &station_metrics_);
-  ExportMetricsToJson(sim_time, trucks_metrics_, station_metrics_);
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::ExtendRun(
+    minutes_t sim_time) {
+  sim_duration_ = sim_time;
+  std::vector<PackedEvent> deferred;
+  deferred.swap(deferred_);
+  for (const PackedEvent& event : deferred) Schedule(event);
 }
 
 // Handle a single simulation event by delegating to the appropriate transition
-void Controller::ProcessEvent(minutes_t start_time, const Event& event) {
-  assert(start_time == event.end_time);
-  const auto truck_id = event.truck_id;
-  switch (event.type) {
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::ProcessEvent(
+    const PackedEvent& event) {
+  const auto start_time = event.end_time();
+  const auto truck_id = event.truck_id();
+  switch (event.type()) {
     case EventType::Mine: {
       TravelToStation(truck_id, start_time);
       break;
@@ -100,83 +271,325 @@ void Controller::ProcessEvent(minutes_t start_time, const Event& event) {
 }
 
 // Check if a time is beyond the simulation limit, and log if so
-bool Controller::ExceedsSimTime(minutes_t time) const {
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+bool BasicController<Sink, Scheduler, Timing, Dispatch>::ExceedsSimTime(
+    minutes_t time) {
   if (time <= sim_duration_) return false;
+  if (!Logger::TraceEnabled()) return true;
+  StatsTimer timer;
   Logger::LogTrace(
       "[Time Limit Exceeded] Time: " + std::to_string(time.count()) +
       ", Limit: " + std::to_string(sim_duration_.count()));
+  if constexpr (kStatsEnabled) {
+    ++stats_.trace_messages;
+    stats_.trace_ms += timer.Lap();
+  }
   return true;
 }
 
-// Generate a random mining duration within a fixed range
-minutes_t Controller::RandomMiningDuration() {
-  std::uniform_int_distribution<uint64_t> dist(kMinDuration.count(),
-                                               kMaxDuration.count());
-  return minutes_t(dist(engine_));
+// Draw the truck's next mining duration from its class's distribution, or
+// else the controller's
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+minutes_t
+BasicController<Sink, Scheduler, Timing, Dispatch>::RandomMiningDuration(
+    size_t truck_id) {
+  if constexpr (kStatsEnabled) ++stats_.random_draws;
+  // Every mine started before this one was recorded: a draw that ends past
+  // the end of the run is the truck's last until the run is extended, and
+  // the extension records it first. Reading the count here also loads the
+  // cache line that recording this mine is about to update.
+  const auto cycle = static_cast<uint32_t>(
+      metrics_.trucks().mines_completed[truck_id]);
+  const MiningDistribution* distribution = timing_.Mining(truck_id);
+  if (distribution == nullptr) distribution = &mining_distribution_;
+  return distribution->Sample(rng_, static_cast<uint32_t>(truck_id), cycle);
 }
 
-// Schedule the truck to travel from mine to station
-void Controller::TravelToStation(size_t truck_id, minutes_t start_time) {
-  const auto end_time = start_time + kTravelTime;
-  if (!ExceedsSimTime(end_time)) {
-    EmitEvent(EventType::TravelToStation, truck_id, std::nullopt, start_time,
-              end_time);
-    trucks_metrics_[truck_id].travel_time += kTravelTime;
+// What a checkpoint must be resumed with besides the fleet and seed
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+std::string
+BasicController<Sink, Scheduler, Timing, Dispatch>::Configuration() const {
+  std::string configuration;
+  if constexpr (std::is_same_v<Timing, FixedTiming>) {
+    configuration = mining_distribution_.Describe();
+  } else {
+    configuration = timing_.Describe();
   }
+  const std::string dispatch = station_queue_.Describe();
+  return dispatch.empty() ? configuration
+                          : configuration + ";dispatch=" + dispatch;
+}
+
+// Schedule the truck to travel from mine to station
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::TravelToStation(
+    size_t truck_id, minutes_t start_time) {
+  Schedule(PackedEvent(EventType::TravelToStation, truck_id,
+                       PackedEvent::kNoStation, start_time,
+                       start_time + timing_.TravelTime(truck_id)));
 }
 
 // Record that the truck waited in line at a station
-void Controller::RecordQueueing(size_t truck_id, size_t station_id,
-                                minutes_t start_time, minutes_t end_time) {
-  EmitEvent(EventType::Queue, truck_id, station_id, start_time, end_time);
-  const auto duration = end_time - start_time;
-  trucks_metrics_[truck_id].queueing_time += duration;
-  trucks_metrics_[truck_id].queues_completed++;
-  station_metrics_[station_id].queueing_time += duration;
-  station_metrics_[station_id].queues_completed++;
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::RecordQueueing(
+    size_t truck_id, size_t station_id, minutes_t start_time,
+    minutes_t end_time) {
+  // Queue events are informational: the Unload that follows is what gets
+  // scheduled, so the event only goes to the sink
+  sink_.OnEvent({EventType::Queue, truck_id, station_id, start_time, end_time});
+  ++events_emitted_;
+  if constexpr (kStatsEnabled) {
+    ++stats_.events_by_type[static_cast<size_t>(EventType::Queue)];
+  }
+  metrics_.AddQueueing(truck_id, station_id, end_time - start_time);
+  time_series_.AddTruckSpan(TruckState::Queueing, start_time, end_time);
+  time_series_.AddStationQueue(station_id, start_time, end_time);
 }
 
 // Schedule the truck to unload at a station
-void Controller::UnloadTruck(size_t truck_id, minutes_t start_time) {
-  const auto [available_time, station_id] = station_queue_.PopNextAvailable();
-
-  // If the truck arrives before the station is available, track wait time
-  const auto end_time = std::max(start_time, available_time) + kUnloadTime;
-  if (!ExceedsSimTime(end_time)) {
-    if (available_time > start_time) {
-      RecordQueueing(truck_id, station_id, start_time, available_time);
-    }
-
-    start_time = std::max(available_time, start_time);
-    const auto end_time = start_time + kUnloadTime;
-    EmitEvent(EventType::Unload, truck_id, station_id, start_time, end_time);
-    station_queue_.MarkAvailable(end_time, station_id);
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::UnloadTruck(
+    size_t truck_id, minutes_t start_time) {
+  const auto [available_time, station_id] =
+      station_queue_.Assign(truck_id, start_time);
 
-    // Update metrics
-    trucks_metrics_[truck_id].trips_completed++;
-    trucks_metrics_[truck_id].unloading_time += kUnloadTime;
-    station_metrics_[station_id].throughput++;
-    station_metrics_[station_id].unloading_time += kUnloadTime;
+  // If the truck arrives before the station is available, it waits in line.
+  // The station is busy until the end even if that is past the end of the
+  // run (see deferred_).
+  const auto end_time = std::max(start_time, available_time) +
+                        timing_.UnloadTime(station_id);
+  station_queue_.MarkAvailable(end_time, station_id);
+  if constexpr (kStatsEnabled) {
+    stats_.peak_queued_trucks =
+        std::max(stats_.peak_queued_trucks,
+                 waiting_trucks_.Arrive(start_time, available_time));
   }
+  Schedule(PackedEvent(EventType::Unload, truck_id,
+                       static_cast<uint32_t>(station_id), start_time,
+                       end_time));
 }
 
 // Schedule the truck to return to the mine
-void Controller::TravelToMine(size_t truck_id, minutes_t start_time) {
-  const auto end_time = start_time + kTravelTime;
-  if (!ExceedsSimTime(end_time)) {
-    EmitEvent(EventType::TravelToMine, truck_id, std::nullopt, start_time,
-              end_time);
-    trucks_metrics_[truck_id].travel_time += kTravelTime;
-  }
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::TravelToMine(
+    size_t truck_id, minutes_t start_time) {
+  Schedule(PackedEvent(EventType::TravelToMine, truck_id,
+                       PackedEvent::kNoStation, start_time,
+                       start_time + timing_.TravelTime(truck_id)));
 }
 
 // Schedule the truck to mine again
-void Controller::Mine(size_t truck_id, minutes_t start_time) {
-  const auto duration = RandomMiningDuration();
-  const auto end_time = start_time + duration;
-  if (!ExceedsSimTime(end_time)) {
-    EmitEvent(EventType::Mine, truck_id, std::nullopt, start_time, end_time);
-    trucks_metrics_[truck_id].mines_completed++;
-    trucks_metrics_[truck_id].mining_time += duration;
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::Mine(
+    size_t truck_id, minutes_t start_time) {
+  const auto duration = RandomMiningDuration(truck_id);
+  Schedule(PackedEvent(EventType::Mine, truck_id, PackedEvent::kNoStation,
+                       start_time, start_time + duration));
+}
+
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::Schedule(
+    const PackedEvent& event) {
+  const auto truck_id = event.truck_id();
+  auto start_time = event.start_time();
+  const auto end_time = event.end_time();
+  if (ExceedsSimTime(end_time)) {
+    deferred_.push_back(event);
+    return;
   }
+
+  switch (event.type()) {
+    case EventType::Mine: {
+      EmitEvent(EventType::Mine, truck_id, std::nullopt, start_time,
+                end_time);
+      metrics_.AddMining(truck_id, end_time - start_time);
+      time_series_.AddTruckSpan(TruckState::Mining, start_time, end_time);
+      break;
+    }
+    case EventType::TravelToStation:
+    case EventType::TravelToMine: {
+      EmitEvent(event.type(), truck_id, std::nullopt, start_time, end_time);
+      metrics_.AddTravel(truck_id, end_time - start_time);
+      time_series_.AddTruckSpan(TruckState::Traveling, start_time, end_time);
+      break;
+    }
+    case EventType::Unload: {
+      const size_t station_id = event.station_id();
+      const minutes_t unload_time = timing_.UnloadTime(station_id);
+      if (end_time - unload_time > start_time) {
+        RecordQueueing(truck_id, station_id, start_time,
+                       end_time - unload_time);
+      }
+      start_time = end_time - unload_time;
+      EmitEvent(EventType::Unload, truck_id, station_id, start_time,
+                end_time);
+      metrics_.AddUnloading(truck_id, station_id, unload_time);
+      if (steady_state_.enabled()) {
+        steady_state_.AddUnload(end_time, unload_time,
+                                start_time - event.start_time());
+      }
+      time_series_.AddTruckSpan(TruckState::Unloading, start_time, end_time);
+      time_series_.AddStationBusy(station_id, start_time, end_time);
+      break;
+    }
+    default: {
+      Logger::LogError("Unrecognized event type!");
+      break;
+    }
+  }
+}
+
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::LoadCheckpoint(
+    const std::string& filename) {
+  Checkpoint checkpoint = ReadCheckpoint(filename);
+  const RunParameters& params = checkpoint.params;
+  if (params.num_trucks != num_trucks_ ||
+      params.num_stations != num_stations_ ||
+      params.random_seed != random_seed_) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Checkpoint " + filename + " is of another run (" +
+        std::to_string(params.num_trucks) + " trucks, " +
+        std::to_string(params.num_stations) + " stations, seed " +
+        std::to_string(params.random_seed) + ")");
+  }
+  if (checkpoint.mining_distribution != Configuration()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Checkpoint " + filename + " has another mining distribution, " +
+        "timing or dispatch (" +
+        checkpoint.mining_distribution + ")");
+  }
+  resume_from_ = std::move(checkpoint);
 }
+
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+Checkpoint BasicController<Sink, Scheduler, Timing, Dispatch>::MakeCheckpoint(
+    minutes_t time, const PackedEvent* front) const {
+  Checkpoint checkpoint;
+  checkpoint.params = {num_trucks_, num_stations_, sim_duration_,
+                       random_seed_};
+  checkpoint.time = time;
+  checkpoint.events_emitted = events_emitted_;
+  checkpoint.mining_distribution = Configuration();
+
+  if (front != nullptr) checkpoint.pending.push_back(*front);
+  const std::vector<PackedEvent> pending = event_queue_.Pending();
+  checkpoint.pending.insert(checkpoint.pending.end(), pending.begin(),
+                            pending.end());
+  checkpoint.deferred = deferred_;
+  checkpoint.station_queue = station_queue_.Save();
+  checkpoint.metrics = metrics_;
+
+  checkpoint.time_series_interval = time_series_.interval();
+  checkpoint.truck_minutes = time_series_.truck_minutes();
+  checkpoint.busy_minutes = time_series_.busy_minutes();
+  checkpoint.queue_minutes = time_series_.queue_minutes();
+  return checkpoint;
+}
+
+// Called with the first event past the next checkpoint time; the checkpoint
+// is taken at the last multiple of the interval before that event
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::WriteCheckpointBefore(
+    const PackedEvent& front) {
+  const minutes_t time =
+      next_checkpoint_ + (front.end_time() - next_checkpoint_ - 1min) /
+                             checkpoint_interval_ * checkpoint_interval_;
+  WriteCheckpoint(checkpoint_filename_, MakeCheckpoint(time, &front));
+  next_checkpoint_ = time + checkpoint_interval_;
+}
+
+// Events of the saved run are all pending again in their original order,
+// ahead of anything the resumed run pushes. Its deferred transitions are
+// scheduled as the longer run would have: they end past the saved run, so
+// their place among the pending events is set by time alone.
+template <EventSink Sink, EventScheduler Scheduler, TimingPolicy Timing,
+          StationDispatcher Dispatch>
+void BasicController<Sink, Scheduler, Timing, Dispatch>::Restore(
+    const Checkpoint& checkpoint) {
+  if (sim_duration_ < checkpoint.params.sim_time) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Cannot resume a run of " +
+        std::to_string(checkpoint.params.sim_time.count()) +
+        " minutes with a shorter one");
+  }
+
+  metrics_ = checkpoint.metrics;
+  station_queue_.Restore(checkpoint.station_queue);
+  event_queue_.Clear();
+  for (const PackedEvent& event : checkpoint.pending) event_queue_.Push(event);
+  events_emitted_ = checkpoint.events_emitted;
+
+  time_series_interval_ = checkpoint.time_series_interval;
+  time_series_.Reset(time_series_interval_, sim_duration_, num_stations_);
+  time_series_.AddBins(checkpoint.truck_minutes, checkpoint.busy_minutes,
+                       checkpoint.queue_minutes);
+
+  deferred_.clear();
+  for (const PackedEvent& event : checkpoint.deferred) Schedule(event);
+  if (checkpoint_interval_ > 0min) {
+    next_checkpoint_ = checkpoint.time + checkpoint_interval_;
+  }
+}
+
+template class BasicController<NullEventSink>;
+template class BasicController<VectorEventSink>;
+template class BasicController<FileEventSink>;
+template class BasicController<CallbackEventSink>;
+template class BasicController<NullEventSink, BinaryHeapScheduler>;
+template class BasicController<VectorEventSink, BinaryHeapScheduler>;
+template class BasicController<FileEventSink, BinaryHeapScheduler>;
+template class BasicController<NullEventSink, TimingWheelScheduler,
+                               ScenarioTiming>;
+template class BasicController<VectorEventSink, TimingWheelScheduler,
+                               ScenarioTiming>;
+template class BasicController<FileEventSink, TimingWheelScheduler,
+                               ScenarioTiming>;
+template class BasicController<NullEventSink, TimingWheelScheduler,
+                               FixedTiming, LeastLoadedDispatch>;
+template class BasicController<VectorEventSink, TimingWheelScheduler,
+                               FixedTiming, LeastLoadedDispatch>;
+template class BasicController<FileEventSink, TimingWheelScheduler,
+                               FixedTiming, LeastLoadedDispatch>;
+template class BasicController<NullEventSink, TimingWheelScheduler,
+                               ScenarioTiming, LeastLoadedDispatch>;
+template class BasicController<VectorEventSink, TimingWheelScheduler,
+                               ScenarioTiming, LeastLoadedDispatch>;
+template class BasicController<FileEventSink, TimingWheelScheduler,
+                               ScenarioTiming, LeastLoadedDispatch>;
+template class BasicController<NullEventSink, TimingWheelScheduler,
+                               FixedTiming, RoundRobinDispatch>;
+template class BasicController<VectorEventSink, TimingWheelScheduler,
+                               FixedTiming, RoundRobinDispatch>;
+template class BasicController<FileEventSink, TimingWheelScheduler,
+                               FixedTiming, RoundRobinDispatch>;
+template class BasicController<NullEventSink, TimingWheelScheduler,
+                               ScenarioTiming, RoundRobinDispatch>;
+template class BasicController<VectorEventSink, TimingWheelScheduler,
+                               ScenarioTiming, RoundRobinDispatch>;
+template class BasicController<FileEventSink, TimingWheelScheduler,
+                               ScenarioTiming, RoundRobinDispatch>;
+template class BasicController<NullEventSink, TimingWheelScheduler,
+                               FixedTiming, AffinityDispatch>;
+template class BasicController<VectorEventSink, TimingWheelScheduler,
+                               FixedTiming, AffinityDispatch>;
+template class BasicController<FileEventSink, TimingWheelScheduler,
+                               FixedTiming, AffinityDispatch>;
+template class BasicController<NullEventSink, TimingWheelScheduler,
+                               ScenarioTiming, AffinityDispatch>;
+template class BasicController<VectorEventSink, TimingWheelScheduler,
+                               ScenarioTiming, AffinityDispatch>;
+template class BasicController<FileEventSink, TimingWheelScheduler,
+                               ScenarioTiming, AffinityDispatch>;
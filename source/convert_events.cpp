@@ -0,0 +1,60 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "event_export.h"
+#include "event_log.h"
+
+void PrintUsage(const char* program_name) {
+  std::cerr << "Usage: " << program_name << " <input> <output> [--to=<f>]\n"
+            << "  Converts a binary event log to JSON Lines, or a JSON Lines "
+               "log to the binary format.\n"
+            << "  The direction is detected from the input file.\n"
+            << "  --to=<f>  Export a log of any format as a JSON array "
+               "(json), csv or an\n"
+            << "            Arrow IPC file (arrow) instead\n";
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3 && argc != 4) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const std::string input = argv[1];
+  const std::string output = argv[2];
+
+  try {
+    if (argc == 4) {
+      const std::string option = argv[3];
+      if (option.rfind("--to=", 0) != 0) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+      EventExportOptions options;
+      options.format = EventExportFormatFromString(option.substr(5));
+      options.path = output;
+      const EventExportResult result = ExportEventLog(input, options);
+      std::cout << "Exported " << result.num_events << " events of " << input
+                << " to " << output;
+      if (result.skipped > 0) {
+        std::cout << " (" << result.skipped << " skipped)";
+      }
+      std::cout << "\n";
+    } else if (IsBinaryEventLog(input)) {
+      ConvertBinaryToJsonLines(input, output);
+      std::cout << "Converted binary log " << input << " to JSON Lines "
+                << output << "\n";
+    } else {
+      ConvertJsonLinesToBinary(input, output);
+      std::cout << "Converted JSON Lines log " << input << " to binary "
+                << output << "\n";
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,9 +1,16 @@
 #include "event.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "event_index.h"
+#include "event_log.h"
 #include "logger.h"
 #include "nlohmann/json.hpp"
 
@@ -90,73 +97,256 @@ Event JsonToEvent(const json& j) {
   return event;
 }
 
-// Initializes the EventLogger with a flush thread and opens output file
-EventLogger::EventLogger(const std::string& filename) : filename_(filename) {
-  ofs_.open(filename, std::ios::app);
-  if (!ofs_.is_open()) {
-    Logger::LogError("Unable to open log file for writing: " + filename);
-    throw std::runtime_error("Unable to open log file for writing: " +
-                             filename);
-  }
-  flush_thread_ = std::thread([this] {
-    while (!done_.load()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      FlushBuffer();  // Periodically flush buffered events to disk
-    }
-    FlushBuffer();  // Final flush on shutdown
-  });
+std::string EventToJsonLine(const Event& event) {
+  return EventToJson(event).dump();
+}
+
+Event EventFromJsonLine(const std::string& line) {
+  return JsonToEvent(json::parse(line));
+}
+
+namespace {
+// Upper bound on how long logged events may sit in the ring before the
+// writer thread wakes up on its own
+constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+}  // namespace
+
+// Initializes the EventLogger with a writer thread and opens output file
+EventLogger::EventLogger(const std::string& filename, LogFormat format,
+                         size_t buffer_capacity, OverflowPolicy overflow)
+    : filename_(filename),
+      format_(format),
+      ring_(buffer_capacity),
+      overflow_(overflow) {
+  OpenOutput(std::ios::app);
+  flush_thread_ = std::thread([this] { WriterLoop(); });
 }
 
-// Gracefully stops the background flush thread and closes files
+// Gracefully stops the background writer thread and closes files
 EventLogger::~EventLogger() {
   done_ = true;
+  FlushBuffer();  // Wake the writer so it drains and exits
   if (flush_thread_.joinable()) flush_thread_.join();
   CloseStreams();
 }
 
-// Adds an event to the buffer, logs trace output
+// Hands an event to the writer thread, logs trace output
 void EventLogger::LogEvent(const Event& event) {
-  std::lock_guard<std::mutex> lock(buffer_mutex_);
-  buffer_.push_back(event);
-  Logger::LogTrace(event.to_string());
+  if (Logger::TraceEnabled()) Logger::LogTrace(event.to_string());
+  const PackedEvent packed(event);
+
+  // Once events have spilled they must keep spilling until the writer has
+  // caught up, otherwise newer events could overtake older ones
+  if (spilled_.load(std::memory_order_relaxed)) {
+    SpillEvent(packed);
+  } else if (!ring_.TryPush(packed)) {
+    switch (overflow_.load(std::memory_order_relaxed)) {
+      case OverflowPolicy::Block: {
+        StatsTimer timer;
+        do {
+          FlushBuffer();
+          ring_.WaitForSpace();
+        } while (!ring_.TryPush(packed));
+        if constexpr (kStatsEnabled) {
+          ++stats_.blocked_waits;
+          stats_.blocked_ms += timer.Lap();
+        }
+        break;
+      }
+      case OverflowPolicy::Drop:
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      case OverflowPolicy::Grow:
+        SpillEvent(packed);
+        break;
+    }
+  }
+
+  // Only this thread writes logged_seq_, so no read-modify-write is needed
+  const uint64_t seq = logged_seq_.load(std::memory_order_relaxed) + 1;
+  logged_seq_.store(seq, std::memory_order_release);
+
+  // Wake the writer every half ring so it drains in large batches
+  if (seq % (ring_.capacity() / 2) == 0) FlushBuffer();
+}
+
+// Appends an event to the overflow buffer used by OverflowPolicy::Grow
+void EventLogger::SpillEvent(const PackedEvent& event) {
+  std::lock_guard<std::mutex> lock(spill_mutex_);
+  spill_.push_back(event);
+  spilled_.store(true, std::memory_order_release);
 }
 
-// Writes buffered events to disk and clears the buffer
+// Wakes the writer thread to write buffered events now
 void EventLogger::FlushBuffer() {
-  std::lock_guard<std::mutex> lock(buffer_mutex_);
-  for (const auto& e : buffer_) {
-    ofs_ << EventToJson(e).dump() << "\n";
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    flush_requested_ = true;
   }
-  buffer_.clear();
-  ofs_.flush();
+  wake_cv_.notify_one();
 }
 
-// Waits for the background flush thread to finish flushing
-void EventLogger::WaitUntilFlushed() {
-  FlushBuffer();
+// Writer thread: sleeps until woken (or kFlushInterval), then drains the
+// ring and any spilled events to disk in one batch
+void EventLogger::WriterLoop() {
+  std::vector<PackedEvent> batch;
   while (true) {
     {
-      std::lock_guard<std::mutex> lock(buffer_mutex_);
-      if (buffer_.empty()) break;
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_cv_.wait_for(lock, kFlushInterval,
+                        [this] { return flush_requested_ || done_.load(); });
+      flush_requested_ = false;
+    }
+    const bool stopping = done_.load();
+
+    batch.clear();
+    ring_.PopBatch(&batch, SIZE_MAX);
+    if (spilled_.load(std::memory_order_acquire)) {
+      // The producer stopped pushing to the ring before it started
+      // spilling, so the ring is drained completely before the spill
+      ring_.PopBatch(&batch, SIZE_MAX);
+      std::lock_guard<std::mutex> lock(spill_mutex_);
+      batch.insert(batch.end(), spill_.begin(), spill_.end());
+      spill_.clear();
+      spilled_.store(false, std::memory_order_release);
+    }
+
+    if (!batch.empty()) {
+      WriteBatch(batch);
+      flushed_seq_.fetch_add(batch.size(), std::memory_order_release);
+      flushed_seq_.notify_all();
+    }
+    if (stopping) break;
+  }
+}
+
+// Serializes a batch of events to the output file; compressed JSON Lines
+// go out as one gzip member per batch, or per index block when indexing
+void EventLogger::WriteBatch(const std::vector<PackedEvent>& batch) {
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  StatsTimer timer;
+  const size_t block_size = index_ ? kIndexBlockEvents : batch.size();
+  uint64_t bytes = 0;
+  for (size_t first = 0; first < batch.size(); first += block_size) {
+    bytes += WriteBlock(std::span(batch).subspan(
+        first, std::min(block_size, batch.size() - first)));
+  }
+  ofs_.flush();
+  if (index_) index_->Flush();  // After the log, so entries never run ahead
+
+  if constexpr (kStatsEnabled) {
+    const double ms = timer.Lap();
+    ++stats_.flushes;
+    stats_.bytes_written += bytes;
+    stats_.flush_ms += ms;
+    stats_.max_flush_ms = std::max(stats_.max_flush_ms, ms);
+  }
+}
+
+// Writes events as one contiguous block of the log and indexes it
+uint64_t EventLogger::WriteBlock(std::span<const PackedEvent> events) {
+  batch_records_.clear();
+  if (format_ == LogFormat::Binary || index_) {
+    for (const auto& e : events) batch_records_.push_back(ToRecord(e));
+  }
+  std::string_view output;
+  if (format_ == LogFormat::Binary) {
+    output = {reinterpret_cast<const char*>(batch_records_.data()),
+              batch_records_.size() * sizeof(EventRecord)};
+  } else {
+    batch_text_.clear();
+    for (const auto& e : events) {
+      batch_text_ += EventToJson(e.ToEvent()).dump();
+      batch_text_ += '\n';
+    }
+    output = batch_text_;
+    if (compressor_) {
+      compressor_->Compress(batch_text_, &batch_block_);
+      output = batch_block_;
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ofs_.write(output.data(), output.size());
+  if (index_) index_->AddBlock(batch_records_, log_bytes_, output.size());
+  log_bytes_ += output.size();
+  return output.size();
+}
+
+LoggerStats EventLogger::stats() {
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  LoggerStats stats = stats_;
+  if constexpr (kStatsEnabled) {
+    stats.events_logged = logged_seq_.load(std::memory_order_acquire);
+    stats.events_dropped = dropped_.load();
+  }
+  return stats;
+}
+
+void PrintLoggerStats(const LoggerStats& stats) {
+  const double mean_flush_ms =
+      stats.flushes > 0 ? stats.flush_ms / stats.flushes : 0.0;
+  std::cout << "\n=== Event Logger Statistics ===\n"
+            << std::fixed << std::setprecision(3)
+            << "Events Logged: " << stats.events_logged << " ("
+            << stats.events_dropped << " dropped)\n"
+            << "Flushes: " << stats.flushes << ", "
+            << stats.bytes_written << " bytes\n"
+            << "Flush Latency: " << mean_flush_ms << " ms mean, "
+            << stats.max_flush_ms << " ms max, " << stats.flush_ms
+            << " ms total\n"
+            << "Blocked on Full Buffer: " << stats.blocked_waits
+            << " times, " << stats.blocked_ms << " ms\n";
+}
+
+// Stores the run parameters and refreshes the binary header if needed
+void EventLogger::SetRunParameters(const RunParameters& params) {
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  params_ = params;
+  if (format_ == LogFormat::Binary) WriteHeader();
+}
+
+// Waits until the writer thread has written every event logged so far
+void EventLogger::WaitUntilFlushed() {
+  const uint64_t target = logged_seq_.load(std::memory_order_acquire);
+  FlushBuffer();
+  uint64_t flushed = flushed_seq_.load(std::memory_order_acquire);
+  while (flushed < target) {
+    flushed_seq_.wait(flushed, std::memory_order_acquire);
+    flushed = flushed_seq_.load(std::memory_order_acquire);
   }
 }
 
 // Reads the next event from file, skipping blank lines
 bool EventLogger::ReadNextEvent(Event* event) {
-  if (!ifs_.is_open()) {
-    ifs_.open(filename_);
+  if (format_ == LogFormat::Binary) {
     if (!ifs_.is_open()) {
-      Logger::LogError("Unable to open log file for reading: " + filename_);
-      throw std::runtime_error("Unable to open log file for reading: " +
-                               filename_);
+      ifs_.open(filename_, std::ios::in | std::ios::binary);
+      if (!ifs_.is_open()) {
+        Logger::LogError("Unable to open log file for reading: " + filename_);
+        throw std::runtime_error("Unable to open log file for reading: " +
+                                 filename_);
+      }
+    }
+    if (ifs_.tellg() == 0) {
+      EventLogHeader header{};
+      if (!ifs_.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+      }
+      ValidateHeader(header, filename_);
+    }
+    EventRecord record;
+    if (!ifs_.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+      return false;
     }
+    *event = FromRecord(record);
+    return true;
   }
 
+  if (!line_reader_) {
+    line_reader_ = std::make_unique<EventLogLineReader>(filename_);
+  }
   std::string line;
-  if (std::getline(ifs_, line)) {
-    if (line.empty()) return ReadNextEvent(event);  // recurse to skip blanks
+  while (line_reader_->ReadLine(&line)) {
+    if (line.empty()) continue;
     json j = json::parse(line);
     *event = JsonToEvent(j);
     return true;
@@ -164,20 +354,100 @@ bool EventLogger::ReadNextEvent(Event* event) {
   return false;
 }
 
+// Takes effect on the current log at once, once what is buffered is on disk
+void EventLogger::SetIndexing(bool enabled) {
+  WaitUntilFlushed();
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  if (enabled == indexing_) return;
+  indexing_ = enabled;
+  OpenIndex();
+}
+
 // Truncates the log file, removing all prior events
 void EventLogger::ClearEvents() {
+  WaitUntilFlushed();
   CloseStreams();
-  ofs_.open(filename_, std::ios::out | std::ios::trunc);
+  OpenOutput(std::ios::out | std::ios::trunc);
+}
+
+// Switches the logger to a new file and format, starting it empty unless
+// appending
+void EventLogger::Reopen(const std::string& filename, LogFormat format,
+                         bool append, int compression_level) {
+  if (compression_level != 0 && format == LogFormat::Binary) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Binary event logs cannot be compressed");
+  }
+  // Checks the level before anything changes
+  auto compressor = compression_level != 0
+                        ? std::make_unique<BlockCompressor>(compression_level)
+                        : nullptr;
+  WaitUntilFlushed();
+  CloseStreams();
+  {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    filename_ = filename;
+    format_ = format;
+    compression_level_ = compression_level;
+    compressor_ = std::move(compressor);
+  }
+  OpenOutput(append ? std::ios::app : std::ios::out | std::ios::trunc);
+}
+
+// Opens the output stream; a new binary log starts with its header
+void EventLogger::OpenOutput(std::ios::openmode mode) {
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  std::error_code ec;
+  const bool empty = (mode & std::ios::trunc) ||
+                     std::filesystem::file_size(filename_, ec) == 0 || ec;
+  ofs_.open(filename_, mode | std::ios::binary);
   if (!ofs_.is_open()) {
     Logger::LogError("Unable to open log file for writing: " + filename_);
     throw std::runtime_error("Unable to open log file for writing: " +
                              filename_);
   }
+  if (format_ == LogFormat::Binary && empty) {
+    const EventLogHeader header = MakeHeader(params_);
+    ofs_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs_.flush();
+  }
+  log_bytes_ = std::filesystem::file_size(filename_, ec);
+  if (ec) log_bytes_ = 0;
+  OpenIndex();
+}
+
+// Continues the sidecar index from what the log already holds, or removes
+// a sidecar that is no longer kept. Called with stream_mutex_ held.
+void EventLogger::OpenIndex() {
+  index_.reset();
+  const std::string path = EventIndexPath(filename_);
+  if (!indexing_) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return;
+  }
+  ofs_.flush();
+  const bool empty =
+      log_bytes_ <=
+      (format_ == LogFormat::Binary ? sizeof(EventLogHeader) : uint64_t{0});
+  index_ = std::make_unique<EventIndexWriter>(
+      path, empty ? 0 : BuildEventIndex(filename_));
+}
+
+// Rewrites the header in place. Records are appended through ofs_, so the
+// header region at offset 0 can be patched through a separate handle.
+void EventLogger::WriteHeader() {
+  ofs_.flush();
+  std::fstream fs(filename_, std::ios::in | std::ios::out | std::ios::binary);
+  if (!fs.is_open()) return;
+  const EventLogHeader header = MakeHeader(params_);
+  fs.seekp(0);
+  fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
 }
 
 // Flushes and closes both input/output streams
 void EventLogger::CloseStreams() {
-  FlushBuffer();
+  std::lock_guard<std::mutex> lock(stream_mutex_);
   if (ofs_.is_open()) {
     ofs_.flush();
     ofs_.close();
@@ -185,16 +455,19 @@ void EventLogger::CloseStreams() {
   if (ifs_.is_open()) {
     ifs_.close();
   }
+  line_reader_.reset();
+  index_.reset();
 }
 
-// Global shared EventLogger instance (singleton-like)
-namespace {
-std::shared_ptr<EventLogger> logger =
-    std::make_shared<EventLogger>("events.json");
+// Global shared EventLogger instance (singleton-like). Created on first use,
+// so runs that never touch it (e.g. metrics-only replications) do not open
+// events.json or start a writer thread.
+EventLogger& GetEventLogger() {
+  static EventLogger logger("events.json");
+  return logger;
 }
 
 // Convenience global functions that proxy to the singleton
-EventLogger& GetEventLogger() { return *logger; }
 void LogEvent(const Event& event) { GetEventLogger().LogEvent(event); }
 bool ReadEvent(Event* event) { return GetEventLogger().ReadNextEvent(event); }
 void ClearEvents() { GetEventLogger().ClearEvents(); }
@@ -0,0 +1,690 @@
+#include "event_export.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "analyze.h"
+#include "event.h"
+#include "event_log.h"
+#include "logger.h"
+#include "thread_pool.h"
+
+namespace {
+// Events per chunk of a binary log, and bytes per chunk of a JSON Lines one
+// (about the same number of events)
+constexpr size_t kChunkEvents = 1 << 16;
+constexpr size_t kChunkBytes = 1 << 22;
+
+// Indexed by EventType
+constexpr std::string_view kTypeNames[kNumEventTypes] = {
+    "TravelToStation", "Mine", "TravelToMine", "Queue", "Unload"};
+
+void AppendUint(std::string* out, uint32_t value) {
+  char buffer[16];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out->append(buffer, result.ptr);
+}
+
+// Each row is preceded by ",\n"; the writer drops the first comma
+void AppendJsonRows(std::span<const EventRecord> events, std::string* out) {
+  for (const EventRecord& e : events) {
+    out->append(",\n{\"end_time\":");
+    AppendUint(out, e.end_time);
+    out->append(",\"start_time\":");
+    AppendUint(out, e.start_time);
+    out->append(",\"station_id\":");
+    if (e.station_id != kNoStation) {
+      AppendUint(out, e.station_id);
+    } else {
+      out->append("null");
+    }
+    out->append(",\"truck_id\":");
+    AppendUint(out, e.truck_id);
+    out->append(",\"type\":\"");
+    out->append(kTypeNames[e.type]);
+    out->append("\"}");
+  }
+}
+
+void AppendCsvRows(std::span<const EventRecord> events, std::string* out) {
+  for (const EventRecord& e : events) {
+    out->append(kTypeNames[e.type]);
+    out->push_back(',');
+    AppendUint(out, e.truck_id);
+    out->push_back(',');
+    if (e.station_id != kNoStation) AppendUint(out, e.station_id);
+    out->push_back(',');
+    AppendUint(out, e.start_time);
+    out->push_back(',');
+    AppendUint(out, e.end_time);
+    out->push_back('\n');
+  }
+}
+
+// Arrow IPC file format: the magic, a stream of encapsulated messages (the
+// schema, the dictionary of event type names, a record batch per chunk, an
+// end-of-stream marker), then a footer indexing the messages. Messages are
+// described by FlatBuffers (Arrow's Message.fbs, Schema.fbs and File.fbs).
+
+constexpr char kArrowMagic[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+constexpr uint32_t kArrowContinuation = 0xFFFFFFFF;
+constexpr int16_t kArrowMetadataV5 = 4;
+
+// MessageHeader and Type union members
+constexpr uint8_t kArrowSchema = 1;
+constexpr uint8_t kArrowDictionaryBatch = 2;
+constexpr uint8_t kArrowRecordBatch = 3;
+constexpr uint8_t kArrowInt = 2;
+constexpr uint8_t kArrowUtf8 = 5;
+
+struct ArrowFieldNode {
+  int64_t length;
+  int64_t null_count;
+};
+
+struct ArrowBuffer {
+  int64_t offset;  // In the message body
+  int64_t length;
+};
+
+struct ArrowBlock {
+  int64_t offset;            // Of the message, in the file
+  int32_t metadata_length;   // Prefix and FlatBuffer
+  int32_t padding = 0;
+  int64_t body_length;
+};
+static_assert(sizeof(ArrowBlock) == 24);
+
+// Lays out a FlatBuffer front to back: a table is written with its offset
+// fields left blank, and they are linked to their targets as those are
+// written after it (FlatBuffers offsets point forwards).
+class FlatBufferBuilder {
+ public:
+  static constexpr uint8_t kOffset = 0;
+
+  struct Field {
+    uint16_t id;
+    uint8_t size;  // Bytes of the scalar, or kOffset
+    uint64_t value = 0;
+  };
+
+  FlatBufferBuilder() : buffer_(4, '\0') {}  // Room for the root offset
+
+  // Writes a table (its vtable first) and returns its position; slots gets
+  // where each field went, by id, for Link
+  size_t Table(std::initializer_list<Field> fields,
+               std::vector<size_t>* slots) {
+    uint16_t num_ids = 0;
+    for (const Field& field : fields) {
+      num_ids = std::max<uint16_t>(num_ids, field.id + 1);
+    }
+    Align(2);
+    const size_t vtable = buffer_.size();
+    buffer_.resize(vtable + 4 + 2 * num_ids);
+
+    // The table starts 4 bytes before an 8-byte boundary, so its 8-byte
+    // fields, which come first after the vtable offset, are aligned
+    Align(4);
+    if (buffer_.size() % 8 == 0) buffer_.resize(buffer_.size() + 4);
+    const size_t table = buffer_.size();
+    Put<int32_t>(static_cast<int32_t>(table - vtable));
+    slots->assign(num_ids, 0);
+    for (const size_t size : {8, 4, 2, 1}) {
+      for (const Field& field : fields) {
+        if ((field.size == kOffset ? 4 : field.size) != size) continue;
+        (*slots)[field.id] = buffer_.size();
+        PutAt<uint16_t>(vtable + 4 + 2 * field.id,
+                        static_cast<uint16_t>(buffer_.size() - table));
+        buffer_.append(reinterpret_cast<const char*>(&field.value), size);
+      }
+    }
+    PutAt<uint16_t>(vtable, static_cast<uint16_t>(4 + 2 * num_ids));
+    PutAt<uint16_t>(vtable + 2, static_cast<uint16_t>(buffer_.size() - table));
+    return table;
+  }
+
+  // Vector of 8-byte aligned structs
+  template <typename T>
+  size_t StructVector(std::span<const T> items) {
+    Align(4);
+    if (buffer_.size() % 8 == 0) buffer_.resize(buffer_.size() + 4);
+    const size_t vector = buffer_.size();
+    Put<uint32_t>(static_cast<uint32_t>(items.size()));
+    buffer_.append(reinterpret_cast<const char*>(items.data()),
+                   items.size_bytes());
+    return vector;
+  }
+
+  // Vector of count offsets; slots gets where each is, for Link
+  size_t OffsetVector(size_t count, std::vector<size_t>* slots) {
+    Align(4);
+    const size_t vector = buffer_.size();
+    Put<uint32_t>(static_cast<uint32_t>(count));
+    slots->clear();
+    for (size_t i = 0; i < count; ++i) {
+      slots->push_back(buffer_.size());
+      Put<uint32_t>(0);
+    }
+    return vector;
+  }
+
+  size_t String(std::string_view text) {
+    Align(4);
+    const size_t string = buffer_.size();
+    Put<uint32_t>(static_cast<uint32_t>(text.size()));
+    buffer_.append(text);
+    buffer_.push_back('\0');
+    return string;
+  }
+
+  // Points the offset at slot to target, which was written after it
+  void Link(size_t slot, size_t target) {
+    PutAt<uint32_t>(slot, static_cast<uint32_t>(target - slot));
+  }
+
+  // The buffer with root as its root table, padded to 8 bytes
+  std::string Finish(size_t root) {
+    Link(0, root);
+    Align(8);
+    return std::move(buffer_);
+  }
+
+ private:
+  void Align(size_t alignment) {
+    buffer_.resize((buffer_.size() + alignment - 1) / alignment * alignment);
+  }
+
+  template <typename T>
+  void Put(T value) {
+    buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  template <typename T>
+  void PutAt(size_t position, T value) {
+    std::memcpy(buffer_.data() + position, &value, sizeof(value));
+  }
+
+  std::string buffer_;
+};
+
+using Fb = FlatBufferBuilder;
+
+size_t ArrowInt(Fb* fb, int32_t bit_width, bool is_signed) {
+  std::vector<size_t> slots;
+  return fb->Table({{0, 4, static_cast<uint32_t>(bit_width)},
+                    {1, 1, is_signed}},
+                   &slots);
+}
+
+// Schema table of the event columns
+size_t ArrowSchema(Fb* fb) {
+  struct Column {
+    const char* name;
+    bool nullable;
+  };
+  constexpr Column kColumns[] = {{"type", false},
+                                 {"truck_id", false},
+                                 {"station_id", true},
+                                 {"start_time", false},
+                                 {"end_time", false}};
+
+  std::vector<size_t> slots, fields, field, unused;
+  const size_t schema = fb->Table({{1, Fb::kOffset}}, &slots);
+  fb->Link(slots[1], fb->OffsetVector(std::size(kColumns), &fields));
+  for (size_t i = 0; i < std::size(kColumns); ++i) {
+    const uint8_t nullable = kColumns[i].nullable;
+    if (i == 0) {
+      // Type names: strings, dictionary-encoded
+      fb->Link(fields[i], fb->Table({{0, Fb::kOffset},
+                                     {1, 1, nullable},
+                                     {2, 1, kArrowUtf8},
+                                     {3, Fb::kOffset},
+                                     {4, Fb::kOffset},
+                                     {5, Fb::kOffset}},
+                                    &field));
+    } else {
+      fb->Link(fields[i], fb->Table({{0, Fb::kOffset},
+                                     {1, 1, nullable},
+                                     {2, 1, kArrowInt},
+                                     {3, Fb::kOffset},
+                                     {5, Fb::kOffset}},
+                                    &field));
+    }
+    fb->Link(field[0], fb->String(kColumns[i].name));
+    if (i == 0) {
+      std::vector<size_t> encoding;
+      fb->Link(field[3], fb->Table({}, &unused));
+      fb->Link(field[4], fb->Table({{0, 8, 0}, {1, Fb::kOffset}}, &encoding));
+      fb->Link(encoding[1], ArrowInt(fb, 8, true));
+    } else {
+      fb->Link(field[3], ArrowInt(fb, 32, false));
+    }
+    fb->Link(field[5], fb->OffsetVector(0, &unused));  // No children
+  }
+  return schema;
+}
+
+size_t ArrowRecordBatch(Fb* fb, int64_t length,
+                        std::span<const ArrowFieldNode> nodes,
+                        std::span<const ArrowBuffer> buffers) {
+  std::vector<size_t> slots;
+  const size_t batch = fb->Table(
+      {{0, 8, static_cast<uint64_t>(length)}, {1, Fb::kOffset},
+       {2, Fb::kOffset}},
+      &slots);
+  fb->Link(slots[1], fb->StructVector(nodes));
+  fb->Link(slots[2], fb->StructVector(buffers));
+  return batch;
+}
+
+// Message metadata: a Message table around a header built by header()
+template <typename BuildHeader>
+std::string ArrowMessage(uint8_t header_type, int64_t body_length,
+                         const BuildHeader& header) {
+  Fb fb;
+  std::vector<size_t> slots;
+  const size_t message =
+      fb.Table({{0, 2, static_cast<uint64_t>(kArrowMetadataV5)},
+                {1, 1, header_type},
+                {2, Fb::kOffset},
+                {3, 8, static_cast<uint64_t>(body_length)}},
+               &slots);
+  fb.Link(slots[2], header(&fb));
+  return fb.Finish(message);
+}
+
+// Appends the continuation marker, the metadata length and the metadata,
+// and returns the length of the three
+int32_t AppendArrowMetadata(const std::string& metadata, std::string* out) {
+  const uint32_t length = static_cast<uint32_t>(metadata.size());
+  out->append(reinterpret_cast<const char*>(&kArrowContinuation), 4);
+  out->append(reinterpret_cast<const char*>(&length), 4);
+  out->append(metadata);
+  return static_cast<int32_t>(8 + metadata.size());
+}
+
+// Body buffers are laid out one after another, each padded to 8 bytes
+class ArrowBody {
+ public:
+  // Adds a buffer of length bytes to the layout
+  void Add(size_t length) {
+    buffers_.push_back({size_, static_cast<int64_t>(length)});
+    size_ += (length + 7) / 8 * 8;
+  }
+
+  const std::vector<ArrowBuffer>& buffers() const { return buffers_; }
+  int64_t size() const { return size_; }
+
+ private:
+  std::vector<ArrowBuffer> buffers_;
+  int64_t size_ = 0;
+};
+
+void PadTo8(std::string* out, size_t start) {
+  out->resize(start + (out->size() - start + 7) / 8 * 8);
+}
+
+// A record batch message for events: its metadata, then the body
+void AppendArrowBatch(std::span<const EventRecord> events, std::string* out,
+                      int32_t* metadata_length, int64_t* body_length) {
+  const size_t n = events.size();
+  const int64_t no_station = std::count_if(
+      events.begin(), events.end(),
+      [](const EventRecord& e) { return e.station_id == kNoStation; });
+
+  // Per column a validity bitmap (empty when nothing is null) and values
+  ArrowBody body;
+  body.Add(0);
+  body.Add(n);  // int8 type indices
+  body.Add(0);
+  body.Add(4 * n);
+  body.Add(no_station > 0 ? (n + 7) / 8 : 0);
+  body.Add(4 * n);
+  body.Add(0);
+  body.Add(4 * n);
+  body.Add(0);
+  body.Add(4 * n);
+  const int64_t length = static_cast<int64_t>(n);
+  const ArrowFieldNode nodes[] = {
+      {length, 0}, {length, 0}, {length, no_station}, {length, 0},
+      {length, 0}};
+
+  *metadata_length = AppendArrowMetadata(
+      ArrowMessage(kArrowRecordBatch, body.size(),
+                   [&](Fb* fb) {
+                     return ArrowRecordBatch(fb, length, nodes,
+                                             body.buffers());
+                   }),
+      out);
+  *body_length = body.size();
+
+  const size_t start = out->size();
+  for (const EventRecord& e : events) out->push_back(static_cast<char>(e.type));
+  PadTo8(out, start);
+  const auto append_column = [&](uint32_t EventRecord::*field) {
+    const size_t column = out->size();
+    out->resize(column + 4 * n);
+    char* data = out->data() + column;
+    for (const EventRecord& e : events) {
+      const uint32_t value = e.*field != kNoStation ? e.*field : 0;
+      std::memcpy(data, &value, 4);
+      data += 4;
+    }
+    PadTo8(out, start);
+  };
+  append_column(&EventRecord::truck_id);
+  if (no_station > 0) {
+    const size_t bitmap = out->size();
+    out->resize(bitmap + (n + 7) / 8);
+    for (size_t i = 0; i < n; ++i) {
+      if (events[i].station_id != kNoStation) {
+        (*out)[bitmap + i / 8] |= static_cast<char>(1 << (i % 8));
+      }
+    }
+    PadTo8(out, start);
+  }
+  append_column(&EventRecord::station_id);
+  append_column(&EventRecord::start_time);
+  append_column(&EventRecord::end_time);
+}
+
+// The file magic, the schema and the dictionary batch of type names
+void AppendArrowPreamble(std::string* out, ArrowBlock* dictionary) {
+  out->append(kArrowMagic, sizeof(kArrowMagic));
+  AppendArrowMetadata(
+      ArrowMessage(kArrowSchema, 0, [](Fb* fb) { return ArrowSchema(fb); }),
+      out);
+
+  std::vector<int32_t> offsets = {0};
+  std::string names;
+  for (const std::string_view name : kTypeNames) {
+    names.append(name);
+    offsets.push_back(static_cast<int32_t>(names.size()));
+  }
+  ArrowBody body;
+  body.Add(0);
+  body.Add(offsets.size() * sizeof(int32_t));
+  body.Add(names.size());
+  const int64_t length = kNumEventTypes;
+  const ArrowFieldNode node = {length, 0};
+
+  dictionary->offset = static_cast<int64_t>(out->size());
+  dictionary->metadata_length = AppendArrowMetadata(
+      ArrowMessage(kArrowDictionaryBatch, body.size(),
+                   [&](Fb* fb) {
+                     std::vector<size_t> slots;
+                     const size_t batch = fb->Table(
+                         {{0, 8, 0}, {1, Fb::kOffset}}, &slots);
+                     fb->Link(slots[1],
+                              ArrowRecordBatch(fb, length, {&node, 1},
+                                               body.buffers()));
+                     return batch;
+                   }),
+      out);
+  dictionary->body_length = body.size();
+  const size_t start = out->size();
+  out->append(reinterpret_cast<const char*>(offsets.data()),
+              offsets.size() * sizeof(int32_t));
+  PadTo8(out, start);
+  out->append(names);
+  PadTo8(out, start);
+}
+
+// The end-of-stream marker, the footer, its length and the closing magic
+void AppendArrowFooter(const ArrowBlock& dictionary,
+                       const std::vector<ArrowBlock>& batches,
+                       std::string* out) {
+  out->append(reinterpret_cast<const char*>(&kArrowContinuation), 4);
+  out->append(4, '\0');
+
+  Fb fb;
+  std::vector<size_t> slots;
+  const size_t footer = fb.Table(
+      {{0, 2, static_cast<uint64_t>(kArrowMetadataV5)},
+       {1, Fb::kOffset},
+       {2, Fb::kOffset},
+       {3, Fb::kOffset}},
+      &slots);
+  fb.Link(slots[1], ArrowSchema(&fb));
+  fb.Link(slots[2], fb.StructVector<ArrowBlock>({&dictionary, 1}));
+  fb.Link(slots[3], fb.StructVector<ArrowBlock>(batches));
+  const std::string metadata = fb.Finish(footer);
+  const uint32_t length = static_cast<uint32_t>(metadata.size());
+  out->append(metadata);
+  out->append(reinterpret_cast<const char*>(&length), 4);
+  out->append(kArrowMagic, 6);
+}
+
+// A chunk of the log on its way through the pool
+struct Chunk {
+  std::string text;                      // JSON Lines input
+  std::span<const EventRecord> records;  // Binary input
+  std::vector<EventRecord> events;       // Those that can be exported
+  uint64_t skipped = 0;
+  std::string output;
+  int32_t metadata_length = 0;  // Arrow record batch
+  int64_t body_length = 0;
+};
+
+void ConvertChunk(EventExportFormat format, Chunk* chunk) {
+  chunk->events.clear();
+  chunk->skipped = 0;
+  chunk->output.clear();
+  if (!chunk->text.empty()) {
+    std::string_view text = chunk->text;
+    EventRecord record;
+    while (!text.empty()) {
+      const size_t newline = text.find('\n');
+      const std::string_view line = text.substr(0, newline);
+      text.remove_prefix(std::min(text.size(), line.size() + 1));
+      if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+        continue;
+      }
+      if (ParseEventRecord(line, &record)) {
+        chunk->events.push_back(record);
+      } else {
+        ++chunk->skipped;
+      }
+    }
+  } else {
+    for (const EventRecord& record : chunk->records) {
+      if (record.type < kNumEventTypes) {
+        chunk->events.push_back(record);
+      } else {
+        ++chunk->skipped;
+      }
+    }
+  }
+
+  switch (format) {
+    case EventExportFormat::Json:
+      AppendJsonRows(chunk->events, &chunk->output);
+      break;
+    case EventExportFormat::Csv:
+      AppendCsvRows(chunk->events, &chunk->output);
+      break;
+    case EventExportFormat::Arrow:
+      if (!chunk->events.empty()) {
+        AppendArrowBatch(chunk->events, &chunk->output,
+                         &chunk->metadata_length, &chunk->body_length);
+      }
+      break;
+  }
+}
+}  // namespace
+
+EventExportFormat EventExportFormatFromString(const std::string& name) {
+  if (name == "json") return EventExportFormat::Json;
+  if (name == "csv") return EventExportFormat::Csv;
+  if (name == "arrow") return EventExportFormat::Arrow;
+  Logger::LogAndThrowError<std::invalid_argument>(
+      "Unknown event export format: " + name);
+  return EventExportFormat::Json;
+}
+
+std::string DefaultEventExportPath(size_t num_trucks, size_t num_stations,
+                                   minutes_t sim_time,
+                                   EventExportFormat format) {
+  std::ostringstream os;
+  os << "events." << num_trucks << "truck_" << num_stations << "station_"
+     << sim_time << "_minutes.";
+  switch (format) {
+    case EventExportFormat::Json:
+      os << "json";
+      break;
+    case EventExportFormat::Csv:
+      os << "csv";
+      break;
+    case EventExportFormat::Arrow:
+      os << "arrow";
+      break;
+  }
+  return os.str();
+}
+
+EventExportResult ExportEventLog(const std::string& log_path,
+                                 const EventExportOptions& options) {
+  if (options.path.empty()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "No path to export event log " + log_path + " to");
+  }
+  std::error_code ec;
+  if (std::filesystem::equivalent(log_path, options.path, ec)) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Cannot export event log " + log_path + " over itself");
+  }
+
+  // Binary logs are read in place, JSON Lines ones a chunk of text at a time
+  std::optional<MappedEventLog> log;
+  std::optional<EventLogLineReader> reader;
+  if (IsBinaryEventLog(log_path)) {
+    log.emplace(log_path);
+  } else {
+    reader.emplace(log_path);
+  }
+  std::span<const EventRecord> records =
+      log.has_value() ? log->records() : std::span<const EventRecord>();
+
+  std::ofstream out(options.path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open event export for writing: " +
+                             options.path);
+  }
+
+  // A log that fits in one chunk is not worth starting threads for
+  const bool small = log.has_value()
+                         ? records.size() <= kChunkEvents
+                         : std::filesystem::file_size(log_path) <= kChunkBytes;
+  std::optional<WorkStealingPool> pool;
+  if (options.num_threads != 1 && !small) pool.emplace(options.num_threads);
+  const size_t chunks_per_round =
+      pool.has_value() ? 2 * pool->num_threads() : 1;
+
+  // Fills the chunks of a round and returns how many there are
+  const auto read_round = [&](std::vector<Chunk>* round) {
+    size_t filled = 0;
+    for (; filled < chunks_per_round; ++filled) {
+      Chunk& chunk = (*round)[filled];
+      if (log.has_value()) {
+        if (records.empty()) break;
+        chunk.records = records.first(std::min(records.size(), kChunkEvents));
+        records = records.subspan(chunk.records.size());
+      } else if (!reader->ReadLines(kChunkBytes, &chunk.text)) {
+        break;
+      }
+    }
+    return filled;
+  };
+
+  EventExportResult result;
+  result.path = options.path;
+  uint64_t written = 0;
+  const auto write = [&](std::string_view bytes) {
+    out.write(bytes.data(), bytes.size());
+    written += bytes.size();
+  };
+
+  ArrowBlock dictionary{};
+  std::vector<ArrowBlock> batches;
+  std::string preamble;
+  switch (options.format) {
+    case EventExportFormat::Json:
+      preamble = "[";
+      break;
+    case EventExportFormat::Csv:
+      preamble = "type,truck_id,station_id,start_time,end_time\n";
+      break;
+    case EventExportFormat::Arrow:
+      AppendArrowPreamble(&preamble, &dictionary);
+      break;
+  }
+  write(preamble);
+
+  std::vector<Chunk> rounds[2] = {std::vector<Chunk>(chunks_per_round),
+                                  std::vector<Chunk>(chunks_per_round)};
+  size_t current = 0;
+  size_t filled = read_round(&rounds[current]);
+  while (filled > 0) {
+    std::vector<Chunk>& round = rounds[current];
+    for (size_t c = 0; c < filled; ++c) {
+      Chunk* chunk = &round[c];
+      if (pool.has_value()) {
+        pool->Submit([format = options.format, chunk] {
+          ConvertChunk(format, chunk);
+        });
+      } else {
+        ConvertChunk(options.format, chunk);
+      }
+    }
+    // The next round is read while this one is converted
+    const size_t next = read_round(&rounds[1 - current]);
+    if (pool.has_value()) pool->Wait();
+
+    for (size_t c = 0; c < filled; ++c) {
+      const Chunk& chunk = round[c];
+      result.skipped += chunk.skipped;
+      if (chunk.events.empty()) continue;
+      std::string_view output = chunk.output;
+      if (options.format == EventExportFormat::Json && result.num_events == 0) {
+        output.remove_prefix(1);  // No comma before the first event
+      } else if (options.format == EventExportFormat::Arrow) {
+        batches.push_back({static_cast<int64_t>(written),
+                           chunk.metadata_length, 0, chunk.body_length});
+      }
+      write(output);
+      result.num_events += chunk.events.size();
+    }
+    filled = next;
+    current = 1 - current;
+  }
+
+  std::string trailer;
+  switch (options.format) {
+    case EventExportFormat::Json:
+      trailer = result.num_events > 0 ? "\n]\n" : "]\n";
+      break;
+    case EventExportFormat::Csv:
+      break;
+    case EventExportFormat::Arrow:
+      AppendArrowFooter(dictionary, batches, &trailer);
+      break;
+  }
+  write(trailer);
+  out.flush();
+  if (!out) {
+    Logger::LogAndThrowError("Unable to write event export: " + options.path);
+  }
+  return result;
+}
@@ -0,0 +1,321 @@
+#include "event_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <utility>
+
+#include "analyze.h"
+#include "logger.h"
+
+std::string EventIndexPath(const std::string& log_path) {
+  return log_path + ".idx";
+}
+
+EventIndexWriter::EventIndexWriter(const std::string& path,
+                                   uint64_t first_event)
+    : path_(path), next_event_(first_event) {
+  out_.open(path, std::ios::out | std::ios::binary |
+                      (first_event > 0 ? std::ios::app : std::ios::trunc));
+  if (!out_.is_open()) {
+    Logger::LogAndThrowError("Unable to open event index for writing: " +
+                             path);
+  }
+  if (first_event == 0) {
+    EventIndexHeader header{};
+    std::memcpy(header.magic, kEventIndexMagic, sizeof(header.magic));
+    header.version = kEventIndexVersion;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_.flush();  // An index without blocks yet is still readable
+  }
+}
+
+// Ids are dense, so the first sighting of each in a block is found by
+// stamping it with the block, and only distinct ids are sorted
+void EventIndexWriter::AddId(uint32_t id, std::vector<uint64_t>* seen,
+                             std::vector<uint32_t>* ids) {
+  if (id >= seen->size()) seen->resize(size_t{id} + 1, 0);
+  if ((*seen)[id] != block_) {
+    (*seen)[id] = block_;
+    ids->push_back(id);
+  }
+}
+
+// Blocks without events are left out; nothing refers to them
+void EventIndexWriter::AddBlock(std::span<const EventRecord> records,
+                                uint64_t offset, uint64_t size) {
+  if (records.empty()) return;
+  EventIndexEntry entry{};
+  entry.offset = offset;
+  entry.size = size;
+  entry.first_event = next_event_;
+  entry.num_events = static_cast<uint32_t>(records.size());
+  entry.min_start = std::numeric_limits<uint32_t>::max();
+  trucks_.clear();
+  stations_.clear();
+  ++block_;
+  for (const EventRecord& record : records) {
+    if (record.type < kNumEventTypes) entry.type_mask |= 1u << record.type;
+    entry.min_start = std::min(entry.min_start, record.start_time);
+    entry.max_end = std::max(entry.max_end, record.end_time);
+    AddId(record.truck_id, &truck_seen_, &trucks_);
+    if (record.station_id != kNoStation) {
+      AddId(record.station_id, &station_seen_, &stations_);
+    }
+  }
+  std::sort(trucks_.begin(), trucks_.end());
+  std::sort(stations_.begin(), stations_.end());
+  entry.num_trucks = static_cast<uint32_t>(trucks_.size());
+  entry.num_stations = static_cast<uint32_t>(stations_.size());
+
+  out_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  out_.write(reinterpret_cast<const char*>(trucks_.data()),
+             trucks_.size() * sizeof(uint32_t));
+  out_.write(reinterpret_cast<const char*>(stations_.data()),
+             stations_.size() * sizeof(uint32_t));
+  if (!out_) Logger::LogAndThrowError("Unable to write event index: " + path_);
+  next_event_ += records.size();
+}
+
+namespace {
+// Appends the events of the JSON Lines in text; blank lines and lines that
+// do not parse are skipped
+void ParseLines(std::string_view text, std::vector<EventRecord>* records) {
+  for (size_t line = 0; line < text.size();) {
+    const size_t end = std::min(text.find('\n', line), text.size());
+    EventRecord record{};
+    if (end > line &&
+        ParseEventRecord(text.substr(line, end - line), &record)) {
+      records->push_back(record);
+    }
+    line = end + 1;
+  }
+}
+
+bool IsCompressed(std::span<const char> bytes) {
+  return bytes.size() >= 2 && static_cast<unsigned char>(bytes[0]) == 0x1f &&
+         static_cast<unsigned char>(bytes[1]) == 0x8b;
+}
+
+bool IsBinary(std::span<const char> bytes) {
+  return bytes.size() >= sizeof(kEventLogMagic) &&
+         std::memcmp(bytes.data(), kEventLogMagic, sizeof(kEventLogMagic)) ==
+             0;
+}
+
+// Inverts the id lists of the blocks (lists[b] is where block b's ids start
+// in words, and how many there are) into a posting list of blocks per id
+void BuildPostings(const std::vector<uint32_t>& words,
+                   const std::vector<std::pair<size_t, uint32_t>>& lists,
+                   std::vector<uint32_t>* starts,
+                   std::vector<uint32_t>* blocks) {
+  starts->assign(1, 0);
+  for (const auto& [at, count] : lists) {
+    for (uint32_t i = 0; i < count; ++i) {
+      const size_t id = words[at + i];
+      if (id + 2 > starts->size()) starts->resize(id + 2, 0);
+      ++(*starts)[id + 1];
+    }
+  }
+  std::partial_sum(starts->begin(), starts->end(), starts->begin());
+  blocks->resize(starts->back());
+  std::vector<uint32_t> next(starts->begin(), starts->end() - 1);
+  for (uint32_t block = 0; block < lists.size(); ++block) {
+    const auto& [at, count] = lists[block];
+    for (uint32_t i = 0; i < count; ++i) {
+      (*blocks)[next[words[at + i]]++] = block;
+    }
+  }
+}
+
+bool Matches(const EventQuery& query, const EventRecord& record) {
+  return (!query.type || record.type == static_cast<uint32_t>(*query.type)) &&
+         (!query.truck_id || record.truck_id == *query.truck_id) &&
+         (!query.station_id || (record.station_id != kNoStation &&
+                                record.station_id == *query.station_id)) &&
+         minutes_t(record.start_time) <= query.to &&
+         minutes_t(record.end_time) >= query.from;
+}
+}  // namespace
+
+uint64_t BuildEventIndex(const std::string& log_path) {
+  EventIndexWriter index(EventIndexPath(log_path), 0);
+  std::vector<EventRecord> records;
+  if (IsBinaryEventLog(log_path)) {
+    const MappedEventLog log(log_path);
+    const std::span<const EventRecord> all = log.records();
+    for (size_t first = 0; first < all.size(); first += kIndexBlockEvents) {
+      const auto block =
+          all.subspan(first, std::min(kIndexBlockEvents, all.size() - first));
+      index.AddBlock(block,
+                     sizeof(EventLogHeader) + first * sizeof(EventRecord),
+                     block.size_bytes());
+    }
+    index.Flush();
+    return index.num_events();
+  }
+
+  const MappedFile log(log_path);
+  const std::span<const char> bytes = log.bytes();
+  if (IsCompressed(bytes)) {
+    std::string text;
+    for (size_t offset = 0; offset < bytes.size();) {
+      const size_t size = DecompressMember(bytes.subspan(offset), &text);
+      if (size == 0) break;  // Cut off mid-member
+      records.clear();
+      ParseLines(text, &records);
+      index.AddBlock(records, offset, size);
+      offset += size;
+    }
+  } else {
+    const std::string_view text(bytes.data(), bytes.size());
+    size_t block_start = 0;
+    for (size_t line = 0; line < text.size();) {
+      const size_t end = std::min(text.find('\n', line), text.size());
+      ParseLines(text.substr(line, end - line), &records);
+      line = std::min(end + 1, text.size());
+      if (records.size() == kIndexBlockEvents || line == text.size()) {
+        index.AddBlock(records, block_start, line - block_start);
+        records.clear();
+        block_start = line;
+      }
+    }
+  }
+  index.Flush();
+  return index.num_events();
+}
+
+// Entries and their id lists are read as 32-bit words; everything in the
+// file is a multiple of 4 bytes
+EventIndex::EventIndex(const std::string& log_path) : log_path_(log_path) {
+  const std::string path = EventIndexPath(log_path);
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in.is_open()) {
+    Logger::LogAndThrowError("No event index for " + log_path + " (" + path +
+                             ")");
+  }
+  std::vector<uint32_t> words(static_cast<size_t>(in.tellg()) /
+                              sizeof(uint32_t));
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(words.data()),
+          words.size() * sizeof(uint32_t));
+  EventIndexHeader header{};
+  constexpr size_t kHeaderWords = sizeof(header) / sizeof(uint32_t);
+  constexpr size_t kEntryWords = sizeof(EventIndexEntry) / sizeof(uint32_t);
+  if (words.size() < kHeaderWords) {
+    Logger::LogAndThrowError("Truncated event index: " + path);
+  }
+  std::memcpy(&header, words.data(), sizeof(header));
+  if (std::memcmp(header.magic, kEventIndexMagic, sizeof(header.magic)) != 0 ||
+      header.version != kEventIndexVersion) {
+    Logger::LogAndThrowError("Not an event index this build can read: " +
+                             path);
+  }
+
+  log_ = std::make_unique<MappedFile>(log_path);
+  const std::span<const char> bytes = log_->bytes();
+  binary_ = IsBinary(bytes);
+  compressed_ = IsCompressed(bytes);
+
+  // A partial last entry (e.g. crash mid-flush) is ignored
+  std::vector<std::pair<size_t, uint32_t>> trucks, stations;
+  for (size_t at = kHeaderWords; at + kEntryWords <= words.size();) {
+    EventIndexEntry entry{};
+    std::memcpy(&entry, words.data() + at, sizeof(entry));
+    const size_t ids = at + kEntryWords;
+    at = ids + size_t{entry.num_trucks} + entry.num_stations;
+    if (at > words.size()) break;
+    if (entry.offset + entry.size > bytes.size()) {
+      Logger::LogAndThrowError("Event index " + path + " does not match " +
+                               log_path + "; rebuild it");
+    }
+    blocks_.push_back(entry);
+    trucks.emplace_back(ids, entry.num_trucks);
+    stations.emplace_back(ids + entry.num_trucks, entry.num_stations);
+    num_events_ = entry.first_event + entry.num_events;
+  }
+  BuildPostings(words, trucks, &truck_starts_, &truck_blocks_);
+  BuildPostings(words, stations, &station_starts_, &station_blocks_);
+}
+
+std::span<const uint32_t> EventIndex::Postings(
+    const std::vector<uint32_t>& starts, const std::vector<uint32_t>& blocks,
+    size_t id) const {
+  if (id + 1 >= starts.size()) return {};
+  return {blocks.data() + starts[id], starts[id + 1] - starts[id]};
+}
+
+// Candidates come from the posting lists (intersected if both a truck and a
+// station are given) and are then pruned by type and time range
+std::vector<uint32_t> EventIndex::MatchingBlocks(
+    const EventQuery& query) const {
+  std::vector<uint32_t> matches;
+  if (query.truck_id && query.station_id) {
+    const auto trucks = Postings(truck_starts_, truck_blocks_, *query.truck_id);
+    const auto stations =
+        Postings(station_starts_, station_blocks_, *query.station_id);
+    std::set_intersection(trucks.begin(), trucks.end(), stations.begin(),
+                          stations.end(), std::back_inserter(matches));
+  } else if (query.truck_id) {
+    const auto trucks = Postings(truck_starts_, truck_blocks_, *query.truck_id);
+    matches.assign(trucks.begin(), trucks.end());
+  } else if (query.station_id) {
+    const auto stations =
+        Postings(station_starts_, station_blocks_, *query.station_id);
+    matches.assign(stations.begin(), stations.end());
+  } else {
+    matches.resize(blocks_.size());
+    std::iota(matches.begin(), matches.end(), 0);
+  }
+  std::erase_if(matches, [&](uint32_t id) {
+    const EventIndexEntry& block = blocks_[id];
+    return (query.type &&
+            (block.type_mask & 1u << static_cast<uint32_t>(*query.type)) ==
+                0) ||
+           minutes_t(block.min_start) > query.to ||
+           minutes_t(block.max_end) < query.from;
+  });
+  return matches;
+}
+
+void EventIndex::ReadBlock(const EventIndexEntry& block,
+                           std::vector<EventRecord>* records) const {
+  const std::span<const char> bytes =
+      log_->bytes().subspan(block.offset, block.size);
+  records->clear();
+  if (binary_) {
+    records->resize(bytes.size() / sizeof(EventRecord));
+    std::memcpy(records->data(), bytes.data(),
+                records->size() * sizeof(EventRecord));
+  } else if (compressed_) {
+    std::string text;
+    if (DecompressMember(bytes, &text) == 0) {
+      Logger::LogAndThrowError("Event index " + EventIndexPath(log_path_) +
+                               " does not match " + log_path_ +
+                               "; rebuild it");
+    }
+    ParseLines(text, records);
+  } else {
+    ParseLines({bytes.data(), bytes.size()}, records);
+  }
+}
+
+std::vector<Event> EventIndex::Query(const EventQuery& query) const {
+  std::vector<Event> events;
+  std::vector<EventRecord> records;
+  for (const uint32_t block : MatchingBlocks(query)) {
+    ReadBlock(blocks_[block], &records);
+    for (const EventRecord& record : records) {
+      if (Matches(query, record)) events.push_back(FromRecord(record));
+    }
+  }
+  return events;
+}
+
+std::vector<Event> QueryEvents(const EventQuery& query) {
+  WaitUntilFlushed();
+  return EventIndex(GetEventLogger().filename()).Query(query);
+}
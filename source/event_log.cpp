@@ -0,0 +1,441 @@
+#include "event_log.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "event_index.h"
+#include "logger.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VAST_HAS_MMAP 1
+#endif
+
+// Packs an Event into its fixed-width on-disk form
+EventRecord ToRecord(const Event& event) {
+  EventRecord record;
+  record.type = static_cast<uint32_t>(event.type);
+  record.truck_id = static_cast<uint32_t>(event.truck_id);
+  record.station_id = event.station_id.has_value()
+                          ? static_cast<uint32_t>(event.station_id.value())
+                          : kNoStation;
+  record.start_time = static_cast<uint32_t>(event.start_time.count());
+  record.end_time = static_cast<uint32_t>(event.end_time.count());
+  return record;
+}
+
+// Packs a compact in-memory event; no optional or 64-bit fields to narrow
+EventRecord ToRecord(const PackedEvent& event) {
+  EventRecord record;
+  record.type = static_cast<uint32_t>(event.type());
+  record.truck_id = static_cast<uint32_t>(event.truck_id());
+  record.station_id = event.has_station() ? event.station_id() : kNoStation;
+  record.start_time = static_cast<uint32_t>(event.start_time().count());
+  record.end_time = static_cast<uint32_t>(event.end_time().count());
+  return record;
+}
+
+// Expands an on-disk record back into an Event
+Event FromRecord(const EventRecord& record) {
+  Event event;
+  event.type = static_cast<EventType>(record.type);
+  event.truck_id = record.truck_id;
+  if (record.station_id != kNoStation) event.station_id = record.station_id;
+  event.start_time = minutes_t(record.start_time);
+  event.end_time = minutes_t(record.end_time);
+  return event;
+}
+
+EventLogHeader MakeHeader(const RunParameters& params) {
+  EventLogHeader header{};
+  std::memcpy(header.magic, kEventLogMagic, sizeof(header.magic));
+  header.version = kEventLogVersion;
+  header.record_size = sizeof(EventRecord);
+  header.num_trucks = params.num_trucks;
+  header.num_stations = params.num_stations;
+  header.sim_minutes = params.sim_time.count();
+  header.random_seed = params.random_seed;
+  return header;
+}
+
+RunParameters ParamsFromHeader(const EventLogHeader& header) {
+  RunParameters params;
+  params.num_trucks = header.num_trucks;
+  params.num_stations = header.num_stations;
+  params.sim_time = minutes_t(header.sim_minutes);
+  params.random_seed = header.random_seed;
+  return params;
+}
+
+void ValidateHeader(const EventLogHeader& header, const std::string& filename) {
+  if (std::memcmp(header.magic, kEventLogMagic, sizeof(header.magic)) != 0) {
+    Logger::LogAndThrowError("Not a binary event log: " + filename);
+  }
+  if (header.version != kEventLogVersion ||
+      header.record_size != sizeof(EventRecord)) {
+    Logger::LogAndThrowError("Unsupported binary event log version in " +
+                             filename);
+  }
+}
+
+bool IsBinaryEventLog(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  char magic[sizeof(kEventLogMagic)] = {};
+  if (!in.read(magic, sizeof(magic))) return false;
+  return std::memcmp(magic, kEventLogMagic, sizeof(magic)) == 0;
+}
+
+// Maps the whole file read-only
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef VAST_HAS_MMAP
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    Logger::LogAndThrowError("Unable to open log file for reading: " +
+                             filename);
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      Logger::LogAndThrowError("Unable to map log file: " + filename);
+    }
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    mapping_ = mapping;
+    mapping_size_ = size;
+    bytes_ = {static_cast<const char*>(mapping), size};
+  }
+  ::close(fd);
+#else
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in.is_open()) {
+    Logger::LogAndThrowError("Unable to open log file for reading: " +
+                             filename);
+  }
+  fallback_.resize(static_cast<size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(fallback_.data(), fallback_.size());
+  bytes_ = fallback_;
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef VAST_HAS_MMAP
+  if (mapping_ != nullptr) ::munmap(mapping_, mapping_size_);
+#endif
+}
+
+// Validates the header and exposes the records in place
+MappedEventLog::MappedEventLog(const std::string& filename) : file_(filename) {
+  const std::span<const char> bytes = file_.bytes();
+  if (bytes.size() < sizeof(EventLogHeader)) {
+    Logger::LogAndThrowError("Truncated binary event log: " + filename);
+  }
+  std::memcpy(&header_, bytes.data(), sizeof(header_));
+  ValidateHeader(header_, filename);
+
+  // A partially written trailing record (e.g. crash mid-flush) is ignored
+  const size_t count =
+      (bytes.size() - sizeof(EventLogHeader)) / sizeof(EventRecord);
+  records_ = {
+      reinterpret_cast<const EventRecord*>(bytes.data() + sizeof(header_)),
+      count};
+}
+
+bool IsCompressedEventLog(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  unsigned char magic[2] = {};
+  if (!in.read(reinterpret_cast<char*>(magic), sizeof(magic))) return false;
+  return magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+namespace {
+// Members are capped so lengths fit zlib's 32-bit counters
+constexpr size_t kMaxMemberBytes = size_t{1} << 30;
+
+// zlib's window bits plus 16 selects the gzip wrapper
+constexpr int kGzipWindowBits = 15 + 16;
+
+// Status of the last read of file: Z_OK at the end of its data, or
+// Z_BUF_ERROR if it was cut off mid-member; throws on anything else
+int ReadStatus(gzFile file, const std::string& filename) {
+  int status = Z_OK;
+  const char* message = gzerror(file, &status);
+  if (status != Z_OK && status != Z_BUF_ERROR) {
+    Logger::LogAndThrowError("Corrupt compressed event log " + filename +
+                             ": " + message);
+  }
+  return status;
+}
+
+gzFile OpenForReading(const std::string& filename) {
+  gzFile file = gzopen(filename.c_str(), "rb");
+  if (file == nullptr) {
+    Logger::LogAndThrowError("Unable to open log file for reading: " +
+                             filename);
+  }
+  gzbuffer(file, 1 << 17);
+  return file;
+}
+}  // namespace
+
+BlockCompressor::BlockCompressor(int level)
+    : level_(level), stream_(std::make_unique<z_stream>()) {
+  if (level < 1 || level > 9) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Compression level must be between 1 and 9, not " +
+        std::to_string(level));
+  }
+  if (deflateInit2(stream_.get(), level, Z_DEFLATED, kGzipWindowBits, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    Logger::LogAndThrowError("Unable to initialize compression");
+  }
+}
+
+BlockCompressor::~BlockCompressor() { deflateEnd(stream_.get()); }
+
+// The output is sized by deflateBound, so each member takes a single
+// deflate call
+void BlockCompressor::Compress(std::string_view text, std::string* out) {
+  out->clear();
+  size_t offset = 0;
+  do {
+    const std::string_view piece = text.substr(offset, kMaxMemberBytes);
+    deflateReset(stream_.get());
+    const size_t start = out->size();
+    out->resize(start + deflateBound(stream_.get(), piece.size()));
+    stream_->next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(piece.data()));
+    stream_->avail_in = static_cast<uInt>(piece.size());
+    stream_->next_out = reinterpret_cast<Bytef*>(out->data() + start);
+    stream_->avail_out = static_cast<uInt>(out->size() - start);
+    if (deflate(stream_.get(), Z_FINISH) != Z_STREAM_END) {
+      Logger::LogAndThrowError("Unable to compress event log block");
+    }
+    out->resize(start + stream_->total_out);
+    offset += piece.size();
+  } while (offset < text.size());
+}
+
+// gzopen reads files without the gzip magic as they are
+EventLogLineReader::EventLogLineReader(const std::string& filename)
+    : filename_(filename), file_(OpenForReading(filename)) {}
+
+EventLogLineReader::~EventLogLineReader() { gzclose(file_); }
+
+bool EventLogLineReader::ReadLine(std::string* line) {
+  line->clear();
+  char buffer[4096];
+  while (gzgets(file_, buffer, sizeof(buffer)) != nullptr) {
+    line->append(buffer);
+    if (!line->empty() && line->back() == '\n') {
+      line->pop_back();
+      return true;
+    }
+  }
+  if (ReadStatus(file_, filename_) == Z_BUF_ERROR) {
+    return false;  // Partial line of a cut-off log
+  }
+  return !line->empty();
+}
+
+bool EventLogLineReader::Fill(size_t size, std::string* text) {
+  size_t filled = text->size();
+  text->resize(size);
+  while (filled < size) {
+    const int read = gzread(
+        file_, text->data() + filled,
+        static_cast<unsigned>(std::min(size - filled, kMaxMemberBytes)));
+    if (read <= 0) {
+      text->resize(filled);
+      return false;
+    }
+    filled += read;
+  }
+  return true;
+}
+
+bool EventLogLineReader::ReadLines(size_t max_bytes, std::string* text) {
+  text->swap(pending_);
+  pending_.clear();
+  for (size_t size = max_bytes; Fill(size, text); size += max_bytes) {
+    const size_t newline = text->rfind('\n');
+    if (newline != std::string::npos) {
+      pending_.assign(*text, newline + 1);
+      text->resize(newline + 1);
+      return true;
+    }
+  }
+  if (ReadStatus(file_, filename_) == Z_BUF_ERROR) {
+    text->resize(text->rfind('\n') + 1);  // Partial line of a cut-off log
+  } else if (!text->empty() && text->back() != '\n') {
+    text->push_back('\n');
+  }
+  return !text->empty();
+}
+
+size_t DecompressMember(std::span<const char> bytes, std::string* text) {
+  z_stream stream{};
+  if (inflateInit2(&stream, kGzipWindowBits) != Z_OK) {
+    Logger::LogAndThrowError("Unable to initialize decompression");
+  }
+  const std::unique_ptr<z_stream, int (*)(z_streamp)> guard(&stream,
+                                                            inflateEnd);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(bytes.data()));
+  stream.avail_in = static_cast<uInt>(
+      std::min<size_t>(bytes.size(), std::numeric_limits<uInt>::max()));
+  text->clear();
+  int status = Z_OK;
+  while (status == Z_OK) {
+    if (stream.total_out == text->size()) {
+      text->resize(std::max<size_t>(2 * text->size(), 1 << 16));
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(text->data() + stream.total_out);
+    stream.avail_out = static_cast<uInt>(std::min<size_t>(
+        text->size() - stream.total_out, std::numeric_limits<uInt>::max()));
+    status = inflate(&stream, Z_NO_FLUSH);
+  }
+  if (status == Z_BUF_ERROR && stream.avail_in == 0) {
+    text->clear();
+    return 0;
+  }
+  if (status != Z_STREAM_END) {
+    Logger::LogAndThrowError("Corrupt compressed event log member");
+  }
+  text->resize(stream.total_out);
+  return stream.total_in;
+}
+
+std::string DecompressEventLog(const std::string& filename) {
+  const std::unique_ptr<gzFile_s, int (*)(gzFile)> file(
+      OpenForReading(filename), gzclose);
+  constexpr size_t kChunk = 1 << 20;
+  std::string text;
+  size_t size = 0;
+  int read = 0;
+  do {
+    text.resize(size + kChunk);
+    read = gzread(file.get(), text.data() + size, kChunk);
+    if (read > 0) size += read;
+  } while (read > 0);
+  text.resize(size);
+  if (ReadStatus(file.get(), filename) == Z_BUF_ERROR) {
+    text.resize(text.rfind('\n') + 1);  // Empty if no line is whole
+  }
+  return text;
+}
+
+void ConvertJsonLinesToBinary(const std::string& jsonl_path,
+                              const std::string& binary_path,
+                              const RunParameters& params) {
+  EventLogLineReader in(jsonl_path);
+  std::ofstream out(binary_path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open log file for writing: " +
+                             binary_path);
+  }
+
+  const EventLogHeader header = MakeHeader(params);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  std::string line;
+  while (in.ReadLine(&line)) {
+    if (line.empty()) continue;
+    const EventRecord record = ToRecord(EventFromJsonLine(line));
+    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  }
+}
+
+void ConvertBinaryToJsonLines(const std::string& binary_path,
+                              const std::string& jsonl_path) {
+  const MappedEventLog log(binary_path);
+  std::ofstream out(jsonl_path, std::ios::trunc);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open log file for writing: " +
+                             jsonl_path);
+  }
+  for (const auto& record : log.records()) {
+    out << EventToJsonLine(FromRecord(record)) << "\n";
+  }
+}
+
+namespace {
+void ThrowTooFewEvents(const std::string& filename, uint64_t count) {
+  Logger::LogAndThrowError("Event log " + filename + " has fewer than " +
+                           std::to_string(count) + " events");
+}
+
+// A compressed log cannot be cut in place, so its first count events are
+// recompressed into a new file that then replaces it
+void TruncateCompressedEventLog(const std::string& filename, uint64_t count) {
+  constexpr size_t kBlockBytes = 1 << 24;
+  const std::string rewritten = filename + ".tmp";
+  uint64_t events = 0;
+  {
+    EventLogLineReader in(filename);
+    std::ofstream out(rewritten, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      Logger::LogAndThrowError("Unable to open log file for writing: " +
+                               rewritten);
+    }
+    BlockCompressor compressor;
+    std::string text, block, line;
+    bool more = true;
+    while (more) {
+      more = events < count && in.ReadLine(&line);
+      if (more && !line.empty()) {
+        text += line;
+        text += '\n';
+        ++events;
+      }
+      if (!text.empty() && (text.size() >= kBlockBytes || !more)) {
+        compressor.Compress(text, &block);
+        out.write(block.data(), block.size());
+        text.clear();
+      }
+    }
+  }
+  if (events < count) {
+    std::filesystem::remove(rewritten);
+    ThrowTooFewEvents(filename, count);
+  }
+  std::filesystem::rename(rewritten, filename);
+}
+}  // namespace
+
+void TruncateEventLog(const std::string& filename, uint64_t count) {
+  // The sidecar index may describe events that are about to go
+  std::error_code ec;
+  std::filesystem::remove(EventIndexPath(filename), ec);
+  if (IsCompressedEventLog(filename)) {
+    TruncateCompressedEventLog(filename, count);
+    return;
+  }
+  uint64_t size = 0;
+  uint64_t events = 0;
+  if (IsBinaryEventLog(filename)) {
+    size = sizeof(EventLogHeader) + count * sizeof(EventRecord);
+    if (std::filesystem::file_size(filename) >= size) events = count;
+  } else {
+    // Blank lines are skipped when reading, so they are not counted
+    std::ifstream in(filename, std::ios::binary);
+    std::string line;
+    while (events < count && std::getline(in, line)) {
+      size += line.size() + 1;
+      if (!line.empty()) ++events;
+    }
+  }
+  if (events < count) ThrowTooFewEvents(filename, count);
+  std::filesystem::resize_file(filename, size);
+}
@@ -1,23 +1,427 @@
+#include <algorithm>
 #include <chrono>  // NOLINT(build/c++11)
 #include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "checkpoint.h"
 #include "controller.h"
 #include "event.h"
+#include "event_export.h"
+#include "event_log.h"
+#include "event_sink.h"
+#include "metrics_export.h"
+#include "mining_distribution.h"
+#include "parallel_controller.h"
+#include "replication.h"
 #include "report.h"
+#include "scenario.h"
+#include "shard.h"
+#include "station_dispatch.h"
+#include "steady_state.h"
+#include "timing.h"
+
+// Where --checkpoint-every writes
+constexpr char kCheckpointFile[] = "checkpoint.bin";
+
+// Observation interval of --steady-state (5 make an MSER-5 group)
+constexpr minutes_t kSteadyStateInterval = 12min;
+
+// Checkpoint options of a single run
+struct CheckpointOptions {
+  minutes_t every = 0min;   // 0: no checkpoints
+  std::string resume_from;  // Empty: start at minute 0
+};
 
 void PrintUsage(const char* program_name) {
   std::cerr << "Usage: " << program_name
-            << " <num_trucks> <num_stations> [sim_minutes]\n"
+            << " [options] <num_trucks> <num_stations> [sim_minutes]\n"
+            << "       " << program_name
+            << " [options] --scenario=<file> [sim_minutes]\n"
             << "  <num_trucks>     Number of mining trucks (required)\n"
             << "  <num_stations>   Number of unload stations (required)\n"
             << "  [sim_minutes]    Duration of simulation in minutes "
-               "(optional, default: 4320)\n";
+               "(optional, default: 4320)\n"
+            << "Options:\n"
+            << "  --binary-events          Write events.bin in the binary log "
+               "format\n"
+            << "                           instead of events.json\n"
+            << "  --compress[=<level>]     Write events.json.gz, gzip level "
+               "1-9 (default: "
+            << kDefaultCompressionLevel << ")\n"
+            << "  --sink=<name>            Where events go: file (default), "
+               "memory or null\n"
+            << "  --stats                  Print engine and event logger "
+               "statistics after\n"
+            << "                           the run\n"
+            << "  --interval=<m>           Also export utilization and "
+               "queue length per m-minute\n"
+            << "                           interval (time series report)\n"
+            << "  --estimate               Print an analytic queueing "
+               "estimate instead of\n"
+            << "                           simulating (no files written)\n"
+            << "  --replications=<k>       Run up to k independent "
+               "replications (metrics\n"
+            << "                           only) and report means with 95% "
+               "CIs\n"
+            << "  --threads=<n>            Worker threads for replications "
+               "(default: all)\n"
+            << "  --engine-threads=<n>     Simulate one run on n threads "
+               "(0: all cores);\n"
+            << "                           same results, no event log "
+               "(implies --sink=null)\n"
+            << "  --target-half-width=<h>  Stop replicating once the "
+               "utilization CIs are\n"
+            << "                           within +/- h percentage points\n"
+            << "  --shard=<i>/<n>          Run only shard i of n of the "
+               "replications and write\n"
+            << "                           a partial result for the merge "
+               "tool\n"
+            << "  --checkpoint-every=<m>   Save the run's state to "
+            << kCheckpointFile << " every m\n"
+            << "                           simulated minutes and at the end\n"
+            << "  --resume=<file>          Continue the run saved in a "
+               "checkpoint up to\n"
+            << "                           sim_minutes (same trucks and "
+               "stations; may be\n"
+            << "                           longer, to extend a finished "
+               "run)\n"
+            << "  --mining=<spec>          Mining durations: uniform "
+               "(default),\n"
+            << "                           triangular:<mode>, "
+               "lognormal:<median>:<sigma>\n"
+            << "                           (either may end in :<min>:<max>) "
+               "or\n"
+            << "                           empirical:<histogram file>\n"
+            << "  --scenario=<file>        Take the trucks, stations and "
+               "their timing from a\n"
+            << "                           JSON scenario file (single runs "
+               "only)\n"
+            << "  --metrics-format=<f>     Metrics report as json "
+               "(default), compact (JSON\n"
+            << "                           without whitespace), csv or "
+               "columnar (binary)\n"
+            << "  --metrics-out=<file>     Write the metrics report to file "
+               "instead of\n"
+            << "                           metrics.<trucks>truck_..."
+               "<ext>\n"
+            << "  --dispatch=<policy>      How arriving trucks are given "
+               "stations: earliest\n"
+            << "                           (default), least-loaded, "
+               "round-robin or\n"
+            << "                           affinity:<mines> (single runs "
+               "only)\n"
+            << "  --export-events[=<f>]    After the run, also convert the "
+               "event log to json\n"
+            << "                           (default), csv or arrow (Feather "
+               "v2) in\n"
+            << "                           events.<trucks>truck_...<ext>\n"
+            << "  --index-events           Keep a sidecar index of the event "
+               "log (<log>.idx)\n"
+            << "                           for block-level queries "
+               "(single runs only)\n"
+            << "  --steady-state[=<p>]     Drop the warm-up (MSER-5) and stop "
+               "once batch-means\n"
+            << "                           CIs are within p of the "
+               "steady-state values\n"
+            << "                           (default: 0.05; 0 runs to "
+               "sim_minutes; single\n"
+            << "                           runs only)\n";
+}
+
+// Runs and times one simulation with the given event sink, timing and
+// dispatcher
+template <EventSink Sink, TimingPolicy Timing = FixedTiming,
+          StationDispatcher Dispatch = EarliestAvailable<Timing>>
+void RunSimulation(size_t num_trucks, size_t num_stations, minutes_t sim_time,
+                   minutes_t interval, bool stats,
+                   const MiningDistribution& mining,
+                   const CheckpointOptions& checkpoints,
+                   const SteadyStateOptions& steady_state,
+                   const MetricsExportOptions& metrics_export,
+                   Timing timing = Timing(), Dispatch dispatch = Dispatch(),
+                   Sink sink = Sink()) {
+  BasicController<Sink, TimingWheelScheduler, Timing, Dispatch> controller(
+      num_trucks, num_stations, 0xBEEF, std::move(sink));
+  controller.SetTimeSeriesInterval(interval);
+  controller.SetMetricsExport(metrics_export);
+  controller.SetMiningDistribution(mining);
+  controller.SetTiming(std::move(timing));
+  controller.SetDispatch(std::move(dispatch));
+  controller.SetCheckpointInterval(checkpoints.every, kCheckpointFile);
+  controller.SetSteadyState(steady_state);
+  if (!checkpoints.resume_from.empty()) {
+    controller.LoadCheckpoint(checkpoints.resume_from);
+  }
+  auto start_time = std::chrono::steady_clock::now();
+  controller.Run(sim_time);
+  auto end_time = std::chrono::steady_clock::now();
+  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         end_time - start_time)
+                         .count();
+
+  if constexpr (std::is_same_v<Sink, VectorEventSink>) {
+    std::cout << "\nEvents kept in memory: "
+              << controller.sink().events().size() << "\n";
+  }
+  std::cout << "\nSimulation completed in " << duration_ms << " ms\n";
+
+  if (stats) {
+    PrintEngineStats(controller.stats());
+    if constexpr (std::is_same_v<Sink, FileEventSink>) {
+      WaitUntilFlushed();
+      PrintLoggerStats(GetEventLogger().stats());
+    }
+  }
+}
+
+// Runs and times one simulation on the parallel engine
+void RunParallelSimulation(size_t num_trucks, size_t num_stations,
+                           minutes_t sim_time, minutes_t interval, bool stats,
+                           const MiningDistribution& mining,
+                           const MetricsExportOptions& metrics_export,
+                           size_t num_threads) {
+  ParallelController controller(num_trucks, num_stations, 0xBEEF,
+                                num_threads);
+  controller.SetTimeSeriesInterval(interval);
+  controller.SetMetricsExport(metrics_export);
+  controller.SetMiningDistribution(mining);
+  auto start_time = std::chrono::steady_clock::now();
+  controller.Run(sim_time);
+  auto end_time = std::chrono::steady_clock::now();
+  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         end_time - start_time)
+                         .count();
+
+  std::cout << "\nSimulation completed in " << duration_ms << " ms on "
+            << controller.num_threads() << " threads\n";
+  if (stats) PrintEngineStats(controller.stats());
+}
+
+// Computes and times the analytic estimate of a run
+void RunEstimate(size_t num_trucks, size_t num_stations, minutes_t sim_time) {
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+  auto start_time = std::chrono::steady_clock::now();
+  const QueueingEstimate estimate = EstimateQueueing(num_trucks, num_stations);
+  EstimateMetrics(num_trucks, num_stations, sim_time, &trucks, &stations);
+  auto end_time = std::chrono::steady_clock::now();
+  auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                         end_time - start_time)
+                         .count();
+
+  PrintMetricsSummary(trucks, stations, sim_time);
+  std::cout << "\n=== Steady State ===\n"
+            << "Cycle Time: " << estimate.cycle_time << " minutes\n"
+            << "Station Utilization: "
+            << estimate.station_utilization * 100.0 << "%\n"
+            << "Probability of Queueing: "
+            << estimate.wait_probability * 100.0 << "%\n"
+            << "Mean Queueing Time: " << estimate.mean_wait
+            << " minutes per arrival\n"
+            << "\nEstimate completed in " << duration_us << " us\n";
+}
+
+// Runs and times a batch of replications, then reports their statistics,
+// or for a shard writes its partial result
+void RunReplicationBatch(const ReplicationOptions& options) {
+  auto start_time = std::chrono::steady_clock::now();
+  const ReplicationResult result = RunReplications(options);
+  auto end_time = std::chrono::steady_clock::now();
+  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         end_time - start_time)
+                         .count();
+
+  if (options.shard.sharded()) {
+    std::cout << "\nPartial result of " << result.replications
+              << " replications: " << WriteReplicationShard(options, result)
+              << "\n"
+              << "\nShard completed in " << duration_ms << " ms\n";
+    return;
+  }
+  PrintReplicationSummary(options, result);
+  std::cout << "\nFull replication report: "
+            << ExportReplicationsToJson(options, result) << "\n"
+            << "\nReplications completed in " << duration_ms << " ms\n";
+}
+
+// Parses the value of a --name=value option
+template <typename T>
+bool ParseOptionValue(const std::string& arg, const std::string& prefix,
+                      T* value) {
+  if (arg.rfind(prefix, 0) != 0) return false;
+  const std::string text = arg.substr(prefix.size());
+  if constexpr (std::is_floating_point_v<T>) {
+    *value = std::stod(text);
+  } else {
+    *value = std::stoul(text);
+  }
+  return true;
 }
 
 int main(int argc, char** argv) {
-  if (argc < 3) {
+  std::vector<std::string> args;
+  bool binary_events = false;
+  size_t compression_level = 0;
+  std::string sink = "file";
+  bool sink_given = false;
+  bool estimate = false;
+  bool stats = false;
+  size_t interval_minutes = 0;
+  size_t replications = 0;
+  size_t num_threads = 0;
+  std::optional<size_t> engine_threads;
+  double target_half_width = 0.0;
+  size_t checkpoint_minutes = 0;
+  std::string resume_from;
+  MiningDistribution mining = MiningDistribution::Uniform(
+      Controller::kMinDuration, Controller::kMaxDuration);
+  bool mining_given = false;
+  std::optional<Scenario> scenario;
+  std::string dispatch = "earliest";
+  size_t num_mines = 1;  // For affinity dispatch
+  MetricsExportOptions metrics_export;
+  std::optional<EventExportOptions> event_export;
+  bool index_events = false;
+  SteadyStateOptions steady_state;
+  ShardSpec shard;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    try {
+      if (ParseOptionValue(arg, "--interval=", &interval_minutes) ||
+          ParseOptionValue(arg, "--replications=", &replications) ||
+          ParseOptionValue(arg, "--threads=", &num_threads) ||
+          ParseOptionValue(arg, "--checkpoint-every=", &checkpoint_minutes) ||
+          ParseOptionValue(arg, "--compress=", &compression_level) ||
+          ParseOptionValue(arg, "--target-half-width=", &target_half_width)) {
+        continue;
+      }
+    } catch (const std::exception& e) {
+      std::cerr << "Error: Invalid value in " << arg << "\n";
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    if (arg.rfind("--engine-threads=", 0) == 0) {
+      try {
+        engine_threads = std::stoul(arg.substr(17));
+      } catch (const std::exception& e) {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--mining=", 0) == 0) {
+      try {
+        mining = MiningDistribution::Parse(arg.substr(9),
+                                           Controller::kMinDuration,
+                                           Controller::kMaxDuration);
+        mining_given = true;
+      } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--scenario=", 0) == 0) {
+      try {
+        scenario = ReadScenario(arg.substr(11));
+      } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--dispatch=", 0) == 0) {
+      dispatch = arg.substr(11);
+      if (dispatch.rfind("affinity:", 0) == 0) {
+        try {
+          num_mines = std::stoul(dispatch.substr(9));
+        } catch (const std::exception& e) {
+          num_mines = 0;
+        }
+        dispatch = num_mines > 0 ? "affinity" : "";
+      }
+      if (dispatch != "earliest" && dispatch != "least-loaded" &&
+          dispatch != "round-robin" && dispatch != "affinity") {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--metrics-format=", 0) == 0) {
+      try {
+        metrics_export.format = MetricsFormatFromString(
+            arg.substr(std::string("--metrics-format=").size()));
+      } catch (const std::exception& e) {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--export-events") {
+      event_export.emplace();
+    } else if (arg.rfind("--export-events=", 0) == 0) {
+      try {
+        event_export.emplace().format = EventExportFormatFromString(
+            arg.substr(std::string("--export-events=").size()));
+      } catch (const std::exception& e) {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--metrics-out=", 0) == 0) {
+      metrics_export.path = arg.substr(std::string("--metrics-out=").size());
+    } else if (arg.rfind("--resume=", 0) == 0) {
+      resume_from = arg.substr(std::string("--resume=").size());
+    } else if (arg == "--steady-state") {
+      steady_state.interval = kSteadyStateInterval;
+    } else if (arg.rfind("--steady-state=", 0) == 0) {
+      steady_state.interval = kSteadyStateInterval;
+      try {
+        steady_state.relative_precision = std::stod(
+            arg.substr(std::string("--steady-state=").size()));
+      } catch (const std::exception& e) {
+        steady_state.relative_precision = -1.0;
+      }
+      if (steady_state.relative_precision < 0.0) {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--shard=", 0) == 0) {
+      try {
+        shard = ParseShardSpec(arg.substr(std::string("--shard=").size()));
+      } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--index-events") {
+      index_events = true;
+    } else if (arg == "--binary-events") {
+      binary_events = true;
+    } else if (arg == "--compress") {
+      compression_level = kDefaultCompressionLevel;
+    } else if (arg == "--estimate") {
+      estimate = true;
+    } else if (arg == "--stats") {
+      stats = true;
+    } else if (arg.rfind("--sink=", 0) == 0) {
+      sink = arg.substr(std::string("--sink=").size());
+      sink_given = true;
+      if (sink != "file" && sink != "memory" && sink != "null") {
+        std::cerr << "Error: Unknown sink " << sink << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Error: Unknown option " << arg << "\n";
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  // A scenario gives the trucks and stations, leaving only [sim_minutes]
+  const size_t fleet_args = scenario.has_value() ? 0 : 2;
+  if (args.size() < fleet_args || (scenario.has_value() && args.size() > 1)) {
     PrintUsage(argv[0]);
     return EXIT_FAILURE;
   }
@@ -27,31 +431,224 @@ int main(int argc, char** argv) {
   minutes_t sim_time = 72 * 60min;  // Default: 72 hours
 
   try {
-    num_trucks = std::stoul(argv[1]);
-    num_stations = std::stoul(argv[2]);
-    if (argc >= 4) {
-      sim_time = minutes_t(std::stoul(argv[3]));
+    if (scenario.has_value()) {
+      num_trucks = scenario->num_trucks();
+      num_stations = scenario->num_stations();
+    } else {
+      num_trucks = std::stoul(args[0]);
+      num_stations = std::stoul(args[1]);
+    }
+    if (args.size() > fleet_args) {
+      sim_time = minutes_t(std::stoul(args[fleet_args]));
     }
   } catch (const std::exception& e) {
     std::cerr << "Error: Invalid argument.\n";
     PrintUsage(argv[0]);
     return EXIT_FAILURE;
   }
-  ClearEvents();
 
-  std::cout << "Running simulation with " << num_trucks << " trucks and "
-            << num_stations << " stations for " << sim_time.count()
-            << " minutes...\n";
+  if (compression_level > 9 || (compression_level > 0 && binary_events)) {
+    std::cerr << "Error: Only JSON Lines logs are compressed, at levels 1 "
+                 "to 9\n";
+    return EXIT_FAILURE;
+  }
+
+  const CheckpointOptions checkpoints{minutes_t(checkpoint_minutes),
+                                      resume_from};
+  const bool single_run =
+      !estimate && replications == 0 && !engine_threads.has_value();
+  if ((checkpoints.every > 0min || !resume_from.empty()) && !single_run) {
+    std::cerr << "Error: Checkpoints only apply to a single run on the "
+                 "sequential engine\n";
+    return EXIT_FAILURE;
+  }
 
-  Controller controller(num_trucks, num_stations);
-  auto start_time = std::chrono::steady_clock::now();
-  controller.Run(sim_time);
-  auto end_time = std::chrono::steady_clock::now();
-  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                         end_time - start_time)
-                         .count();
+  const bool metrics_given = metrics_export.format != MetricsFormat::Json ||
+                             !metrics_export.path.empty();
+  if (metrics_given && (estimate || replications > 0)) {
+    std::cerr << "Error: The metrics report options only apply to a single "
+                 "run\n";
+    return EXIT_FAILURE;
+  }
 
-  std::cout << "\nSimulation completed in " << duration_ms << " ms\n";
+  if (event_export.has_value() && (!single_run || sink != "file")) {
+    std::cerr << "Error: Events are only exported from the log of a single "
+                 "run with --sink=file\n";
+    return EXIT_FAILURE;
+  }
+
+  if (index_events && (!single_run || sink != "file")) {
+    std::cerr << "Error: Only the event log of a single run with "
+                 "--sink=file is indexed\n";
+    return EXIT_FAILURE;
+  }
+
+  if (steady_state.interval > 0min &&
+      (!single_run || checkpoints.every > 0min || !resume_from.empty())) {
+    std::cerr << "Error: Steady-state monitoring only applies to a single "
+                 "run on the sequential engine, without checkpoints\n";
+    return EXIT_FAILURE;
+  }
+
+  if (shard.sharded() && (replications == 0 || target_half_width > 0.0)) {
+    std::cerr << "Error: Shards split a fixed number of --replications; "
+                 "early stopping needs them all\n";
+    return EXIT_FAILURE;
+  }
+
+  if (dispatch != "earliest" && !single_run) {
+    std::cerr << "Error: Dispatch policies only apply to a single run on the "
+                 "sequential engine\n";
+    return EXIT_FAILURE;
+  }
+  if (scenario.has_value() && (!single_run || mining_given)) {
+    std::cerr << "Error: A scenario only applies to a single run on the "
+                 "sequential engine, with the scenario's mining durations\n";
+    return EXIT_FAILURE;
+  }
+
+  if (estimate) {
+    if (mining_given) {
+      std::cerr << "Error: The estimate assumes uniform mining durations\n";
+      return EXIT_FAILURE;
+    }
+    if (num_trucks == 0 || num_stations == 0) {
+      std::cerr << "Error: Need at least one truck and one station.\n";
+      return EXIT_FAILURE;
+    }
+    std::cout << "Estimating " << num_trucks << " trucks and " << num_stations
+              << " stations for " << sim_time.count() << " minutes...\n";
+    RunEstimate(num_trucks, num_stations, sim_time);
+    return EXIT_SUCCESS;
+  }
+
+  if (replications > 0) {
+    ReplicationOptions options;
+    options.num_trucks = num_trucks;
+    options.num_stations = num_stations;
+    options.sim_time = sim_time;
+    options.max_replications = replications;
+    options.min_replications = std::min(options.min_replications, replications);
+    options.num_threads = num_threads;
+    options.target_half_width = target_half_width;
+    options.shard = shard;
+    if (mining_given) options.mining_distribution = mining;
+
+    if (shard.sharded()) {
+      std::cout << "Running shard " << shard.index + 1 << " of "
+                << shard.count << " (" << shard.NumItems(replications)
+                << " of " << replications << " replications) with ";
+    } else {
+      std::cout << "Running up to " << replications << " replications with ";
+    }
+    std::cout << num_trucks << " trucks and " << num_stations
+              << " stations for " << sim_time.count() << " minutes...\n";
+    try {
+      RunReplicationBatch(options);
+    } catch (const std::exception& e) {
+      std::cerr << "Error: " << e.what() << "\n";
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (engine_threads.has_value()) {
+    if (sink_given && sink != "null") {
+      std::cerr << "Error: The parallel engine does not log events; use "
+                   "--sink=null\n";
+      return EXIT_FAILURE;
+    }
+    std::cout << "Running simulation with " << num_trucks << " trucks and "
+              << num_stations << " stations for " << sim_time.count()
+              << " minutes on the parallel engine...\n";
+    try {
+      RunParallelSimulation(
+          num_trucks, num_stations, sim_time, minutes_t(interval_minutes),
+          stats, mining, metrics_export, *engine_threads);
+    } catch (const std::exception& e) {
+      std::cerr << "Error: " << e.what() << "\n";
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  try {
+    if (sink == "file") {
+      const std::string log = binary_events           ? "events.bin"
+                              : compression_level > 0 ? "events.json.gz"
+                                                      : "events.json";
+      const bool resume = !resume_from.empty();
+      // A resumed run continues the log, from where the checkpoint was taken
+      if (resume) {
+        TruncateEventLog(log, ReadCheckpointHeader(resume_from).events_emitted);
+      }
+      if (binary_events) {
+        GetEventLogger().Reopen(log, LogFormat::Binary, resume);
+      } else if (compression_level > 0) {
+        GetEventLogger().Reopen(log, LogFormat::JsonLines, resume,
+                                static_cast<int>(compression_level));
+      } else if (!resume) {
+        ClearEvents();
+      }
+      // A resumed log is indexed up to the checkpoint first
+      if (index_events) GetEventLogger().SetIndexing(true);
+    }
+
+    std::cout << (resume_from.empty() ? "Running" : "Resuming")
+              << " simulation with " << num_trucks << " trucks and "
+              << num_stations << " stations for " << sim_time.count()
+              << " minutes...\n";
+
+    const minutes_t interval(interval_minutes);
+    const auto run_with = [&](auto timing, auto dispatcher) {
+      using Timing = decltype(timing);
+      using Dispatch = decltype(dispatcher);
+      if (sink == "null") {
+        RunSimulation<NullEventSink, Timing, Dispatch>(
+            num_trucks, num_stations, sim_time, interval, stats, mining,
+            checkpoints, steady_state, metrics_export, std::move(timing),
+            std::move(dispatcher));
+      } else if (sink == "memory") {
+        RunSimulation<VectorEventSink, Timing, Dispatch>(
+            num_trucks, num_stations, sim_time, interval, stats, mining,
+            checkpoints, steady_state, metrics_export, std::move(timing),
+            std::move(dispatcher));
+      } else {
+        RunSimulation<FileEventSink, Timing, Dispatch>(
+            num_trucks, num_stations, sim_time, interval, stats, mining,
+            checkpoints, steady_state, metrics_export, std::move(timing),
+            std::move(dispatcher));
+      }
+    };
+    const auto run = [&](auto timing) {
+      if (dispatch == "least-loaded") {
+        run_with(std::move(timing), LeastLoadedDispatch());
+      } else if (dispatch == "round-robin") {
+        run_with(std::move(timing), RoundRobinDispatch());
+      } else if (dispatch == "affinity") {
+        run_with(std::move(timing), AffinityDispatch(num_mines));
+      } else {
+        run_with(std::move(timing), EarliestAvailable<decltype(timing)>());
+      }
+    };
+    if (!scenario.has_value()) {
+      run(FixedTiming());
+    } else if (scenario->UsesFixedTiming()) {
+      // Homogeneous: the constant-folded default engine
+      if (!scenario->truck_classes.empty()) {
+        mining = scenario->truck_classes.front().mining;
+      }
+      run(FixedTiming());
+    } else {
+      run(ScenarioTiming(*scenario));
+    }
+    if (event_export.has_value()) {
+      ExportAllEventsToJson(num_trucks, num_stations, sim_time, *event_export);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,108 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "replication.h"
+#include "shard.h"
+#include "sweep.h"
+
+void PrintUsage(const char* program_name) {
+  std::cerr << "Usage: " << program_name << " [options] <shard>...\n"
+            << "  Combines the partial results of a sharded replication "
+               "batch (main --shard)\n"
+            << "  or sweep (sweep --shard) into the report of the whole "
+               "batch.\n"
+            << "Options:\n"
+            << "  --output=<file>    Sweep table (default: sweep.csv); a "
+               ".bin extension\n"
+            << "                     writes the binary format instead of "
+               "CSV\n";
+}
+
+// Merges replication shards and reports them as main does an unsharded
+// batch
+void MergeReplications(const std::vector<std::string>& files) {
+  std::vector<ReplicationShard> shards;
+  for (const std::string& file : files) {
+    shards.push_back(ReadReplicationShard(file));
+  }
+  ReplicationOptions options;
+  const ReplicationResult result = MergeReplicationShards(shards, &options);
+  if (result.replications < options.max_replications) {
+    std::cerr << "Warning: Shards cover " << result.replications << " of "
+              << options.max_replications << " replications\n";
+  }
+
+  PrintReplicationSummary(options, result);
+  std::cout << "\nFull replication report: "
+            << ExportReplicationsToJson(options, result) << "\n";
+}
+
+// Merges sweep shards into one table in grid order
+void MergeSweep(const std::vector<std::string>& files,
+                const std::string& output) {
+  std::vector<SweepShard> shards;
+  for (const std::string& file : files) {
+    shards.push_back(ReadSweepShard(file));
+  }
+  SweepOptions options;
+  const std::vector<SweepResult> results = MergeSweepShards(shards, &options);
+  const size_t num_cells = options.trucks.size() * options.stations.size() *
+                           options.sim_times.size();
+  if (results.size() < num_cells) {
+    std::cerr << "Warning: Shards cover " << results.size() << " of "
+              << num_cells << " configurations\n";
+  }
+
+  const bool binary =
+      output.size() >= 4 && output.compare(output.size() - 4, 4, ".bin") == 0;
+  if (binary) {
+    WriteSweepBinary(output, results);
+  } else {
+    WriteSweepCsv(output, results);
+  }
+  std::cout << "Merged " << results.size() << " configurations\n"
+            << "\nSweep table: " << output << "\n";
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> files;
+  std::string output = "sweep.csv";
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--output=", 0) == 0) {
+      output = arg.substr(9);
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Error: Unknown option " << arg << "\n";
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      files.push_back(arg);
+    }
+  }
+
+  if (files.empty()) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  try {
+    const std::string kind = ReadShardKind(files.front());
+    std::cout << "Merging " << files.size() << " " << kind << " shards...\n";
+    if (kind == "replications") {
+      MergeReplications(files);
+    } else if (kind == "sweep") {
+      MergeSweep(files, output);
+    } else {
+      std::cerr << "Error: Unknown kind of partial result: " << kind << "\n";
+      return EXIT_FAILURE;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,352 @@
+#include "metrics_export.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "logger.h"
+#include "metrics_store.h"
+#include "thread_pool.h"
+
+namespace {
+// One field of a truck or station row, in the report's order (the JSON
+// keys sorted, as the report has always had them)
+struct Field {
+  const char* name;
+  const std::vector<int32_t>* ints = nullptr;
+  const std::vector<double>* doubles = nullptr;
+  const std::vector<int64_t>* longs = nullptr;  // None: the row's id
+
+  bool is_id() const {
+    return ints == nullptr && doubles == nullptr && longs == nullptr;
+  }
+};
+
+std::vector<Field> TruckFields(const MetricsStore::TruckColumns& t) {
+  return {{"avg_queueing_time", nullptr, &t.avg_queueing_time},
+          {"avg_trip_time", nullptr, &t.avg_trip_time},
+          {"id"},
+          {"idle_time", &t.idle_time},
+          {"mines_completed", &t.mines_completed},
+          {"mining_time", &t.mining_time},
+          {"queueing_time", &t.queueing_time},
+          {"queues_completed", &t.queues_completed},
+          {"trips_completed", &t.trips_completed},
+          {"utilization", nullptr, &t.utilization}};
+}
+
+std::vector<Field> StationFields(const MetricsStore::StationColumns& s) {
+  return {{"avg_queueing_time", nullptr, &s.avg_queueing_time},
+          {"id"},
+          {"idle_time", nullptr, nullptr, &s.idle_time},
+          {"queueing_time", nullptr, nullptr, &s.queueing_time},
+          {"queues_completed", &s.queues_completed},
+          {"throughput", &s.throughput},
+          {"unloading_time", nullptr, nullptr, &s.unloading_time},
+          {"utilization", nullptr, &s.utilization}};
+}
+
+void AppendInt(std::string* out, int64_t value) {
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out->append(buffer, result.ptr);
+}
+
+// Formatted by nlohmann::json's own double printer (Grisu2, fixed notation
+// for decimal exponents in [-4, 15], whole numbers with a ".0"), so the
+// streamed report is byte for byte the document's dump. Non-finite values
+// are null (empty in CSV).
+void AppendDouble(std::string* out, double value, bool json) {
+  if (!std::isfinite(value)) {
+    if (json) out->append("null");
+    return;
+  }
+  char buffer[64];
+  out->append(buffer,
+              nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer),
+                                         value));
+}
+
+void AppendValue(std::string* out, const Field& field, size_t row,
+                 bool json) {
+  if (field.ints != nullptr) {
+    AppendInt(out, (*field.ints)[row]);
+  } else if (field.longs != nullptr) {
+    AppendInt(out, (*field.longs)[row]);
+  } else if (field.doubles != nullptr) {
+    AppendDouble(out, (*field.doubles)[row], json);
+  } else {
+    AppendInt(out, static_cast<int64_t>(row));
+  }
+}
+
+// Appends rows [begin, end) of a table as JSON objects, each but the
+// table's first preceded by a comma
+void AppendJsonRows(const std::vector<Field>& fields, bool pretty,
+                    size_t begin, size_t end, std::string* out) {
+  for (size_t row = begin; row < end; ++row) {
+    if (row > 0) out->append(pretty ? ",\n" : ",");
+    out->append(pretty ? "    {\n" : "{");
+    for (size_t f = 0; f < fields.size(); ++f) {
+      if (f > 0) out->append(pretty ? ",\n" : ",");
+      if (pretty) out->append("      ");
+      out->push_back('"');
+      out->append(fields[f].name);
+      out->append(pretty ? "\": " : "\":");
+      AppendValue(out, fields[f], row, true);
+    }
+    out->append(pretty ? "\n    }" : "}");
+  }
+}
+
+// Appends rows [begin, end) as CSV lines; columns holds the table's field
+// for each CSV column, or nullptr where the table has none
+void AppendCsvRows(const char* table, const std::vector<const Field*>& columns,
+                   size_t begin, size_t end, std::string* out) {
+  for (size_t row = begin; row < end; ++row) {
+    out->append(table);
+    for (const Field* field : columns) {
+      out->push_back(',');
+      if (field != nullptr) AppendValue(out, *field, row, false);
+    }
+    out->push_back('\n');
+  }
+}
+
+// Formats rows [0, count) a chunk per pool task and writes the chunks to
+// out in order, a round of chunks at a time; without a pool the rows are
+// formatted on this thread
+template <typename FormatRows>
+void WriteRows(size_t count, WorkStealingPool* pool, std::ofstream* out,
+               const FormatRows& format_rows) {
+  constexpr size_t kChunkRows = 1 << 14;
+  const size_t chunks_per_round = pool != nullptr ? 2 * pool->num_threads() : 1;
+  std::vector<std::string> chunks(chunks_per_round);
+  for (size_t round = 0; round < count;
+       round += chunks_per_round * kChunkRows) {
+    size_t used = 0;
+    for (; used < chunks_per_round; ++used) {
+      const size_t begin = round + used * kChunkRows;
+      if (begin >= count) break;
+      const size_t end = std::min(count, begin + kChunkRows);
+      std::string* text = &chunks[used];
+      text->clear();
+      if (pool != nullptr) {
+        pool->Submit([&format_rows, begin, end, text] {
+          format_rows(begin, end, text);
+        });
+      } else {
+        format_rows(begin, end, text);
+      }
+    }
+    if (pool != nullptr) pool->Wait();
+    for (size_t c = 0; c < used; ++c) {
+      out->write(chunks[c].data(), chunks[c].size());
+    }
+  }
+}
+
+void WriteJson(minutes_t sim_time, const MetricsStore& metrics, bool pretty,
+               WorkStealingPool* pool, std::ofstream* out) {
+  const auto write_table = [&](const char* name, size_t count,
+                               const std::vector<Field>& fields,
+                               bool last) {
+    *out << (pretty ? "  \"" : "\"") << name << (pretty ? "\": [" : "\":[");
+    if (count > 0) {
+      if (pretty) *out << "\n";
+      WriteRows(count, pool, out,
+                [&fields, pretty](size_t begin, size_t end, std::string* text) {
+                  AppendJsonRows(fields, pretty, begin, end, text);
+                });
+      if (pretty) *out << "\n  ";
+    }
+    *out << "]" << (last ? "" : ",") << (pretty ? "\n" : "");
+  };
+
+  *out << (pretty ? "{\n  \"simulation_duration\": "
+                  : "{\"simulation_duration\":")
+       << sim_time.count() << (pretty ? ",\n" : ",");
+  write_table("stations", metrics.num_stations(),
+              StationFields(metrics.stations()), false);
+  write_table("trucks", metrics.num_trucks(), TruckFields(metrics.trucks()),
+              true);
+  *out << "}\n";
+}
+
+void WriteCsv(const MetricsStore& metrics, WorkStealingPool* pool,
+              std::ofstream* out) {
+  const std::vector<Field> trucks = TruckFields(metrics.trucks());
+  const std::vector<Field> stations = StationFields(metrics.stations());
+
+  // The id, the truck fields, then the fields only stations have
+  std::vector<std::string> names = {"id"};
+  for (const auto& fields : {trucks, stations}) {
+    for (const Field& field : fields) {
+      if (std::find(names.begin(), names.end(), field.name) == names.end()) {
+        names.push_back(field.name);
+      }
+    }
+  }
+  const auto layout = [&names](const std::vector<Field>& fields) {
+    std::vector<const Field*> columns;
+    for (const std::string& name : names) {
+      const auto it =
+          std::find_if(fields.begin(), fields.end(),
+                       [&name](const Field& f) { return name == f.name; });
+      columns.push_back(it != fields.end() ? &*it : nullptr);
+    }
+    return columns;
+  };
+  const std::vector<const Field*> truck_columns = layout(trucks);
+  const std::vector<const Field*> station_columns = layout(stations);
+
+  *out << "table";
+  for (const std::string& name : names) *out << "," << name;
+  *out << "\n";
+  WriteRows(metrics.num_trucks(), pool, out,
+            [&truck_columns](size_t begin, size_t end, std::string* text) {
+              AppendCsvRows("truck", truck_columns, begin, end, text);
+            });
+  WriteRows(metrics.num_stations(), pool, out,
+            [&station_columns](size_t begin, size_t end, std::string* text) {
+              AppendCsvRows("station", station_columns, begin, end, text);
+            });
+}
+
+// A column's type (see MetricsColumnDescriptor) and its values as bytes
+struct ColumnBytes {
+  uint32_t type;
+  std::span<const char> bytes;
+};
+
+template <typename T>
+std::span<const char> AsBytes(const std::vector<T>& column) {
+  return {reinterpret_cast<const char*>(column.data()),
+          column.size() * sizeof(T)};
+}
+
+ColumnBytes ColumnData(const Field& field) {
+  if (field.doubles != nullptr) return {1, AsBytes(*field.doubles)};
+  if (field.longs != nullptr) return {2, AsBytes(*field.longs)};
+  return {0, AsBytes(*field.ints)};
+}
+
+// The columns are written from the store as they are
+void WriteColumns(minutes_t sim_time, const MetricsStore& metrics,
+                  std::ofstream* out) {
+  std::vector<std::pair<uint32_t, Field>> columns;
+  for (const Field& field : TruckFields(metrics.trucks())) {
+    if (!field.is_id()) columns.emplace_back(0, field);
+  }
+  for (const Field& field : StationFields(metrics.stations())) {
+    if (!field.is_id()) columns.emplace_back(1, field);
+  }
+
+  MetricsColumnsHeader header{};
+  std::memcpy(header.magic, kMetricsColumnsMagic, sizeof(header.magic));
+  header.version = kMetricsColumnsVersion;
+  header.num_columns = static_cast<uint32_t>(columns.size());
+  header.num_trucks = metrics.num_trucks();
+  header.num_stations = metrics.num_stations();
+  header.sim_minutes = sim_time.count();
+  out->write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  uint64_t offset = sizeof(MetricsColumnsHeader) +
+                    columns.size() * sizeof(MetricsColumnDescriptor);
+  for (const auto& [table, field] : columns) {
+    MetricsColumnDescriptor descriptor{};
+    std::strncpy(descriptor.name, field.name, sizeof(descriptor.name) - 1);
+    descriptor.table = table;
+    descriptor.type = ColumnData(field).type;
+    descriptor.offset = offset;
+    out->write(reinterpret_cast<const char*>(&descriptor), sizeof(descriptor));
+    offset += ColumnData(field).bytes.size();
+  }
+  for (const auto& [table, field] : columns) {
+    const std::span<const char> bytes = ColumnData(field).bytes;
+    out->write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  }
+}
+}  // namespace
+
+MetricsFormat MetricsFormatFromString(const std::string& name) {
+  if (name == "json") return MetricsFormat::Json;
+  if (name == "compact") return MetricsFormat::CompactJson;
+  if (name == "csv") return MetricsFormat::Csv;
+  if (name == "columnar") return MetricsFormat::Columnar;
+  Logger::LogAndThrowError<std::invalid_argument>(
+      "Unknown metrics format: " + name);
+  return MetricsFormat::Json;
+}
+
+std::string DefaultMetricsPath(size_t num_trucks, size_t num_stations,
+                               minutes_t sim_time, MetricsFormat format) {
+  std::ostringstream os;
+  os << "metrics." << num_trucks << "truck_" << num_stations << "station_"
+     << sim_time << "_minutes.";
+  switch (format) {
+    case MetricsFormat::Json:
+    case MetricsFormat::CompactJson:
+      os << "json";
+      break;
+    case MetricsFormat::Csv:
+      os << "csv";
+      break;
+    case MetricsFormat::Columnar:
+      os << "bin";
+      break;
+  }
+  return os.str();
+}
+
+std::string WriteMetricsReport(minutes_t sim_time, const MetricsStore& metrics,
+                               const MetricsExportOptions& options) {
+  const std::string path =
+      options.path.empty()
+          ? DefaultMetricsPath(metrics.num_trucks(), metrics.num_stations(),
+                               sim_time, options.format)
+          : options.path;
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open metrics report for writing: " +
+                             path);
+  }
+
+  // Small reports are not worth starting threads for
+  constexpr size_t kMinParallelRows = 1 << 15;
+  std::optional<WorkStealingPool> pool;
+  if (options.format != MetricsFormat::Columnar && options.num_threads != 1 &&
+      metrics.num_trucks() + metrics.num_stations() >= kMinParallelRows) {
+    pool.emplace(options.num_threads);
+  }
+  WorkStealingPool* formatters = pool.has_value() ? &*pool : nullptr;
+
+  switch (options.format) {
+    case MetricsFormat::Json:
+    case MetricsFormat::CompactJson:
+      WriteJson(sim_time, metrics, options.format == MetricsFormat::Json,
+                formatters, &out);
+      break;
+    case MetricsFormat::Csv:
+      WriteCsv(metrics, formatters, &out);
+      break;
+    case MetricsFormat::Columnar:
+      WriteColumns(sim_time, metrics, &out);
+      break;
+  }
+  out.flush();
+  if (!out) {
+    Logger::LogAndThrowError("Unable to write metrics report: " + path);
+  }
+  return path;
+}
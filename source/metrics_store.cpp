@@ -0,0 +1,206 @@
+#include "metrics_store.h"
+
+#include <utility>
+
+namespace {
+// Sets v to n zeros, keeping its capacity
+template <typename T>
+void Zero(std::vector<T>* v, size_t n) {
+  v->assign(n, T{});
+}
+
+// Mean wait (or trip time) per completion, 0 with no completions. The
+// masking instead of a branch keeps the loops that call it vectorizable.
+template <typename Total>
+inline double PerCompletion(Total total, int32_t count) {
+  const int32_t any = count != 0;
+  return static_cast<double>(total * any) /
+         static_cast<double>(count + 1 - any);
+}
+
+// Number of independent accumulators in the column sums
+constexpr size_t kLanes = 8;
+}  // namespace
+
+void MetricsStore::Reset(size_t num_trucks, size_t num_stations) {
+  Zero(&trucks_.mining_time, num_trucks);
+  Zero(&trucks_.travel_time, num_trucks);
+  Zero(&trucks_.queueing_time, num_trucks);
+  Zero(&trucks_.unloading_time, num_trucks);
+  Zero(&trucks_.trips_completed, num_trucks);
+  Zero(&trucks_.mines_completed, num_trucks);
+  Zero(&trucks_.queues_completed, num_trucks);
+  Zero(&trucks_.idle_time, num_trucks);
+  Zero(&trucks_.utilization, num_trucks);
+  Zero(&trucks_.avg_trip_time, num_trucks);
+  Zero(&trucks_.avg_queueing_time, num_trucks);
+
+  Zero(&stations_.unloading_time, num_stations);
+  Zero(&stations_.queueing_time, num_stations);
+  Zero(&stations_.throughput, num_stations);
+  Zero(&stations_.queues_completed, num_stations);
+  Zero(&stations_.idle_time, num_stations);
+  Zero(&stations_.utilization, num_stations);
+  Zero(&stations_.avg_queueing_time, num_stations);
+}
+
+// Same formulas as GenerateMetrics, one column at a time
+void MetricsStore::Derive(minutes_t sim_time) {
+  const auto sim = static_cast<int32_t>(sim_time.count());
+  const auto sim_d = static_cast<double>(sim);
+
+  const size_t n = num_trucks();
+  const int32_t* mining = trucks_.mining_time.data();
+  const int32_t* travel = trucks_.travel_time.data();
+  const int32_t* unloading = trucks_.unloading_time.data();
+  const int32_t* trips = trucks_.trips_completed.data();
+  const int32_t* queueing = trucks_.queueing_time.data();
+  const int32_t* queues = trucks_.queues_completed.data();
+  int32_t* idle = trucks_.idle_time.data();
+  double* utilization = trucks_.utilization.data();
+  double* avg_trip = trucks_.avg_trip_time.data();
+  double* avg_queueing = trucks_.avg_queueing_time.data();
+  for (size_t i = 0; i < n; ++i) {
+    const int32_t busy = mining[i] + unloading[i] + travel[i];
+    idle[i] = sim - busy;
+    avg_trip[i] = PerCompletion(busy, trips[i]);
+    avg_queueing[i] = PerCompletion(queueing[i], queues[i]);
+    utilization[i] = static_cast<double>(busy) / sim_d * 100.0;
+  }
+
+  const size_t m = num_stations();
+  const int64_t sim_64 = sim;
+  const int64_t* station_unloading = stations_.unloading_time.data();
+  const int64_t* station_queueing = stations_.queueing_time.data();
+  const int32_t* station_queues = stations_.queues_completed.data();
+  int64_t* station_idle = stations_.idle_time.data();
+  double* station_utilization = stations_.utilization.data();
+  double* station_avg_queueing = stations_.avg_queueing_time.data();
+  for (size_t i = 0; i < m; ++i) {
+    station_avg_queueing[i] =
+        PerCompletion(station_queueing[i], station_queues[i]);
+    station_idle[i] = sim_64 - station_unloading[i];
+    station_utilization[i] =
+        static_cast<double>(station_unloading[i]) / sim_d * 100.0;
+  }
+}
+
+double MetricsStore::AverageTruckUtilization() const {
+  if (num_trucks() == 0) return 0.0;
+  return SumColumn(trucks_.utilization) / static_cast<double>(num_trucks());
+}
+
+double MetricsStore::AverageStationUtilization() const {
+  if (num_stations() == 0) return 0.0;
+  return SumColumn(stations_.utilization) /
+         static_cast<double>(num_stations());
+}
+
+void MetricsStore::ToMetrics(std::vector<TruckMetrics>* trucks,
+                             std::vector<StationMetrics>* stations) const {
+  trucks->resize(num_trucks());
+  for (size_t i = 0; i < num_trucks(); ++i) {
+    TruckMetrics& t = (*trucks)[i];
+    t.utilization = trucks_.utilization[i];
+    t.trips_completed = trucks_.trips_completed[i];
+    t.mines_completed = trucks_.mines_completed[i];
+    t.queues_completed = trucks_.queues_completed[i];
+    t.idle_time = minutes_t(trucks_.idle_time[i]);
+    t.mining_time = minutes_t(trucks_.mining_time[i]);
+    t.queueing_time = minutes_t(trucks_.queueing_time[i]);
+    t.unloading_time = minutes_t(trucks_.unloading_time[i]);
+    t.travel_time = minutes_t(trucks_.travel_time[i]);
+    t.avg_trip_time = trucks_.avg_trip_time[i];
+    t.avg_queueing_time = trucks_.avg_queueing_time[i];
+  }
+
+  stations->resize(num_stations());
+  for (size_t i = 0; i < num_stations(); ++i) {
+    StationMetrics& s = (*stations)[i];
+    s.utilization = stations_.utilization[i];
+    s.throughput = stations_.throughput[i];
+    s.queues_completed = stations_.queues_completed[i];
+    s.idle_time = minutes_t(stations_.idle_time[i]);
+    s.unloading_time = minutes_t(stations_.unloading_time[i]);
+    s.queueing_time = minutes_t(stations_.queueing_time[i]);
+    s.avg_queueing_time = stations_.avg_queueing_time[i];
+  }
+}
+
+MetricsStore MetricsStore::FromMetrics(
+    const std::vector<TruckMetrics>& trucks,
+    const std::vector<StationMetrics>& stations) {
+  MetricsStore store;
+  store.Reset(trucks.size(), stations.size());
+  TruckColumns& tc = store.trucks_;
+  for (size_t i = 0; i < trucks.size(); ++i) {
+    const TruckMetrics& t = trucks[i];
+    tc.mining_time[i] = static_cast<int32_t>(t.mining_time.count());
+    tc.travel_time[i] = static_cast<int32_t>(t.travel_time.count());
+    tc.queueing_time[i] = static_cast<int32_t>(t.queueing_time.count());
+    tc.unloading_time[i] = static_cast<int32_t>(t.unloading_time.count());
+    tc.trips_completed[i] = static_cast<int32_t>(t.trips_completed);
+    tc.mines_completed[i] = static_cast<int32_t>(t.mines_completed);
+    tc.queues_completed[i] = static_cast<int32_t>(t.queues_completed);
+    tc.idle_time[i] = static_cast<int32_t>(t.idle_time.count());
+    tc.utilization[i] = t.utilization;
+    tc.avg_trip_time[i] = t.avg_trip_time;
+    tc.avg_queueing_time[i] = t.avg_queueing_time;
+  }
+
+  StationColumns& sc = store.stations_;
+  for (size_t i = 0; i < stations.size(); ++i) {
+    const StationMetrics& s = stations[i];
+    sc.unloading_time[i] = s.unloading_time.count();
+    sc.queueing_time[i] = s.queueing_time.count();
+    sc.throughput[i] = static_cast<int32_t>(s.throughput);
+    sc.queues_completed[i] = static_cast<int32_t>(s.queues_completed);
+    sc.idle_time[i] = s.idle_time.count();
+    sc.utilization[i] = s.utilization;
+    sc.avg_queueing_time[i] = s.avg_queueing_time;
+  }
+  return store;
+}
+
+MetricsStore MetricsStore::FromColumns(TruckColumns trucks,
+                                       StationColumns stations) {
+  MetricsStore store;
+  store.trucks_ = std::move(trucks);
+  store.stations_ = std::move(stations);
+  const size_t n = store.num_trucks();
+  Zero(&store.trucks_.idle_time, n);
+  Zero(&store.trucks_.utilization, n);
+  Zero(&store.trucks_.avg_trip_time, n);
+  Zero(&store.trucks_.avg_queueing_time, n);
+  const size_t m = store.num_stations();
+  Zero(&store.stations_.idle_time, m);
+  Zero(&store.stations_.utilization, m);
+  Zero(&store.stations_.avg_queueing_time, m);
+  return store;
+}
+
+int64_t SumColumn(const std::vector<int32_t>& column) {
+  int64_t sum = 0;
+  for (const int32_t value : column) sum += value;
+  return sum;
+}
+
+// Floating-point addition is not associative, so a single running sum would
+// have to be evaluated in order; kLanes interleaved partial sums can be
+// added element-wise instead.
+double SumColumn(const std::vector<double>& column) {
+  double lanes[kLanes] = {};
+  const size_t n = column.size();
+  const double* values = column.data();
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      lanes[lane] += values[i + lane];
+    }
+  }
+  for (; i < n; ++i) lanes[0] += values[i];
+
+  double sum = 0.0;
+  for (const double lane : lanes) sum += lane;
+  return sum;
+}
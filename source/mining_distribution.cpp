@@ -0,0 +1,293 @@
+#include "mining_distribution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+#include "logger.h"
+
+namespace {
+// Largest range (and so alias table) accepted, in minutes
+constexpr uint32_t kMaxRange = 1 << 20;
+
+void CheckRange(minutes_t min, minutes_t max, const std::string& what) {
+  if (min < 1min || max < min || (max - min).count() >= kMaxRange) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Invalid mining duration range for " + what + ": " +
+        std::to_string(min.count()) + " to " + std::to_string(max.count()));
+  }
+}
+
+// Weight of each minute of [min, max] under a continuous CDF: the mass that
+// rounds to it
+std::vector<double> RoundedWeights(minutes_t min, minutes_t max,
+                                   const std::function<double(double)>& cdf) {
+  std::vector<double> weights;
+  for (auto minute = min.count(); minute <= max.count(); ++minute) {
+    weights.push_back(cdf(minute + 0.5) - cdf(minute - 0.5));
+  }
+  return weights;
+}
+
+double ParseNumber(const std::string& text, const std::string& spec) {
+  size_t pos = 0;
+  double value = 0.0;
+  try {
+    value = std::stod(text, &pos);
+  } catch (const std::exception&) {
+    pos = 0;
+  }
+  if (text.empty() || pos != text.size() || !std::isfinite(value)) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Invalid mining distribution: " + spec);
+  }
+  return value;
+}
+
+minutes_t ParseMinutes(const std::string& text, const std::string& spec) {
+  const double value = ParseNumber(text, spec);
+  if (value != std::floor(value) || value < 0 || value > kMaxRange) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Invalid mining distribution: " + spec);
+  }
+  return minutes_t(static_cast<int64_t>(value));
+}
+
+std::string FormatNumber(double value) {
+  std::ostringstream out;
+  out << value;
+  return out.str();
+}
+}  // namespace
+
+MiningDistribution MiningDistribution::Uniform(minutes_t min, minutes_t max) {
+  CheckRange(min, max, "uniform");
+  return MiningDistribution(Kind::Uniform, static_cast<uint32_t>(min.count()),
+                            static_cast<uint32_t>(max.count()));
+}
+
+MiningDistribution MiningDistribution::Triangular(minutes_t min,
+                                                  minutes_t mode,
+                                                  minutes_t max) {
+  CheckRange(min, max, "triangular");
+  if (mode < min || mode > max) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Triangular mode outside the range: " + std::to_string(mode.count()));
+  }
+  MiningDistribution distribution(Kind::Triangular,
+                                  static_cast<uint32_t>(min.count()),
+                                  static_cast<uint32_t>(max.count()));
+  // Over [min - 0.5, max + 0.5], so that every minute of the range can come
+  // up, min and max included
+  const double low = min.count() - 0.5;
+  const double high = max.count() + 0.5;
+  const double peak = static_cast<double>(mode.count());
+  distribution.BuildAliasTable(
+      RoundedWeights(min, max, [low, high, peak](double x) {
+        if (x <= low) return 0.0;
+        if (x >= high) return 1.0;
+        if (x <= peak) {
+          return (x - low) * (x - low) / ((high - low) * (peak - low));
+        }
+        return 1.0 - (high - x) * (high - x) / ((high - low) * (high - peak));
+      }));
+  distribution.parameters_ = std::to_string(mode.count()) + ":" +
+                             std::to_string(min.count()) + ":" +
+                             std::to_string(max.count());
+  return distribution;
+}
+
+MiningDistribution MiningDistribution::Lognormal(double median, double sigma,
+                                                 minutes_t min,
+                                                 minutes_t max) {
+  CheckRange(min, max, "lognormal");
+  if (!(median > 0.0) || !(sigma > 0.0)) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Lognormal median and sigma must be positive");
+  }
+  MiningDistribution distribution(Kind::Lognormal,
+                                  static_cast<uint32_t>(min.count()),
+                                  static_cast<uint32_t>(max.count()));
+  const double mu = std::log(median);
+  distribution.BuildAliasTable(
+      RoundedWeights(min, max, [mu, sigma](double x) {
+        if (x <= 0.0) return 0.0;
+        return 0.5 * std::erfc(-(std::log(x) - mu) / (sigma * std::sqrt(2.0)));
+      }));
+  distribution.parameters_ = FormatNumber(median) + ":" + FormatNumber(sigma) +
+                             ":" + std::to_string(min.count()) + ":" +
+                             std::to_string(max.count());
+  return distribution;
+}
+
+MiningDistribution MiningDistribution::Empirical(const std::vector<Bin>& bins) {
+  if (bins.empty()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Empirical mining distribution without bins");
+  }
+  minutes_t min = bins.front().from;
+  minutes_t max = bins.front().to;
+  for (const Bin& bin : bins) {
+    if (bin.to < bin.from || !(bin.weight >= 0.0) ||
+        !std::isfinite(bin.weight)) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Invalid histogram bin: " + std::to_string(bin.from.count()) +
+          " to " + std::to_string(bin.to.count()));
+    }
+    min = std::min(min, bin.from);
+    max = std::max(max, bin.to);
+  }
+  CheckRange(min, max, "empirical");
+
+  std::vector<double> weights((max - min).count() + 1, 0.0);
+  for (const Bin& bin : bins) {
+    const double share = bin.weight / ((bin.to - bin.from).count() + 1);
+    for (auto minute = bin.from; minute <= bin.to; ++minute) {
+      weights[(minute - min).count()] += share;
+    }
+  }
+  MiningDistribution distribution(Kind::Empirical,
+                                  static_cast<uint32_t>(min.count()),
+                                  static_cast<uint32_t>(max.count()));
+  distribution.BuildAliasTable(weights);
+  return distribution;
+}
+
+MiningDistribution MiningDistribution::FromHistogramFile(
+    const std::string& filename) {
+  std::ifstream in(filename);
+  if (!in.is_open()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Unable to open histogram: " + filename);
+  }
+  std::vector<Bin> bins;
+  std::string line;
+  for (size_t line_number = 1; std::getline(in, line); ++line_number) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::vector<std::string> values;
+    for (std::string value; fields >> value;) values.push_back(value);
+    if (values.empty()) continue;
+    const std::string where = filename + ":" + std::to_string(line_number);
+    if (values.size() == 2) {
+      const minutes_t minute = ParseMinutes(values[0], where);
+      bins.push_back({minute, minute, ParseNumber(values[1], where)});
+    } else if (values.size() == 3) {
+      bins.push_back({ParseMinutes(values[0], where),
+                      ParseMinutes(values[1], where),
+                      ParseNumber(values[2], where)});
+    } else {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Invalid histogram bin at " + where);
+    }
+  }
+  MiningDistribution distribution = Empirical(bins);
+  distribution.parameters_ = filename;
+  return distribution;
+}
+
+MiningDistribution MiningDistribution::Parse(const std::string& spec,
+                                             minutes_t min, minutes_t max) {
+  const size_t colon = spec.find(':');
+  const std::string kind = spec.substr(0, colon);
+  const std::string rest =
+      colon == std::string::npos ? "" : spec.substr(colon + 1);
+  if (kind == "empirical") {
+    if (rest.empty()) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Invalid mining distribution: " + spec);
+    }
+    return FromHistogramFile(rest);
+  }
+
+  std::vector<std::string> parts;
+  std::istringstream fields(rest);
+  for (std::string field; std::getline(fields, field, ':');) {
+    parts.push_back(field);
+  }
+  if (colon != std::string::npos && parts.empty()) parts.push_back("");
+
+  // The shape parameters, then optionally the range
+  const size_t shape = kind == "uniform"      ? 0
+                       : kind == "triangular" ? 1
+                       : kind == "lognormal"  ? 2
+                                              : SIZE_MAX;
+  if (shape == SIZE_MAX ||
+      (parts.size() != shape && parts.size() != shape + 2)) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Invalid mining distribution: " + spec);
+  }
+  if (parts.size() == shape + 2) {
+    min = ParseMinutes(parts[shape], spec);
+    max = ParseMinutes(parts[shape + 1], spec);
+  }
+  if (kind == "uniform") return Uniform(min, max);
+  if (kind == "triangular") {
+    return Triangular(min, ParseMinutes(parts[0], spec), max);
+  }
+  return Lognormal(ParseNumber(parts[0], spec), ParseNumber(parts[1], spec),
+                   min, max);
+}
+
+std::vector<double> MiningDistribution::Probabilities() const {
+  if (kind_ != Kind::Uniform) return probabilities_;
+  return std::vector<double>(max_ - min_ + 1, 1.0 / (max_ - min_ + 1));
+}
+
+std::string MiningDistribution::Describe() const {
+  switch (kind_) {
+    case Kind::Uniform:
+      return "uniform:" + std::to_string(min_) + ":" + std::to_string(max_);
+    case Kind::Triangular:
+      return "triangular:" + parameters_;
+    case Kind::Lognormal:
+      return "lognormal:" + parameters_;
+    case Kind::Empirical:
+      return parameters_.empty() ? "empirical" : "empirical:" + parameters_;
+  }
+  return "";
+}
+
+// Vose's construction: columns with less than the average weight are topped
+// up from one with more, which becomes their alias
+void MiningDistribution::BuildAliasTable(const std::vector<double>& weights) {
+  double total = 0.0;
+  for (const double weight : weights) total += weight;
+  if (!(total > 0.0) || !std::isfinite(total)) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Mining distribution has no weight in " + std::to_string(min_) +
+        " to " + std::to_string(max_));
+  }
+
+  const size_t n = weights.size();
+  probabilities_.resize(n);
+  std::vector<double> scaled(n);
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (size_t i = 0; i < n; ++i) {
+    probabilities_[i] = weights[i] / total;
+    scaled[i] = probabilities_[i] * n;
+    (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+  }
+
+  constexpr double kCoinRange = 4294967296.0;  // 2^32
+  columns_.assign(n, {uint64_t{1} << 32, 0});
+  while (!small.empty() && !large.empty()) {
+    const uint32_t less = small.back();
+    small.pop_back();
+    const uint32_t more = large.back();
+    columns_[less] = {static_cast<uint64_t>(scaled[less] * kCoinRange), more};
+    scaled[more] -= 1.0 - scaled[less];
+    if (scaled[more] < 1.0) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+  // What is left is 1 up to rounding, and keeps its own minute
+  for (const uint32_t i : small) columns_[i] = {uint64_t{1} << 32, i};
+  for (const uint32_t i : large) columns_[i] = {uint64_t{1} << 32, i};
+}
@@ -0,0 +1,428 @@
+#include "parallel_controller.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "logger.h"
+
+// A contiguous range of group_size_ trucks and everything a worker needs to
+// advance them without touching other groups
+struct ParallelController::Group {
+  explicit Group(minutes_t horizon) : events(horizon) {}
+
+  TimingWheelScheduler events;
+  TimeSeries time_series;  // Truck activity only
+
+  // Set aside in step 1, by minute of the epoch; each in sequence order
+  std::array<std::vector<Request>, kEpochMinutes> arrivals;
+  std::array<std::vector<Request>, kEpochMinutes> returns;
+
+  // Handed back by step 3, in the order they were decided
+  std::vector<MiningStart> mining_starts;
+  std::vector<UnloadStart> unload_starts;
+
+  // Event counts and time-limit traces; summed into the run's stats
+  EngineStats stats;
+};
+
+namespace {
+// Copies runs that are each in sequence order to out, one after the other,
+// and merges them into a single run in sequence order
+template <typename Request>
+void MergeRuns(const std::vector<const std::vector<Request>*>& runs,
+               Request* out) {
+  std::vector<Request*> bounds = {out};
+  for (const auto* run : runs) {
+    bounds.push_back(std::copy(run->begin(), run->end(), bounds.back()));
+  }
+  const auto by_sequence = [](const Request& lhs, const Request& rhs) {
+    return lhs.sequence < rhs.sequence;
+  };
+
+  // Bottom up: merge neighbouring runs until one is left
+  while (bounds.size() > 2) {
+    std::vector<Request*> merged = {bounds[0]};
+    for (size_t i = 2; i < bounds.size(); i += 2) {
+      std::inplace_merge(bounds[i - 2], bounds[i - 1], bounds[i], by_sequence);
+      merged.push_back(bounds[i]);
+    }
+    if (bounds.size() % 2 == 0) merged.push_back(bounds.back());
+    bounds = std::move(merged);
+  }
+}
+}  // namespace
+
+ParallelController::ParallelController(size_t num_trucks,
+                                       size_t num_stations,
+                                       size_t random_seed,
+                                       size_t num_threads)
+    : num_trucks_(num_trucks),
+      num_stations_(num_stations),
+      random_seed_(random_seed),
+      rng_(random_seed),
+      pool_(num_threads) {
+  const size_t num_groups = std::max<size_t>(
+      1, std::min(pool_.num_threads(), num_trucks_));
+  group_size_ = std::max<size_t>(1, (num_trucks_ + num_groups - 1) /
+                                        num_groups);
+  for (size_t first = 0; first < num_trucks_ || groups_.empty();
+       first += group_size_) {
+    groups_.push_back(std::make_unique<Group>(Timing::kMaxDuration));
+  }
+}
+
+ParallelController::~ParallelController() = default;
+
+void ParallelController::SetMiningDistribution(
+    MiningDistribution distribution) {
+  if (distribution.min() < kEpoch) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "The parallel engine needs mining durations of at least " +
+        std::to_string(kEpoch.count()) + " minutes, not " +
+        distribution.Describe());
+  }
+  mining_distribution_ = std::move(distribution);
+}
+
+void ParallelController::Run(minutes_t sim_time) {
+  Simulate(sim_time);
+  if (num_trucks_ == 0 || num_stations_ == 0) return;
+  StatsTimer timer;
+  ExportMetrics(sim_time, metrics_, metrics_export_);
+  if (time_series_.enabled()) {
+    std::cout << "Time series report: "
+              << ExportTimeSeriesToJson(num_trucks_, time_series_) << "\n";
+  }
+  if constexpr (kStatsEnabled) stats_.export_ms = timer.Lap();
+}
+
+void ParallelController::Simulate(minutes_t sim_time) {
+  if (num_trucks_ == 0 || num_stations_ == 0) {
+    Logger::LogError("No trucks or stations.");
+    return;
+  }
+
+  if (num_trucks_ > size_t{PackedEvent::kMaxTruckId} + 1) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Too many trucks: at most " +
+        std::to_string(size_t{PackedEvent::kMaxTruckId} + 1) + " supported");
+  }
+  if (sim_time > MetricsStore::kMaxSimTime) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Simulation time too long: at most " +
+        std::to_string(MetricsStore::kMaxSimTime.count()) +
+        " minutes supported");
+  }
+
+  StatsTimer timer;
+  stats_ = {};
+  sim_duration_ = sim_time;
+  metrics_.Reset(num_trucks_, num_stations_);
+  station_queue_.Initialize(num_stations_);
+  time_series_.Reset(time_series_interval_, sim_time, num_stations_);
+  sequence_.assign(num_trucks_, 0);
+  next_draw_ = 0;
+  next_assignment_ = 0;
+  for (auto& group : groups_) {
+    group->events.Clear();
+    group->time_series.Reset(time_series_interval_, sim_time, 0);
+    for (auto& arrivals : group->arrivals) arrivals.clear();
+    for (auto& returns : group->returns) returns.clear();
+    group->mining_starts.clear();
+    group->unload_starts.clear();
+    group->stats = {};
+  }
+
+  // Dispatch all trucks to start mining, in truck order like the sequential
+  // engine; the groups start them in the first epoch
+  for (size_t i = 0; i < num_trucks_; ++i) {
+    GroupOf(i).mining_starts.push_back(
+        {static_cast<uint32_t>(i), 0, next_draw_++});
+  }
+
+  if constexpr (kStatsEnabled) {
+    waiting_trucks_.Clear();
+    stats_.setup_ms = timer.Lap();
+  }
+
+  // The epoch that starts after the end of the run only applies the last
+  // step 3; nothing is left to advance by then
+  for (minutes_t epoch = 0min;; epoch += kEpoch) {
+    for (auto& group : groups_) {
+      pool_.Submit([this, group = group.get(), epoch] {
+        AdvanceGroup(group, epoch + kEpoch);
+      });
+    }
+    pool_.Wait();
+    if constexpr (kStatsEnabled) {
+      size_t pending = 0;
+      for (const auto& group : groups_) pending += group->events.Size();
+      stats_.peak_pending_events =
+          std::max(stats_.peak_pending_events, pending);
+      ++stats_.epochs;
+    }
+    if (epoch > sim_time) break;
+
+    OrderRequests();
+    StatsTimer serial_timer;
+    AssignStations();
+    NumberReturns();
+    if constexpr (kStatsEnabled) stats_.serial_ms += serial_timer.Lap();
+  }
+
+  // Collect the groups' truck activity and counts
+  for (const auto& group : groups_) {
+    time_series_.AddTruckMinutes(group->time_series);
+    if constexpr (kStatsEnabled) {
+      for (size_t i = 0; i < kNumEventTypes; ++i) {
+        stats_.events_by_type[i] += group->stats.events_by_type[i];
+      }
+      stats_.events_processed += group->stats.events_processed;
+      stats_.random_draws += group->stats.random_draws;
+      stats_.trace_messages += group->stats.trace_messages;
+      stats_.trace_ms += group->stats.trace_ms;
+    }
+  }
+  if constexpr (kStatsEnabled) stats_.loop_ms = timer.Lap();
+
+  // Collect simulation metrics
+  metrics_.Derive(sim_time);
+  if constexpr (kStatsEnabled) stats_.metrics_ms = timer.Lap();
+}
+
+// Step 1. Outcomes of the serial step come first: the epoch they were
+// decided in has already been advanced, so unloads that finished during it
+// are completed on the spot.
+void ParallelController::AdvanceGroup(Group* group, minutes_t limit) {
+  const minutes_t epoch_start = limit - kEpoch;
+  for (const MiningStart& start : group->mining_starts) {
+    StartMining(group, start);
+  }
+  for (const UnloadStart& start : group->unload_starts) {
+    StartUnloading(group, start, epoch_start);
+  }
+  group->mining_starts.clear();
+  group->unload_starts.clear();
+  for (auto& arrivals : group->arrivals) arrivals.clear();
+  for (auto& returns : group->returns) returns.clear();
+
+  PackedEvent event;
+  while (group->events.PopBefore(limit, &event)) {
+    if constexpr (kStatsEnabled) ++group->stats.events_processed;
+    const auto time = event.end_time();
+    const auto truck_id = event.truck_id();
+    const auto minute = static_cast<size_t>((time - epoch_start).count());
+    switch (event.type()) {
+      case EventType::Mine: {
+        TravelToStation(group, truck_id, time);
+        break;
+      }
+      case EventType::TravelToStation: {
+        group->arrivals[minute].push_back({static_cast<uint32_t>(truck_id),
+                                   static_cast<uint32_t>(time.count()),
+                                   sequence_[truck_id]});
+        break;
+      }
+      case EventType::Unload: {
+        TravelToMine(group, truck_id, time);
+        break;
+      }
+      case EventType::TravelToMine: {
+        group->returns[minute].push_back({static_cast<uint32_t>(truck_id),
+                                  static_cast<uint32_t>(time.count()),
+                                  sequence_[truck_id]});
+        break;
+      }
+      default: {
+        Logger::LogError("Unrecognized event type!");
+        break;
+      }
+    }
+  }
+}
+
+// Step 2: each minute's requests are merged into arrivals_ and returns_ by a
+// task of their own
+void ParallelController::OrderRequests() {
+  std::array<size_t, kEpochMinutes + 1> arrival_offsets{};
+  std::array<size_t, kEpochMinutes + 1> return_offsets{};
+  for (size_t minute = 0; minute < kEpochMinutes; ++minute) {
+    arrival_offsets[minute + 1] = arrival_offsets[minute];
+    return_offsets[minute + 1] = return_offsets[minute];
+    for (const auto& group : groups_) {
+      arrival_offsets[minute + 1] += group->arrivals[minute].size();
+      return_offsets[minute + 1] += group->returns[minute].size();
+    }
+  }
+  arrivals_.resize(arrival_offsets.back());
+  returns_.resize(return_offsets.back());
+
+  for (size_t minute = 0; minute < kEpochMinutes; ++minute) {
+    pool_.Submit([this, minute,
+                  arrivals = arrivals_.data() + arrival_offsets[minute],
+                  returns = returns_.data() + return_offsets[minute]] {
+      std::vector<const std::vector<Request>*> runs;
+      for (const auto& group : groups_) {
+        runs.push_back(&group->arrivals[minute]);
+      }
+      MergeRuns(runs, arrivals);
+      runs.clear();
+      for (const auto& group : groups_) {
+        runs.push_back(&group->returns[minute]);
+      }
+      MergeRuns(runs, returns);
+    });
+  }
+  pool_.Wait();
+}
+
+// Step 3: the arrivals of the epoch take stations in sequential order
+void ParallelController::AssignStations() {
+  for (const Request& arrival : arrivals_) {
+    if (station_queue_.Empty()) {
+      Logger::LogTrace("Station queue is empty!");
+      continue;
+    }
+    const auto [available_time, station_id] =
+        station_queue_.PopNextAvailable();
+
+    // As in the sequential engine, the station is busy until the end of an
+    // unload that ends after the run, which is not recorded
+    const minutes_t arrival_time(arrival.time);
+    const auto start_time = std::max(arrival_time, available_time);
+    const auto end_time = start_time + Timing::kUnloadTime;
+    station_queue_.MarkAvailable(end_time, station_id);
+    if constexpr (kStatsEnabled) {
+      stats_.peak_queued_trucks =
+          std::max(stats_.peak_queued_trucks,
+                   waiting_trucks_.Arrive(arrival_time, available_time));
+    }
+    if (ExceedsSimTime(end_time, &stats_)) continue;
+
+    if (available_time > arrival_time) {
+      metrics_.AddStationQueueing(station_id, available_time - arrival_time);
+      time_series_.AddStationQueue(station_id, arrival_time, available_time);
+    }
+    metrics_.AddStationUnloading(station_id, Timing::kUnloadTime);
+    time_series_.AddStationBusy(station_id, start_time, end_time);
+
+    GroupOf(arrival.truck_id)
+        .unload_starts.push_back(
+            {arrival.truck_id, static_cast<uint32_t>(station_id),
+             arrival.time, static_cast<uint32_t>(start_time.count()),
+             next_assignment_++});
+  }
+}
+
+// Step 3: the returns of the epoch are numbered in sequential order
+void ParallelController::NumberReturns() {
+  for (const Request& mine_return : returns_) {
+    GroupOf(mine_return.truck_id)
+        .mining_starts.push_back(
+            {mine_return.truck_id, mine_return.time, next_draw_++});
+  }
+}
+
+void ParallelController::EmitEvent(Group* group, EventType type,
+                                   size_t truck_id, uint32_t station_id,
+                                   minutes_t start, minutes_t end) {
+  group->events.Push(PackedEvent(type, truck_id, station_id, start, end));
+  if constexpr (kStatsEnabled) {
+    ++group->stats.events_by_type[static_cast<size_t>(type)];
+  }
+}
+
+void ParallelController::StartMining(Group* group, const MiningStart& start) {
+  if constexpr (kStatsEnabled) ++group->stats.random_draws;
+  const minutes_t start_time(start.start_time);
+  // Indexed by mines started, like Controller::RandomMiningDuration
+  const auto cycle = static_cast<uint32_t>(
+      metrics_.trucks().mines_completed[start.truck_id]);
+  const minutes_t duration =
+      mining_distribution_.Sample(rng_, start.truck_id, cycle);
+  const auto end_time = start_time + duration;
+  if (!ExceedsSimTime(end_time, &group->stats)) {
+    sequence_[start.truck_id] = start.draw;
+    EmitEvent(group, EventType::Mine, start.truck_id, PackedEvent::kNoStation,
+              start_time, end_time);
+    metrics_.AddMining(start.truck_id, duration);
+    group->time_series.AddTruckSpan(TruckState::Mining, start_time, end_time);
+  }
+}
+
+// The station side was recorded in step 3. Unloads that end before
+// epoch_start (which has been advanced past already) are completed here.
+void ParallelController::StartUnloading(Group* group, const UnloadStart& start,
+                                        minutes_t epoch_start) {
+  const size_t truck_id = start.truck_id;
+  const minutes_t arrival_time(start.arrival_time);
+  const minutes_t start_time(start.start_time);
+  const auto end_time = start_time + Timing::kUnloadTime;
+  if (start_time > arrival_time) {
+    if constexpr (kStatsEnabled) {
+      ++group->stats.events_by_type[static_cast<size_t>(EventType::Queue)];
+    }
+    metrics_.AddTruckQueueing(truck_id, start_time - arrival_time);
+    group->time_series.AddTruckSpan(TruckState::Queueing, arrival_time,
+                                    start_time);
+  }
+
+  sequence_[truck_id] = start.assignment;
+  metrics_.AddTruckUnloading(truck_id, Timing::kUnloadTime);
+  group->time_series.AddTruckSpan(TruckState::Unloading, start_time, end_time);
+  if (end_time >= epoch_start) {
+    EmitEvent(group, EventType::Unload, truck_id, start.station_id,
+              start_time, end_time);
+    return;
+  }
+
+  if constexpr (kStatsEnabled) {
+    ++group->stats.events_by_type[static_cast<size_t>(EventType::Unload)];
+    ++group->stats.events_processed;
+  }
+  TravelToMine(group, truck_id, end_time);
+}
+
+void ParallelController::TravelToStation(Group* group, size_t truck_id,
+                                         minutes_t start_time) {
+  const auto end_time = start_time + Timing::kTravelTime;
+  if (!ExceedsSimTime(end_time, &group->stats)) {
+    EmitEvent(group, EventType::TravelToStation, truck_id,
+              PackedEvent::kNoStation, start_time, end_time);
+    metrics_.AddTravel(truck_id, Timing::kTravelTime);
+    group->time_series.AddTruckSpan(TruckState::Traveling, start_time,
+                                    end_time);
+  }
+}
+
+void ParallelController::TravelToMine(Group* group, size_t truck_id,
+                                      minutes_t start_time) {
+  const auto end_time = start_time + Timing::kTravelTime;
+  if (!ExceedsSimTime(end_time, &group->stats)) {
+    EmitEvent(group, EventType::TravelToMine, truck_id,
+              PackedEvent::kNoStation, start_time, end_time);
+    metrics_.AddTravel(truck_id, Timing::kTravelTime);
+    group->time_series.AddTruckSpan(TruckState::Traveling, start_time,
+                                    end_time);
+  }
+}
+
+// Check if a time is beyond the simulation limit, and log if so
+bool ParallelController::ExceedsSimTime(minutes_t time,
+                                        EngineStats* stats) const {
+  if (time <= sim_duration_) return false;
+  if (!Logger::TraceEnabled()) return true;
+  StatsTimer timer;
+  Logger::LogTrace(
+      "[Time Limit Exceeded] Time: " + std::to_string(time.count()) +
+      ", Limit: " + std::to_string(sim_duration_.count()));
+  if constexpr (kStatsEnabled) {
+    ++stats->trace_messages;
+    stats->trace_ms += timer.Lap();
+  }
+  return true;
+}
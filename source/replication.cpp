@@ -0,0 +1,588 @@
+#include "replication.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "controller.h"
+#include "event.h"
+#include "event_sink.h"
+#include "logger.h"
+
+using json = nlohmann::json;
+
+namespace {
+// Two-sided 95% quantiles of Student's t distribution for 1..30 degrees of
+// freedom
+constexpr std::array<double, 30> kStudentT95 = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+double StudentT95(size_t degrees_of_freedom) {
+  if (degrees_of_freedom <= kStudentT95.size()) {
+    return kStudentT95[degrees_of_freedom - 1];
+  }
+  if (degrees_of_freedom <= 40) return 2.021;
+  if (degrees_of_freedom <= 60) return 2.000;
+  if (degrees_of_freedom <= 120) return 1.980;
+  return 1.960;
+}
+
+double Minutes(minutes_t time) { return static_cast<double>(time.count()); }
+
+json StatToJson(const RunningStat& stat) {
+  const double half_width = stat.HalfWidth();
+  return {{"mean", stat.mean()},
+          {"variance", stat.variance()},
+          {"ci95_half_width", std::isfinite(half_width) ? json(half_width)
+                                                        : json(nullptr)}};
+}
+
+// The statistics of each truck and station field, by report name
+template <typename Stats>
+using StatField = std::pair<const char*, RunningStat Stats::*>;
+
+constexpr std::array<StatField<TruckReplicationStats>, 11> kTruckFields = {{
+    {"utilization", &TruckReplicationStats::utilization},
+    {"idle_time", &TruckReplicationStats::idle_time},
+    {"trips_completed", &TruckReplicationStats::trips_completed},
+    {"mines_completed", &TruckReplicationStats::mines_completed},
+    {"queues_completed", &TruckReplicationStats::queues_completed},
+    {"mining_time", &TruckReplicationStats::mining_time},
+    {"queueing_time", &TruckReplicationStats::queueing_time},
+    {"unloading_time", &TruckReplicationStats::unloading_time},
+    {"travel_time", &TruckReplicationStats::travel_time},
+    {"avg_trip_time", &TruckReplicationStats::avg_trip_time},
+    {"avg_queueing_time", &TruckReplicationStats::avg_queueing_time},
+}};
+
+constexpr std::array<StatField<StationReplicationStats>, 7> kStationFields = {{
+    {"utilization", &StationReplicationStats::utilization},
+    {"idle_time", &StationReplicationStats::idle_time},
+    {"throughput", &StationReplicationStats::throughput},
+    {"queues_completed", &StationReplicationStats::queues_completed},
+    {"unloading_time", &StationReplicationStats::unloading_time},
+    {"queueing_time", &StationReplicationStats::queueing_time},
+    {"avg_queueing_time", &StationReplicationStats::avg_queueing_time},
+}};
+
+// The mergeable moments of a stat, for partial results
+json MomentsToJson(const RunningStat& stat) {
+  return {{"count", stat.count()}, {"mean", stat.mean()}, {"m2", stat.m2()}};
+}
+
+RunningStat MomentsFromJson(const json& j) {
+  return RunningStat::FromMoments(j.at("count").get<size_t>(),
+                                  j.at("mean").get<double>(),
+                                  j.at("m2").get<double>());
+}
+
+json HistogramToJson(const Histogram& histogram) {
+  return {{"min", histogram.min()},
+          {"max", histogram.max()},
+          {"counts", histogram.counts()}};
+}
+
+Histogram HistogramFromJson(const json& j) {
+  return Histogram(j.at("min").get<double>(), j.at("max").get<double>(),
+                   j.at("counts").get<std::vector<uint64_t>>());
+}
+
+// Per-object stats as one object per field holding a mean and an m2 array
+// (every stat has counted the same replications)
+template <typename Stats, size_t N>
+json ColumnsToJson(const std::vector<Stats>& objects,
+                   const std::array<StatField<Stats>, N>& fields) {
+  json columns = json::object();
+  std::vector<double> means(objects.size());
+  std::vector<double> m2s(objects.size());
+  for (const auto& [name, field] : fields) {
+    for (size_t i = 0; i < objects.size(); ++i) {
+      means[i] = (objects[i].*field).mean();
+      m2s[i] = (objects[i].*field).m2();
+    }
+    columns[name] = {{"mean", means}, {"m2", m2s}};
+  }
+  return columns;
+}
+
+template <typename Stats, size_t N>
+std::vector<Stats> ColumnsFromJson(const json& columns, size_t count,
+                                   size_t num_objects,
+                                   const std::array<StatField<Stats>, N>& fields) {
+  std::vector<Stats> objects(num_objects);
+  for (const auto& [name, field] : fields) {
+    const json& column = columns.at(name);
+    const auto means = column.at("mean").get<std::vector<double>>();
+    const auto m2s = column.at("m2").get<std::vector<double>>();
+    if (means.size() != num_objects || m2s.size() != num_objects) {
+      throw std::runtime_error(std::string("Wrong length of ") + name);
+    }
+    for (size_t i = 0; i < num_objects; ++i) {
+      objects[i].*field = RunningStat::FromMoments(count, means[i], m2s[i]);
+    }
+  }
+  return objects;
+}
+
+// replications.<trucks>truck_<stations>station_<minutes>_minutes, the
+// name of the report without its extension
+std::string ReportStem(const ReplicationOptions& options) {
+  std::ostringstream os;
+  os << "replications." << options.num_trucks << "truck_"
+     << options.num_stations << "station_" << options.sim_time
+     << "_minutes";
+  return os.str();
+}
+
+// Metrics of one replication, handed from a worker to the aggregating thread.
+// The worker fills in the results, then sets ready.
+struct ReplicationSlot {
+  std::atomic<bool> ready{false};
+  std::exception_ptr error;
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+};
+}  // namespace
+
+void RunningStat::Add(double value) {
+  ++count_;
+  const double delta = value - mean_;
+  mean_ += delta / static_cast<double>(count_);
+  m2_ += delta * (value - mean_);
+}
+
+double RunningStat::variance() const {
+  return count_ > 1 ? m2_ / static_cast<double>(count_ - 1) : 0.0;
+}
+
+double RunningStat::HalfWidth() const {
+  if (count_ < 2) return std::numeric_limits<double>::infinity();
+  return StudentT95(count_ - 1) *
+         std::sqrt(variance() / static_cast<double>(count_));
+}
+
+RunningStat RunningStat::FromMoments(size_t count, double mean, double m2) {
+  RunningStat stat;
+  stat.count_ = count;
+  stat.mean_ = count > 0 ? mean : 0.0;
+  stat.m2_ = count > 1 ? m2 : 0.0;
+  return stat;
+}
+
+void RunningStat::Merge(const RunningStat& other) {
+  if (other.count_ == 0) return;
+  if (count_ == 0) {
+    *this = other;
+    return;
+  }
+  const double n = static_cast<double>(count_);
+  const double m = static_cast<double>(other.count_);
+  const double delta = other.mean_ - mean_;
+  count_ += other.count_;
+  mean_ += delta * m / (n + m);
+  m2_ += other.m2_ + delta * delta * n * m / (n + m);
+}
+
+Histogram::Histogram(double min, double max, size_t num_bins)
+    : Histogram(min, max, std::vector<uint64_t>(num_bins)) {}
+
+Histogram::Histogram(double min, double max, std::vector<uint64_t> counts)
+    : min_(min), max_(max), counts_(std::move(counts)) {
+  if (!(max > min) || counts_.empty()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "A histogram needs max > min and at least one bin");
+  }
+}
+
+void Histogram::Add(double value) {
+  const double bins = static_cast<double>(counts_.size());
+  const double bin = std::floor((value - min_) / (max_ - min_) * bins);
+  ++counts_[static_cast<size_t>(std::clamp(bin, 0.0, bins - 1.0))];
+}
+
+void Histogram::Merge(const Histogram& other) {
+  if (other.min_ != min_ || other.max_ != max_ ||
+      other.counts_.size() != counts_.size()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Cannot merge histograms with different bins");
+  }
+  for (size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+}
+
+void TruckReplicationStats::Add(const TruckMetrics& m) {
+  utilization.Add(m.utilization);
+  trips_completed.Add(static_cast<double>(m.trips_completed));
+  mines_completed.Add(static_cast<double>(m.mines_completed));
+  queues_completed.Add(static_cast<double>(m.queues_completed));
+  idle_time.Add(Minutes(m.idle_time));
+  mining_time.Add(Minutes(m.mining_time));
+  queueing_time.Add(Minutes(m.queueing_time));
+  unloading_time.Add(Minutes(m.unloading_time));
+  travel_time.Add(Minutes(m.travel_time));
+  avg_trip_time.Add(m.avg_trip_time);
+  avg_queueing_time.Add(m.avg_queueing_time);
+}
+
+void StationReplicationStats::Add(const StationMetrics& m) {
+  utilization.Add(m.utilization);
+  throughput.Add(static_cast<double>(m.throughput));
+  queues_completed.Add(static_cast<double>(m.queues_completed));
+  idle_time.Add(Minutes(m.idle_time));
+  unloading_time.Add(Minutes(m.unloading_time));
+  queueing_time.Add(Minutes(m.queueing_time));
+  avg_queueing_time.Add(m.avg_queueing_time);
+}
+
+uint64_t ReplicationSeed(uint64_t base_seed, size_t replication) {
+  uint64_t z = base_seed + replication + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// Workers claim replication indices from a shared counter and publish their
+// metrics into per-index slots. This thread folds the slots in index order
+// and raises the stop flag once the stopping rule is met; workers finish the
+// replication they are on and exit, and results past the stopping point are
+// discarded.
+ReplicationResult RunReplications(const ReplicationOptions& options) {
+  if (options.num_trucks == 0 || options.num_stations == 0) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Replications need at least one truck and one station.");
+  }
+  if (options.max_replications == 0) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "max_replications must be at least 1.");
+  }
+  const ShardSpec& shard = options.shard;
+  if (shard.count == 0 || shard.index >= shard.count ||
+      shard.NumItems(options.max_replications) == 0) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Shard " + shard.Suffix() + " has no replications of " +
+        std::to_string(options.max_replications));
+  }
+  if (shard.sharded() && options.target_half_width > 0.0) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Early stopping needs every replication; shards run a fixed number");
+  }
+  // Replications of the shard; the j-th has index index + j * count
+  const size_t num_replications = shard.NumItems(options.max_replications);
+
+  size_t num_threads = options.num_threads;
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, num_replications);
+
+  std::vector<ReplicationSlot> slots(num_replications);
+  std::atomic<size_t> next_replication{0};
+  std::atomic<bool> stop{false};
+
+  auto worker = [&] {
+    EventArena arena;  // Reused by every replication on this thread
+    while (!stop.load(std::memory_order_relaxed)) {
+      const size_t j = next_replication.fetch_add(1);
+      if (j >= num_replications) break;
+
+      ReplicationSlot& slot = slots[j];
+      const size_t k = shard.index + j * shard.count;
+      try {
+        BasicController<NullEventSink> controller(
+            options.num_trucks, options.num_stations,
+            ReplicationSeed(options.base_seed, k), NullEventSink(), &arena);
+        if (options.mining_distribution.has_value()) {
+          controller.SetMiningDistribution(*options.mining_distribution);
+        }
+        controller.Simulate(options.sim_time);
+        slot.trucks = controller.truck_metrics();
+        slot.stations = controller.station_metrics();
+      } catch (...) {
+        slot.error = std::current_exception();
+      }
+      slot.ready.store(true, std::memory_order_release);
+      slot.ready.notify_one();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) workers.emplace_back(worker);
+
+  ReplicationResult result;
+  if (options.mining_distribution.has_value()) {
+    result.mining_distribution = options.mining_distribution->Describe();
+  }
+  result.trucks.resize(options.num_trucks);
+  result.stations.resize(options.num_stations);
+  std::exception_ptr error;
+
+  for (size_t j = 0; j < num_replications; ++j) {
+    ReplicationSlot& slot = slots[j];
+    slot.ready.wait(false, std::memory_order_acquire);
+    if (slot.error) {
+      error = slot.error;
+      break;
+    }
+
+    double truck_utilization = 0.0;
+    for (size_t i = 0; i < slot.trucks.size(); ++i) {
+      result.trucks[i].Add(slot.trucks[i]);
+      truck_utilization += slot.trucks[i].utilization;
+    }
+    double station_utilization = 0.0;
+    for (size_t i = 0; i < slot.stations.size(); ++i) {
+      result.stations[i].Add(slot.stations[i]);
+      station_utilization += slot.stations[i].utilization;
+    }
+    truck_utilization /= static_cast<double>(slot.trucks.size());
+    station_utilization /= static_cast<double>(slot.stations.size());
+    result.truck_utilization.Add(truck_utilization);
+    result.station_utilization.Add(station_utilization);
+    result.truck_utilization_histogram.Add(truck_utilization);
+    result.station_utilization_histogram.Add(station_utilization);
+    result.replications = j + 1;
+    slot.trucks = {};  // Release the per-replication metrics early
+    slot.stations = {};
+
+    if (options.target_half_width > 0.0 &&
+        result.replications >= options.min_replications &&
+        result.truck_utilization.HalfWidth() <= options.target_half_width &&
+        result.station_utilization.HalfWidth() <= options.target_half_width) {
+      result.converged = true;
+      break;
+    }
+  }
+
+  stop = true;
+  for (auto& t : workers) t.join();
+  if (error) std::rethrow_exception(error);
+  return result;
+}
+
+// Prints fleet-level utilization as mean +/- CI half-width
+void PrintReplicationSummary(const ReplicationOptions& options,
+                             const ReplicationResult& result) {
+  std::cout << "\n=== Replication Summary ===\n"
+            << "Simulation Time: " << options.sim_time.count() << " minutes\n"
+            << "Trucks: " << options.num_trucks << "\n"
+            << "Stations: " << options.num_stations << "\n"
+            << "Replications: " << result.replications
+            << (result.converged ? " (target CI reached)" : "") << "\n"
+            << std::fixed << std::setprecision(2)
+            << "Average Truck Utilization: "
+            << result.truck_utilization.mean() << "% +/- "
+            << result.truck_utilization.HalfWidth() << "\n"
+            << "Average Station Utilization: "
+            << result.station_utilization.mean() << "% +/- "
+            << result.station_utilization.HalfWidth() << "\n";
+}
+
+// Exports per-truck and per-station statistics in the layout of the
+// single-run metrics report, with {mean, variance, ci95_half_width} per field
+std::string ExportReplicationsToJson(const ReplicationOptions& options,
+                                     const ReplicationResult& result) {
+  json j;
+  j["simulation_duration"] = options.sim_time.count();
+  j["base_seed"] = options.base_seed;
+  if (!result.mining_distribution.empty()) {
+    j["mining_distribution"] = result.mining_distribution;
+  }
+  j["replications"] = result.replications;
+  j["converged"] = result.converged;
+  j["truck_utilization"] = StatToJson(result.truck_utilization);
+  j["station_utilization"] = StatToJson(result.station_utilization);
+  j["truck_utilization_histogram"] =
+      result.truck_utilization_histogram.counts();
+  j["station_utilization_histogram"] =
+      result.station_utilization_histogram.counts();
+
+  for (size_t i = 0; i < result.trucks.size(); ++i) {
+    const auto& t = result.trucks[i];
+    j["trucks"].push_back({
+        {"id", i},
+        {"utilization", StatToJson(t.utilization)},
+        {"idle_time", StatToJson(t.idle_time)},
+        {"trips_completed", StatToJson(t.trips_completed)},
+        {"mines_completed", StatToJson(t.mines_completed)},
+        {"queues_completed", StatToJson(t.queues_completed)},
+        {"mining_time", StatToJson(t.mining_time)},
+        {"queueing_time", StatToJson(t.queueing_time)},
+        {"unloading_time", StatToJson(t.unloading_time)},
+        {"travel_time", StatToJson(t.travel_time)},
+        {"avg_trip_time", StatToJson(t.avg_trip_time)},
+        {"avg_queueing_time", StatToJson(t.avg_queueing_time)},
+    });
+  }
+
+  for (size_t i = 0; i < result.stations.size(); ++i) {
+    const auto& s = result.stations[i];
+    j["stations"].push_back({
+        {"id", i},
+        {"utilization", StatToJson(s.utilization)},
+        {"idle_time", StatToJson(s.idle_time)},
+        {"throughput", StatToJson(s.throughput)},
+        {"queues_completed", StatToJson(s.queues_completed)},
+        {"unloading_time", StatToJson(s.unloading_time)},
+        {"queueing_time", StatToJson(s.queueing_time)},
+        {"avg_queueing_time", StatToJson(s.avg_queueing_time)},
+    });
+  }
+
+  const std::string filename = ReportStem(options) + ".json";
+  std::ofstream out(filename);
+  out << std::setw(2) << j << std::endl;
+  return filename;
+}
+
+std::string WriteReplicationShard(const ReplicationOptions& options,
+                                  const ReplicationResult& result) {
+  json j;
+  j["kind"] = "replications";
+  j["version"] = kShardFileVersion;
+  j["shard"] = options.shard.index + 1;
+  j["shards"] = options.shard.count;
+  j["num_trucks"] = options.num_trucks;
+  j["num_stations"] = options.num_stations;
+  j["simulation_duration"] = options.sim_time.count();
+  j["base_seed"] = options.base_seed;
+  j["max_replications"] = options.max_replications;
+  j["mining_distribution"] = result.mining_distribution;
+  j["replications"] = result.replications;
+  j["truck_utilization"] = MomentsToJson(result.truck_utilization);
+  j["station_utilization"] = MomentsToJson(result.station_utilization);
+  j["truck_utilization_histogram"] =
+      HistogramToJson(result.truck_utilization_histogram);
+  j["station_utilization_histogram"] =
+      HistogramToJson(result.station_utilization_histogram);
+  j["trucks"] = ColumnsToJson(result.trucks, kTruckFields);
+  j["stations"] = ColumnsToJson(result.stations, kStationFields);
+
+  // Compact: the columns dominate, and only the merge tool reads it
+  const std::string filename =
+      ReportStem(options) + ".shard" + options.shard.Suffix() + ".json";
+  std::ofstream out(filename);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open shard file for writing: " +
+                             filename);
+  }
+  out << j.dump() << std::endl;
+  return filename;
+}
+
+ReplicationShard ReadReplicationShard(const std::string& filename) {
+  if (ReadShardKind(filename) != "replications") {
+    Logger::LogAndThrowError("Not a partial replication result: " +
+                             filename);
+  }
+  std::ifstream in(filename);
+  ReplicationShard shard;
+  try {
+    const json j = json::parse(in);
+    ReplicationOptions& options = shard.options;
+    options.shard.index = j.at("shard").get<size_t>() - 1;
+    options.shard.count = j.at("shards").get<size_t>();
+    if (options.shard.index >= options.shard.count) {
+      throw std::runtime_error("shard " + options.shard.Suffix());
+    }
+    options.num_trucks = j.at("num_trucks").get<size_t>();
+    options.num_stations = j.at("num_stations").get<size_t>();
+    options.sim_time = minutes_t(j.at("simulation_duration").get<int64_t>());
+    options.base_seed = j.at("base_seed").get<uint64_t>();
+    options.max_replications = j.at("max_replications").get<size_t>();
+
+    ReplicationResult& result = shard.result;
+    result.mining_distribution = j.at("mining_distribution");
+    result.replications = j.at("replications").get<size_t>();
+    result.truck_utilization = MomentsFromJson(j.at("truck_utilization"));
+    result.station_utilization = MomentsFromJson(j.at("station_utilization"));
+    result.truck_utilization_histogram =
+        HistogramFromJson(j.at("truck_utilization_histogram"));
+    result.station_utilization_histogram =
+        HistogramFromJson(j.at("station_utilization_histogram"));
+    result.trucks = ColumnsFromJson(j.at("trucks"), result.replications,
+                                    options.num_trucks, kTruckFields);
+    result.stations = ColumnsFromJson(j.at("stations"), result.replications,
+                                      options.num_stations, kStationFields);
+  } catch (const std::exception& e) {
+    Logger::LogAndThrowError("Malformed partial replication result " +
+                             filename + ": " + e.what());
+  }
+  return shard;
+}
+
+ReplicationResult MergeReplicationShards(
+    const std::vector<ReplicationShard>& shards, ReplicationOptions* options) {
+  if (shards.empty()) {
+    Logger::LogAndThrowError<std::invalid_argument>("No shards to merge");
+  }
+  // In shard order, so the result does not depend on the order given
+  std::vector<const ReplicationShard*> ordered;
+  for (const ReplicationShard& shard : shards) ordered.push_back(&shard);
+  std::sort(ordered.begin(), ordered.end(), [](const auto* a, const auto* b) {
+    return a->options.shard.index < b->options.shard.index;
+  });
+
+  const ReplicationShard& first = *ordered.front();
+  const ReplicationOptions& batch = first.options;
+  for (size_t i = 0; i < ordered.size(); ++i) {
+    const ReplicationShard& shard = *ordered[i];
+    const ReplicationOptions& o = shard.options;
+    if (o.num_trucks != batch.num_trucks ||
+        o.num_stations != batch.num_stations ||
+        o.sim_time != batch.sim_time || o.base_seed != batch.base_seed ||
+        o.max_replications != batch.max_replications ||
+        o.shard.count != batch.shard.count ||
+        shard.result.mining_distribution !=
+            first.result.mining_distribution) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Shard " + o.shard.Suffix() + " is of another batch than shard " +
+          batch.shard.Suffix());
+    }
+    if (i > 0 && o.shard.index == ordered[i - 1]->options.shard.index) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Shard " + o.shard.Suffix() + " is given twice");
+    }
+  }
+
+  *options = batch;
+  options->shard = {};
+  options->target_half_width = 0.0;
+  ReplicationResult result;
+  result.mining_distribution = first.result.mining_distribution;
+  result.trucks.resize(batch.num_trucks);
+  result.stations.resize(batch.num_stations);
+  for (const ReplicationShard* shard : ordered) {
+    const ReplicationResult& part = shard->result;
+    result.replications += part.replications;
+    result.truck_utilization.Merge(part.truck_utilization);
+    result.station_utilization.Merge(part.station_utilization);
+    result.truck_utilization_histogram.Merge(
+        part.truck_utilization_histogram);
+    result.station_utilization_histogram.Merge(
+        part.station_utilization_histogram);
+    for (size_t i = 0; i < result.trucks.size(); ++i) {
+      for (const auto& [name, field] : kTruckFields) {
+        (result.trucks[i].*field).Merge(part.trucks[i].*field);
+      }
+    }
+    for (size_t i = 0; i < result.stations.size(); ++i) {
+      for (const auto& [name, field] : kStationFields) {
+        (result.stations[i].*field).Merge(part.stations[i].*field);
+      }
+    }
+  }
+  return result;
+}
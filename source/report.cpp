@@ -1,5 +1,7 @@
 #include "report.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -8,6 +10,7 @@
 #include "controller.h"
 #include "event.h"
 #include "logger.h"
+#include "metrics_store.h"
 
 using json = nlohmann::json;
 
@@ -47,73 +50,226 @@ void GenerateMetrics(minutes_t sim_time,
   }
 }
 
+namespace {
+// Erlang C: probability that an arrival waits at c servers offered a Erlangs
+double ErlangC(size_t c, double a) {
+  if (a >= static_cast<double>(c)) return 1.0;
+  double blocking = 1.0;  // Erlang B, built up one server at a time
+  for (size_t k = 1; k <= c; ++k) {
+    blocking = a * blocking / (static_cast<double>(k) + a * blocking);
+  }
+  const double rho = a / static_cast<double>(c);
+  return blocking / (1.0 - rho * (1.0 - blocking));
+}
+
+// Share of item i when total is split as evenly as possible over n items:
+// floor or ceil of total / n, summing to floor(total)
+size_t Share(double total, size_t i, size_t n) {
+  const double per_item = total / static_cast<double>(n);
+  return static_cast<size_t>(std::floor(per_item * (i + 1)) -
+                             std::floor(per_item * i));
+}
+
+// Expected number of times by time t that a truck has completed the phase of
+// its cycle that ends lag minutes after a mining operation. The first
+// completion is spread like the mining duration; later ones are spread over
+// a whole cycle (renewal approximation).
+double ExpectedCompletions(double t, double lag, double cycle_time) {
+  const double min_mining =
+      static_cast<double>(Controller::kMinDuration.count());
+  const double max_mining =
+      static_cast<double>(Controller::kMaxDuration.count());
+  const double first = std::clamp(
+      (t - lag - min_mining) / (max_mining - min_mining), 0.0, 1.0);
+  const double later = std::max(
+      0.0, (t - lag - (min_mining + max_mining) / 2.0) / cycle_time - 0.5);
+  return first + later;
+}
+}  // namespace
+
+// Mean value analysis, one truck at a time, of a network with an
+// infinite-server delay (mining, travel and the Seidmann delay) and one
+// queue of c-times-faster service. An arriving truck finds the queue the
+// network had with one truck fewer; the one in service has half its
+// (deterministic) unload left.
+QueueingEstimate EstimateQueueing(size_t num_trucks, size_t num_stations) {
+  QueueingEstimate estimate;
+  if (num_trucks == 0 || num_stations == 0) return estimate;
+
+  const double c = static_cast<double>(num_stations);
+  const double unload = static_cast<double>(Controller::kUnloadTime.count());
+  const double mining = static_cast<double>((Controller::kMinDuration +
+                                             Controller::kMaxDuration)
+                                                .count()) /
+                        2.0;
+  const double travel = static_cast<double>(Controller::kTravelTime.count());
+  const double service = unload / c;
+  const double delay = mining + 2.0 * travel + unload - service;
+
+  double queue = 0.0;
+  double utilization = 0.0;
+  double residence = service;
+  double throughput = 0.0;
+  for (size_t n = 1; n <= num_trucks; ++n) {
+    residence = service * (1.0 + queue - utilization / 2.0);
+    throughput = static_cast<double>(n) / (delay + residence);
+    queue = throughput * residence;
+    utilization = throughput * service;
+  }
+
+  // Seidmann's approximation overstates the wait at many lightly loaded
+  // stations, where the open M/D/c value (Erlang C, with half the M/M/c
+  // conditional wait) is accurate; near saturation the open value diverges
+  // while the closed network's wait stays bounded. Take the smaller.
+  const double wait_probability = ErlangC(num_stations, throughput * unload);
+  double wait = residence - service;
+  if (utilization < 1.0) {
+    wait = std::min(wait, wait_probability * unload /
+                              (2.0 * c * (1.0 - utilization)));
+  }
+
+  // The residual-time correction lets the recursion overshoot the stations'
+  // capacity by a hair at saturation
+  throughput = std::min(throughput, 1.0 / service);
+  estimate.throughput = throughput;
+  estimate.cycle_time = static_cast<double>(num_trucks) / throughput;
+  estimate.station_utilization = std::min(utilization, 1.0);
+  estimate.wait_probability = wait_probability;
+  estimate.mean_wait = wait;
+  return estimate;
+}
+
+// Expected completions of each phase of the cycle by sim_time, spread
+// evenly over trucks and stations
+void EstimateMetrics(size_t num_trucks, size_t num_stations,
+                     minutes_t sim_time, std::vector<TruckMetrics>* trucks,
+                     std::vector<StationMetrics>* stations) {
+  trucks->assign(num_trucks, {});
+  stations->assign(num_stations, {});
+  if (num_trucks == 0 || num_stations == 0) return;
+
+  const QueueingEstimate estimate = EstimateQueueing(num_trucks, num_stations);
+  const double t = static_cast<double>(sim_time.count());
+  const double cycle = estimate.cycle_time;
+  const double mining = static_cast<double>((Controller::kMinDuration +
+                                             Controller::kMaxDuration)
+                                                .count()) /
+                        2.0;
+  const double travel = static_cast<double>(Controller::kTravelTime.count());
+  const double unload = static_cast<double>(Controller::kUnloadTime.count());
+  const double n = static_cast<double>(num_trucks);
+
+  // Earliest time any unload can finish
+  const double first_unload = static_cast<double>(
+      (Controller::kMinDuration + Controller::kTravelTime +
+       Controller::kUnloadTime)
+          .count());
+
+  // Every truck starts at the mine with the stations idle, so queueing
+  // builds up over about one cycle before reaching its steady-state mean;
+  // average that ramp over the part of the run in which unloads can occur
+  const double unload_window = t - first_unload;
+  double wait = 0.0;
+  if (unload_window > cycle) {
+    wait = estimate.mean_wait * (1.0 - cycle / (2.0 * unload_window));
+  } else if (unload_window > 0.0) {
+    wait = estimate.mean_wait * unload_window / (2.0 * cycle);
+  }
+
+  // Phase ends, measured from the end of mining. The first trucks to arrive
+  // find the stations idle, so trips are counted without a queueing delay
+  // and are instead capped by the stations' capacity, which is what limits
+  // a saturated fleet.
+  const double arrive_lag = travel;
+  const double unload_lag = arrive_lag + unload;
+  const double return_lag = unload_lag + wait + travel;
+  const double capacity = static_cast<double>(num_stations) / unload *
+                          std::max(0.0, unload_window);
+
+  const double mines = n * ExpectedCompletions(t, 0.0, cycle);
+  const double to_station = n * ExpectedCompletions(t, arrive_lag, cycle);
+  const double trips =
+      std::min(n * ExpectedCompletions(t, unload_lag, cycle), capacity);
+  const double to_mine =
+      std::min(n * ExpectedCompletions(t, return_lag, cycle), trips);
+  const double queues = trips * estimate.wait_probability;
+  const double queueing = trips * wait;
+
+  for (size_t i = 0; i < num_trucks; ++i) {
+    auto& m = (*trucks)[i];
+    m.mines_completed = Share(mines, i, num_trucks);
+    m.trips_completed = Share(trips, i, num_trucks);
+    m.queues_completed = Share(queues, i, num_trucks);
+    m.mining_time = minutes_t(Share(mines * mining, i, num_trucks));
+    m.travel_time =
+        Controller::kTravelTime *
+        (Share(to_station, i, num_trucks) + Share(to_mine, i, num_trucks));
+    m.unloading_time = Controller::kUnloadTime * m.trips_completed;
+    m.queueing_time = minutes_t(Share(queueing, i, num_trucks));
+  }
+
+  for (size_t i = 0; i < num_stations; ++i) {
+    auto& s = (*stations)[i];
+    s.throughput = Share(trips, i, num_stations);
+    s.queues_completed = Share(queues, i, num_stations);
+    s.unloading_time = Controller::kUnloadTime * s.throughput;
+    s.queueing_time = minutes_t(Share(queueing, i, num_stations));
+  }
+
+  GenerateMetrics(sim_time, trucks, stations);
+}
+
 // Exports a formatted report of truck and station metrics to JSON
 void ExportMetricsToJson(minutes_t sim_time,
                          const std::vector<TruckMetrics>& trucks,
                          const std::vector<StationMetrics>& stations) {
-  json j;
-  j["simulation_duration"] = sim_time.count();
-
-  for (size_t i = 0; i < trucks.size(); ++i) {
-    const auto& t = trucks[i];
-    j["trucks"].push_back({
-        {"id", i},
-        {"utilization", t.utilization},
-        {"idle_time", t.idle_time.count()},
-        {"trips_completed", t.trips_completed},
-        {"mines_completed", t.mines_completed},
-        {"queues_completed", t.queues_completed},
-        {"mining_time", t.mining_time.count()},
-        {"queueing_time", t.queueing_time.count()},
-        {"avg_trip_time", t.avg_trip_time},
-        {"avg_queueing_time", t.avg_queueing_time},
-    });
-  }
-
-  for (size_t i = 0; i < stations.size(); ++i) {
-    const auto& s = stations[i];
-    j["stations"].push_back({
-        {"id", i},
-        {"utilization", s.utilization},
-        {"idle_time", s.idle_time.count()},
-        {"throughput", s.throughput},
-        {"queues_completed", s.queues_completed},
-        {"unloading_time", s.unloading_time.count()},
-        {"queueing_time", s.queueing_time.count()},
-        {"avg_queueing_time", s.avg_queueing_time},
-    });
-  }
+  ExportMetrics(sim_time, MetricsStore::FromMetrics(trucks, stations));
+}
 
-  // Construct a descriptive filename for output
-  std::ostringstream os;
-  os << "metrics." << trucks.size() << "truck_" << stations.size() << "station_"
-     << sim_time << "_minutes.json";
+void ExportMetricsToJson(minutes_t sim_time, const MetricsStore& metrics) {
+  ExportMetrics(sim_time, metrics);
+}
 
-  std::ofstream out(os.str());
-  out << std::setw(2) << j << std::endl;
+void ExportMetrics(minutes_t sim_time, const MetricsStore& metrics,
+                   const MetricsExportOptions& options) {
+  const std::string path = WriteMetricsReport(sim_time, metrics, options);
+  PrintMetricsSummary(metrics, sim_time);
+  std::cout << "\nFull metrics report: " << path << std::endl;
+}
 
-  PrintMetricsSummary(trucks, stations, sim_time);
-  std::cout << "\nFull metrics report: " << os.str() << std::endl;
+void ExportAllEventsToJson(size_t num_trucks, size_t num_stations,
+                           minutes_t sim_time,
+                           const EventExportOptions& options) {
+  WaitUntilFlushed();
+  EventExportOptions export_options = options;
+  if (export_options.path.empty()) {
+    export_options.path = DefaultEventExportPath(num_trucks, num_stations,
+                                                 sim_time, options.format);
+  }
+  const EventExportResult result =
+      ExportEventLog(GetEventLogger().filename(), export_options);
+  std::cout << "\nEvent export: " << result.path << " (" << result.num_events
+            << " events";
+  if (result.skipped > 0) std::cout << ", " << result.skipped << " skipped";
+  std::cout << ")" << std::endl;
 }
 
 // Prints a summary of overall utilization to the console
 void PrintMetricsSummary(const std::vector<TruckMetrics>& trucks,
                          const std::vector<StationMetrics>& stations,
                          minutes_t sim_time) {
-  double avg_truck_util = 0.0;
-  for (const auto& t : trucks) avg_truck_util += t.utilization;
-  avg_truck_util /= trucks.size();
-
-  double avg_station_util = 0.0;
-  for (const auto& s : stations) avg_station_util += s.utilization;
-  avg_station_util /= stations.size();
+  PrintMetricsSummary(MetricsStore::FromMetrics(trucks, stations), sim_time);
+}
 
+void PrintMetricsSummary(const MetricsStore& metrics, minutes_t sim_time) {
   std::cout << "\n=== Simulation Summary ===\n"
             << "Simulation Time: " << sim_time.count() << " minutes\n"
-            << "Trucks: " << trucks.size() << "\n"
-            << "Stations: " << stations.size() << "\n"
+            << "Trucks: " << metrics.num_trucks() << "\n"
+            << "Stations: " << metrics.num_stations() << "\n"
             << "Average Truck Utilization: " << std::fixed
-            << std::setprecision(2) << avg_truck_util << "%\n"
+            << std::setprecision(2) << metrics.AverageTruckUtilization()
+            << "%\n"
             << "Average Station Utilization: " << std::fixed
-            << std::setprecision(2) << avg_station_util << "%\n";
+            << std::setprecision(2) << metrics.AverageStationUtilization()
+            << "%\n";
 }
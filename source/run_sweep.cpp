@@ -0,0 +1,147 @@
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "mining_distribution.h"
+#include "shard.h"
+#include "sweep.h"
+
+void PrintUsage(const char* program_name) {
+  std::cerr << "Usage: " << program_name
+            << " [options] <trucks> <stations> [sim_minutes]\n"
+            << "  Runs every combination of the given fleet configurations "
+               "and writes one table.\n"
+            << "  Each argument is a value, a range first:last[:step], or a "
+               "comma-separated list\n"
+            << "  of those, e.g. 10:100:10 or 1,2,5 "
+               "(sim_minutes default: 4320).\n"
+            << "Options:\n"
+            << "  --threads=<n>      Worker threads (default: all cores)\n"
+            << "  --estimate         Fill the table from the analytic "
+               "queueing estimate\n"
+            << "                     instead of simulating\n"
+            << "  --mining=<spec>    Mining durations: uniform (default), "
+               "triangular:<mode>,\n"
+            << "                     lognormal:<median>:<sigma> or "
+               "empirical:<histogram file>\n"
+            << "  --output=<file>    Result table (default: sweep.csv); a "
+               ".bin extension\n"
+            << "                     writes the binary format instead of "
+               "CSV\n"
+            << "  --shard=<i>/<n>    Run only shard i of n of the cells and "
+               "write a partial\n"
+            << "                     result for the merge tool (default "
+               "output:\n"
+            << "                     sweep.shard<i>of<n>.json)\n";
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> args;
+  std::string output;
+  SweepOptions options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--threads=", 0) == 0) {
+      try {
+        options.num_threads = std::stoul(arg.substr(10));
+      } catch (const std::exception&) {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--estimate") {
+      options.estimate = true;
+    } else if (arg.rfind("--mining=", 0) == 0) {
+      try {
+        options.mining_distribution = MiningDistribution::Parse(
+            arg.substr(9), Controller::kMinDuration, Controller::kMaxDuration);
+      } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--shard=", 0) == 0) {
+      try {
+        options.shard = ParseShardSpec(arg.substr(8));
+      } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--output=", 0) == 0) {
+      output = arg.substr(9);
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Error: Unknown option " << arg << "\n";
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (args.size() < 2 || args.size() > 3) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (options.estimate && options.mining_distribution.has_value()) {
+    std::cerr << "Error: The estimate assumes uniform mining durations\n";
+    return EXIT_FAILURE;
+  }
+
+  try {
+    options.trucks = ParseSweepRange(args[0]);
+    options.stations = ParseSweepRange(args[1]);
+    for (size_t minutes : ParseSweepRange(args.size() > 2 ? args[2] : "4320")) {
+      options.sim_times.push_back(minutes_t(minutes));
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t num_cells = options.trucks.size() * options.stations.size() *
+                           options.sim_times.size();
+  const bool sharded = options.shard.sharded();
+  if (output.empty()) {
+    output = sharded ? "sweep.shard" + options.shard.Suffix() + ".json"
+                     : "sweep.csv";
+  }
+  if (sharded) {
+    std::cout << "Running shard " << options.shard.index + 1 << " of "
+              << options.shard.count << " ("
+              << options.shard.NumItems(num_cells) << " of " << num_cells
+              << " configurations)...\n";
+  } else {
+    std::cout << "Running " << num_cells << " configurations...\n";
+  }
+
+  try {
+    auto start_time = std::chrono::steady_clock::now();
+    const std::vector<SweepResult> results = RunSweep(options);
+    auto end_time = std::chrono::steady_clock::now();
+    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           end_time - start_time)
+                           .count();
+
+    const bool binary =
+        output.size() >= 4 && output.compare(output.size() - 4, 4, ".bin") == 0;
+    if (sharded) {
+      WriteSweepShard(output, options, results);
+    } else if (binary) {
+      WriteSweepBinary(output, results);
+    } else {
+      WriteSweepCsv(output, results);
+    }
+    std::cout << (sharded ? "\nPartial sweep: " : "\nSweep table: ")
+              << output << "\n"
+              << "\nSweep completed in " << duration_ms << " ms\n";
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "scenario.h"
+
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+#include "logger.h"
+
+using json = nlohmann::json;
+
+namespace {
+// Reads a non-negative whole number of minutes (or a count) from field of
+// object, or returns fallback if it is absent
+int64_t ReadCount(const json& object, const char* field, int64_t fallback,
+                  const std::string& filename) {
+  if (!object.contains(field)) return fallback;
+  const json& value = object.at(field);
+  if (!value.is_number_integer() || value.get<int64_t>() < 0) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Invalid " + std::string(field) + " in scenario " + filename);
+  }
+  return value.get<int64_t>();
+}
+}  // namespace
+
+size_t Scenario::num_trucks() const {
+  size_t total = 0;
+  for (const TruckClass& truck_class : truck_classes) {
+    total += truck_class.count;
+  }
+  return total;
+}
+
+size_t Scenario::num_stations() const {
+  size_t total = 0;
+  for (const StationGroup& group : station_groups) total += group.count;
+  return total;
+}
+
+bool Scenario::UsesFixedTiming() const {
+  for (const TruckClass& truck_class : truck_classes) {
+    if (truck_class.travel_time != FixedTiming::kTravelTime ||
+        truck_class.mining.Describe() !=
+            truck_classes.front().mining.Describe()) {
+      return false;
+    }
+  }
+  for (const StationGroup& group : station_groups) {
+    if (group.unload_time != FixedTiming::kUnloadTime) return false;
+  }
+  return true;
+}
+
+Scenario ReadScenario(const std::string& filename) {
+  std::ifstream in(filename);
+  if (!in.is_open()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Unable to open scenario: " + filename);
+  }
+  json j;
+  try {
+    in >> j;
+  } catch (const json::exception& e) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Invalid scenario " + filename + ": " + e.what());
+  }
+  if (!j.is_object() || !j.contains("trucks") || !j.contains("stations") ||
+      !j.at("trucks").is_array() || !j.at("stations").is_array()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Scenario " + filename + " needs \"trucks\" and \"stations\" lists");
+  }
+
+  Scenario scenario;
+  for (const json& entry : j.at("trucks")) {
+    if (!entry.is_object()) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Invalid truck class in scenario " + filename);
+    }
+    Scenario::TruckClass truck_class;
+    truck_class.name = entry.value("class", "");
+    truck_class.count = ReadCount(entry, "count", 0, filename);
+    truck_class.travel_time = minutes_t(ReadCount(
+        entry, "travel_time", FixedTiming::kTravelTime.count(), filename));
+    if (entry.contains("mining")) {
+      if (!entry.at("mining").is_string()) {
+        Logger::LogAndThrowError<std::invalid_argument>(
+            "Invalid mining in scenario " + filename);
+      }
+      truck_class.mining = MiningDistribution::Parse(
+          entry.at("mining").get<std::string>(), FixedTiming::kMinDuration,
+          FixedTiming::kMaxDuration);
+    }
+    scenario.truck_classes.push_back(std::move(truck_class));
+  }
+  for (const json& entry : j.at("stations")) {
+    if (!entry.is_object()) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Invalid station group in scenario " + filename);
+    }
+    Scenario::StationGroup group;
+    group.count = ReadCount(entry, "count", 0, filename);
+    group.unload_time = minutes_t(ReadCount(
+        entry, "unload_time", FixedTiming::kUnloadTime.count(), filename));
+    if (group.unload_time < 1min) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Unload time must be at least a minute in scenario " + filename);
+    }
+    scenario.station_groups.push_back(group);
+  }
+  if (scenario.truck_classes.size() > std::numeric_limits<uint16_t>::max()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Too many truck classes in scenario " + filename);
+  }
+  return scenario;
+}
+
+ScenarioTiming::ScenarioTiming(const Scenario& scenario) {
+  for (size_t i = 0; i < scenario.truck_classes.size(); ++i) {
+    const Scenario::TruckClass& truck_class = scenario.truck_classes[i];
+    classes_.push_back({truck_class.travel_time, truck_class.mining});
+    truck_class_.insert(truck_class_.end(), truck_class.count,
+                        static_cast<uint16_t>(i));
+    description_ += i > 0 ? "," : "trucks=";
+    description_ += std::to_string(truck_class.count);
+    description_ += 'x';
+    description_ += std::to_string(truck_class.travel_time.count());
+    description_ += ':';
+    description_ += truck_class.mining.Describe();
+  }
+  description_ += ";stations=";
+  for (size_t i = 0; i < scenario.station_groups.size(); ++i) {
+    const Scenario::StationGroup& group = scenario.station_groups[i];
+    unload_time_.insert(unload_time_.end(), group.count, group.unload_time);
+    if (i > 0) description_ += ',';
+    description_ += std::to_string(group.count);
+    description_ += 'x';
+    description_ += std::to_string(group.unload_time.count());
+  }
+}
+
+void ScenarioTiming::Validate(size_t num_trucks, size_t num_stations) const {
+  if (num_trucks != truck_class_.size() ||
+      num_stations != unload_time_.size()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Scenario timing covers " + std::to_string(truck_class_.size()) +
+        " trucks and " + std::to_string(unload_time_.size()) +
+        " stations, not " + std::to_string(num_trucks) + " and " +
+        std::to_string(num_stations));
+  }
+}
@@ -0,0 +1,129 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace {
+// Heap comparator: "a comes after b" gives a min-heap on (time, sequence)
+template <typename Entry>
+bool LaterThan(const Entry& a, const Entry& b) {
+  if (a.event.end_time() != b.event.end_time()) {
+    return a.event.end_time() > b.event.end_time();
+  }
+  return a.sequence > b.sequence;
+}
+}  // namespace
+
+void BinaryHeapScheduler::Push(const PackedEvent& event) {
+  heap_.push_back({event, next_sequence_++});
+  std::push_heap(heap_.begin(), heap_.end(), LaterThan<Entry>);
+}
+
+PackedEvent BinaryHeapScheduler::Pop() {
+  std::pop_heap(heap_.begin(), heap_.end(), LaterThan<Entry>);
+  const PackedEvent event = heap_.back().event;
+  heap_.pop_back();
+  return event;
+}
+
+std::vector<PackedEvent> BinaryHeapScheduler::Pending() const {
+  std::vector<Entry> entries(heap_.begin(), heap_.end());
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return LaterThan(b, a); });
+  std::vector<PackedEvent> events;
+  events.reserve(entries.size());
+  for (const Entry& entry : entries) events.push_back(entry.event);
+  return events;
+}
+
+void BinaryHeapScheduler::Clear() {
+  heap_.clear();  // Keeps capacity for the next run
+  next_sequence_ = 0;
+}
+
+// Sizes the wheel to the next power of two above the horizon so that bucket
+// lookup is a mask instead of a modulo
+TimingWheelScheduler::TimingWheelScheduler(minutes_t horizon,
+                                           std::pmr::memory_resource* resource)
+    : horizon_(horizon),
+      mask_(std::bit_ceil(static_cast<uint64_t>(horizon.count()) + 1) - 1),
+      buckets_(mask_ + 1, resource),
+      overflow_(horizon, resource) {}
+
+void TimingWheelScheduler::Clear() {
+  for (auto& bucket : buckets_) bucket.clear();
+  now_ = 0min;
+  read_index_ = 0;
+  wheel_size_ = 0;
+  overflow_.Clear();
+}
+
+// Wheel events are within the horizon of the cursor, so a bucket holds a
+// single minute and the buckets from the cursor on are in time order.
+// Overflow events come first among events of the same minute, as they do
+// when migrated.
+std::vector<PackedEvent> TimingWheelScheduler::Pending() const {
+  std::vector<PackedEvent> wheel;
+  wheel.reserve(wheel_size_);
+  for (int64_t offset = 0; offset <= horizon_.count(); ++offset) {
+    const auto& bucket = buckets_[(now_.count() + offset) & mask_];
+    const size_t begin = offset == 0 ? read_index_ : 0;
+    wheel.insert(wheel.end(), bucket.begin() + begin, bucket.end());
+  }
+
+  const std::vector<PackedEvent> overflow = overflow_.Pending();
+  std::vector<PackedEvent> events;
+  events.reserve(wheel.size() + overflow.size());
+  std::merge(overflow.begin(), overflow.end(), wheel.begin(), wheel.end(),
+             std::back_inserter(events),
+             [](const PackedEvent& a, const PackedEvent& b) {
+               return a.end_time() < b.end_time();
+             });
+  return events;
+}
+
+std::pmr::vector<PackedEvent>* TimingWheelScheduler::AdvanceToNextEvent() {
+  buckets_[now_.count() & mask_].clear();  // Keeps capacity for reuse
+  read_index_ = 0;
+
+  // Nothing within the horizon: jump straight to the next overflow event
+  if (wheel_size_ == 0) now_ = overflow_.NextTime() - 1min;
+
+  std::pmr::vector<PackedEvent>* bucket = nullptr;
+  do {
+    now_ += 1min;
+    MigrateOverflow();
+    bucket = &buckets_[now_.count() & mask_];
+  } while (bucket->empty());
+  return bucket;
+}
+
+bool TimingWheelScheduler::PopBefore(minutes_t limit, PackedEvent* event) {
+  auto* bucket = &buckets_[now_.count() & mask_];
+  while (read_index_ == bucket->size()) {
+    if (Empty() || now_ + 1min >= limit) return false;
+    bucket->clear();
+    read_index_ = 0;
+    // Nothing within the horizon: jump towards the next overflow event, but
+    // not past the limit
+    if (wheel_size_ == 0) {
+      now_ = std::min(overflow_.NextTime(), limit) - 1min;
+      if (now_ + 1min >= limit) return false;
+    }
+    now_ += 1min;
+    MigrateOverflow();
+    bucket = &buckets_[now_.count() & mask_];
+  }
+  --wheel_size_;
+  *event = (*bucket)[read_index_++];
+  return true;
+}
+
+void TimingWheelScheduler::MigrateOverflow() {
+  while (!overflow_.Empty() && overflow_.NextTime() - now_ <= horizon_) {
+    const PackedEvent event = overflow_.Pop();
+    buckets_[event.end_time().count() & mask_].push_back(event);
+    ++wheel_size_;
+  }
+}
@@ -0,0 +1,51 @@
+#include "shard.h"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+#include "logger.h"
+
+using json = nlohmann::json;
+
+std::string ShardSpec::Suffix() const {
+  return std::to_string(index + 1) + "of" + std::to_string(count);
+}
+
+ShardSpec ParseShardSpec(const std::string& spec) {
+  size_t index = 0;
+  size_t count = 0;
+  const size_t slash = spec.find('/');
+  if (slash != std::string::npos) {
+    try {
+      size_t index_end = 0;
+      size_t count_end = 0;
+      index = std::stoul(spec.substr(0, slash), &index_end);
+      count = std::stoul(spec.substr(slash + 1), &count_end);
+      if (index_end != slash || slash + 1 + count_end != spec.size()) {
+        count = 0;
+      }
+    } catch (const std::exception&) {
+      count = 0;
+    }
+  }
+  if (count == 0 || index == 0 || index > count) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Invalid shard " + spec + ": expected <i>/<n> with 1 <= i <= n");
+  }
+  return {index - 1, count};
+}
+
+std::string ReadShardKind(const std::string& filename) {
+  std::ifstream in(filename);
+  if (!in.is_open()) {
+    Logger::LogAndThrowError("Unable to open shard file: " + filename);
+  }
+  const json j = json::parse(in, nullptr, false);
+  if (j.is_discarded() || !j.is_object() || !j.contains("kind") ||
+      !j["kind"].is_string() || j.value("version", 0) != kShardFileVersion) {
+    Logger::LogAndThrowError("Not a partial result of this version: " +
+                             filename);
+  }
+  return j["kind"].get<std::string>();
+}
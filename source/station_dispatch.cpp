@@ -0,0 +1,259 @@
+#include "station_dispatch.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "logger.h"
+
+namespace {
+// Popped entries are dropped from the front of a StationQueue once there are
+// at least this many and they make up half of it
+constexpr size_t kStationQueueCompaction = 4096;
+
+// Available times by station id as saved entries
+StationQueueState SaveAvailable(const std::vector<minutes_t>& available) {
+  StationQueueState state;
+  for (size_t i = 0; i < available.size(); ++i) {
+    state.entries.emplace_back(available[i], i);
+  }
+  return state;
+}
+
+std::vector<minutes_t> RestoreAvailable(const StationQueueState& state) {
+  std::vector<minutes_t> available(state.entries.size(), 0min);
+  for (const auto& [time, station_id] : state.entries) {
+    if (station_id >= available.size()) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Saved station " + std::to_string(station_id) + " out of range");
+    }
+    available[station_id] = time;
+  }
+  return available;
+}
+}  // namespace
+
+void StationQueue::Initialize(size_t num_stations) {
+  entries_.clear();
+  entries_.reserve(num_stations);
+  for (size_t i = 0; i < num_stations; ++i) {
+    entries_.emplace_back(0min, i);
+  }
+  head_ = 0;
+  sorted_end_ = 0;
+  last_popped_ = minutes_t::min();
+  last_marked_ = minutes_t::min();
+}
+
+bool StationQueue::Empty() const { return head_ == entries_.size(); }
+
+std::pair<minutes_t, size_t> StationQueue::PopNextAvailable() {
+  if (head_ == sorted_end_) {
+    // First pop at this time: every station available then is queued
+    const minutes_t time = entries_[head_].first;
+    sorted_end_ = head_ + 1;
+    while (sorted_end_ < entries_.size() &&
+           entries_[sorted_end_].first == time) {
+      ++sorted_end_;
+    }
+    std::sort(entries_.begin() + head_, entries_.begin() + sorted_end_);
+  }
+
+  const auto entry = entries_[head_++];
+  last_popped_ = entry.first;
+  if (head_ >= kStationQueueCompaction && head_ * 2 >= entries_.size()) {
+    entries_.erase(entries_.begin(), entries_.begin() + head_);
+    sorted_end_ -= head_;
+    head_ = 0;
+  }
+  return entry;
+}
+
+void StationQueue::MarkAvailable(minutes_t time, size_t station_id) {
+  if (time <= last_popped_ || time < last_marked_) {
+    Logger::LogAndThrowError<std::logic_error>(
+        "Station " + std::to_string(station_id) +
+        " marked available out of order at " + std::to_string(time.count()));
+  }
+  last_marked_ = time;
+  entries_.emplace_back(time, station_id);
+}
+
+StationQueueState StationQueue::Save() const {
+  return {{entries_.begin() + head_, entries_.end()}, last_popped_,
+          last_marked_, {}};
+}
+
+// Stations of the front time that were already sorted are sorted again on
+// the next pop, which leaves them as they are
+void StationQueue::Restore(const StationQueueState& state) {
+  entries_ = state.entries;
+  head_ = 0;
+  sorted_end_ = 0;
+  last_popped_ = state.last_popped;
+  last_marked_ = state.last_marked;
+}
+
+void StationHeap::Initialize(size_t num_stations) {
+  heap_.clear();
+  for (size_t i = 0; i < num_stations; ++i) heap_.emplace_back(0min, i);
+}
+
+std::pair<minutes_t, size_t> StationHeap::PopNextAvailable() {
+  std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+  const auto entry = heap_.back();
+  heap_.pop_back();
+  return entry;
+}
+
+void StationHeap::MarkAvailable(minutes_t time, size_t station_id) {
+  heap_.emplace_back(time, station_id);
+  std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+}
+
+StationQueueState StationHeap::Save() const {
+  StationQueueState state{heap_, minutes_t::min(), minutes_t::min(), {}};
+  std::sort(state.entries.begin(), state.entries.end());
+  return state;
+}
+
+// Sorted entries are already a min-heap
+void StationHeap::Restore(const StationQueueState& state) {
+  heap_ = state.entries;
+  std::make_heap(heap_.begin(), heap_.end(), std::greater<>());
+}
+
+void LeastLoadedDispatch::Initialize(size_t num_stations) {
+  heap_.resize(num_stations);
+  position_.resize(num_stations);
+  for (uint32_t i = 0; i < num_stations; ++i) {
+    heap_[i] = i;
+    position_[i] = i;
+  }
+  available_.assign(num_stations, 0min);
+  load_.assign(num_stations, 0);
+  arrival_time_ = 0min;
+}
+
+// Only the station at the front is ever marked, and its load only grows
+void LeastLoadedDispatch::MarkAvailable(minutes_t time, size_t station_id) {
+  load_[station_id] +=
+      (time - std::max(arrival_time_, available_[station_id])).count();
+  available_[station_id] = time;
+  SiftDown(position_[station_id]);
+}
+
+void LeastLoadedDispatch::SiftDown(size_t index) {
+  const uint32_t station_id = heap_[index];
+  for (;;) {
+    const size_t first = index * kArity + 1;
+    if (first >= heap_.size()) break;
+    const size_t last = std::min(first + kArity, heap_.size());
+    size_t best = first;
+    for (size_t child = first + 1; child < last; ++child) {
+      if (Less(heap_[child], heap_[best])) best = child;
+    }
+    if (!Less(heap_[best], station_id)) break;
+    heap_[index] = heap_[best];
+    position_[heap_[index]] = static_cast<uint32_t>(index);
+    index = best;
+  }
+  heap_[index] = station_id;
+  position_[station_id] = static_cast<uint32_t>(index);
+}
+
+StationQueueState LeastLoadedDispatch::Save() const {
+  StationQueueState state = SaveAvailable(available_);
+  state.counters = load_;
+  return state;
+}
+
+void LeastLoadedDispatch::Restore(const StationQueueState& state) {
+  Initialize(state.entries.size());
+  if (state.counters.size() != load_.size()) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Saved station loads do not match the stations");
+  }
+  available_ = RestoreAvailable(state);
+  load_ = state.counters;
+  for (size_t i = heap_.size() / kArity + 1; i-- > 0;) {
+    if (i < heap_.size()) SiftDown(i);
+  }
+}
+
+void RoundRobinDispatch::Initialize(size_t num_stations) {
+  available_.assign(num_stations, 0min);
+  next_ = 0;
+}
+
+StationQueueState RoundRobinDispatch::Save() const {
+  StationQueueState state = SaveAvailable(available_);
+  state.counters = {static_cast<int64_t>(next_)};
+  return state;
+}
+
+void RoundRobinDispatch::Restore(const StationQueueState& state) {
+  available_ = RestoreAvailable(state);
+  next_ = state.counters.empty() || available_.empty()
+              ? 0
+              : static_cast<size_t>(state.counters.front()) % available_.size();
+}
+
+void AffinityDispatch::Initialize(size_t num_stations) {
+  if (num_mines_ == 0 || num_stations < num_mines_) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Cannot split " + std::to_string(num_stations) + " stations among " +
+        std::to_string(num_mines_) + " mines");
+  }
+  available_.assign(num_stations, 0min);
+  leaves_ = std::bit_ceil(num_stations);
+  tree_.assign(2 * leaves_, kNoStation);
+  for (uint32_t i = 0; i < num_stations; ++i) tree_[leaves_ + i] = i;
+  for (size_t node = leaves_ - 1; node > 0; --node) {
+    tree_[node] = Winner(tree_[2 * node], tree_[2 * node + 1]);
+  }
+}
+
+uint32_t AffinityDispatch::Winner(uint32_t a, uint32_t b) const {
+  if (a == kNoStation) return b;
+  if (b == kNoStation) return a;
+  return std::make_pair(available_[a], a) < std::make_pair(available_[b], b)
+             ? a
+             : b;
+}
+
+// The usual bottom-up range query over [first, last) of the leaves
+std::pair<minutes_t, size_t> AffinityDispatch::Assign(
+    size_t truck_id, minutes_t /*arrival_time*/) {
+  const size_t mine = truck_id % num_mines_;
+  const size_t num_stations = available_.size();
+  size_t first = leaves_ + mine * num_stations / num_mines_;
+  size_t last = leaves_ + (mine + 1) * num_stations / num_mines_;
+  uint32_t best = kNoStation;
+  for (; first < last; first >>= 1, last >>= 1) {
+    if (first & 1) best = Winner(best, tree_[first++]);
+    if (last & 1) best = Winner(best, tree_[--last]);
+  }
+  return {available_[best], best};
+}
+
+void AffinityDispatch::MarkAvailable(minutes_t time, size_t station_id) {
+  available_[station_id] = time;
+  for (size_t node = (leaves_ + station_id) / 2; node > 0; node /= 2) {
+    tree_[node] = Winner(tree_[2 * node], tree_[2 * node + 1]);
+  }
+}
+
+StationQueueState AffinityDispatch::Save() const {
+  return SaveAvailable(available_);
+}
+
+void AffinityDispatch::Restore(const StationQueueState& state) {
+  Initialize(state.entries.size());
+  available_ = RestoreAvailable(state);
+  for (size_t node = leaves_ - 1; node > 0; --node) {
+    tree_[node] = Winner(tree_[2 * node], tree_[2 * node + 1]);
+  }
+}
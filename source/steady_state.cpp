@@ -0,0 +1,243 @@
+#include "steady_state.h"
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <stdexcept>
+
+#include "logger.h"
+#include "replication.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Sums of the unloads over a run of observations
+struct Totals {
+  int64_t unloads = 0;
+  int64_t busy_minutes = 0;
+  int64_t queue_minutes = 0;
+};
+
+// The three metrics of totals over length minutes: station utilization
+// (percent), queueing time per unload and unloads per hour
+std::array<double, 3> Values(const Totals& totals, double length,
+                             size_t num_stations) {
+  const double unloads = static_cast<double>(totals.unloads);
+  return {
+      100.0 * static_cast<double>(totals.busy_minutes) /
+          (static_cast<double>(num_stations) * length),
+      totals.unloads > 0
+          ? static_cast<double>(totals.queue_minutes) / unloads
+          : 0.0,
+      unloads * 60.0 / length,
+  };
+}
+
+// MSER cutoff of values: the truncation d <= n / 2 minimizing the squared
+// standard error of the mean of what is left, sum((z - mean)^2) / (n - d)^2
+size_t MserCutoff(const std::vector<double>& values) {
+  const size_t n = values.size();
+  if (n == 0) return 0;
+  double sum = 0.0;
+  double sum_squares = 0.0;
+  for (size_t i = n / 2 + 1; i < n; ++i) {
+    sum += values[i];
+    sum_squares += values[i] * values[i];
+  }
+  size_t cutoff = 0;
+  double best = std::numeric_limits<double>::infinity();
+  // From the latest truncation down, so ties go to the earliest
+  for (size_t d = n / 2 + 1; d-- > 0;) {
+    sum += values[d];
+    sum_squares += values[d] * values[d];
+    const double kept = static_cast<double>(n - d);
+    const double statistic =
+        std::max(sum_squares - sum * sum / kept, 0.0) / (kept * kept);
+    if (statistic <= best) {
+      best = statistic;
+      cutoff = d;
+    }
+  }
+  return cutoff;
+}
+
+json MetricToJson(const SteadyStateMetric& metric) {
+  return {{"whole_run", metric.whole_run},
+          {"steady_state", metric.mean},
+          {"ci95_half_width", std::isfinite(metric.half_width)
+                                  ? json(metric.half_width)
+                                  : json(nullptr)}};
+}
+
+void PrintMetric(const char* name, const SteadyStateMetric& metric,
+                 const char* unit) {
+  std::cout << name << ": " << metric.mean;
+  if (std::isfinite(metric.half_width)) {
+    std::cout << " +/- " << metric.half_width;
+  }
+  std::cout << unit << " (whole run " << metric.whole_run << unit << ")\n";
+}
+
+}  // namespace
+
+void SteadyStateMonitor::Reset(const SteadyStateOptions& options,
+                               minutes_t sim_time, size_t num_stations) {
+  if (options.interval < 0min || options.num_batches < 2) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Steady-state monitoring needs a positive interval and at least two "
+        "batches");
+  }
+  options_ = options;
+  num_stations_ = num_stations;
+  observations_.clear();
+  if (enabled()) {
+    observations_.resize(static_cast<size_t>(
+        (sim_time.count() + options_.interval.count() - 1) /
+        options_.interval.count()));
+  }
+  result_ = {};
+}
+
+bool SteadyStateMonitor::Update(minutes_t time) {
+  result_ = {};
+  result_.end = time;
+  if (!enabled() || time <= 0min || num_stations_ == 0) return false;
+
+  // Whole run: every unload added so far ended by time
+  Totals whole;
+  for (const Observation& o : observations_) {
+    whole.unloads += o.unloads;
+    whole.busy_minutes += o.busy_minutes;
+    whole.queue_minutes += o.queue_minutes;
+  }
+  const std::array<double, 3> whole_values =
+      Values(whole, static_cast<double>(time.count()), num_stations_);
+  SteadyStateMetric* metrics[] = {&result_.station_utilization,
+                                  &result_.avg_queueing_time,
+                                  &result_.throughput};
+  for (size_t m = 0; m < 3; ++m) {
+    metrics[m]->whole_run = whole_values[m];
+    metrics[m]->half_width = std::numeric_limits<double>::infinity();
+  }
+
+  // MSER-5 on the complete groups of kMserBatch intervals
+  const size_t num_groups = std::min(
+      static_cast<size_t>(time / options_.interval), observations_.size()) /
+      kMserBatch;
+  const double group_length =
+      static_cast<double>((options_.interval * kMserBatch).count());
+  std::vector<Totals> groups(num_groups);
+  std::array<std::vector<double>, 3> series;
+  for (size_t g = 0; g < num_groups; ++g) {
+    for (size_t i = g * kMserBatch; i < (g + 1) * kMserBatch; ++i) {
+      groups[g].unloads += observations_[i].unloads;
+      groups[g].busy_minutes += observations_[i].busy_minutes;
+      groups[g].queue_minutes += observations_[i].queue_minutes;
+    }
+    const std::array<double, 3> values =
+        Values(groups[g], group_length, num_stations_);
+    for (size_t m = 0; m < 3; ++m) series[m].push_back(values[m]);
+  }
+  size_t cutoff = 0;
+  for (size_t m = 0; m < 3; ++m) {
+    cutoff = std::max(cutoff, MserCutoff(series[m]));
+  }
+
+  // Batch means of equal length over the groups left
+  const size_t k = options_.num_batches;
+  if (num_groups - cutoff < k) return false;
+  const size_t batch_groups = (num_groups - cutoff) / k;
+  const size_t first = num_groups - batch_groups * k;
+  result_.warmup = options_.interval * (first * kMserBatch);
+  result_.batches = k;
+  result_.batch_observations = batch_groups * kMserBatch;
+
+  std::array<RunningStat, 3> stats;
+  Totals steady;
+  for (size_t b = 0; b < k; ++b) {
+    Totals batch;
+    for (size_t g = first + b * batch_groups;
+         g < first + (b + 1) * batch_groups; ++g) {
+      batch.unloads += groups[g].unloads;
+      batch.busy_minutes += groups[g].busy_minutes;
+      batch.queue_minutes += groups[g].queue_minutes;
+    }
+    steady.unloads += batch.unloads;
+    steady.busy_minutes += batch.busy_minutes;
+    const std::array<double, 3> values = Values(
+        batch, group_length * static_cast<double>(batch_groups),
+        num_stations_);
+    for (size_t m = 0; m < 3; ++m) stats[m].Add(values[m]);
+  }
+  for (size_t m = 0; m < 3; ++m) {
+    metrics[m]->mean = stats[m].mean();
+    metrics[m]->half_width = stats[m].HalfWidth();
+  }
+
+  // The queueing time is judged against the time at a station
+  const double unload_time =
+      steady.unloads > 0 ? static_cast<double>(steady.busy_minutes) /
+                               static_cast<double>(steady.unloads)
+                         : 0.0;
+  const double scales[] = {
+      std::abs(result_.station_utilization.mean),
+      result_.avg_queueing_time.mean + unload_time,
+      std::abs(result_.throughput.mean),
+  };
+  const double precision = options_.relative_precision;
+  result_.converged = precision > 0.0;
+  for (size_t m = 0; m < 3; ++m) {
+    if (metrics[m]->half_width > precision * scales[m]) {
+      result_.converged = false;
+    }
+  }
+  return result_.converged;
+}
+
+void PrintSteadyStateSummary(const SteadyStateResult& result) {
+  std::cout << "\n=== Steady State (batch means) ===\n" << std::fixed
+            << std::setprecision(2);
+  if (result.batches == 0) {
+    std::cout << "Not estimated: the " << result.end.count()
+              << " minutes observed leave too few intervals after the "
+                 "warm-up\n";
+    return;
+  }
+  std::cout << "Warm-up: " << result.warmup.count() << " minutes\n"
+            << "Observed: " << result.end.count() << " minutes, "
+            << result.batches << " batches of " << result.batch_observations
+            << " intervals ("
+            << (result.converged ? "converged" : "not converged") << ")\n";
+  PrintMetric("Station Utilization", result.station_utilization, "%");
+  PrintMetric("Average Queueing Time", result.avg_queueing_time,
+              " minutes per unload");
+  PrintMetric("Throughput", result.throughput, " unloads per hour");
+}
+
+std::string ExportSteadyStateToJson(size_t num_trucks, size_t num_stations,
+                                    const SteadyStateResult& result) {
+  json j;
+  j["simulation_duration"] = result.end.count();
+  j["num_trucks"] = num_trucks;
+  j["num_stations"] = num_stations;
+  j["converged"] = result.converged;
+  j["warmup"] = result.warmup.count();
+  j["batches"] = result.batches;
+  j["batch_observations"] = result.batch_observations;
+  j["station_utilization"] = MetricToJson(result.station_utilization);
+  j["avg_queueing_time"] = MetricToJson(result.avg_queueing_time);
+  j["throughput"] = MetricToJson(result.throughput);
+
+  std::ostringstream os;
+  os << "steadystate." << num_trucks << "truck_" << num_stations
+     << "station_" << result.end << "_minutes.json";
+  std::ofstream out(os.str());
+  out << j.dump(2) << std::endl;
+  return os.str();
+}
@@ -0,0 +1,380 @@
+#include "sweep.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <stdexcept>
+
+#include "controller.h"
+#include "event_sink.h"
+#include "logger.h"
+#include "metrics_store.h"
+#include "report.h"
+#include "thread_pool.h"
+
+using json = nlohmann::json;
+
+namespace {
+size_t ParseCount(const std::string& text, const std::string& spec) {
+  size_t pos = 0;
+  size_t value = 0;
+  try {
+    value = std::stoul(text, &pos);
+  } catch (const std::exception&) {
+    pos = 0;
+  }
+  if (text.empty() || pos != text.size()) {
+    Logger::LogAndThrowError<std::invalid_argument>("Invalid sweep range: " +
+                                                    spec);
+  }
+  return value;
+}
+
+// Fills the fleet-level numbers of a cell from its metrics
+void ReduceMetrics(const MetricsStore& metrics, SweepResult* result) {
+  const MetricsStore::TruckColumns& trucks = metrics.trucks();
+  result->avg_truck_utilization = metrics.AverageTruckUtilization();
+  result->avg_station_utilization = metrics.AverageStationUtilization();
+  result->trips_completed = SumColumn(trucks.trips_completed);
+  result->queues_completed = SumColumn(trucks.queues_completed);
+  result->avg_trip_time =
+      SumColumn(trucks.avg_trip_time) / metrics.num_trucks();
+  result->throughput = SumColumn(metrics.stations().throughput);
+  if (result->queues_completed > 0) {
+    result->avg_queueing_time =
+        static_cast<double>(SumColumn(trucks.queueing_time)) /
+        result->queues_completed;
+  }
+}
+
+// Runs (or estimates) one cell and reduces its metrics to fleet-level
+// numbers
+SweepResult RunCell(size_t num_trucks, size_t num_stations,
+                    minutes_t sim_time, const SweepOptions& options) {
+  const auto start_time = std::chrono::steady_clock::now();
+  SweepResult result;
+  result.num_trucks = num_trucks;
+  result.num_stations = num_stations;
+  result.sim_minutes = sim_time.count();
+
+  if (options.estimate) {
+    std::vector<TruckMetrics> truck_metrics;
+    std::vector<StationMetrics> station_metrics;
+    EstimateMetrics(num_trucks, num_stations, sim_time, &truck_metrics,
+                    &station_metrics);
+    ReduceMetrics(MetricsStore::FromMetrics(truck_metrics, station_metrics),
+                  &result);
+  } else {
+    BasicController<NullEventSink> controller(num_trucks, num_stations,
+                                              options.random_seed);
+    if (options.mining_distribution.has_value()) {
+      controller.SetMiningDistribution(*options.mining_distribution);
+    }
+    controller.Simulate(sim_time);
+    ReduceMetrics(controller.metrics(), &result);
+  }
+
+  result.elapsed_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start_time)
+                          .count();
+  return result;
+}
+
+size_t NumCells(const SweepOptions& options) {
+  return options.trucks.size() * options.stations.size() *
+         options.sim_times.size();
+}
+
+std::vector<int64_t> MinutesToJson(const std::vector<minutes_t>& sim_times) {
+  std::vector<int64_t> minutes;
+  for (minutes_t sim_time : sim_times) minutes.push_back(sim_time.count());
+  return minutes;
+}
+
+json SweepResultToJson(size_t cell, const SweepResult& r) {
+  return {{"index", cell},
+          {"num_trucks", r.num_trucks},
+          {"num_stations", r.num_stations},
+          {"sim_minutes", r.sim_minutes},
+          {"avg_truck_utilization", r.avg_truck_utilization},
+          {"avg_station_utilization", r.avg_station_utilization},
+          {"trips_completed", r.trips_completed},
+          {"throughput", r.throughput},
+          {"queues_completed", r.queues_completed},
+          {"avg_queueing_time", r.avg_queueing_time},
+          {"avg_trip_time", r.avg_trip_time},
+          {"elapsed_ms", r.elapsed_ms}};
+}
+
+SweepResult SweepResultFromJson(const json& j) {
+  SweepResult r;
+  r.num_trucks = j.at("num_trucks");
+  r.num_stations = j.at("num_stations");
+  r.sim_minutes = j.at("sim_minutes");
+  r.avg_truck_utilization = j.at("avg_truck_utilization");
+  r.avg_station_utilization = j.at("avg_station_utilization");
+  r.trips_completed = j.at("trips_completed");
+  r.throughput = j.at("throughput");
+  r.queues_completed = j.at("queues_completed");
+  r.avg_queueing_time = j.at("avg_queueing_time");
+  r.avg_trip_time = j.at("avg_trip_time");
+  r.elapsed_ms = j.at("elapsed_ms");
+  return r;
+}
+}  // namespace
+
+std::vector<size_t> ParseSweepRange(const std::string& spec) {
+  std::vector<size_t> values;
+  std::istringstream list(spec);
+  std::string item;
+  while (std::getline(list, item, ',')) {
+    std::vector<std::string> parts;
+    std::istringstream fields(item);
+    std::string field;
+    while (std::getline(fields, field, ':')) parts.push_back(field);
+    if (parts.empty() || parts.size() > 3) {
+      Logger::LogAndThrowError<std::invalid_argument>("Invalid sweep range: " +
+                                                      spec);
+    }
+
+    const size_t first = ParseCount(parts[0], spec);
+    const size_t last = parts.size() > 1 ? ParseCount(parts[1], spec) : first;
+    const size_t step = parts.size() > 2 ? ParseCount(parts[2], spec) : 1;
+    if (last < first || step == 0) {
+      Logger::LogAndThrowError<std::invalid_argument>("Invalid sweep range: " +
+                                                      spec);
+    }
+    for (size_t value = first; value <= last; value += step) {
+      values.push_back(value);
+      if (last - value < step) break;  // Avoid overflow past SIZE_MAX
+    }
+  }
+  if (values.empty()) {
+    Logger::LogAndThrowError<std::invalid_argument>("Empty sweep range: " +
+                                                    spec);
+  }
+  return values;
+}
+
+// Cells differ in cost by orders of magnitude (it grows with trucks * time),
+// so they are submitted one task each and balanced by work stealing rather
+// than split into equal-sized chunks up front.
+std::vector<SweepResult> RunSweep(const SweepOptions& options) {
+  for (size_t n : options.trucks) {
+    if (n == 0) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Sweep needs at least one truck per cell.");
+    }
+  }
+  for (size_t n : options.stations) {
+    if (n == 0) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Sweep needs at least one station per cell.");
+    }
+  }
+
+  const ShardSpec& shard = options.shard;
+  if (shard.count == 0 || shard.index >= shard.count) {
+    Logger::LogAndThrowError<std::invalid_argument>("Invalid sweep shard " +
+                                                    shard.Suffix());
+  }
+
+  std::vector<SweepResult> results(shard.NumItems(NumCells(options)));
+  WorkStealingPool pool(options.num_threads);
+  size_t cell = 0;
+  size_t index = 0;
+  for (size_t trucks : options.trucks) {
+    for (size_t stations : options.stations) {
+      for (minutes_t sim_time : options.sim_times) {
+        if (!shard.Owns(cell++)) continue;
+        SweepResult* result = &results[index++];
+        pool.Submit([=, &options] {
+          *result = RunCell(trucks, stations, sim_time, options);
+        });
+      }
+    }
+  }
+  pool.Wait();
+  return results;
+}
+
+void WriteSweepCsv(const std::string& filename,
+                   const std::vector<SweepResult>& results) {
+  std::ofstream out(filename);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open sweep table for writing: " +
+                             filename);
+  }
+  out << "num_trucks,num_stations,sim_minutes,avg_truck_utilization,"
+         "avg_station_utilization,trips_completed,throughput,"
+         "queues_completed,avg_queueing_time,avg_trip_time,elapsed_ms\n";
+  out << std::setprecision(10);
+  for (const auto& r : results) {
+    out << r.num_trucks << ',' << r.num_stations << ',' << r.sim_minutes
+        << ',' << r.avg_truck_utilization << ',' << r.avg_station_utilization
+        << ',' << r.trips_completed << ',' << r.throughput << ','
+        << r.queues_completed << ',' << r.avg_queueing_time << ','
+        << r.avg_trip_time << ',' << r.elapsed_ms << '\n';
+  }
+}
+
+void WriteSweepBinary(const std::string& filename,
+                      const std::vector<SweepResult>& results) {
+  std::ofstream out(filename, std::ios::binary);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open sweep table for writing: " +
+                             filename);
+  }
+  SweepTableHeader header{};
+  std::memcpy(header.magic, kSweepTableMagic, sizeof(header.magic));
+  header.version = kSweepTableVersion;
+  header.record_size = sizeof(SweepResult);
+  header.count = results.size();
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(results.data()),
+            results.size() * sizeof(SweepResult));
+}
+
+std::vector<SweepResult> ReadSweepBinary(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in.is_open()) {
+    Logger::LogAndThrowError("Unable to open sweep table for reading: " +
+                             filename);
+  }
+  SweepTableHeader header{};
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kSweepTableMagic, sizeof(header.magic)) != 0) {
+    Logger::LogAndThrowError("Not a binary sweep table: " + filename);
+  }
+  if (header.version != kSweepTableVersion ||
+      header.record_size != sizeof(SweepResult)) {
+    Logger::LogAndThrowError("Unsupported sweep table version in " +
+                             filename);
+  }
+
+  std::vector<SweepResult> results(header.count);
+  if (!in.read(reinterpret_cast<char*>(results.data()),
+               results.size() * sizeof(SweepResult))) {
+    Logger::LogAndThrowError("Truncated sweep table: " + filename);
+  }
+  return results;
+}
+
+void WriteSweepShard(const std::string& filename, const SweepOptions& options,
+                     const std::vector<SweepResult>& results) {
+  const ShardSpec& shard = options.shard;
+  if (results.size() != shard.NumItems(NumCells(options))) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Sweep results do not match shard " + shard.Suffix());
+  }
+  json j;
+  j["kind"] = "sweep";
+  j["version"] = kShardFileVersion;
+  j["shard"] = shard.index + 1;
+  j["shards"] = shard.count;
+  j["trucks"] = options.trucks;
+  j["stations"] = options.stations;
+  j["sim_minutes"] = MinutesToJson(options.sim_times);
+  j["random_seed"] = options.random_seed;
+  j["estimate"] = options.estimate;
+  j["mining_distribution"] = options.mining_distribution.has_value()
+                                 ? options.mining_distribution->Describe()
+                                 : "";
+  json cells = json::array();
+  for (size_t i = 0; i < results.size(); ++i) {
+    cells.push_back(SweepResultToJson(shard.index + i * shard.count,
+                                      results[i]));
+  }
+  j["cells"] = std::move(cells);
+
+  std::ofstream out(filename);
+  if (!out.is_open()) {
+    Logger::LogAndThrowError("Unable to open shard file for writing: " +
+                             filename);
+  }
+  out << j.dump() << std::endl;
+}
+
+SweepShard ReadSweepShard(const std::string& filename) {
+  if (ReadShardKind(filename) != "sweep") {
+    Logger::LogAndThrowError("Not a partial sweep: " + filename);
+  }
+  std::ifstream in(filename);
+  SweepShard shard;
+  try {
+    const json j = json::parse(in);
+    SweepOptions& options = shard.options;
+    options.shard.index = j.at("shard").get<size_t>() - 1;
+    options.shard.count = j.at("shards").get<size_t>();
+    if (options.shard.index >= options.shard.count) {
+      throw std::runtime_error("shard " + options.shard.Suffix());
+    }
+    options.trucks = j.at("trucks").get<std::vector<size_t>>();
+    options.stations = j.at("stations").get<std::vector<size_t>>();
+    for (int64_t minutes : j.at("sim_minutes").get<std::vector<int64_t>>()) {
+      options.sim_times.push_back(minutes_t(minutes));
+    }
+    options.random_seed = j.at("random_seed");
+    options.estimate = j.at("estimate");
+    shard.mining_distribution = j.at("mining_distribution");
+    for (const json& cell : j.at("cells")) {
+      const size_t index = cell.at("index");
+      if (index >= NumCells(options) || !options.shard.Owns(index)) {
+        throw std::runtime_error("cell " + std::to_string(index) +
+                                 " is not the shard's");
+      }
+      shard.cells.push_back(index);
+      shard.results.push_back(SweepResultFromJson(cell));
+    }
+  } catch (const std::exception& e) {
+    Logger::LogAndThrowError("Malformed partial sweep " + filename + ": " +
+                             e.what());
+  }
+  return shard;
+}
+
+std::vector<SweepResult> MergeSweepShards(const std::vector<SweepShard>& shards,
+                                          SweepOptions* options) {
+  if (shards.empty()) {
+    Logger::LogAndThrowError<std::invalid_argument>("No shards to merge");
+  }
+  const SweepShard& first = shards.front();
+  const SweepOptions& grid = first.options;
+  std::vector<bool> seen(grid.shard.count);
+  for (const SweepShard& shard : shards) {
+    const SweepOptions& o = shard.options;
+    if (o.trucks != grid.trucks || o.stations != grid.stations ||
+        o.sim_times != grid.sim_times || o.random_seed != grid.random_seed ||
+        o.estimate != grid.estimate || o.shard.count != grid.shard.count ||
+        shard.mining_distribution != first.mining_distribution) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Shard " + o.shard.Suffix() + " is of another sweep than shard " +
+          grid.shard.Suffix());
+    }
+    if (seen[o.shard.index]) {
+      Logger::LogAndThrowError<std::invalid_argument>(
+          "Shard " + o.shard.Suffix() + " is given twice");
+    }
+    seen[o.shard.index] = true;
+  }
+
+  // Cells by grid index, so the table is in grid order
+  std::vector<const SweepResult*> cells(NumCells(grid));
+  for (const SweepShard& shard : shards) {
+    for (size_t i = 0; i < shard.cells.size(); ++i) {
+      cells[shard.cells[i]] = &shard.results[i];
+    }
+  }
+  std::vector<SweepResult> results;
+  for (const SweepResult* cell : cells) {
+    if (cell != nullptr) results.push_back(*cell);
+  }
+
+  *options = grid;
+  options->shard = {};
+  return results;
+}
@@ -0,0 +1,106 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+// Identifies the pool worker running on this thread, if any
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  queues_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+// Finishes the queued tasks, then stops the workers
+WorkStealingPool::~WorkStealingPool() {
+  Wait();
+  done_ = true;
+  queued_.fetch_add(1);  // Any non-zero value wakes the sleeping workers
+  queued_.notify_all();
+  for (auto& t : threads_) t.join();
+}
+
+void WorkStealingPool::Submit(Task task) {
+  const size_t index = current_pool == this
+                           ? current_worker
+                           : next_queue_.fetch_add(1) % queues_.size();
+  // Counted before it is pushed, so a worker can never take a task that
+  // queued_ does not yet include
+  unfinished_.fetch_add(1);
+  queued_.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  queued_.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+  size_t unfinished = unfinished_.load();
+  while (unfinished != 0) {
+    unfinished_.wait(unfinished);
+    unfinished = unfinished_.load();
+  }
+
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+std::optional<WorkStealingPool::Task> WorkStealingPool::TakeTask(
+    size_t index) {
+  {
+    WorkerQueue& own = *queues_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      Task task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return task;
+    }
+  }
+  for (size_t offset = 1; offset < queues_.size(); ++offset) {
+    WorkerQueue& victim = *queues_[(index + offset) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      Task task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return task;
+    }
+  }
+  return std::nullopt;
+}
+
+// Runs tasks until the pool is destroyed, sleeping while all deques are empty
+void WorkStealingPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  current_worker = index;
+  while (!done_.load()) {
+    std::optional<Task> task = TakeTask(index);
+    if (!task) {
+      // Returns at once if a task was submitted since the scan (or is being
+      // pushed right now), in which case the scan is retried
+      queued_.wait(0);
+      continue;
+    }
+    queued_.fetch_sub(1);
+
+    try {
+      (*task)();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      if (!error_) error_ = std::current_exception();
+    }
+    if (unfinished_.fetch_sub(1) == 1) unfinished_.notify_all();
+  }
+}
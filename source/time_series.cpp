@@ -0,0 +1,152 @@
+#include "time_series.h"
+
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <stdexcept>
+
+#include "logger.h"
+
+using json = nlohmann::json;
+
+void TimeSeries::Reset(minutes_t interval, minutes_t sim_time,
+                       size_t num_stations) {
+  interval_ = std::max(interval, 0min);
+  sim_time_ = sim_time;
+  num_stations_ = num_stations;
+  num_bins_ = 0;
+  if (enabled() && sim_time > 0min) {
+    num_bins_ = static_cast<size_t>((sim_time.count() + interval_.count() - 1) /
+                                    interval_.count());
+  }
+  truck_minutes_.assign(num_bins_ * kNumTruckStates, 0);
+  busy_minutes_.assign(num_bins_ * num_stations_, 0);
+  queue_minutes_.assign(num_bins_ * num_stations_, 0);
+}
+
+void TimeSeries::Truncate(minutes_t sim_time) {
+  if (sim_time >= sim_time_) return;
+  sim_time_ = std::max(sim_time, 0min);
+  num_bins_ = 0;
+  if (enabled() && sim_time_ > 0min) {
+    num_bins_ = static_cast<size_t>(
+        (sim_time_.count() + interval_.count() - 1) / interval_.count());
+  }
+  truck_minutes_.resize(num_bins_ * kNumTruckStates);
+  busy_minutes_.resize(num_bins_ * num_stations_);
+  queue_minutes_.resize(num_bins_ * num_stations_);
+}
+
+minutes_t TimeSeries::BinLength(size_t bin) const {
+  return std::min(interval_, sim_time_ - interval_ * static_cast<int64_t>(bin));
+}
+
+void TimeSeries::AddTruckSpan(TruckState state, minutes_t start,
+                              minutes_t end) {
+  Spread(&truck_minutes_, kNumTruckStates, static_cast<size_t>(state), start,
+         end);
+}
+
+void TimeSeries::AddStationBusy(size_t station_id, minutes_t start,
+                                minutes_t end) {
+  Spread(&busy_minutes_, num_stations_, station_id, start, end);
+}
+
+void TimeSeries::AddStationQueue(size_t station_id, minutes_t start,
+                                 minutes_t end) {
+  Spread(&queue_minutes_, num_stations_, station_id, start, end);
+}
+
+void TimeSeries::AddTruckMinutes(const TimeSeries& other) {
+  for (size_t i = 0; i < truck_minutes_.size(); ++i) {
+    truck_minutes_[i] += other.truck_minutes_[i];
+  }
+}
+
+void TimeSeries::AddBins(const std::vector<int64_t>& truck_minutes,
+                         const std::vector<int64_t>& busy_minutes,
+                         const std::vector<int64_t>& queue_minutes) {
+  const size_t bins = truck_minutes.size() / kNumTruckStates;
+  if (bins > num_bins_ || truck_minutes.size() != bins * kNumTruckStates ||
+      busy_minutes.size() != bins * num_stations_ ||
+      queue_minutes.size() != bins * num_stations_) {
+    Logger::LogAndThrowError<std::invalid_argument>(
+        "Time series bins do not fit: " + std::to_string(bins) + " bins for " +
+        std::to_string(num_stations_) + " stations");
+  }
+  // Row-major by bin, so the bins added are a prefix of each array
+  for (size_t i = 0; i < truck_minutes.size(); ++i) {
+    truck_minutes_[i] += truck_minutes[i];
+  }
+  for (size_t i = 0; i < busy_minutes.size(); ++i) {
+    busy_minutes_[i] += busy_minutes[i];
+    queue_minutes_[i] += queue_minutes[i];
+  }
+}
+
+// Spans are at most a few bins long (mining is the longest), so walking the
+// overlapped bins is cheaper than keeping per-minute difference arrays
+void TimeSeries::Spread(std::vector<int64_t>* values, size_t stride,
+                        size_t offset, minutes_t start, minutes_t end) {
+  if (!enabled()) return;
+  start = std::max(start, 0min);
+  end = std::min(end, sim_time_);
+  while (start < end) {
+    const size_t bin = static_cast<size_t>(start / interval_);
+    const minutes_t bin_end =
+        std::min(interval_ * static_cast<int64_t>(bin + 1), end);
+    (*values)[bin * stride + offset] += (bin_end - start).count();
+    start = bin_end;
+  }
+}
+
+std::string ExportTimeSeriesToJson(size_t num_trucks,
+                                   const TimeSeries& series) {
+  const size_t bins = series.num_bins();
+  json j;
+  j["interval"] = series.interval().count();
+  j["simulation_duration"] = series.sim_time().count();
+  j["num_trucks"] = num_trucks;
+  j["num_stations"] = series.num_stations();
+
+  std::vector<int64_t> bin_minutes(bins);
+  std::vector<int64_t> mining(bins), traveling(bins), queueing(bins);
+  std::vector<int64_t> unloading(bins), idle(bins);
+  for (size_t b = 0; b < bins; ++b) {
+    bin_minutes[b] = series.BinLength(b).count();
+    mining[b] = series.TruckMinutes(b, TruckState::Mining);
+    traveling[b] = series.TruckMinutes(b, TruckState::Traveling);
+    queueing[b] = series.TruckMinutes(b, TruckState::Queueing);
+    unloading[b] = series.TruckMinutes(b, TruckState::Unloading);
+    idle[b] = static_cast<int64_t>(num_trucks) * bin_minutes[b] - mining[b] -
+              traveling[b] - queueing[b] - unloading[b];
+  }
+  j["bin_minutes"] = bin_minutes;
+  j["trucks"] = {
+      {"mining", mining},
+      {"traveling", traveling},
+      {"queueing", queueing},
+      {"unloading", unloading},
+      {"idle", idle},
+  };
+
+  j["stations"] = json::array();
+  std::vector<int64_t> busy(bins), queue(bins);
+  for (size_t s = 0; s < series.num_stations(); ++s) {
+    for (size_t b = 0; b < bins; ++b) {
+      busy[b] = series.BusyMinutes(b, s);
+      queue[b] = series.QueueMinutes(b, s);
+    }
+    j["stations"].push_back({{"id", s}, {"busy", busy}, {"queue", queue}});
+  }
+
+  std::ostringstream os;
+  os << "timeseries." << num_trucks << "truck_" << series.num_stations()
+     << "station_" << series.sim_time() << "_minutes.json";
+
+  // Compact (no indentation): the arrays dominate the size of the file
+  std::ofstream out(os.str());
+  out << j.dump() << std::endl;
+  return os.str();
+}
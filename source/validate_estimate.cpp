@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "sweep.h"
+
+void PrintUsage(const char* program_name) {
+  std::cerr << "Usage: " << program_name
+            << " [options] <trucks> <stations> [sim_minutes]\n"
+            << "  Simulates and estimates every configuration of the grid "
+               "and reports the\n"
+            << "  estimate's error. Arguments take the same ranges as "
+               "sweep.\n"
+            << "Options:\n"
+            << "  --threads=<n>      Worker threads (default: all cores)\n"
+            << "  --output=<file>    Also write the per-configuration errors "
+               "as CSV\n";
+}
+
+// Mean and worst absolute error of one column over the grid
+struct ErrorSummary {
+  double sum = 0.0;
+  double max = 0.0;
+  size_t count = 0;
+
+  void Add(double error) {
+    sum += std::abs(error);
+    max = std::max(max, std::abs(error));
+    ++count;
+  }
+  double mean() const { return count > 0 ? sum / count : 0.0; }
+};
+
+int main(int argc, char** argv) {
+  std::vector<std::string> args;
+  std::string output;
+  SweepOptions options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--threads=", 0) == 0) {
+      try {
+        options.num_threads = std::stoul(arg.substr(10));
+      } catch (const std::exception&) {
+        std::cerr << "Error: Invalid value in " << arg << "\n";
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    } else if (arg.rfind("--output=", 0) == 0) {
+      output = arg.substr(9);
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Error: Unknown option " << arg << "\n";
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (args.size() < 2 || args.size() > 3) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<SweepResult> simulated;
+  std::vector<SweepResult> estimated;
+  try {
+    options.trucks = ParseSweepRange(args[0]);
+    options.stations = ParseSweepRange(args[1]);
+    for (size_t minutes : ParseSweepRange(args.size() > 2 ? args[2] : "4320")) {
+      options.sim_times.push_back(minutes_t(minutes));
+    }
+    simulated = RunSweep(options);
+    options.estimate = true;
+    estimated = RunSweep(options);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream csv;
+  if (!output.empty()) {
+    csv.open(output);
+    csv << "num_trucks,num_stations,sim_minutes,"
+           "truck_utilization_error,station_utilization_error,"
+           "throughput_error,avg_queueing_time_error\n";
+  }
+
+  // Utilization errors are in percentage points, throughput relative (%),
+  // queueing time in minutes per queueing truck
+  ErrorSummary truck_utilization;
+  ErrorSummary station_utilization;
+  ErrorSummary throughput;
+  ErrorSummary queueing_time;
+  double simulate_ms = 0.0;
+  double estimate_ms = 0.0;
+  for (size_t i = 0; i < simulated.size(); ++i) {
+    const SweepResult& sim = simulated[i];
+    const SweepResult& est = estimated[i];
+    const double truck_error =
+        est.avg_truck_utilization - sim.avg_truck_utilization;
+    const double station_error =
+        est.avg_station_utilization - sim.avg_station_utilization;
+    const double throughput_error =
+        sim.throughput > 0 ? (static_cast<double>(est.throughput) -
+                              static_cast<double>(sim.throughput)) /
+                                 static_cast<double>(sim.throughput) * 100.0
+                           : 0.0;
+    const double queueing_error =
+        est.avg_queueing_time - sim.avg_queueing_time;
+
+    truck_utilization.Add(truck_error);
+    station_utilization.Add(station_error);
+    throughput.Add(throughput_error);
+    queueing_time.Add(queueing_error);
+    simulate_ms += sim.elapsed_ms;
+    estimate_ms += est.elapsed_ms;
+
+    if (csv.is_open()) {
+      csv << sim.num_trucks << ',' << sim.num_stations << ','
+          << sim.sim_minutes << ',' << truck_error << ',' << station_error
+          << ',' << throughput_error << ',' << queueing_error << '\n';
+    }
+  }
+
+  std::cout << "\n=== Estimate vs. Simulation (" << simulated.size()
+            << " configurations) ===\n"
+            << std::fixed << std::setprecision(2)
+            << "                          mean |err|   max |err|\n"
+            << "Truck Utilization (pp)    " << std::setw(9)
+            << truck_utilization.mean() << "   " << std::setw(9)
+            << truck_utilization.max << "\n"
+            << "Station Utilization (pp)  " << std::setw(9)
+            << station_utilization.mean() << "   " << std::setw(9)
+            << station_utilization.max << "\n"
+            << "Throughput (%)            " << std::setw(9)
+            << throughput.mean() << "   " << std::setw(9) << throughput.max
+            << "\n"
+            << "Avg Queueing Time (min)   " << std::setw(9)
+            << queueing_time.mean() << "   " << std::setw(9)
+            << queueing_time.max << "\n"
+            << "\nSimulation: " << simulate_ms << " ms, estimate: "
+            << estimate_ms << " ms (summed over configurations)\n";
+  if (csv.is_open()) {
+    std::cout << "Per-configuration errors: " << output << "\n";
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include "analyze.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <vector>
+
+#include "controller.h"
+#include "event_sink.h"
+
+namespace {
+
+void ExpectSameSummary(const EventLogSummary& lhs,
+                       const EventLogSummary& rhs) {
+  EXPECT_EQ(lhs.num_events, rhs.num_events);
+  EXPECT_EQ(lhs.duration, rhs.duration);
+  ASSERT_EQ(lhs.trucks.size(), rhs.trucks.size());
+  for (size_t i = 0; i < lhs.trucks.size(); ++i) {
+    EXPECT_EQ(lhs.trucks[i].mine, rhs.trucks[i].mine);
+    EXPECT_EQ(lhs.trucks[i].travel, rhs.trucks[i].travel);
+    EXPECT_EQ(lhs.trucks[i].queue, rhs.trucks[i].queue);
+    EXPECT_EQ(lhs.trucks[i].unload, rhs.trucks[i].unload);
+    EXPECT_EQ(lhs.trucks[i].trips_completed, rhs.trucks[i].trips_completed);
+  }
+  ASSERT_EQ(lhs.stations.size(), rhs.stations.size());
+  for (size_t i = 0; i < lhs.stations.size(); ++i) {
+    EXPECT_EQ(lhs.stations[i].unload, rhs.stations[i].unload);
+    EXPECT_EQ(lhs.stations[i].unload_count, rhs.stations[i].unload_count);
+  }
+}
+
+}  // namespace
+
+TEST(TestAnalyze, ParsesEventLines) {
+  EventRecord record;
+  ASSERT_TRUE(ParseEventRecord(
+      EventToJsonLine({EventType::Unload, 4, 2, 150min, 157min}), &record));
+  EXPECT_EQ(record.type, static_cast<uint32_t>(EventType::Unload));
+  EXPECT_EQ(record.truck_id, 4u);
+  EXPECT_EQ(record.station_id, 2u);
+  EXPECT_EQ(record.start_time, 150u);
+  EXPECT_EQ(record.end_time, 157u);
+
+  // Key order and whitespace do not matter
+  ASSERT_TRUE(ParseEventRecord(
+      R"( { "type": "Mine", "truck_id": 1, "station_id": null,)"
+      R"( "start_time": 0, "end_time": 90 } )",
+      &record));
+  EXPECT_EQ(record.type, static_cast<uint32_t>(EventType::Mine));
+  EXPECT_EQ(record.station_id, kNoStation);
+  EXPECT_EQ(record.end_time, 90u);
+
+  EXPECT_FALSE(ParseEventRecord("", &record));
+  EXPECT_FALSE(ParseEventRecord(R"({"type":"Mine","truck_id":1)", &record));
+  EXPECT_FALSE(ParseEventRecord(
+      R"({"type":"Dig","truck_id":1,"start_time":0,"end_time":1})", &record));
+  EXPECT_FALSE(ParseEventRecord(
+      R"({"type":"Mine","truck_id":-1,"start_time":0,"end_time":1})",
+      &record));
+  EXPECT_FALSE(ParseEventRecord(R"({"type":"Mine","start_time":0})", &record));
+}
+
+// The parallel summary of a multi-chunk log, in either format, matches the
+// events summed one by one and the simulation's own metrics
+TEST(TestAnalyze, SummaryMatchesRun) {
+  BasicController<VectorEventSink> controller(300, 4);
+  controller.Simulate(10 * 24 * 60min);
+  const std::vector<Event>& events = controller.sink().events();
+
+  EventLogSummary expected;
+  {
+    std::ofstream jsonl("analyze.test.jsonl", std::ios::trunc);
+    std::ofstream binary("analyze.test.bin", std::ios::binary);
+    const EventLogHeader header =
+        MakeHeader(controller.sink().params());
+    binary.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& event : events) {
+      const EventRecord record = ToRecord(event);
+      expected.Add(record);
+      jsonl << EventToJsonLine(event) << "\n";
+      binary.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    jsonl << "not json\n\n";  // Skipped, like plot_report.py does
+  }
+
+  const EventLogSummary from_jsonl = AnalyzeEventLog("analyze.test.jsonl", 4);
+  ExpectSameSummary(from_jsonl, expected);
+  EXPECT_EQ(from_jsonl.skipped_lines, 1u);
+
+  const EventLogSummary from_binary = AnalyzeEventLog("analyze.test.bin", 4);
+  ExpectSameSummary(from_binary, expected);
+  EXPECT_EQ(from_binary.skipped_lines, 0u);
+
+  ASSERT_EQ(expected.trucks.size(), controller.truck_metrics().size());
+  for (size_t i = 0; i < expected.trucks.size(); ++i) {
+    const TruckMetrics& metrics = controller.truck_metrics()[i];
+    EXPECT_EQ(expected.trucks[i].mine, metrics.mining_time);
+    EXPECT_EQ(expected.trucks[i].queue, metrics.queueing_time);
+    EXPECT_EQ(expected.trucks[i].unload, metrics.unloading_time);
+  }
+}
@@ -0,0 +1,205 @@
+#include "checkpoint.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "controller.h"
+
+namespace {
+
+auto Key(const Event& event) {
+  return std::make_tuple(event.end_time, event.truck_id, event.type,
+                         event.start_time, event.station_id);
+}
+
+void ExpectSameEvents(const std::vector<Event>& actual,
+                      const std::vector<Event>& expected) {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_EQ(Key(actual[i]), Key(expected[i])) << "event " << i;
+  }
+}
+
+template <typename Controller>
+void ExpectSameResults(const Controller& actual, const Controller& expected) {
+  const auto& trucks = actual.metrics().trucks();
+  const auto& expected_trucks = expected.metrics().trucks();
+  EXPECT_EQ(trucks.mining_time, expected_trucks.mining_time);
+  EXPECT_EQ(trucks.travel_time, expected_trucks.travel_time);
+  EXPECT_EQ(trucks.queueing_time, expected_trucks.queueing_time);
+  EXPECT_EQ(trucks.unloading_time, expected_trucks.unloading_time);
+  EXPECT_EQ(trucks.trips_completed, expected_trucks.trips_completed);
+  EXPECT_EQ(trucks.utilization, expected_trucks.utilization);
+  const auto& stations = actual.metrics().stations();
+  const auto& expected_stations = expected.metrics().stations();
+  EXPECT_EQ(stations.unloading_time, expected_stations.unloading_time);
+  EXPECT_EQ(stations.queueing_time, expected_stations.queueing_time);
+  EXPECT_EQ(stations.throughput, expected_stations.throughput);
+
+  const TimeSeries& series = actual.time_series();
+  const TimeSeries& expected_series = expected.time_series();
+  EXPECT_EQ(series.interval(), expected_series.interval());
+  EXPECT_EQ(series.truck_minutes(), expected_series.truck_minutes());
+  EXPECT_EQ(series.busy_minutes(), expected_series.busy_minutes());
+  EXPECT_EQ(series.queue_minutes(), expected_series.queue_minutes());
+}
+
+}  // namespace
+
+// Extending a finished run from its final checkpoint gives the results of
+// the longer run; resuming that with the same length changes nothing
+template <typename Scheduler>
+void ExpectExtensionMatchesLongerRun() {
+  using TestController = BasicController<NullEventSink, Scheduler>;
+  const std::string filename = "extend_run.ckpt";
+  const std::string extended_filename = "extend_run_extended.ckpt";
+
+  TestController full(300, 5);
+  full.SetTimeSeriesInterval(60min);
+  full.Simulate(72 * 60min);
+
+  TestController first(300, 5);
+  first.SetTimeSeriesInterval(60min);
+  first.SetCheckpointInterval(1000min, filename);
+  first.Simulate(2500min);
+  const Checkpoint checkpoint = ReadCheckpoint(filename);
+  EXPECT_EQ(checkpoint.time, 2500min);
+  EXPECT_TRUE(checkpoint.pending.empty());
+  EXPECT_FALSE(checkpoint.deferred.empty());
+
+  TestController extended(300, 5);
+  extended.SetCheckpointInterval(1000min, extended_filename);
+  extended.LoadCheckpoint(filename);
+  extended.Simulate(72 * 60min);
+  ExpectSameResults(extended, full);
+
+  TestController again(300, 5);
+  again.LoadCheckpoint(extended_filename);
+  again.Simulate(72 * 60min);
+  ExpectSameResults(again, full);
+  std::filesystem::remove(filename);
+  std::filesystem::remove(extended_filename);
+}
+
+TEST(TestCheckpoint, ExtensionMatchesLongerRun) {
+  ExpectExtensionMatchesLongerRun<TimingWheelScheduler>();
+}
+
+TEST(TestCheckpoint, ExtensionMatchesLongerRunWithHeap) {
+  ExpectExtensionMatchesLongerRun<BinaryHeapScheduler>();
+}
+
+// A checkpoint written part way through a run, resumed with the same
+// length: the events before it plus the resumed run's are the full log
+TEST(TestCheckpoint, ResumedEventsContinueTheLog) {
+  const std::string filename = "resume_events.ckpt";
+  const std::string kept = "resume_events_kept.ckpt";
+  const minutes_t sim_time = 48 * 60min;
+
+  BasicController<VectorEventSink> full(120, 3);
+  full.SetTimeSeriesInterval(120min);
+  full.Simulate(sim_time);
+
+  // Copies the checkpoint file as soon as an event starts past 1000min,
+  // while it still holds the checkpoint taken at 900min
+  bool copied = false;
+  BasicController<CallbackEventSink> interrupted(
+      120, 3, 0xBEEF, CallbackEventSink([&](const Event& event) {
+        if (!copied && event.start_time > 1000min) {
+          std::filesystem::copy_file(
+              filename, kept,
+              std::filesystem::copy_options::overwrite_existing);
+          copied = true;
+        }
+      }));
+  interrupted.SetTimeSeriesInterval(120min);
+  interrupted.SetCheckpointInterval(300min, filename);
+  interrupted.Simulate(sim_time);
+  ASSERT_TRUE(copied);
+
+  const Checkpoint checkpoint = ReadCheckpoint(kept);
+  EXPECT_EQ(checkpoint.time, 900min);
+  EXPECT_FALSE(checkpoint.pending.empty());
+
+  BasicController<VectorEventSink> resumed(120, 3);
+  resumed.LoadCheckpoint(kept);
+  resumed.Simulate(sim_time);
+  ExpectSameResults(resumed, full);
+
+  const auto& all = full.sink().events();
+  std::vector<Event> events(all.begin(),
+                            all.begin() + checkpoint.events_emitted);
+  events.insert(events.end(), resumed.sink().events().begin(),
+                resumed.sink().events().end());
+  ExpectSameEvents(events, all);
+  std::filesystem::remove(filename);
+  std::filesystem::remove(kept);
+}
+
+// Extending a finished run gives the same events as the longer run; those
+// the shorter run left past its end are emitted when the extension starts
+TEST(TestCheckpoint, ExtendedRunHasSameEvents) {
+  const std::string filename = "extend.ckpt";
+  BasicController<VectorEventSink> full(40, 2);
+  full.SetTimeSeriesInterval(90min);
+  full.Simulate(72 * 60min);
+
+  BasicController<VectorEventSink> first(40, 2);
+  first.SetTimeSeriesInterval(90min);
+  first.Simulate(24 * 60min);
+  WriteCheckpoint(filename, first.SaveCheckpoint());
+
+  BasicController<VectorEventSink> extended(40, 2);
+  extended.LoadCheckpoint(filename);
+  extended.Simulate(72 * 60min);
+  ExpectSameResults(extended, full);
+
+  std::vector<Event> events = first.sink().events();
+  events.insert(events.end(), extended.sink().events().begin(),
+                extended.sink().events().end());
+  std::vector<Event> expected = full.sink().events();
+  const auto by_key = [](const Event& a, const Event& b) {
+    return Key(a) < Key(b);
+  };
+  std::sort(events.begin(), events.end(), by_key);
+  std::sort(expected.begin(), expected.end(), by_key);
+  ExpectSameEvents(events, expected);
+  std::filesystem::remove(filename);
+}
+
+TEST(TestCheckpoint, RejectsOtherRuns) {
+  const std::string filename = "other_run.ckpt";
+  BasicController<NullEventSink> controller(10, 2);
+  controller.Simulate(600min);
+  WriteCheckpoint(filename, controller.SaveCheckpoint());
+
+  BasicController<NullEventSink> other_fleet(11, 2);
+  EXPECT_THROW(other_fleet.LoadCheckpoint("missing.ckpt"), std::runtime_error);
+  EXPECT_THROW(other_fleet.LoadCheckpoint(filename), std::invalid_argument);
+  BasicController<NullEventSink> other_seed(10, 2, 7);
+  EXPECT_THROW(other_seed.LoadCheckpoint(filename), std::invalid_argument);
+  BasicController<NullEventSink> other_mining(10, 2);
+  other_mining.SetMiningDistribution(
+      MiningDistribution::Triangular(60min, 90min, 300min));
+  EXPECT_THROW(other_mining.LoadCheckpoint(filename), std::invalid_argument);
+
+  // Shorter than the saved run
+  BasicController<NullEventSink> shorter(10, 2);
+  shorter.LoadCheckpoint(filename);
+  EXPECT_THROW(shorter.Simulate(300min), std::invalid_argument);
+
+  // Cut short
+  const auto size = std::filesystem::file_size(filename);
+  std::filesystem::resize_file(filename, size - 8);
+  EXPECT_THROW(ReadCheckpoint(filename), std::runtime_error);
+  std::ofstream(filename, std::ios::trunc) << "not a checkpoint";
+  EXPECT_THROW(ReadCheckpoint(filename), std::runtime_error);
+  std::filesystem::remove(filename);
+}
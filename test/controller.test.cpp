@@ -2,7 +2,16 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
 #include "event.h"
+#include "event_index.h"
 #include "logger.h"
 #include "minutes.h"
 
@@ -85,17 +94,12 @@ TEST(TestController, NoTrucksNoEvents) {
 
 // Edge case: No stations available, trucks should mine but never unload
 TEST(TestController, NoStationsHandledGracefully) {
+  GetEventLogger().SetIndexing(true);
   ClearEvents();
   Controller controller(10, 0);
   controller.Run(60min);
-  WaitUntilFlushed();
-  bool saw_unload = false;
-  Event event;
-  while (ReadEvent(&event)) {
-    ASSERT_NE(event.type, EventType::Unload);
-    if (event.type == EventType::Unload) saw_unload = true;
-  }
-  EXPECT_FALSE(saw_unload);
+  EXPECT_TRUE(QueryEvents({.type = EventType::Unload}).empty());
+  GetEventLogger().SetIndexing(false);
 }
 
 // Ensures each truck mines at least once and the simulation makes progress
@@ -146,11 +150,24 @@ TEST_P(TestController_WithParams, UnloadOrderMatchesMiningOrder) {
       unloading_order.push({event.start_time, event});
   }
 
+  // Trucks that finish mining in the same minute unload one after the other
+  // (in scheduling order), so each such group is compared as a set
   while (!mining_order.empty() && !unloading_order.empty()) {
-    ASSERT_EQ(mining_order.top().second.truck_id,
-              unloading_order.top().second.truck_id);
-    mining_order.pop();
-    unloading_order.pop();
+    const minutes_t end_time = mining_order.top().first;
+    std::vector<size_t> mined;
+    std::vector<size_t> unloaded;
+    while (!mining_order.empty() && mining_order.top().first == end_time) {
+      mined.push_back(mining_order.top().second.truck_id);
+      mining_order.pop();
+    }
+    while (unloaded.size() < mined.size() && !unloading_order.empty()) {
+      unloaded.push_back(unloading_order.top().second.truck_id);
+      unloading_order.pop();
+    }
+    if (unloaded.size() < mined.size()) break;  // Past the end of the run
+    std::sort(mined.begin(), mined.end());
+    std::sort(unloaded.begin(), unloaded.end());
+    ASSERT_EQ(mined, unloaded);
   }
 }
 
@@ -199,28 +216,35 @@ TEST_P(TestController_WithParams, NoEventsExceedSimTime) {
   }
 }
 
+// Reads each truck's events and each station's unloads through the index
 TEST(TestController, NoTruckOrStationOverlaps) {
+  const size_t num_trucks = 25;
+  const size_t num_stations = 4;
+  GetEventLogger().SetIndexing(true);
   ClearEvents();
-  Controller controller(/*num_trucks=*/25, /*num_stations=*/4);
+  Controller controller(num_trucks, num_stations);
   controller.Run(48 * 60min);
   WaitUntilFlushed();
+  const EventIndex index(GetEventLogger().filename());
 
   std::unordered_map<size_t, std::vector<std::pair<minutes_t, minutes_t>>>
       truck_events;
   std::unordered_map<size_t, std::vector<std::pair<minutes_t, minutes_t>>>
       station_unloads;
 
-  Event event;
-  while (ReadEvent(&event)) {
-    // Track per-truck events
-    truck_events[event.truck_id].emplace_back(event.start_time, event.end_time);
-
-    // Only track unloads per station
-    if (event.type == EventType::Unload && event.station_id.has_value()) {
-      station_unloads[event.station_id.value()].emplace_back(event.start_time,
-                                                             event.end_time);
+  for (size_t truck = 0; truck < num_trucks; ++truck) {
+    for (const Event& event : index.Query({.truck_id = truck})) {
+      truck_events[truck].emplace_back(event.start_time, event.end_time);
+    }
+  }
+  for (size_t station = 0; station < num_stations; ++station) {
+    for (const Event& event :
+         index.Query({.type = EventType::Unload, .station_id = station})) {
+      station_unloads[station].emplace_back(event.start_time, event.end_time);
     }
   }
+  EXPECT_EQ(truck_events.size(), num_trucks);
+  EXPECT_EQ(station_unloads.size(), num_stations);
 
   // Check each truck's events are sequential (no overlaps)
   for (const auto& [truck_id, intervals] : truck_events) {
@@ -249,4 +273,202 @@ TEST(TestController, NoTruckOrStationOverlaps) {
           << sorted[i].second.count() << "]";
     }
   }
+  GetEventLogger().SetIndexing(false);
+}
+
+// The in-memory sink sees exactly the events written to the event log
+TEST(TestController, VectorSinkMatchesEventLog) {
+  ClearEvents();
+  Controller file_controller(12, 3);
+  file_controller.Run(24 * 60min);
+  WaitUntilFlushed();
+
+  BasicController<VectorEventSink> vector_controller(12, 3);
+  vector_controller.Run(24 * 60min);
+  const auto& events = vector_controller.sink().events();
+  EXPECT_EQ(vector_controller.sink().params().num_trucks, 12);
+
+  size_t i = 0;
+  Event event;
+  while (ReadEvent(&event)) {
+    ASSERT_LT(i, events.size());
+    EXPECT_EQ(event.type, events[i].type);
+    EXPECT_EQ(event.truck_id, events[i].truck_id);
+    EXPECT_EQ(event.station_id, events[i].station_id);
+    EXPECT_EQ(event.start_time, events[i].start_time);
+    EXPECT_EQ(event.end_time, events[i].end_time);
+    ++i;
+  }
+  EXPECT_EQ(i, events.size());
+}
+
+// A sink reused for another run holds only that run's events
+TEST(TestController, VectorSinkKeepsOnlyTheLatestRun) {
+  BasicController<VectorEventSink> reused(12, 3);
+  reused.Simulate(48 * 60min);
+  const size_t first_run_events = reused.sink().events().size();
+  reused.Simulate(24 * 60min);
+
+  BasicController<VectorEventSink> fresh(12, 3);
+  fresh.Simulate(24 * 60min);
+  const auto& events = reused.sink().events();
+  const auto& expected = fresh.sink().events();
+  EXPECT_EQ(reused.sink().params().sim_time, 24 * 60min);
+  EXPECT_LT(events.size(), first_run_events);
+  ASSERT_EQ(events.size(), expected.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(events[i].type, expected[i].type);
+    EXPECT_EQ(events[i].truck_id, expected[i].truck_id);
+    EXPECT_EQ(events[i].start_time, expected[i].start_time);
+    EXPECT_EQ(events[i].end_time, expected[i].end_time);
+  }
+}
+
+// Metrics do not depend on where the events go
+TEST(TestController, NullAndCallbackSinksProduceSameMetrics) {
+  BasicController<VectorEventSink> reference(25, 4);
+  reference.Run(48 * 60min);
+
+  size_t callback_events = 0;
+  BasicController<CallbackEventSink> callback(
+      25, 4, 0xBEEF,
+      CallbackEventSink([&callback_events](const Event&) {
+        ++callback_events;
+      }));
+  callback.Run(48 * 60min);
+
+  BasicController<NullEventSink> null(25, 4);
+  null.Run(48 * 60min);
+
+  EXPECT_EQ(callback_events, reference.sink().events().size());
+  ASSERT_EQ(null.truck_metrics().size(), reference.truck_metrics().size());
+  for (size_t i = 0; i < null.truck_metrics().size(); ++i) {
+    EXPECT_EQ(null.truck_metrics()[i].trips_completed,
+              reference.truck_metrics()[i].trips_completed);
+    EXPECT_EQ(null.truck_metrics()[i].mining_time,
+              reference.truck_metrics()[i].mining_time);
+    EXPECT_EQ(callback.truck_metrics()[i].queueing_time,
+              reference.truck_metrics()[i].queueing_time);
+  }
+  for (size_t i = 0; i < null.station_metrics().size(); ++i) {
+    EXPECT_EQ(null.station_metrics()[i].throughput,
+              reference.station_metrics()[i].throughput);
+  }
+}
+
+// A truck mines for the same durations whatever the station count and fleet
+// size: its draws only depend on the seed, its id and the cycle
+TEST(TestController, MiningDurationsAreCommonAcrossConfigurations) {
+  const auto mining_durations = [](size_t num_trucks, size_t num_stations) {
+    BasicController<VectorEventSink> controller(num_trucks, num_stations);
+    controller.Run(72 * 60min);
+    std::vector<std::vector<minutes_t>> durations(num_trucks);
+    for (const Event& event : controller.sink().events()) {
+      if (event.type == EventType::Mine) {
+        durations[event.truck_id].push_back(event.end_time - event.start_time);
+      }
+    }
+    return durations;
+  };
+
+  const auto reference = mining_durations(20, 1);
+  for (const auto& [num_trucks, num_stations] :
+       {std::pair<size_t, size_t>{20, 5}, {20, 20}, {10, 3}}) {
+    const auto durations = mining_durations(num_trucks, num_stations);
+    for (size_t truck = 0; truck < num_trucks; ++truck) {
+      // Less queueing fits more cycles into the run: compare the common part
+      const size_t cycles =
+          std::min(durations[truck].size(), reference[truck].size());
+      ASSERT_GT(cycles, 0u);
+      EXPECT_TRUE(std::equal(durations[truck].begin(),
+                             durations[truck].begin() + cycles,
+                             reference[truck].begin()))
+          << "truck " << truck;
+    }
+  }
+}
+
+// Engine counters agree with the events the run emitted
+TEST(TestController, StatsCountEmittedEvents) {
+  if constexpr (!kStatsEnabled) GTEST_SKIP() << "Stats compiled out";
+
+  BasicController<VectorEventSink> controller(30, 3);
+  controller.Simulate(24 * 60min);
+  const EngineStats& stats = controller.stats();
+
+  std::array<uint64_t, kNumEventTypes> emitted{};
+  for (const auto& event : controller.sink().events()) {
+    ++emitted[static_cast<size_t>(event.type)];
+  }
+  EXPECT_EQ(stats.events_by_type, emitted);
+
+  // Every scheduled event is dispatched; Queue events never are
+  const uint64_t scheduled = controller.sink().events().size() -
+                             emitted[static_cast<size_t>(EventType::Queue)];
+  EXPECT_EQ(stats.events_processed, scheduled);
+
+  // One draw per Mine, plus the draws whose mining would end past the run
+  EXPECT_GE(stats.random_draws, emitted[static_cast<size_t>(EventType::Mine)]);
+  EXPECT_LE(stats.random_draws,
+            emitted[static_cast<size_t>(EventType::Mine)] + 30);
+  EXPECT_GE(stats.peak_pending_events, 1u);
+  EXPECT_LE(stats.peak_pending_events, 30u);
+  EXPECT_GT(stats.EventsPerSecond(), 0.0);
+}
+
+// The queue high-water mark is the most Queue events open at once
+TEST(TestController, StatsPeakQueuedTrucks) {
+  if constexpr (!kStatsEnabled) GTEST_SKIP() << "Stats compiled out";
+
+  // 200 trucks are more than 2 stations can unload without queues
+  BasicController<VectorEventSink> controller(200, 2);
+  controller.Simulate(24 * 60min);
+  std::vector<std::pair<minutes_t, int>> changes;
+  for (const Event& event : controller.sink().events()) {
+    if (event.type != EventType::Queue) continue;
+    changes.emplace_back(event.start_time, 1);
+    changes.emplace_back(event.end_time, -1);
+  }
+  std::sort(changes.begin(), changes.end());  // Waits end before others start
+  size_t waiting = 0;
+  size_t peak = 0;
+  for (const auto& [time, change] : changes) {
+    waiting += change;
+    peak = std::max(peak, waiting);
+  }
+  EXPECT_GT(peak, 10u);
+  EXPECT_EQ(controller.stats().peak_queued_trucks, peak);
+
+  // Without queueing there is nothing to wait for
+  BasicController<NullEventSink> idle(3, 3);
+  idle.Simulate(24 * 60min);
+  EXPECT_EQ(idle.stats().peak_queued_trucks, 0u);
+}
+
+// The FIFO-of-times queue pops stations in the same order as a min-heap on
+// (time, station) when used the way the controller uses it: arrivals in time
+// order, each taking the next station and releasing it after an unload
+TEST(TestController, StationQueueMatchesHeap) {
+  using Entry = std::pair<minutes_t, size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> heap;
+  StationQueue queue;
+  queue.Initialize(5);
+  for (size_t i = 0; i < 5; ++i) heap.emplace(0min, i);
+
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> gap(0, 2);
+  minutes_t arrival = 0min;
+  for (int i = 0; i < 200000 && !heap.empty(); ++i) {
+    // About as many arrivals as the stations can serve: queues come and go
+    arrival += minutes_t(gap(rng));
+    const auto expected = heap.top();
+    heap.pop();
+    ASSERT_EQ(queue.PopNextAvailable(), expected);
+    ASSERT_EQ(queue.Size(), heap.size());
+    if (i % 50000 == 49999) continue;  // Dropped, like past the end of a run
+    const auto end = std::max(arrival, expected.first) + 5min;
+    queue.MarkAvailable(end, expected.second);
+    heap.emplace(end, expected.second);
+  }
+  EXPECT_THROW(queue.MarkAvailable(0min, 0), std::logic_error);
 }
@@ -0,0 +1,64 @@
+#include "counter_rng.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Known-answer vectors from the Random123 distribution (kat_vectors)
+TEST(TestCounterRng, PhiloxMatchesReferenceVectors) {
+  EXPECT_EQ(Philox4x32::Generate({0, 0, 0, 0}, {0, 0}),
+            (Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                 0x9b00dbd8}));
+  EXPECT_EQ(Philox4x32::Generate(
+                {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                {0xffffffff, 0xffffffff}),
+            (Philox4x32::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6,
+                                 0x6d5451fd}));
+  EXPECT_EQ(Philox4x32::Generate(
+                {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                {0xa4093822, 0x299f31d0}),
+            (Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420,
+                                 0x24126ea1}));
+}
+
+// Draws are addressed, not sequenced: the same (stream, index) gives the
+// same value in any order, and distinct ones are independent
+TEST(TestCounterRng, DrawsDependOnlyOnTheirAddress) {
+  const CounterRng rng(0xBEEF);
+  std::vector<uint32_t> forward;
+  for (uint32_t index = 0; index < 100; ++index) {
+    forward.push_back(rng.UniformInt(3, index, 60, 300));
+  }
+  for (uint32_t index = 100; index-- > 0;) {
+    EXPECT_EQ(rng.UniformInt(3, index, 60, 300), forward[index]);
+  }
+
+  EXPECT_NE(CounterRng(1).UniformInt(0, 0, 0, 0xfffffffe),
+            CounterRng(2).UniformInt(0, 0, 0, 0xfffffffe));
+  EXPECT_NE(rng.UniformInt(0, 0, 0, 0xfffffffe),
+            rng.UniformInt(1, 0, 0, 0xfffffffe));
+  EXPECT_NE(rng.UniformInt(0, 0, 0, 0xfffffffe),
+            rng.UniformInt(0, 1, 0, 0xfffffffe));
+}
+
+// Every value in the range comes up, and nothing outside it
+TEST(TestCounterRng, UniformIntCoversItsRange) {
+  const CounterRng rng(42);
+  std::array<int, 241> counts{};
+  for (uint32_t stream = 0; stream < 1000; ++stream) {
+    for (uint32_t index = 0; index < 100; ++index) {
+      const uint32_t value = rng.UniformInt(stream, index, 60, 300);
+      ASSERT_GE(value, 60u);
+      ASSERT_LE(value, 300u);
+      ++counts[value - 60];
+    }
+  }
+  // 100000 draws over 241 values: about 415 each
+  for (const int count : counts) {
+    EXPECT_GT(count, 300);
+    EXPECT_LT(count, 530);
+  }
+  EXPECT_EQ(rng.UniformInt(7, 7, 5, 5), 5u);
+}
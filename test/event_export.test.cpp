@@ -0,0 +1,227 @@
+#include "event_export.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "event.h"
+#include "event_log.h"
+
+namespace {
+
+std::string ReadFile(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// A run long enough for its log to take several chunks, as a binary, a JSON
+// Lines (with a line that does not parse) and a compressed JSON Lines log
+const std::vector<Event>& WriteLogs() {
+  static const std::vector<Event> events = [] {
+    BasicController<VectorEventSink> controller(4000, 100);
+    controller.Simulate(2000min);
+    std::ofstream binary("export.test.bin", std::ios::binary);
+    const EventLogHeader header = MakeHeader(controller.sink().params());
+    binary.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::string text;
+    for (const Event& event : controller.sink().events()) {
+      const EventRecord record = ToRecord(event);
+      binary.write(reinterpret_cast<const char*>(&record), sizeof(record));
+      text += EventToJsonLine(event) + "\n";
+    }
+    std::ofstream("export.test.jsonl") << text << "not json\n\n";
+    BlockCompressor compressor;
+    std::string block;
+    compressor.Compress(text, &block);
+    std::ofstream("export.test.jsonl.gz", std::ios::binary) << block;
+    return controller.sink().events();
+  }();
+  return events;
+}
+
+EventExportResult Export(const std::string& log, EventExportFormat format,
+                         const std::string& path, size_t threads) {
+  return ExportEventLog(log, {format, path, threads});
+}
+
+template <typename T>
+T ReadAt(const std::string& bytes, size_t position) {
+  T value{};
+  std::memcpy(&value, bytes.data() + position, sizeof(value));
+  return value;
+}
+
+// An Arrow footer Block: offset, metadata_length (4 bytes of padding after
+// it) and body_length
+struct Block {
+  int64_t offset;
+  int32_t metadata_length;
+  int64_t body_length;
+};
+
+// The Blocks of a vector field of the footer table, a FlatBuffer
+std::vector<Block> ReadFooterBlocks(const std::string& footer, uint16_t id) {
+  const size_t table = ReadAt<uint32_t>(footer, 0);
+  const size_t vtable = table - ReadAt<int32_t>(footer, table);
+  if (4 + 2 * id >= ReadAt<uint16_t>(footer, vtable)) return {};
+  const uint16_t field = ReadAt<uint16_t>(footer, vtable + 4 + 2 * id);
+  if (field == 0) return {};
+  const size_t vector =
+      table + field + ReadAt<uint32_t>(footer, table + field);
+  std::vector<Block> blocks(ReadAt<uint32_t>(footer, vector));
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const size_t block = vector + 4 + 24 * i;
+    blocks[i] = {ReadAt<int64_t>(footer, block),
+                 ReadAt<int32_t>(footer, block + 8),
+                 ReadAt<int64_t>(footer, block + 16)};
+  }
+  return blocks;
+}
+
+}  // namespace
+
+// The array holds what EventToJsonLine gives for each event, in log order,
+// whatever the input format and however many threads convert it
+TEST(TestEventExport, JsonArrayHoldsEveryEvent) {
+  const std::vector<Event>& events = WriteLogs();
+  ASSERT_GT(events.size(), 1 << 16);  // Two chunks of a binary log
+  // The JSON Lines log without its last two lines, a line per event
+  const std::string text = ReadFile("export.test.jsonl");
+  std::string expected = "[\n";
+  for (size_t line = 0; line < text.size() - 11;) {
+    const size_t end = text.find('\n', line);
+    if (line > 0) expected += ",\n";
+    expected.append(text, line, end - line);
+    line = end + 1;
+  }
+  expected += "\n]\n";
+
+  for (const char* log :
+       {"export.test.bin", "export.test.jsonl", "export.test.jsonl.gz"}) {
+    const size_t threads = log == std::string("export.test.bin") ? 1 : 4;
+    const EventExportResult result =
+        Export(log, EventExportFormat::Json, "export.json", threads);
+    EXPECT_EQ(result.path, "export.json");
+    EXPECT_EQ(result.num_events, events.size());
+    EXPECT_EQ(result.skipped, log == std::string("export.test.jsonl"));
+    EXPECT_TRUE(ReadFile("export.json") == expected) << log;
+  }
+  std::filesystem::remove("export.json");
+}
+
+TEST(TestEventExport, CsvHasARowPerEvent) {
+  const std::vector<Event>& events = WriteLogs();
+  Export("export.test.jsonl.gz", EventExportFormat::Csv, "export.csv", 4);
+  std::ifstream in("export.csv");
+  std::string line;
+  ASSERT_TRUE(std::getline(in, line));
+  EXPECT_EQ(line, "type,truck_id,station_id,start_time,end_time");
+  size_t rows = 0;
+  while (std::getline(in, line)) {
+    const Event& e = events[rows++];
+    EXPECT_EQ(line, EventTypeToString(e.type) + "," +
+                        std::to_string(e.truck_id) + "," +
+                        (e.station_id ? std::to_string(*e.station_id) : "") +
+                        "," + std::to_string(e.start_time.count()) + "," +
+                        std::to_string(e.end_time.count()));
+    if (HasFailure()) break;
+  }
+  EXPECT_EQ(rows, events.size());
+  std::filesystem::remove("export.csv");
+}
+
+// The Arrow file is framed as the IPC file format requires, and does not
+// depend on the threads (batches follow the chunks of the input, so it does
+// on the input format)
+TEST(TestEventExport, ArrowFileIsDeterministic) {
+  WriteLogs();
+  Export("export.test.bin", EventExportFormat::Arrow, "export.arrow", 1);
+  const std::string arrow = ReadFile("export.arrow");
+  ASSERT_GT(arrow.size(), 24);
+  EXPECT_EQ(std::memcmp(arrow.data(), "ARROW1\0\0", 8), 0);
+  EXPECT_EQ(arrow.substr(arrow.size() - 6), "ARROW1");
+  uint32_t continuation = 0;
+  std::memcpy(&continuation, arrow.data() + 8, 4);
+  EXPECT_EQ(continuation, 0xFFFFFFFF);  // The schema message
+  const int32_t footer_length = ReadAt<int32_t>(arrow, arrow.size() - 10);
+  EXPECT_EQ(footer_length % 8, 0);
+  EXPECT_LT(footer_length, arrow.size());
+
+  Export("export.test.bin", EventExportFormat::Arrow, "export.arrow", 4);
+  EXPECT_TRUE(ReadFile("export.arrow") == arrow);
+  std::filesystem::remove("export.arrow");
+}
+
+// The footer indexes the dictionary and a record batch per chunk, and the
+// blocks tile the file from the dictionary up to the end-of-stream marker
+TEST(TestEventExport, ArrowFooterIndexesMessages) {
+  const std::vector<Event>& events = WriteLogs();
+  Export("export.test.bin", EventExportFormat::Arrow, "export.arrow", 4);
+  const std::string arrow = ReadFile("export.arrow");
+  std::filesystem::remove("export.arrow");
+  ASSERT_GT(arrow.size(), 24);
+  const size_t footer_length = ReadAt<int32_t>(arrow, arrow.size() - 10);
+  ASSERT_LT(footer_length + 18, arrow.size());
+  const size_t footer_start = arrow.size() - 10 - footer_length;
+  const std::string footer = arrow.substr(footer_start, footer_length);
+  const size_t end_of_stream = footer_start - 8;
+  EXPECT_EQ(ReadAt<uint32_t>(arrow, end_of_stream), 0xFFFFFFFF);
+  EXPECT_EQ(ReadAt<uint32_t>(arrow, end_of_stream + 4), 0u);
+
+  const std::vector<Block> dictionaries = ReadFooterBlocks(footer, 2);
+  const std::vector<Block> batches = ReadFooterBlocks(footer, 3);
+  ASSERT_EQ(dictionaries.size(), 1u);
+  EXPECT_EQ(batches.size(), (events.size() + (1 << 16) - 1) >> 16);
+
+  std::vector<Block> blocks = dictionaries;
+  blocks.insert(blocks.end(), batches.begin(), batches.end());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const Block& block = blocks[i];
+    ASSERT_GE(block.offset, 8);
+    ASSERT_LE(block.offset + block.metadata_length + block.body_length,
+              end_of_stream);
+    EXPECT_EQ(ReadAt<uint32_t>(arrow, block.offset), 0xFFFFFFFF) << i;
+    EXPECT_EQ(block.metadata_length % 8, 0) << i;
+    EXPECT_EQ(block.body_length % 8, 0) << i;
+    const int64_t next =
+        i + 1 < blocks.size() ? blocks[i + 1].offset : end_of_stream;
+    EXPECT_EQ(block.offset + block.metadata_length + block.body_length, next)
+        << i;
+  }
+}
+
+TEST(TestEventExport, EmptyLogsAndErrors) {
+  std::ofstream("export.test.empty.jsonl").close();
+  EXPECT_EQ(Export("export.test.empty.jsonl", EventExportFormat::Json,
+                   "export.json", 0)
+                .num_events,
+            0);
+  EXPECT_EQ(ReadFile("export.json"), "[]\n");
+  Export("export.test.empty.jsonl", EventExportFormat::Csv, "export.json", 0);
+  EXPECT_EQ(ReadFile("export.json"), "type,truck_id,station_id,start_time,"
+                                     "end_time\n");
+
+  EXPECT_THROW(Export("export.test.empty.jsonl", EventExportFormat::Json, "",
+                      0),
+               std::invalid_argument);
+  EXPECT_THROW(Export("export.test.empty.jsonl", EventExportFormat::Json,
+                      "./export.test.empty.jsonl", 0),
+               std::invalid_argument);
+  EXPECT_THROW(Export("missing.jsonl", EventExportFormat::Json, "export.json",
+                      0),
+               std::runtime_error);
+  EXPECT_THROW(EventExportFormatFromString("parquet"), std::invalid_argument);
+  EXPECT_EQ(EventExportFormatFromString("arrow"), EventExportFormat::Arrow);
+  EXPECT_EQ(DefaultEventExportPath(20, 3, 1440min, EventExportFormat::Csv),
+            "events.20truck_3station_1440min_minutes.csv");
+  std::filesystem::remove("export.json");
+  std::filesystem::remove("export.test.empty.jsonl");
+}
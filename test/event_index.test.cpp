@@ -0,0 +1,203 @@
+#include "event_index.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "controller.h"
+#include "event.h"
+#include "event_log.h"
+
+namespace {
+
+// A run long enough for its log to take a few dozen blocks
+const std::vector<Event>& RunEvents() {
+  static const std::vector<Event> events = [] {
+    BasicController<VectorEventSink> controller(600, 10);
+    controller.Simulate(4000min);
+    return controller.sink().events();
+  }();
+  return events;
+}
+
+using EventKey = std::tuple<EventType, size_t, std::optional<size_t>,
+                            int64_t, int64_t>;
+
+std::vector<EventKey> Keys(const std::vector<Event>& events) {
+  std::vector<EventKey> keys;
+  for (const Event& e : events) {
+    keys.emplace_back(e.type, e.truck_id, e.station_id, e.start_time.count(),
+                      e.end_time.count());
+  }
+  return keys;
+}
+
+// What a query should find, by scanning every event
+std::vector<EventKey> Scan(const std::vector<Event>& events,
+                              const EventQuery& query) {
+  std::vector<Event> matches;
+  for (const Event& e : events) {
+    if ((!query.type || e.type == *query.type) &&
+        (!query.truck_id || e.truck_id == *query.truck_id) &&
+        (!query.station_id || e.station_id == query.station_id) &&
+        e.start_time <= query.to && e.end_time >= query.from) {
+      matches.push_back(e);
+    }
+  }
+  return Keys(matches);
+}
+
+const std::vector<EventQuery> kQueries = {
+    {},
+    {.type = EventType::Queue, .station_id = 7, .from = 1000min,
+     .to = 2000min},
+    {.truck_id = 3},
+    {.truck_id = 42, .station_id = 2},
+    {.type = EventType::Mine, .from = 3990min},
+    {.type = EventType::Unload, .from = 500min, .to = 500min},
+    {.station_id = 10},  // No such station
+    {.truck_id = 1000},  // No such truck
+};
+
+void ExpectQueriesMatchScan(const std::string& log,
+                            const std::vector<Event>& events) {
+  const EventIndex index(log);
+  EXPECT_EQ(index.num_events(), events.size());
+  for (const EventQuery& query : kQueries) {
+    EXPECT_TRUE(Keys(index.Query(query)) == Scan(events, query)) << log;
+  }
+}
+
+std::string ReadFile(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+// The writer thread indexes each format as it flushes, and queries find
+// what a scan of the whole log does
+TEST(TestEventIndex, LoggerIndexesAsItFlushes) {
+  const std::vector<Event>& events = RunEvents();
+  ASSERT_GT(events.size(), 8 * kIndexBlockEvents);
+  for (const int compression : {0, 6}) {
+    for (const LogFormat format : {LogFormat::Binary, LogFormat::JsonLines}) {
+      if (compression != 0 && format == LogFormat::Binary) continue;
+      const std::string log = compression != 0 ? "index.test.jsonl.gz"
+                              : format == LogFormat::Binary
+                                  ? "index.test.bin"
+                                  : "index.test.jsonl";
+      {
+        EventLogger logger("index.test.jsonl");
+        logger.Reopen(log, format, false, compression);
+        logger.SetIndexing(true);
+        for (size_t i = 0; i < events.size(); ++i) {
+          logger.LogEvent(events[i]);
+          if (i == events.size() / 3) logger.WaitUntilFlushed();
+        }
+        logger.WaitUntilFlushed();
+        ExpectQueriesMatchScan(log, events);
+      }
+
+      // A narrow time range touches a few blocks, not the whole log
+      const EventIndex index(log);
+      EXPECT_GE(index.blocks().size(), events.size() / kIndexBlockEvents);
+      EXPECT_LE(index.MatchingBlocks({.from = 2000min, .to = 2010min}).size(),
+                3);
+      EXPECT_TRUE(index.MatchingBlocks({.station_id = 10}).empty());
+
+      // Indexing the finished log finds the same events; a compressed log
+      // is indexed by member, which is how the logger wrote it
+      const std::string live = ReadFile(EventIndexPath(log));
+      EXPECT_EQ(BuildEventIndex(log), events.size());
+      if (compression != 0) {
+        EXPECT_TRUE(ReadFile(EventIndexPath(log)) == live);
+      }
+      ExpectQueriesMatchScan(log, events);
+      std::filesystem::remove(log);
+      std::filesystem::remove(EventIndexPath(log));
+    }
+  }
+}
+
+// A resumed run cuts the log back, which drops the index, and indexing the
+// reopened log picks up from the events it kept
+TEST(TestEventIndex, ResumedLogContinuesIndex) {
+  const std::vector<Event>& events = RunEvents();
+  const std::string log = "index.test.resume.bin";
+  const size_t kept = events.size() / 4;
+  EventLogger logger(log, LogFormat::Binary);
+  logger.ClearEvents();
+  logger.SetIndexing(true);
+  for (size_t i = 0; i < events.size() / 2; ++i) logger.LogEvent(events[i]);
+  logger.Reopen("index.test.jsonl", LogFormat::JsonLines);
+  ASSERT_TRUE(std::filesystem::exists(EventIndexPath(log)));
+
+  TruncateEventLog(log, kept);
+  EXPECT_FALSE(std::filesystem::exists(EventIndexPath(log)));
+  logger.Reopen(log, LogFormat::Binary, true);
+  EXPECT_TRUE(logger.indexing());
+  std::vector<Event> expected(events.begin(), events.begin() + kept);
+  for (size_t i = events.size() / 2; i < events.size(); ++i) {
+    logger.LogEvent(events[i]);
+    expected.push_back(events[i]);
+  }
+  logger.WaitUntilFlushed();
+  ExpectQueriesMatchScan(log, expected);
+
+  // Logging without the index removes it rather than let it go stale
+  logger.SetIndexing(false);
+  EXPECT_FALSE(std::filesystem::exists(EventIndexPath(log)));
+  logger.Reopen("index.test.jsonl", LogFormat::JsonLines);
+  std::filesystem::remove(log);
+  std::filesystem::remove("index.test.jsonl");
+}
+
+TEST(TestEventIndex, PartialAndStaleIndexes) {
+  const std::string log = "index.test.small.jsonl";
+  {
+    std::ofstream out(log);
+    for (size_t i = 0; i < 10; ++i) {
+      out << EventToJsonLine({EventType::Unload, i, i % 3, minutes_t(i * 10),
+                              minutes_t(i * 10 + 5)})
+          << "\n\n";
+    }
+    out << "not json\n";
+  }
+  EXPECT_THROW(EventIndex{log}, std::runtime_error);  // No index yet
+  EXPECT_EQ(BuildEventIndex(log), 10);
+
+  // A crash mid-flush leaves part of an entry, which is ignored
+  std::ofstream(EventIndexPath(log), std::ios::app | std::ios::binary)
+      << std::string(20, '\0');
+  {
+    const EventIndex index(log);
+    ASSERT_EQ(index.blocks().size(), 1);
+    EXPECT_EQ(index.blocks()[0].num_trucks, 10);
+    EXPECT_EQ(index.blocks()[0].num_stations, 3);
+    EXPECT_EQ(index.blocks()[0].type_mask,
+              1u << static_cast<int>(EventType::Unload));
+    const std::vector<Event> events =
+        index.Query({.station_id = 1, .from = 40min, .to = 70min});
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_EQ(events[0].truck_id, 4);
+    EXPECT_EQ(events[1].truck_id, 7);
+    EXPECT_TRUE(index.Query({.type = EventType::Mine}).empty());
+    EXPECT_TRUE(index.MatchingBlocks({.type = EventType::Mine}).empty());
+  }
+
+  // A log cut back behind its index's back
+  std::filesystem::resize_file(log, 20);
+  EXPECT_THROW(EventIndex{log}, std::runtime_error);
+  std::ofstream(EventIndexPath(log)) << "VMEL";
+  EXPECT_THROW(EventIndex{log}, std::runtime_error);
+  std::filesystem::remove(log);
+  std::filesystem::remove(EventIndexPath(log));
+}
@@ -0,0 +1,204 @@
+#include "event_log.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "event.h"
+
+namespace {
+
+const std::vector<Event> kSampleEvents = {
+    {EventType::Mine, 0, std::nullopt, 0min, 120min},
+    {EventType::TravelToStation, 0, std::nullopt, 120min, 150min},
+    {EventType::Queue, 3, 7, 150min, 152min},
+    {EventType::Unload, 0, 7, 152min, 157min},
+    {EventType::TravelToMine, 0, std::nullopt, 157min, 187min},
+};
+
+void ExpectSameEvent(const Event& lhs, const Event& rhs) {
+  EXPECT_EQ(lhs.type, rhs.type);
+  EXPECT_EQ(lhs.truck_id, rhs.truck_id);
+  EXPECT_EQ(lhs.station_id, rhs.station_id);
+  EXPECT_EQ(lhs.start_time, rhs.start_time);
+  EXPECT_EQ(lhs.end_time, rhs.end_time);
+}
+
+}  // namespace
+
+TEST(TestEventLog, RecordRoundTrip) {
+  for (const auto& event : kSampleEvents) {
+    ExpectSameEvent(FromRecord(ToRecord(event)), event);
+  }
+}
+
+// Events logged in binary format read back identically, both sequentially
+// and through the memory-mapped span
+TEST(TestEventLog, BinaryLoggerRoundTrip) {
+  {
+    EventLogger logger("events.test.bin", LogFormat::Binary);
+    logger.ClearEvents();
+    logger.SetRunParameters({42, 7, 600min, 0xBEEF});
+    for (const auto& event : kSampleEvents) logger.LogEvent(event);
+    logger.WaitUntilFlushed();
+
+    Event event;
+    for (const auto& expected : kSampleEvents) {
+      ASSERT_TRUE(logger.ReadNextEvent(&event));
+      ExpectSameEvent(event, expected);
+    }
+    EXPECT_FALSE(logger.ReadNextEvent(&event));
+  }
+
+  const MappedEventLog log("events.test.bin");
+  EXPECT_EQ(log.params().num_trucks, 42);
+  EXPECT_EQ(log.params().num_stations, 7);
+  EXPECT_EQ(log.params().sim_time, 600min);
+  EXPECT_EQ(log.params().random_seed, 0xBEEF);
+  ASSERT_EQ(log.records().size(), kSampleEvents.size());
+  for (size_t i = 0; i < kSampleEvents.size(); ++i) {
+    ExpectSameEvent(FromRecord(log.records()[i]), kSampleEvents[i]);
+  }
+}
+
+// The logger counts what the writer thread put on disk
+TEST(TestEventLog, LoggerStatsCountBytesWritten) {
+  if constexpr (!kStatsEnabled) GTEST_SKIP() << "Stats compiled out";
+
+  EventLogger logger("events.stats.test.bin", LogFormat::Binary);
+  logger.ClearEvents();
+  for (const auto& event : kSampleEvents) logger.LogEvent(event);
+  logger.WaitUntilFlushed();
+
+  const LoggerStats stats = logger.stats();
+  EXPECT_EQ(stats.events_logged, kSampleEvents.size());
+  EXPECT_EQ(stats.events_dropped, 0u);
+  EXPECT_GE(stats.flushes, 1u);
+  EXPECT_EQ(stats.bytes_written, kSampleEvents.size() * sizeof(EventRecord));
+  EXPECT_GE(stats.max_flush_ms * stats.flushes, stats.flush_ms);
+}
+
+// A full simulation logged in binary matches the same run logged as JSONL
+TEST(TestEventLog, ConvertJsonLinesAndBinary) {
+  ClearEvents();
+  Controller controller(20, 3);
+  controller.Run(24 * 60min);
+  WaitUntilFlushed();
+
+  const auto& jsonl_path = GetEventLogger().filename();
+  ConvertJsonLinesToBinary(jsonl_path, "events.test.bin", {20, 3, 24 * 60min});
+  ASSERT_TRUE(IsBinaryEventLog("events.test.bin"));
+  ASSERT_FALSE(IsBinaryEventLog(jsonl_path));
+  ConvertBinaryToJsonLines("events.test.bin", "events.test.jsonl");
+
+  const MappedEventLog log("events.test.bin");
+  EventLogger roundtrip("events.test.jsonl");
+  Event event;
+  size_t count = 0;
+  while (ReadEvent(&event)) {
+    ASSERT_LT(count, log.records().size());
+    ExpectSameEvent(FromRecord(log.records()[count]), event);
+
+    Event converted;
+    ASSERT_TRUE(roundtrip.ReadNextEvent(&converted));
+    ExpectSameEvent(converted, event);
+    ++count;
+  }
+  EXPECT_GT(count, 0);
+  EXPECT_EQ(count, log.records().size());
+}
+
+// A compressed log is a series of gzip members that reads back like the
+// plain log, and a resumed run can cut it back and append to it
+TEST(TestEventLog, CompressedLoggerRoundTrip) {
+  const std::string filename = "events.test.json.gz";
+  BasicController<VectorEventSink> controller(20, 3);
+  controller.Simulate(24 * 60min);
+  const std::vector<Event>& events = controller.sink().events();
+  ASSERT_GT(events.size(), 100);
+
+  EventLogger logger("events.test.jsonl");
+  EXPECT_THROW(logger.Reopen(filename, LogFormat::Binary, false, 6),
+               std::invalid_argument);
+  EXPECT_THROW(logger.Reopen(filename, LogFormat::JsonLines, false, 10),
+               std::invalid_argument);
+  logger.Reopen(filename, LogFormat::JsonLines, false, 9);
+  EXPECT_EQ(logger.compression_level(), 9);
+  for (size_t i = 0; i < events.size(); ++i) {
+    logger.LogEvent(events[i]);
+    if (i == events.size() / 2) logger.WaitUntilFlushed();  // Two members
+  }
+  logger.WaitUntilFlushed();
+  ASSERT_TRUE(IsCompressedEventLog(filename));
+  if constexpr (kStatsEnabled) {
+    EXPECT_EQ(logger.stats().bytes_written,
+              std::filesystem::file_size(filename));
+  }
+
+  std::string text;
+  for (const Event& event : events) text += EventToJsonLine(event) + "\n";
+  EXPECT_EQ(DecompressEventLog(filename), text);
+  EXPECT_LT(std::filesystem::file_size(filename), text.size() / 4);
+
+  Event event;
+  for (const Event& expected : events) {
+    ASSERT_TRUE(logger.ReadNextEvent(&event));
+    ExpectSameEvent(event, expected);
+  }
+  EXPECT_FALSE(logger.ReadNextEvent(&event));
+
+  TruncateEventLog(filename, 10);
+  logger.Reopen(filename, LogFormat::JsonLines, true, 1);
+  for (size_t i = 10; i < 20; ++i) logger.LogEvent(events[i]);
+  logger.WaitUntilFlushed();
+  for (size_t i = 0; i < 20; ++i) {
+    ASSERT_TRUE(logger.ReadNextEvent(&event));
+    ExpectSameEvent(event, events[i]);
+  }
+  EXPECT_FALSE(logger.ReadNextEvent(&event));
+  EXPECT_THROW(TruncateEventLog(filename, 21), std::runtime_error);
+  std::filesystem::remove(filename);
+}
+
+// A compressed log cut off mid-member (e.g. crash mid-flush) reads up to its
+// last whole line
+TEST(TestEventLog, ReadsCutOffCompressedLog) {
+  const std::string filename = "events.test.cut.json.gz";
+  std::string text;
+  for (size_t i = 0; i < 1000; ++i) {
+    text += EventToJsonLine(kSampleEvents[i % kSampleEvents.size()]) + "\n";
+  }
+  BlockCompressor compressor(1);
+  std::string block;
+  compressor.Compress(text, &block);
+  std::ofstream(filename, std::ios::binary | std::ios::trunc)
+      .write(block.data(), block.size() / 2);
+
+  EventLogLineReader reader(filename);
+  std::string line;
+  size_t count = 0;
+  while (reader.ReadLine(&line)) {
+    EXPECT_EQ(line, EventToJsonLine(kSampleEvents[count % 5]));
+    ++count;
+  }
+  EXPECT_GT(count, 0);
+  EXPECT_LT(count, 1000);
+  const std::string decompressed = DecompressEventLog(filename);
+  EXPECT_EQ(decompressed, text.substr(0, decompressed.size()));
+  EXPECT_EQ(decompressed.back(), '\n');
+
+  // Read in chunks of whole lines, smaller than a line to begin with
+  EventLogLineReader chunks(filename);
+  std::string chunk, joined;
+  for (size_t bytes = 16; chunks.ReadLines(bytes, &chunk); bytes *= 2) {
+    EXPECT_EQ(chunk.back(), '\n');
+    joined += chunk;
+  }
+  EXPECT_EQ(joined, decompressed);
+  std::filesystem::remove(filename);
+}
@@ -42,3 +42,51 @@ TEST(TestMetrics, StationUtilizationMatchesThroughput) {
   GenerateMetrics(120min, &trucks, &stations);
   EXPECT_GT(stations[0].utilization, 0.0);
 }
+
+// One truck never queues and cycles in mining + travel + unload time
+TEST(TestMetrics, EstimateSingleTruckCycle) {
+  const QueueingEstimate estimate = EstimateQueueing(1, 1);
+  EXPECT_DOUBLE_EQ(estimate.mean_wait, 0.0);
+  EXPECT_DOUBLE_EQ(estimate.cycle_time, 180.0 + 60.0 + 5.0);
+}
+
+// A fleet far larger than the stations can serve saturates them
+TEST(TestMetrics, EstimateSaturatesStations) {
+  const QueueingEstimate estimate = EstimateQueueing(1000, 2);
+  EXPECT_NEAR(estimate.station_utilization, 1.0, 1e-6);
+  EXPECT_NEAR(estimate.throughput, 2.0 / 5.0, 1e-6);
+  EXPECT_DOUBLE_EQ(estimate.wait_probability, 1.0);
+  EXPECT_GT(estimate.mean_wait, 1000.0);
+}
+
+// Nothing completes before the shortest possible mining operation
+TEST(TestMetrics, EstimateShortRunIsEmpty) {
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+  EstimateMetrics(10, 2, Controller::kMinDuration - 1min, &trucks, &stations);
+  ASSERT_EQ(trucks.size(), 10u);
+  ASSERT_EQ(stations.size(), 2u);
+  for (const auto& t : trucks) EXPECT_EQ(t.mines_completed, 0u);
+  for (const auto& s : stations) EXPECT_EQ(s.throughput, 0u);
+}
+
+// The estimate tracks the simulation at light, heavy and saturated loads
+TEST(TestMetrics, EstimateMatchesSimulation) {
+  for (auto [num_trucks, num_stations] :
+       {std::pair<size_t, size_t>{30, 5}, {50, 1}, {200, 2}}) {
+    BasicController<NullEventSink> controller(num_trucks, num_stations);
+    controller.Simulate(72 * 60min);
+    std::vector<TruckMetrics> trucks;
+    std::vector<StationMetrics> stations;
+    EstimateMetrics(num_trucks, num_stations, 72 * 60min, &trucks, &stations);
+
+    double simulated = 0.0;
+    double estimated = 0.0;
+    for (size_t i = 0; i < num_stations; ++i) {
+      simulated += controller.station_metrics()[i].utilization;
+      estimated += stations[i].utilization;
+    }
+    EXPECT_NEAR(estimated / num_stations, simulated / num_stations, 3.0)
+        << num_trucks << " trucks, " << num_stations << " stations";
+  }
+}
@@ -0,0 +1,233 @@
+#include "metrics_export.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "metrics_store.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+std::string ReadFile(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// Enough trucks for the rows to be formatted on several threads
+const MetricsStore& LargeRun() {
+  static const MetricsStore metrics = [] {
+    BasicController<NullEventSink> controller(34000, 30);
+    controller.Simulate(600min);
+    return controller.metrics();
+  }();
+  return metrics;
+}
+
+// The report as the nlohmann::json document it used to be built as
+json ExpectedDocument(minutes_t sim_time, const MetricsStore& metrics) {
+  const MetricsStore::TruckColumns& t = metrics.trucks();
+  const MetricsStore::StationColumns& s = metrics.stations();
+  json j;
+  j["simulation_duration"] = sim_time.count();
+  for (size_t i = 0; i < metrics.num_trucks(); ++i) {
+    j["trucks"].push_back({
+        {"id", i},
+        {"utilization", t.utilization[i]},
+        {"idle_time", t.idle_time[i]},
+        {"trips_completed", t.trips_completed[i]},
+        {"mines_completed", t.mines_completed[i]},
+        {"queues_completed", t.queues_completed[i]},
+        {"mining_time", t.mining_time[i]},
+        {"queueing_time", t.queueing_time[i]},
+        {"avg_trip_time", t.avg_trip_time[i]},
+        {"avg_queueing_time", t.avg_queueing_time[i]},
+    });
+  }
+  for (size_t i = 0; i < metrics.num_stations(); ++i) {
+    j["stations"].push_back({
+        {"id", i},
+        {"utilization", s.utilization[i]},
+        {"idle_time", s.idle_time[i]},
+        {"throughput", s.throughput[i]},
+        {"queues_completed", s.queues_completed[i]},
+        {"unloading_time", s.unloading_time[i]},
+        {"queueing_time", s.queueing_time[i]},
+        {"avg_queueing_time", s.avg_queueing_time[i]},
+    });
+  }
+  return j;
+}
+
+}  // namespace
+
+// Both JSON modes match what dumping the whole document gives, byte for
+// byte, however many threads format them
+TEST(TestMetricsExport, JsonMatchesDocument) {
+  const MetricsStore& metrics = LargeRun();
+  const json expected = ExpectedDocument(600min, metrics);
+  std::ostringstream pretty;
+  pretty << std::setw(2) << expected << "\n";
+
+  for (size_t threads : {1, 4}) {
+    EXPECT_EQ(WriteMetricsReport(600min, metrics,
+                                 {MetricsFormat::Json, "report.json", threads}),
+              "report.json");
+    EXPECT_EQ(ReadFile("report.json"), pretty.str()) << threads;
+    WriteMetricsReport(600min, metrics,
+                       {MetricsFormat::CompactJson, "report.json", threads});
+    EXPECT_EQ(ReadFile("report.json"), expected.dump() + "\n") << threads;
+  }
+  std::filesystem::remove("report.json");
+}
+
+// Doubles at the edges of nlohmann's fixed and exponent notation print the
+// same as in the document
+TEST(TestMetricsExport, DoublesMatchDocumentNotation) {
+  const std::vector<double> values = {
+      1e-4, 5e-4, 1e-5, -2.5e-7, 0.1, 1.0 / 3.0, 0.0, -0.0, 100.0, 1e14,
+      9.99e14, 123456789012345.0, 1e15, 1e16, 1234567890123456.0, 1.5e300,
+      4.9e-324,
+      // Grisu2 prints these with a digit more than the shortest form
+      57.775101817233796, 57.644472361809044};
+  std::vector<StationMetrics> stations(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    stations[i].utilization = values[i];
+    stations[i].avg_queueing_time = -values[i];
+  }
+  const MetricsStore metrics = MetricsStore::FromMetrics({}, stations);
+  WriteMetricsReport(60min, metrics,
+                     {MetricsFormat::CompactJson, "report.json", 1});
+  json expected = ExpectedDocument(60min, metrics);
+  expected["trucks"] = json::array();
+  EXPECT_EQ(ReadFile("report.json"), expected.dump() + "\n");
+
+  WriteMetricsReport(60min, metrics, {MetricsFormat::Csv, "report.csv", 1});
+  std::ifstream in("report.csv");
+  std::string line;
+  std::getline(in, line);
+  for (double value : values) {
+    ASSERT_TRUE(std::getline(in, line));
+    EXPECT_NE(line.find("," + json(value).dump() + ","), std::string::npos)
+        << line;
+  }
+  std::filesystem::remove("report.json");
+  std::filesystem::remove("report.csv");
+}
+
+TEST(TestMetricsExport, CsvHasARowPerTruckAndStation) {
+  const MetricsStore& metrics = LargeRun();
+  WriteMetricsReport(600min, metrics, {MetricsFormat::Csv, "report.csv", 4});
+  std::ifstream in("report.csv");
+  std::string line;
+  ASSERT_TRUE(std::getline(in, line));
+  EXPECT_EQ(line,
+            "table,id,avg_queueing_time,avg_trip_time,idle_time,"
+            "mines_completed,mining_time,queueing_time,queues_completed,"
+            "trips_completed,utilization,throughput,unloading_time");
+
+  size_t trucks = 0;
+  size_t stations = 0;
+  while (std::getline(in, line)) {
+    if (line.rfind("truck,", 0) == 0) {
+      if (trucks == 7) {
+        const auto& t = metrics.trucks();
+        std::ostringstream row;
+        row << "truck,7," << json(t.avg_queueing_time[7]).dump() << ","
+            << json(t.avg_trip_time[7]).dump() << "," << t.idle_time[7]
+            << "," << t.mines_completed[7] << "," << t.mining_time[7] << ","
+            << t.queueing_time[7] << "," << t.queues_completed[7] << ","
+            << t.trips_completed[7] << "," << json(t.utilization[7]).dump()
+            << ",,";
+        EXPECT_EQ(line, row.str());
+      }
+      ++trucks;
+    } else {
+      ASSERT_EQ(line.rfind("station,", 0), 0) << line;
+      ++stations;
+    }
+  }
+  EXPECT_EQ(trucks, metrics.num_trucks());
+  EXPECT_EQ(stations, metrics.num_stations());
+  std::filesystem::remove("report.csv");
+}
+
+TEST(TestMetricsExport, ColumnarHoldsTheColumns) {
+  const MetricsStore& metrics = LargeRun();
+  WriteMetricsReport(600min, metrics, {MetricsFormat::Columnar, "report.bin"});
+  const std::string bytes = ReadFile("report.bin");
+
+  MetricsColumnsHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  EXPECT_EQ(std::memcmp(header.magic, kMetricsColumnsMagic, 4), 0);
+  EXPECT_EQ(header.version, kMetricsColumnsVersion);
+  EXPECT_EQ(header.num_columns, 16);  // 9 truck and 7 station fields
+  EXPECT_EQ(header.num_trucks, metrics.num_trucks());
+  EXPECT_EQ(header.num_stations, metrics.num_stations());
+  EXPECT_EQ(header.sim_minutes, 600);
+
+  size_t checked = 0;
+  for (uint32_t c = 0; c < header.num_columns; ++c) {
+    MetricsColumnDescriptor column;
+    std::memcpy(&column,
+                bytes.data() + sizeof(header) + c * sizeof(column),
+                sizeof(column));
+    const std::string name = column.name;
+    if (name == "utilization" && column.table == 0) {
+      ASSERT_EQ(column.type, 1);
+      std::vector<double> values(header.num_trucks);
+      std::memcpy(values.data(), bytes.data() + column.offset,
+                  values.size() * sizeof(double));
+      EXPECT_EQ(values, metrics.trucks().utilization);
+      ++checked;
+    } else if (name == "queueing_time" && column.table == 1) {
+      ASSERT_EQ(column.type, 2);
+      std::vector<int64_t> values(header.num_stations);
+      std::memcpy(values.data(), bytes.data() + column.offset,
+                  values.size() * sizeof(int64_t));
+      EXPECT_EQ(values, metrics.stations().queueing_time);
+      ++checked;
+    } else if (name == "throughput") {
+      ASSERT_EQ(column.table, 1);
+      ASSERT_EQ(column.type, 0);
+      std::vector<int32_t> values(header.num_stations);
+      std::memcpy(values.data(), bytes.data() + column.offset,
+                  values.size() * sizeof(int32_t));
+      EXPECT_EQ(values, metrics.stations().throughput);
+      ++checked;
+    }
+  }
+  EXPECT_EQ(checked, 3);
+  // Trucks: 6 int32 and 3 float64 columns, stations: 2 int32, 3 int64
+  // (the times) and 2 float64
+  EXPECT_EQ(bytes.size(), sizeof(header) +
+                              16 * sizeof(MetricsColumnDescriptor) +
+                              header.num_trucks * (6 * 4 + 3 * 8) +
+                              header.num_stations * (2 * 4 + 5 * 8));
+  std::filesystem::remove("report.bin");
+}
+
+TEST(TestMetricsExport, NamesFormatsAndPaths) {
+  EXPECT_EQ(MetricsFormatFromString("compact"), MetricsFormat::CompactJson);
+  EXPECT_EQ(MetricsFormatFromString("columnar"), MetricsFormat::Columnar);
+  EXPECT_THROW(MetricsFormatFromString("xml"), std::invalid_argument);
+  EXPECT_EQ(DefaultMetricsPath(20, 3, 1440min, MetricsFormat::Json),
+            "metrics.20truck_3station_1440min_minutes.json");
+  EXPECT_EQ(DefaultMetricsPath(20, 3, 1440min, MetricsFormat::Csv),
+            "metrics.20truck_3station_1440min_minutes.csv");
+
+  EXPECT_THROW(WriteMetricsReport(600min, LargeRun(),
+                                  {MetricsFormat::Json, "missing/dir/r.json"}),
+               std::runtime_error);
+}
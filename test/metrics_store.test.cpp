@@ -0,0 +1,136 @@
+#include "metrics_store.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "controller.h"
+#include "event_sink.h"
+
+// The column derivation gives the same numbers as GenerateMetrics on the
+// per-object form of the same raw counters
+TEST(TestMetricsStore, DeriveMatchesGenerateMetrics) {
+  BasicController<NullEventSink> controller(50, 4);
+  controller.Simulate(48 * 60min);
+  const std::vector<TruckMetrics>& trucks = controller.truck_metrics();
+  const std::vector<StationMetrics>& stations = controller.station_metrics();
+
+  std::vector<TruckMetrics> expected_trucks(trucks.size());
+  for (size_t i = 0; i < trucks.size(); ++i) {
+    expected_trucks[i].trips_completed = trucks[i].trips_completed;
+    expected_trucks[i].mines_completed = trucks[i].mines_completed;
+    expected_trucks[i].queues_completed = trucks[i].queues_completed;
+    expected_trucks[i].mining_time = trucks[i].mining_time;
+    expected_trucks[i].queueing_time = trucks[i].queueing_time;
+    expected_trucks[i].unloading_time = trucks[i].unloading_time;
+    expected_trucks[i].travel_time = trucks[i].travel_time;
+  }
+  std::vector<StationMetrics> expected_stations(stations.size());
+  for (size_t i = 0; i < stations.size(); ++i) {
+    expected_stations[i].throughput = stations[i].throughput;
+    expected_stations[i].queues_completed = stations[i].queues_completed;
+    expected_stations[i].unloading_time = stations[i].unloading_time;
+    expected_stations[i].queueing_time = stations[i].queueing_time;
+  }
+  GenerateMetrics(48 * 60min, &expected_trucks, &expected_stations);
+
+  for (size_t i = 0; i < trucks.size(); ++i) {
+    EXPECT_EQ(trucks[i].idle_time, expected_trucks[i].idle_time);
+    EXPECT_DOUBLE_EQ(trucks[i].utilization, expected_trucks[i].utilization);
+    EXPECT_DOUBLE_EQ(trucks[i].avg_trip_time,
+                     expected_trucks[i].avg_trip_time);
+    EXPECT_DOUBLE_EQ(trucks[i].avg_queueing_time,
+                     expected_trucks[i].avg_queueing_time);
+  }
+  for (size_t i = 0; i < stations.size(); ++i) {
+    EXPECT_EQ(stations[i].idle_time, expected_stations[i].idle_time);
+    EXPECT_DOUBLE_EQ(stations[i].utilization,
+                     expected_stations[i].utilization);
+    EXPECT_DOUBLE_EQ(stations[i].avg_queueing_time,
+                     expected_stations[i].avg_queueing_time);
+  }
+
+  double utilization = 0.0;
+  for (const auto& t : expected_trucks) utilization += t.utilization;
+  EXPECT_NEAR(controller.metrics().AverageTruckUtilization(),
+              utilization / trucks.size(), 1e-9);
+}
+
+// No completions means no averages, not a division by zero
+TEST(TestMetricsStore, EmptyCountsHaveZeroAverages) {
+  MetricsStore store;
+  store.Reset(2, 1);
+  store.AddMining(0, 90min);
+  store.AddUnloading(1, 0, 5min);
+  store.AddQueueing(1, 0, 7min);
+  store.Derive(100min);
+
+  EXPECT_DOUBLE_EQ(store.trucks().avg_trip_time[0], 0.0);
+  EXPECT_DOUBLE_EQ(store.trucks().avg_queueing_time[0], 0.0);
+  EXPECT_DOUBLE_EQ(store.trucks().utilization[0], 90.0);
+  EXPECT_EQ(store.trucks().idle_time[0], 10);
+  EXPECT_DOUBLE_EQ(store.trucks().avg_trip_time[1], 5.0);
+  EXPECT_DOUBLE_EQ(store.trucks().avg_queueing_time[1], 7.0);
+  EXPECT_DOUBLE_EQ(store.stations().utilization[0], 5.0);
+  EXPECT_DOUBLE_EQ(store.stations().avg_queueing_time[0], 7.0);
+}
+
+// A station's queueing time adds up every queued truck's wait, so it can
+// pass 2^31 minutes well within kMaxSimTime
+TEST(TestMetricsStore, StationQueueingExceeds32Bits) {
+  MetricsStore store;
+  store.Reset(1, 1);
+  constexpr int kQueues = 3000;
+  for (int i = 0; i < kQueues; ++i) {
+    store.AddStationQueueing(0, 1'000'000min);
+    store.AddStationUnloading(0, 5min);
+  }
+  store.Derive(1'000'000min);
+
+  EXPECT_EQ(store.stations().queueing_time[0], int64_t{kQueues} * 1'000'000);
+  EXPECT_DOUBLE_EQ(store.stations().avg_queueing_time[0], 1'000'000.0);
+  EXPECT_EQ(store.stations().idle_time[0], 1'000'000 - 5 * kQueues);
+
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+  store.ToMetrics(&trucks, &stations);
+  EXPECT_EQ(stations[0].queueing_time, kQueues * 1'000'000min);
+}
+
+TEST(TestMetricsStore, AdaptersRoundTrip) {
+  std::vector<TruckMetrics> trucks;
+  std::vector<StationMetrics> stations;
+  EstimateMetrics(25, 3, 24 * 60min, &trucks, &stations);
+
+  std::vector<TruckMetrics> round_trucks;
+  std::vector<StationMetrics> round_stations;
+  MetricsStore::FromMetrics(trucks, stations)
+      .ToMetrics(&round_trucks, &round_stations);
+
+  ASSERT_EQ(round_trucks.size(), trucks.size());
+  for (size_t i = 0; i < trucks.size(); ++i) {
+    EXPECT_EQ(round_trucks[i].trips_completed, trucks[i].trips_completed);
+    EXPECT_EQ(round_trucks[i].travel_time, trucks[i].travel_time);
+    EXPECT_EQ(round_trucks[i].idle_time, trucks[i].idle_time);
+    EXPECT_DOUBLE_EQ(round_trucks[i].utilization, trucks[i].utilization);
+  }
+  ASSERT_EQ(round_stations.size(), stations.size());
+  for (size_t i = 0; i < stations.size(); ++i) {
+    EXPECT_EQ(round_stations[i].throughput, stations[i].throughput);
+    EXPECT_DOUBLE_EQ(round_stations[i].avg_queueing_time,
+                     stations[i].avg_queueing_time);
+  }
+}
+
+TEST(TestMetricsStore, SumColumnHandlesPartialLanes) {
+  std::vector<int32_t> counts;
+  std::vector<double> values;
+  for (int32_t i = 1; i <= 21; ++i) {
+    counts.push_back(i);
+    values.push_back(i * 0.5);
+  }
+  EXPECT_EQ(SumColumn(counts), 231);
+  EXPECT_DOUBLE_EQ(SumColumn(values), 115.5);
+  EXPECT_EQ(SumColumn(std::vector<int32_t>{}), 0);
+}
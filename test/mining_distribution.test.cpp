@@ -0,0 +1,153 @@
+#include "mining_distribution.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "counter_rng.h"
+
+namespace {
+
+// Draws num_draws durations over many streams and checks their frequencies
+// against the distribution's probabilities
+void ExpectFrequenciesMatch(const MiningDistribution& distribution,
+                            size_t num_draws) {
+  const CounterRng rng(0xBEEF);
+  const std::vector<double> probabilities = distribution.Probabilities();
+  std::vector<size_t> counts(probabilities.size(), 0);
+  for (uint32_t i = 0; i < num_draws; ++i) {
+    const minutes_t duration = distribution.Sample(rng, i % 1000, i / 1000);
+    ASSERT_GE(duration, distribution.min());
+    ASSERT_LE(duration, distribution.max());
+    ++counts[(duration - distribution.min()).count()];
+  }
+  for (size_t i = 0; i < counts.size(); ++i) {
+    const double expected = probabilities[i] * num_draws;
+    // Five standard deviations of a binomial count
+    const double tolerance = 5.0 * std::sqrt(expected) + 1.0;
+    EXPECT_NEAR(static_cast<double>(counts[i]), expected, tolerance)
+        << "minute " << distribution.min().count() + i;
+  }
+}
+
+}  // namespace
+
+TEST(TestMiningDistribution, UniformMatchesUniformInt) {
+  const CounterRng rng(7);
+  const auto uniform = MiningDistribution::Uniform(60min, 300min);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    EXPECT_EQ(uniform.Sample(rng, i, i % 7).count(),
+              rng.UniformInt(i, i % 7, 60, 300));
+  }
+  EXPECT_EQ(uniform.Describe(), "uniform:60:300");
+}
+
+TEST(TestMiningDistribution, ProbabilitiesSumToOne) {
+  for (const auto& distribution :
+       {MiningDistribution::Uniform(60min, 300min),
+        MiningDistribution::Triangular(60min, 100min, 300min),
+        MiningDistribution::Lognormal(120.0, 0.5, 60min, 300min),
+        MiningDistribution::Empirical({{60min, 89min, 1.0},
+                                       {90min, 90min, 3.0}})}) {
+    const auto probabilities = distribution.Probabilities();
+    EXPECT_EQ(probabilities.size(),
+              (distribution.max() - distribution.min()).count() + 1);
+    EXPECT_NEAR(std::accumulate(probabilities.begin(), probabilities.end(),
+                                0.0),
+                1.0, 1e-12);
+  }
+}
+
+TEST(TestMiningDistribution, TriangularPeaksAtItsMode) {
+  const auto triangular = MiningDistribution::Triangular(60min, 100min, 300min);
+  const auto probabilities = triangular.Probabilities();
+  const auto peak =
+      std::max_element(probabilities.begin(), probabilities.end());
+  EXPECT_EQ(peak - probabilities.begin(), 40);
+  EXPECT_GT(probabilities.front(), 0.0);
+  EXPECT_GT(probabilities.back(), 0.0);
+  ExpectFrequenciesMatch(triangular, 500000);
+}
+
+TEST(TestMiningDistribution, LognormalIsTruncatedToItsRange) {
+  const auto lognormal = MiningDistribution::Lognormal(120.0, 0.5, 60min,
+                                                       300min);
+  const auto probabilities = lognormal.Probabilities();
+  // The median of the untruncated distribution is the most likely region
+  EXPECT_GT(probabilities[120 - 60], probabilities[0]);
+  EXPECT_GT(probabilities[120 - 60], probabilities.back());
+  ExpectFrequenciesMatch(lognormal, 500000);
+}
+
+TEST(TestMiningDistribution, EmpiricalSpreadsBinsOverTheirMinutes) {
+  const auto empirical = MiningDistribution::Empirical(
+      {{100min, 109min, 1.0}, {150min, 150min, 1.0}, {200min, 200min, 0.0}});
+  EXPECT_EQ(empirical.min(), 100min);
+  EXPECT_EQ(empirical.max(), 200min);
+  const auto probabilities = empirical.Probabilities();
+  EXPECT_DOUBLE_EQ(probabilities[0], 0.05);
+  EXPECT_DOUBLE_EQ(probabilities[50], 0.5);
+  EXPECT_DOUBLE_EQ(probabilities[100], 0.0);
+  EXPECT_DOUBLE_EQ(probabilities[20], 0.0);
+  ExpectFrequenciesMatch(empirical, 200000);
+}
+
+TEST(TestMiningDistribution, ParsesSpecs) {
+  EXPECT_EQ(MiningDistribution::Parse("uniform", 60min, 300min).Describe(),
+            "uniform:60:300");
+  EXPECT_EQ(
+      MiningDistribution::Parse("uniform:10:20", 60min, 300min).Describe(),
+      "uniform:10:20");
+  const auto triangular =
+      MiningDistribution::Parse("triangular:90", 60min, 300min);
+  EXPECT_EQ(triangular.kind(), MiningDistribution::Kind::Triangular);
+  EXPECT_EQ(triangular.Describe(), "triangular:90:60:300");
+  const auto lognormal =
+      MiningDistribution::Parse("lognormal:150:0.25:30:400", 60min, 300min);
+  EXPECT_EQ(lognormal.min(), 30min);
+  EXPECT_EQ(lognormal.max(), 400min);
+  // Describe reads back into the same distribution
+  EXPECT_EQ(MiningDistribution::Parse(lognormal.Describe(), 60min, 300min)
+                .Probabilities(),
+            lognormal.Probabilities());
+
+  for (const std::string spec :
+       {"", "gamma", "uniform:", "uniform:10", "triangular",
+        "triangular:400", "triangular:90:60", "lognormal:150",
+        "lognormal:-1:0.5", "lognormal:150:0", "uniform:0:10",
+        "uniform:20:10", "triangular:x", "empirical", "empirical:missing"}) {
+    EXPECT_THROW(MiningDistribution::Parse(spec, 60min, 300min),
+                 std::invalid_argument)
+        << spec;
+  }
+}
+
+TEST(TestMiningDistribution, ReadsHistogramFiles) {
+  const std::string filename = "mining_histogram.txt";
+  std::ofstream(filename) << "# minutes weight\n"
+                             "60 90 3   # bin\n"
+                             "\n"
+                             "120 1\n";
+  const auto empirical =
+      MiningDistribution::Parse("empirical:" + filename, 1min, 2min);
+  EXPECT_EQ(empirical.kind(), MiningDistribution::Kind::Empirical);
+  EXPECT_EQ(empirical.min(), 60min);
+  EXPECT_EQ(empirical.max(), 120min);
+  EXPECT_DOUBLE_EQ(empirical.Probabilities().back(), 0.25);
+  EXPECT_EQ(empirical.Describe(), "empirical:" + filename);
+
+  std::ofstream(filename) << "60 90 3 4\n";
+  EXPECT_THROW(MiningDistribution::FromHistogramFile(filename),
+               std::invalid_argument);
+  std::ofstream(filename) << "60 0\n";
+  EXPECT_THROW(MiningDistribution::FromHistogramFile(filename),
+               std::invalid_argument);
+  std::filesystem::remove(filename);
+}
@@ -0,0 +1,153 @@
+#include "parallel_controller.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "controller.h"
+#include "minutes.h"
+
+// Struct to hold simulation parameters for parameterized tests
+struct ParallelParams {
+  size_t num_trucks;
+  size_t num_stations;
+  minutes_t sim_time;
+  size_t num_threads;
+};
+
+std::ostream& operator<<(std::ostream& os, const ParallelParams& p) {
+  os << "{ trucks=" << p.num_trucks << ", stations=" << p.num_stations
+     << ", sim_time=" << p.sim_time.count()
+     << "min, threads=" << p.num_threads << " }";
+  return os;
+}
+
+class TestParallelController_WithParams
+    : public ::testing::TestWithParam<ParallelParams> {};
+
+// Includes runs shorter than an epoch, runs whose station queue grows past
+// the end (stations drop out of the queue) and more threads than trucks
+INSTANTIATE_TEST_SUITE_P(
+    SimulationVariants, TestParallelController_WithParams,
+    ::testing::Values(ParallelParams{1, 1, 24 * 60min, 1},
+                      ParallelParams{30, 10, 1 * 60min, 2},
+                      ParallelParams{3, 2, 10 * 60min, 4},
+                      ParallelParams{150, 50, 30 * 60min, 3},
+                      ParallelParams{300, 5, 72 * 60min, 2},
+                      ParallelParams{600, 10, 30 * 60min, 4},
+                      ParallelParams{1000, 20, 72 * 60min, 3},
+                      ParallelParams{40, 200, 72 * 60min, 2},
+                      ParallelParams{2000, 2, 24 * 60min, 4}));
+
+// Same seed, same results as the sequential engine, column for column
+TEST_P(TestParallelController_WithParams, MatchesSequentialEngine) {
+  const auto& p = GetParam();
+  BasicController<NullEventSink> sequential(p.num_trucks, p.num_stations);
+  ParallelController parallel(p.num_trucks, p.num_stations, 0xBEEF,
+                              p.num_threads);
+  sequential.SetTimeSeriesInterval(60min);
+  parallel.SetTimeSeriesInterval(60min);
+  sequential.Simulate(p.sim_time);
+  parallel.Simulate(p.sim_time);
+
+  const auto& expected_trucks = sequential.metrics().trucks();
+  const auto& trucks = parallel.metrics().trucks();
+  EXPECT_EQ(trucks.mining_time, expected_trucks.mining_time);
+  EXPECT_EQ(trucks.travel_time, expected_trucks.travel_time);
+  EXPECT_EQ(trucks.queueing_time, expected_trucks.queueing_time);
+  EXPECT_EQ(trucks.unloading_time, expected_trucks.unloading_time);
+  EXPECT_EQ(trucks.trips_completed, expected_trucks.trips_completed);
+  EXPECT_EQ(trucks.mines_completed, expected_trucks.mines_completed);
+  EXPECT_EQ(trucks.queues_completed, expected_trucks.queues_completed);
+  EXPECT_EQ(trucks.utilization, expected_trucks.utilization);
+  EXPECT_EQ(trucks.avg_trip_time, expected_trucks.avg_trip_time);
+
+  const auto& expected_stations = sequential.metrics().stations();
+  const auto& stations = parallel.metrics().stations();
+  EXPECT_EQ(stations.unloading_time, expected_stations.unloading_time);
+  EXPECT_EQ(stations.queueing_time, expected_stations.queueing_time);
+  EXPECT_EQ(stations.throughput, expected_stations.throughput);
+  EXPECT_EQ(stations.queues_completed, expected_stations.queues_completed);
+  EXPECT_EQ(stations.avg_queueing_time, expected_stations.avg_queueing_time);
+
+  const TimeSeries& expected_series = sequential.time_series();
+  const TimeSeries& series = parallel.time_series();
+  ASSERT_EQ(series.num_bins(), expected_series.num_bins());
+  for (size_t bin = 0; bin < series.num_bins(); ++bin) {
+    for (const auto state : {TruckState::Mining, TruckState::Traveling,
+                             TruckState::Queueing, TruckState::Unloading}) {
+      EXPECT_EQ(series.TruckMinutes(bin, state),
+                expected_series.TruckMinutes(bin, state));
+    }
+    for (size_t s = 0; s < p.num_stations; ++s) {
+      EXPECT_EQ(series.BusyMinutes(bin, s),
+                expected_series.BusyMinutes(bin, s));
+      EXPECT_EQ(series.QueueMinutes(bin, s),
+                expected_series.QueueMinutes(bin, s));
+    }
+  }
+
+  if constexpr (kStatsEnabled) {
+    EXPECT_EQ(parallel.stats().events_by_type,
+              sequential.stats().events_by_type);
+    EXPECT_EQ(parallel.stats().events_processed,
+              sequential.stats().events_processed);
+    EXPECT_EQ(parallel.stats().random_draws, sequential.stats().random_draws);
+    EXPECT_EQ(parallel.stats().peak_queued_trucks,
+              sequential.stats().peak_queued_trucks);
+  }
+}
+
+// Runs of different lengths on the same controllers
+TEST(TestParallelController, RepeatedRunsMatchSequentialEngine) {
+  BasicController<NullEventSink> sequential(200, 4, 7);
+  ParallelController parallel(200, 4, 7, 3);
+  for (const minutes_t sim_time : {10 * 60min, 25 * 60min}) {
+    sequential.Simulate(sim_time);
+    parallel.Simulate(sim_time);
+    EXPECT_EQ(parallel.metrics().trucks().mining_time,
+              sequential.metrics().trucks().mining_time);
+    EXPECT_EQ(parallel.metrics().stations().throughput,
+              sequential.metrics().stations().throughput);
+  }
+}
+
+// Includes mining as short as an epoch and longer than the timing wheel
+TEST(TestParallelController, OtherMiningDistributionsMatchSequentialEngine) {
+  ParallelController short_mining(10, 2, 0xBEEF, 2);
+  EXPECT_THROW(
+      short_mining.SetMiningDistribution(MiningDistribution::Uniform(
+          ParallelController::kEpoch - 1min, 60min)),
+      std::invalid_argument);
+
+  for (const auto& distribution :
+       {MiningDistribution::Uniform(ParallelController::kEpoch, 40min),
+        MiningDistribution::Triangular(60min, 90min, 300min),
+        MiningDistribution::Lognormal(200.0, 0.8, 30min, 2000min)}) {
+    BasicController<NullEventSink> sequential(300, 6);
+    ParallelController parallel(300, 6, 0xBEEF, 3);
+    sequential.SetMiningDistribution(distribution);
+    parallel.SetMiningDistribution(distribution);
+    sequential.Simulate(72 * 60min);
+    parallel.Simulate(72 * 60min);
+    const auto& trucks = parallel.metrics().trucks();
+    const auto& expected_trucks = sequential.metrics().trucks();
+    EXPECT_EQ(trucks.mining_time, expected_trucks.mining_time)
+        << distribution.Describe();
+    EXPECT_EQ(trucks.queueing_time, expected_trucks.queueing_time)
+        << distribution.Describe();
+    EXPECT_EQ(parallel.metrics().stations().throughput,
+              sequential.metrics().stations().throughput)
+        << distribution.Describe();
+  }
+}
+
+TEST(TestParallelController, NoTrucksOrStations) {
+  ParallelController no_trucks(0, 3, 0xBEEF, 2);
+  no_trucks.Simulate(60min);
+  EXPECT_EQ(no_trucks.metrics().num_trucks(), 0u);
+
+  ParallelController no_stations(5, 0, 0xBEEF, 2);
+  no_stations.Simulate(60min);
+  EXPECT_EQ(no_stations.metrics().num_stations(), 0u);
+}
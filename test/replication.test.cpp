@@ -0,0 +1,114 @@
+#include "replication.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <set>
+
+#include "controller.h"
+#include "event_sink.h"
+
+// Welford mean/variance agree with the textbook formulas
+TEST(TestRunningStat, MeanVarianceAndHalfWidth) {
+  RunningStat stat;
+  EXPECT_TRUE(std::isinf(stat.HalfWidth()));
+  for (double x : {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0}) stat.Add(x);
+
+  EXPECT_EQ(stat.count(), 8u);
+  EXPECT_DOUBLE_EQ(stat.mean(), 5.0);
+  EXPECT_DOUBLE_EQ(stat.variance(), 32.0 / 7.0);
+  // t(0.975, 7) = 2.365
+  EXPECT_NEAR(stat.HalfWidth(), 2.365 * std::sqrt(32.0 / 7.0 / 8.0), 1e-9);
+}
+
+// Seeds are reproducible and distinct across replications
+TEST(TestReplication, SeedsAreDistinctAndStable) {
+  std::set<uint64_t> seeds;
+  for (size_t k = 0; k < 1000; ++k) {
+    seeds.insert(ReplicationSeed(0xBEEF, k));
+  }
+  EXPECT_EQ(seeds.size(), 1000u);
+  EXPECT_EQ(ReplicationSeed(0xBEEF, 7), ReplicationSeed(0xBEEF, 7));
+  EXPECT_NE(ReplicationSeed(0xBEEF, 7), ReplicationSeed(0xBEEF + 1, 7));
+}
+
+// The aggregate does not depend on how many threads ran the replications
+TEST(TestReplication, ResultIndependentOfThreadCount) {
+  ReplicationOptions options;
+  options.num_trucks = 20;
+  options.num_stations = 3;
+  options.sim_time = 24 * 60min;
+  options.max_replications = 12;
+
+  options.num_threads = 1;
+  const ReplicationResult serial = RunReplications(options);
+  options.num_threads = 4;
+  const ReplicationResult parallel = RunReplications(options);
+
+  ASSERT_EQ(serial.replications, 12u);
+  ASSERT_EQ(parallel.replications, 12u);
+  EXPECT_FALSE(serial.converged);
+  EXPECT_EQ(serial.truck_utilization.mean(),
+            parallel.truck_utilization.mean());
+  EXPECT_EQ(serial.station_utilization.variance(),
+            parallel.station_utilization.variance());
+  for (size_t i = 0; i < options.num_trucks; ++i) {
+    EXPECT_EQ(serial.trucks[i].trips_completed.mean(),
+              parallel.trucks[i].trips_completed.mean());
+    EXPECT_EQ(serial.trucks[i].queueing_time.variance(),
+              parallel.trucks[i].queueing_time.variance());
+  }
+}
+
+// Replication k reproduces a standalone run with ReplicationSeed(base, k)
+TEST(TestReplication, SingleReplicationMatchesController) {
+  ReplicationOptions options;
+  options.num_trucks = 10;
+  options.num_stations = 2;
+  options.sim_time = 12 * 60min;
+  options.min_replications = 1;
+  options.max_replications = 1;
+
+  const ReplicationResult result = RunReplications(options);
+  BasicController<NullEventSink> controller(
+      options.num_trucks, options.num_stations,
+      ReplicationSeed(options.base_seed, 0));
+  controller.Simulate(options.sim_time);
+
+  for (size_t i = 0; i < options.num_trucks; ++i) {
+    EXPECT_DOUBLE_EQ(result.trucks[i].utilization.mean(),
+                     controller.truck_metrics()[i].utilization);
+  }
+  for (size_t i = 0; i < options.num_stations; ++i) {
+    EXPECT_DOUBLE_EQ(result.stations[i].throughput.mean(),
+                     controller.station_metrics()[i].throughput);
+  }
+}
+
+// A loose target stops at min_replications; an unreachable one runs them all
+TEST(TestReplication, StopsEarlyOnTargetHalfWidth) {
+  ReplicationOptions options;
+  options.num_trucks = 20;
+  options.num_stations = 3;
+  options.sim_time = 24 * 60min;
+  options.min_replications = 4;
+  options.max_replications = 40;
+  options.num_threads = 3;
+
+  options.target_half_width = 100.0;
+  const ReplicationResult loose = RunReplications(options);
+  EXPECT_TRUE(loose.converged);
+  EXPECT_EQ(loose.replications, 4u);
+
+  options.max_replications = 8;
+  options.target_half_width = 1e-12;
+  const ReplicationResult strict = RunReplications(options);
+  EXPECT_FALSE(strict.converged);
+  EXPECT_EQ(strict.replications, 8u);
+}
+
+TEST(TestReplication, RejectsEmptyFleet) {
+  ReplicationOptions options;
+  options.num_stations = 1;
+  EXPECT_THROW(RunReplications(options), std::invalid_argument);
+}
@@ -0,0 +1,105 @@
+#include "ring_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "event.h"
+
+TEST(TestRingBuffer, CapacityRoundsUpToPowerOfTwo) {
+  SpscRingBuffer<int> ring(100);
+  EXPECT_EQ(ring.capacity(), 128);
+  EXPECT_TRUE(ring.Empty());
+}
+
+TEST(TestRingBuffer, PushFailsWhenFullAndRecoversAfterPop) {
+  SpscRingBuffer<int> ring(4);
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(ring.TryPush(i));
+  EXPECT_FALSE(ring.TryPush(4));
+
+  std::vector<int> out;
+  EXPECT_EQ(ring.PopBatch(&out, 2), 2);
+  EXPECT_EQ(out, (std::vector<int>{0, 1}));
+  EXPECT_TRUE(ring.TryPush(4));
+  EXPECT_TRUE(ring.TryPush(5));
+  EXPECT_EQ(ring.PopBatch(&out, SIZE_MAX), 4);
+  EXPECT_EQ(out, (std::vector<int>{0, 1, 2, 3, 4, 5}));
+}
+
+// A producer blocking on a small ring hands every value over in order
+TEST(TestRingBuffer, ProducerConsumerPreservesOrder) {
+  constexpr int kCount = 10000;
+  SpscRingBuffer<int> ring(64);
+
+  std::thread producer([&ring] {
+    for (int i = 0; i < kCount; ++i) {
+      while (!ring.TryPush(i)) ring.WaitForSpace();
+    }
+  });
+
+  std::vector<int> out;
+  while (out.size() < kCount) ring.PopBatch(&out, 7);
+  producer.join();
+
+  for (int i = 0; i < kCount; ++i) ASSERT_EQ(out[i], i);
+}
+
+namespace {
+
+// Logs count events (truck ids 0 to count - 1) through a tiny ring and
+// returns how many were written; those must keep their order
+size_t LogThroughSmallRing(OverflowPolicy overflow, size_t count,
+                           size_t* dropped) {
+  size_t written = 0;
+  std::optional<size_t> last_truck_id;
+  {
+    EventLogger logger("events.ring.test.json", LogFormat::Binary, 8,
+                       overflow);
+    logger.ClearEvents();
+    for (size_t i = 0; i < count; ++i) {
+      logger.LogEvent({EventType::Mine, i, std::nullopt, minutes_t(i),
+                       minutes_t(i + 1)});
+    }
+    logger.WaitUntilFlushed();
+
+    Event event;
+    while (logger.ReadNextEvent(&event)) {
+      EXPECT_TRUE(!last_truck_id.has_value() ||
+                  event.truck_id > *last_truck_id)
+          << "Events written out of order";
+      EXPECT_LT(event.truck_id, count);
+      last_truck_id = event.truck_id;
+      ++written;
+    }
+    *dropped = logger.dropped_events();
+  }
+  return written;
+}
+
+}  // namespace
+
+TEST(TestEventLoggerOverflow, BlockIsLossless) {
+  size_t dropped = 0;
+  EXPECT_EQ(LogThroughSmallRing(OverflowPolicy::Block, 5000, &dropped), 5000);
+  EXPECT_EQ(dropped, 0);
+}
+
+TEST(TestEventLoggerOverflow, GrowIsLossless) {
+  size_t dropped = 0;
+  EXPECT_EQ(LogThroughSmallRing(OverflowPolicy::Grow, 5000, &dropped), 5000);
+  EXPECT_EQ(dropped, 0);
+}
+
+// Dropped events are counted, and the survivors are not reported as dropped
+// and keep their order
+TEST(TestEventLoggerOverflow, DropCountsDiscardedEvents) {
+  constexpr size_t kCount = 50000;
+  size_t dropped = 0;
+  const size_t written =
+      LogThroughSmallRing(OverflowPolicy::Drop, kCount, &dropped);
+  EXPECT_EQ(written + dropped, kCount);
+  EXPECT_GT(dropped, 0);  // The writer cannot keep up with an 8-slot ring
+  EXPECT_GT(written, 0);
+}
@@ -0,0 +1,199 @@
+#include "scenario.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "checkpoint.h"
+#include "controller.h"
+#include "timing.h"
+
+namespace {
+
+template <EventSink Sink>
+using ScenarioController =
+    BasicController<Sink, TimingWheelScheduler, ScenarioTiming>;
+
+void WriteFile(const std::string& filename, const std::string& contents) {
+  std::ofstream(filename, std::ios::trunc) << contents;
+}
+
+auto Key(const Event& event) {
+  return std::make_tuple(event.end_time, event.truck_id, event.type,
+                         event.start_time, event.station_id);
+}
+
+// 80 trucks of the default timing and 20 slower ones that mine longer, at
+// 4 quick stations and 2 slow ones
+Scenario MixedScenario() {
+  Scenario scenario;
+  scenario.truck_classes = {
+      {"small", 80},
+      {"large", 20, 45min, MiningDistribution::Uniform(400min, 500min)}};
+  scenario.station_groups = {{4}, {2, 8min}};
+  return scenario;
+}
+
+}  // namespace
+
+TEST(TestScenario, ReadsScenarioFile) {
+  const std::string filename = "scenario_test.json";
+  WriteFile(filename, R"({
+    "trucks": [
+      {"class": "small", "count": 3},
+      {"class": "large", "count": 2, "travel_time": 45,
+       "mining": "triangular:150"}
+    ],
+    "stations": [{"count": 1}, {"count": 2, "unload_time": 8}]
+  })");
+  const Scenario scenario = ReadScenario(filename);
+  ASSERT_EQ(scenario.truck_classes.size(), 2);
+  EXPECT_EQ(scenario.truck_classes[0].name, "small");
+  EXPECT_EQ(scenario.truck_classes[0].travel_time, 30min);
+  EXPECT_EQ(scenario.truck_classes[0].mining.Describe(), "uniform:60:300");
+  EXPECT_EQ(scenario.truck_classes[1].travel_time, 45min);
+  EXPECT_EQ(scenario.truck_classes[1].mining.Describe(),
+            "triangular:150:60:300");
+  ASSERT_EQ(scenario.station_groups.size(), 2);
+  EXPECT_EQ(scenario.station_groups[0].unload_time, 5min);
+  EXPECT_EQ(scenario.station_groups[1].unload_time, 8min);
+  EXPECT_EQ(scenario.num_trucks(), 5);
+  EXPECT_EQ(scenario.num_stations(), 3);
+  EXPECT_FALSE(scenario.UsesFixedTiming());
+
+  const ScenarioTiming timing(scenario);
+  EXPECT_EQ(timing.TravelTime(2), 30min);
+  EXPECT_EQ(timing.TravelTime(3), 45min);
+  EXPECT_EQ(timing.UnloadTime(0), 5min);
+  EXPECT_EQ(timing.UnloadTime(2), 8min);
+  EXPECT_EQ(timing.Mining(4)->kind(), MiningDistribution::Kind::Triangular);
+  EXPECT_NO_THROW(timing.Validate(5, 3));
+  EXPECT_THROW(timing.Validate(5, 4), std::invalid_argument);
+
+  WriteFile(filename, R"({"trucks": [{"count": 10}, {"count": 2}],
+                          "stations": [{"count": 2, "unload_time": 5}]})");
+  EXPECT_TRUE(ReadScenario(filename).UsesFixedTiming());
+  std::filesystem::remove(filename);
+}
+
+TEST(TestScenario, RejectsInvalidScenarios) {
+  const std::string filename = "scenario_invalid.json";
+  EXPECT_THROW(ReadScenario("missing.json"), std::invalid_argument);
+  for (const std::string contents :
+       {"not json", R"({"trucks": []})", R"({"trucks": {}, "stations": []})",
+        R"({"trucks": [{"count": -1}], "stations": []})",
+        R"({"trucks": [{"count": 1, "travel_time": 2.5}], "stations": []})",
+        R"({"trucks": [{"count": 1, "mining": "normal"}], "stations": []})",
+        R"({"trucks": [], "stations": [{"count": 1, "unload_time": 0}]})"}) {
+    WriteFile(filename, contents);
+    EXPECT_THROW(ReadScenario(filename), std::invalid_argument) << contents;
+  }
+  std::filesystem::remove(filename);
+}
+
+// A homogeneous fleet on the table-driven timing runs exactly as on the
+// default constant one
+TEST(TestScenario, HomogeneousScenarioMatchesFixedTiming) {
+  Scenario scenario;
+  scenario.truck_classes = {{"a", 60}, {"b", 40}};
+  scenario.station_groups = {{6}};
+  ASSERT_TRUE(scenario.UsesFixedTiming());
+
+  ScenarioController<VectorEventSink> table(100, 6);
+  table.SetTiming(ScenarioTiming(scenario));
+  table.Simulate(72 * 60min);
+  BasicController<VectorEventSink> fixed(100, 6);
+  fixed.Simulate(72 * 60min);
+
+  const auto& events = table.sink().events();
+  const auto& expected = fixed.sink().events();
+  ASSERT_EQ(events.size(), expected.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(Key(events[i]), Key(expected[i])) << "event " << i;
+  }
+}
+
+TEST(TestScenario, AppliesTimingPerTruckClassAndStation) {
+  const Scenario scenario = MixedScenario();
+  ScenarioController<VectorEventSink> controller(100, 6);
+  controller.SetTiming(ScenarioTiming(scenario));
+  controller.Simulate(72 * 60min);
+
+  std::map<size_t, std::vector<std::pair<minutes_t, minutes_t>>> unloads;
+  for (const Event& event : controller.sink().events()) {
+    const bool large = event.truck_id >= 80;
+    const minutes_t duration = event.end_time - event.start_time;
+    switch (event.type) {
+      case EventType::Mine:
+        EXPECT_GE(duration, large ? 400min : 60min);
+        EXPECT_LE(duration, large ? 500min : 300min);
+        break;
+      case EventType::TravelToStation:
+      case EventType::TravelToMine:
+        EXPECT_EQ(duration, large ? 45min : 30min);
+        break;
+      case EventType::Unload:
+        EXPECT_EQ(duration, *event.station_id >= 4 ? 8min : 5min);
+        unloads[*event.station_id].emplace_back(event.start_time,
+                                                event.end_time);
+        break;
+      default:
+        break;
+    }
+  }
+  // Every station is used, one truck at a time
+  ASSERT_EQ(unloads.size(), 6);
+  for (auto& [station_id, spans] : unloads) {
+    std::sort(spans.begin(), spans.end());
+    for (size_t i = 1; i < spans.size(); ++i) {
+      EXPECT_GE(spans[i].first, spans[i - 1].second) << "station "
+                                                     << station_id;
+    }
+  }
+}
+
+TEST(TestScenario, RejectsTimingOfAnotherFleet) {
+  ScenarioController<NullEventSink> controller(99, 6);
+  controller.SetTiming(ScenarioTiming(MixedScenario()));
+  EXPECT_THROW(controller.Simulate(600min), std::invalid_argument);
+}
+
+TEST(TestScenario, CheckpointResumesScenarioRun) {
+  const std::string filename = "scenario_run.ckpt";
+  ScenarioController<NullEventSink> full(100, 6);
+  full.SetTiming(ScenarioTiming(MixedScenario()));
+  full.Simulate(72 * 60min);
+
+  ScenarioController<NullEventSink> first(100, 6);
+  first.SetTiming(ScenarioTiming(MixedScenario()));
+  first.SetCheckpointInterval(1000min, filename);
+  first.Simulate(2500min);
+
+  ScenarioController<NullEventSink> extended(100, 6);
+  extended.SetTiming(ScenarioTiming(MixedScenario()));
+  extended.LoadCheckpoint(filename);
+  extended.Simulate(72 * 60min);
+  const auto& trucks = extended.metrics().trucks();
+  const auto& expected_trucks = full.metrics().trucks();
+  EXPECT_EQ(trucks.mining_time, expected_trucks.mining_time);
+  EXPECT_EQ(trucks.travel_time, expected_trucks.travel_time);
+  EXPECT_EQ(trucks.queueing_time, expected_trucks.queueing_time);
+  EXPECT_EQ(trucks.unloading_time, expected_trucks.unloading_time);
+  EXPECT_EQ(extended.metrics().stations().unloading_time,
+            full.metrics().stations().unloading_time);
+
+  // Same fleet, other timing
+  Scenario slower = MixedScenario();
+  slower.station_groups[1].unload_time = 9min;
+  ScenarioController<NullEventSink> other(100, 6);
+  other.SetTiming(ScenarioTiming(slower));
+  EXPECT_THROW(other.LoadCheckpoint(filename), std::invalid_argument);
+  std::filesystem::remove(filename);
+}
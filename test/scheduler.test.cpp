@@ -0,0 +1,188 @@
+#include "scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "controller.h"
+
+namespace {
+
+PackedEvent MakeEvent(size_t truck_id, minutes_t end_time) {
+  return {EventType::Mine, truck_id, PackedEvent::kNoStation, 0min, end_time};
+}
+
+// Pushes the same events into a scheduler and returns the pop order
+template <EventScheduler Scheduler>
+std::vector<size_t> PopOrder(Scheduler scheduler,
+                             const std::vector<PackedEvent>& events) {
+  for (const auto& event : events) scheduler.Push(event);
+  std::vector<size_t> order;
+  minutes_t last = 0min;
+  while (!scheduler.Empty()) {
+    const auto event = scheduler.Pop();
+    EXPECT_GE(event.end_time(), last);
+    last = event.end_time();
+    order.push_back(event.truck_id());
+  }
+  return order;
+}
+
+}  // namespace
+
+// Events at the same time come out in insertion order
+TEST(TestScheduler, TiesAreFifo) {
+  const std::vector<PackedEvent> events = {MakeEvent(0, 10min), MakeEvent(1, 5min),
+                                     MakeEvent(2, 10min), MakeEvent(3, 5min),
+                                     MakeEvent(4, 10min)};
+  const std::vector<size_t> expected = {1, 3, 0, 2, 4};
+  EXPECT_EQ(PopOrder(BinaryHeapScheduler(), events), expected);
+  EXPECT_EQ(PopOrder(TimingWheelScheduler(16min), events), expected);
+}
+
+// Events beyond the horizon wait in the overflow and keep FIFO order with
+// events pushed for the same minute later on
+TEST(TestScheduler, WheelOverflowKeepsOrder) {
+  TimingWheelScheduler wheel(8min);
+  wheel.Push(MakeEvent(0, 100min));  // Far beyond the horizon
+  wheel.Push(MakeEvent(1, 2min));
+  EXPECT_EQ(wheel.Size(), 2);
+
+  EXPECT_EQ(wheel.Pop().truck_id(), 1);
+  wheel.Push(MakeEvent(2, 95min));  // Still overflow
+  EXPECT_EQ(wheel.Pop().truck_id(), 2);
+  wheel.Push(MakeEvent(3, 100min));  // Within horizon now
+  EXPECT_EQ(wheel.Pop().truck_id(), 0);
+  EXPECT_EQ(wheel.Pop().truck_id(), 3);
+  EXPECT_TRUE(wheel.Empty());
+}
+
+// PopBefore stops at the limit without moving the cursor past it, so events
+// pushed afterwards for times at or after the limit still come out in order
+TEST(TestScheduler, WheelPopBeforeStopsAtLimit) {
+  TimingWheelScheduler wheel(8min);
+  wheel.Push(MakeEvent(0, 3min));
+  wheel.Push(MakeEvent(1, 40min));  // Overflow
+  PackedEvent event;
+  ASSERT_TRUE(wheel.PopBefore(10min, &event));
+  EXPECT_EQ(event.truck_id(), 0);
+  EXPECT_FALSE(wheel.PopBefore(10min, &event));
+
+  wheel.Push(MakeEvent(2, 10min));
+  wheel.Push(MakeEvent(3, 25min));
+  EXPECT_FALSE(wheel.PopBefore(10min, &event));
+  ASSERT_TRUE(wheel.PopBefore(30min, &event));
+  EXPECT_EQ(event.truck_id(), 2);
+  ASSERT_TRUE(wheel.PopBefore(30min, &event));
+  EXPECT_EQ(event.truck_id(), 3);
+  EXPECT_FALSE(wheel.PopBefore(30min, &event));  // Jumps towards overflow
+
+  wheel.Push(MakeEvent(4, 30min));
+  ASSERT_TRUE(wheel.PopBefore(50min, &event));
+  EXPECT_EQ(event.truck_id(), 4);
+  ASSERT_TRUE(wheel.PopBefore(50min, &event));
+  EXPECT_EQ(event.truck_id(), 1);
+  EXPECT_TRUE(wheel.Empty());
+  EXPECT_FALSE(wheel.PopBefore(100min, &event));
+}
+
+// Hold model: every pop schedules a new event a random delay ahead
+TEST(TestScheduler, WheelMatchesHeapUnderRandomLoad) {
+  BinaryHeapScheduler heap;
+  EventArena arena;
+  TimingWheelScheduler wheel(64min, &arena);
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> delay(0, 100);  // Exceeds the horizon
+
+  size_t next_id = 0;
+  for (; next_id < 200; ++next_id) {
+    const auto event = MakeEvent(next_id, minutes_t(delay(rng)));
+    heap.Push(event);
+    wheel.Push(event);
+  }
+  for (int i = 0; i < 20000; ++i) {
+    const auto heap_event = heap.Pop();
+    const auto wheel_event = wheel.Pop();
+    ASSERT_EQ(heap_event.end_time(), wheel_event.end_time());
+    ASSERT_EQ(heap_event.truck_id(), wheel_event.truck_id());
+
+    const auto event =
+        MakeEvent(next_id, heap_event.end_time() + minutes_t(delay(rng)));
+    heap.Push(event);
+    wheel.Push(event);
+    ++next_id;
+  }
+  EXPECT_EQ(heap.Size(), wheel.Size());
+}
+
+// Pending lists the events in pop order, and restores a scheduler when
+// pushed into an empty one
+TEST(TestScheduler, PendingMatchesPopOrder) {
+  BinaryHeapScheduler heap;
+  TimingWheelScheduler wheel(64min);
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> delay(1, 150);  // Exceeds the horizon
+
+  size_t next_id = 0;
+  for (; next_id < 300; ++next_id) {
+    const auto event = MakeEvent(next_id, minutes_t(delay(rng)));
+    heap.Push(event);
+    wheel.Push(event);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    const auto event = MakeEvent(next_id++, heap.Pop().end_time() +
+                                                minutes_t(delay(rng)));
+    wheel.Pop();
+    heap.Push(event);
+    wheel.Push(event);
+  }
+
+  const std::vector<PackedEvent> heap_pending = heap.Pending();
+  const std::vector<PackedEvent> wheel_pending = wheel.Pending();
+  ASSERT_EQ(heap_pending.size(), heap.Size());
+  ASSERT_EQ(wheel_pending.size(), heap.Size());
+  TimingWheelScheduler restored(64min);
+  for (const auto& event : wheel_pending) restored.Push(event);
+  for (size_t i = 0; i < heap_pending.size(); ++i) {
+    const auto event = heap.Pop();
+    EXPECT_EQ(heap_pending[i].truck_id(), event.truck_id());
+    EXPECT_EQ(wheel_pending[i].truck_id(), event.truck_id());
+    EXPECT_EQ(wheel.Pop().truck_id(), event.truck_id());
+    EXPECT_EQ(restored.Pop().truck_id(), event.truck_id());
+  }
+}
+
+TEST(TestScheduler, PackedEventRoundTrip) {
+  const Event with_station{EventType::Unload, 123456, 42, 1000min, 1005min};
+  const Event without_station{EventType::Mine, PackedEvent::kMaxTruckId,
+                              std::nullopt, 60min, 360min};
+  for (const auto& event : {with_station, without_station}) {
+    const Event round_trip = PackedEvent(event).ToEvent();
+    EXPECT_EQ(round_trip.type, event.type);
+    EXPECT_EQ(round_trip.truck_id, event.truck_id);
+    EXPECT_EQ(round_trip.station_id, event.station_id);
+    EXPECT_EQ(round_trip.start_time, event.start_time);
+    EXPECT_EQ(round_trip.end_time, event.end_time);
+  }
+}
+
+// Both schedulers drive the simulation through the same events
+TEST(TestScheduler, ControllerResultsMatchAcrossSchedulers) {
+  EventArena arena;
+  BasicController<VectorEventSink, BinaryHeapScheduler> heap(200, 3);
+  BasicController<VectorEventSink, TimingWheelScheduler> wheel(
+      200, 3, 0xBEEF, VectorEventSink(), &arena);
+  heap.Simulate(72 * 60min);
+  wheel.Simulate(72 * 60min);
+
+  const auto& heap_events = heap.sink().events();
+  const auto& wheel_events = wheel.sink().events();
+  ASSERT_EQ(heap_events.size(), wheel_events.size());
+  for (size_t i = 0; i < heap_events.size(); ++i) {
+    ASSERT_EQ(heap_events[i].type, wheel_events[i].type);
+    ASSERT_EQ(heap_events[i].truck_id, wheel_events[i].truck_id);
+    ASSERT_EQ(heap_events[i].start_time, wheel_events[i].start_time);
+    ASSERT_EQ(heap_events[i].end_time, wheel_events[i].end_time);
+  }
+}
@@ -0,0 +1,192 @@
+#include "shard.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "replication.h"
+#include "sweep.h"
+
+namespace {
+
+ReplicationOptions BatchOptions() {
+  ReplicationOptions options;
+  options.num_trucks = 12;
+  options.num_stations = 2;
+  options.sim_time = 24 * 60min;
+  options.max_replications = 10;
+  options.num_threads = 2;
+  return options;
+}
+
+void ExpectSameStat(const RunningStat& actual, const RunningStat& expected) {
+  EXPECT_EQ(actual.count(), expected.count());
+  EXPECT_NEAR(actual.mean(), expected.mean(), 1e-9);
+  EXPECT_NEAR(actual.variance(), expected.variance(), 1e-9);
+}
+
+}  // namespace
+
+// Shards are 1-based on the command line and deal items out round-robin
+TEST(TestShard, ParseAndDealItems) {
+  const ShardSpec shard = ParseShardSpec("2/3");
+  EXPECT_EQ(shard.index, 1u);
+  EXPECT_EQ(shard.count, 3u);
+  EXPECT_TRUE(shard.sharded());
+  EXPECT_EQ(shard.Suffix(), "2of3");
+  EXPECT_TRUE(shard.Owns(4));
+  EXPECT_FALSE(shard.Owns(5));
+  EXPECT_EQ(shard.NumItems(10), 3u);  // 1, 4, 7
+  EXPECT_EQ(shard.NumItems(1), 0u);
+  EXPECT_FALSE(ShardSpec{}.sharded());
+  EXPECT_EQ(ShardSpec{}.NumItems(10), 10u);
+
+  for (const char* spec : {"0/3", "4/3", "1/0", "3", "1/3x", "a/b", ""}) {
+    EXPECT_THROW(ParseShardSpec(spec), std::invalid_argument) << spec;
+  }
+}
+
+// Merged moments and histograms are those of the values seen in one go
+TEST(TestShard, StatisticsMerge) {
+  const std::vector<double> values = {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+  RunningStat all;
+  RunningStat first;
+  RunningStat second;
+  Histogram histogram(0.0, 10.0, 5);
+  Histogram first_histogram(0.0, 10.0, 5);
+  Histogram second_histogram(0.0, 10.0, 5);
+  for (size_t i = 0; i < values.size(); ++i) {
+    all.Add(values[i]);
+    histogram.Add(values[i]);
+    (i < 3 ? first : second).Add(values[i]);
+    (i < 3 ? first_histogram : second_histogram).Add(values[i]);
+  }
+  first.Merge(second);
+  ExpectSameStat(first, all);
+  first.Merge(RunningStat());
+  ExpectSameStat(first, all);
+  RunningStat empty;
+  empty.Merge(all);
+  ExpectSameStat(empty, all);
+  ExpectSameStat(RunningStat::FromMoments(all.count(), all.mean(), all.m2()),
+                 all);
+
+  first_histogram.Merge(second_histogram);
+  EXPECT_EQ(first_histogram.counts(), histogram.counts());
+  EXPECT_EQ(histogram.counts(), (std::vector<uint64_t>{0, 1, 5, 1, 1}));
+  histogram.Add(-1.0);
+  histogram.Add(10.0);
+  EXPECT_EQ(histogram.counts(), (std::vector<uint64_t>{1, 1, 5, 1, 2}));
+  EXPECT_THROW(histogram.Merge(Histogram(0.0, 10.0, 4)),
+               std::invalid_argument);
+}
+
+// Shards written, read back and merged give the unsharded batch
+TEST(TestShard, ReplicationShardsMergeToBatch) {
+  const ReplicationResult batch = RunReplications(BatchOptions());
+
+  std::vector<ReplicationShard> shards;
+  for (size_t i = 3; i-- > 0;) {  // Out of order
+    ReplicationOptions options = BatchOptions();
+    options.shard = {i, 3};
+    const std::string file =
+        WriteReplicationShard(options, RunReplications(options));
+    EXPECT_NE(file.find(".shard" + options.shard.Suffix() + ".json"),
+              std::string::npos);
+    EXPECT_EQ(ReadShardKind(file), "replications");
+    shards.push_back(ReadReplicationShard(file));
+    std::remove(file.c_str());
+  }
+  EXPECT_EQ(shards[0].result.replications, 3u);  // 3, 6, 9 of 0..9
+
+  ReplicationOptions options;
+  const ReplicationResult merged = MergeReplicationShards(shards, &options);
+  EXPECT_EQ(options.num_trucks, 12u);
+  EXPECT_EQ(options.max_replications, 10u);
+  EXPECT_FALSE(options.shard.sharded());
+  EXPECT_EQ(merged.replications, 10u);
+  ExpectSameStat(merged.truck_utilization, batch.truck_utilization);
+  ExpectSameStat(merged.station_utilization, batch.station_utilization);
+  EXPECT_EQ(merged.truck_utilization_histogram.counts(),
+            batch.truck_utilization_histogram.counts());
+  EXPECT_EQ(merged.station_utilization_histogram.counts(),
+            batch.station_utilization_histogram.counts());
+  for (size_t i = 0; i < options.num_trucks; ++i) {
+    ExpectSameStat(merged.trucks[i].trips_completed,
+                   batch.trucks[i].trips_completed);
+    ExpectSameStat(merged.trucks[i].queueing_time,
+                   batch.trucks[i].queueing_time);
+  }
+  for (size_t i = 0; i < options.num_stations; ++i) {
+    ExpectSameStat(merged.stations[i].throughput,
+                   batch.stations[i].throughput);
+  }
+
+  // Shards of one batch only, each once
+  std::vector<ReplicationShard> repeated = {shards[0], shards[0]};
+  EXPECT_THROW(MergeReplicationShards(repeated, &options),
+               std::invalid_argument);
+  std::vector<ReplicationShard> mixed = {shards[0], shards[1]};
+  mixed[1].options.base_seed += 1;
+  EXPECT_THROW(MergeReplicationShards(mixed, &options),
+               std::invalid_argument);
+  EXPECT_THROW(MergeReplicationShards({}, &options), std::invalid_argument);
+}
+
+// Sharded runs are for a fixed number of replications
+TEST(TestShard, ReplicationShardOptions) {
+  ReplicationOptions options = BatchOptions();
+  options.shard = {0, 2};
+  options.target_half_width = 1.0;
+  EXPECT_THROW(RunReplications(options), std::invalid_argument);
+  options.target_half_width = 0.0;
+  options.max_replications = 2;
+  options.shard = {2, 3};  // No replications left for it
+  EXPECT_THROW(RunReplications(options), std::invalid_argument);
+}
+
+// Sweep shards merge into the table of the whole grid, in grid order
+TEST(TestShard, SweepShardsMergeToGrid) {
+  SweepOptions options;
+  options.trucks = {5, 10, 20};
+  options.stations = {1, 2};
+  options.sim_times = {600min, 1200min};
+  options.num_threads = 2;
+  const std::vector<SweepResult> grid = RunSweep(options);
+
+  const std::string file = "shard.test.sweep.json";
+  std::vector<SweepShard> shards;
+  for (size_t i = 0; i < 5; ++i) {
+    SweepOptions shard_options = options;
+    shard_options.shard = {i, 5};
+    WriteSweepShard(file, shard_options, RunSweep(shard_options));
+    EXPECT_EQ(ReadShardKind(file), "sweep");
+    shards.push_back(ReadSweepShard(file));
+  }
+  std::remove(file.c_str());
+  EXPECT_EQ(shards[0].cells, (std::vector<size_t>{0, 5, 10}));
+
+  SweepOptions merged_options;
+  std::vector<SweepResult> merged = MergeSweepShards(shards, &merged_options);
+  EXPECT_EQ(merged_options.trucks, options.trucks);
+  EXPECT_EQ(merged_options.sim_times, options.sim_times);
+  ASSERT_EQ(merged.size(), grid.size());
+  for (size_t i = 0; i < grid.size(); ++i) {
+    EXPECT_EQ(merged[i].num_trucks, grid[i].num_trucks);
+    EXPECT_EQ(merged[i].num_stations, grid[i].num_stations);
+    EXPECT_EQ(merged[i].sim_minutes, grid[i].sim_minutes);
+    EXPECT_EQ(merged[i].avg_truck_utilization, grid[i].avg_truck_utilization);
+    EXPECT_EQ(merged[i].throughput, grid[i].throughput);
+    EXPECT_EQ(merged[i].avg_queueing_time, grid[i].avg_queueing_time);
+  }
+
+  // A missing shard leaves its cells out; a repeated one is refused
+  shards.erase(shards.begin());
+  EXPECT_EQ(MergeSweepShards(shards, &merged_options).size(), grid.size() - 3);
+  shards.push_back(shards.back());
+  EXPECT_THROW(MergeSweepShards(shards, &merged_options),
+               std::invalid_argument);
+}
@@ -0,0 +1,171 @@
+#include "station_dispatch.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "checkpoint.h"
+#include "controller.h"
+
+namespace {
+
+template <StationDispatcher Dispatch>
+using DispatchController =
+    BasicController<VectorEventSink, TimingWheelScheduler, FixedTiming,
+                    Dispatch>;
+
+// Assigns a truck arriving at time and books the station for unload_time
+template <StationDispatcher Dispatch>
+size_t Book(Dispatch* dispatcher, size_t truck_id, minutes_t time,
+            minutes_t unload_time = 5min) {
+  const auto [available, station_id] = dispatcher->Assign(truck_id, time);
+  dispatcher->MarkAvailable(std::max(time, available) + unload_time,
+                            station_id);
+  return station_id;
+}
+
+// Runs a fleet with dispatcher and checks that no station unloads two
+// trucks at once
+template <StationDispatcher Dispatch>
+void ExpectStationsUnloadOneAtATime(Dispatch dispatcher) {
+  DispatchController<Dispatch> controller(60, 6);
+  controller.SetDispatch(std::move(dispatcher));
+  controller.Simulate(72 * 60min);
+
+  std::map<size_t, std::vector<std::pair<minutes_t, minutes_t>>> unloads;
+  for (const Event& event : controller.sink().events()) {
+    if (event.type == EventType::Unload) {
+      unloads[*event.station_id].emplace_back(event.start_time,
+                                              event.end_time);
+    }
+  }
+  ASSERT_EQ(unloads.size(), 6);
+  for (auto& [station_id, spans] : unloads) {
+    std::sort(spans.begin(), spans.end());
+    for (size_t i = 1; i < spans.size(); ++i) {
+      EXPECT_GE(spans[i].first, spans[i - 1].second) << "station "
+                                                     << station_id;
+    }
+  }
+}
+
+// A run resumed from a checkpoint taken part way through ends as the run
+// that never stopped
+template <StationDispatcher Dispatch>
+void ExpectCheckpointResumes(const Dispatch& dispatcher) {
+  const std::string filename = "dispatch_run.ckpt";
+  DispatchController<Dispatch> full(60, 6);
+  full.SetDispatch(dispatcher);
+  full.Simulate(72 * 60min);
+
+  DispatchController<Dispatch> first(60, 6);
+  first.SetDispatch(dispatcher);
+  first.SetCheckpointInterval(1000min, filename);
+  first.Simulate(2500min);
+
+  DispatchController<Dispatch> extended(60, 6);
+  extended.SetDispatch(dispatcher);
+  extended.LoadCheckpoint(filename);
+  extended.Simulate(72 * 60min);
+  EXPECT_EQ(extended.metrics().stations().unloading_time,
+            full.metrics().stations().unloading_time);
+  EXPECT_EQ(extended.metrics().trucks().queueing_time,
+            full.metrics().trucks().queueing_time);
+
+  // Saved with another dispatcher
+  BasicController<NullEventSink> other(60, 6);
+  EXPECT_THROW(other.LoadCheckpoint(filename), std::invalid_argument);
+  std::filesystem::remove(filename);
+}
+
+}  // namespace
+
+TEST(TestStationDispatch, LeastLoadedEvensOutUnloadMinutes) {
+  LeastLoadedDispatch dispatcher;
+  dispatcher.Initialize(3);
+  EXPECT_EQ(Book(&dispatcher, 0, 0min, 10min), 0);
+  EXPECT_EQ(Book(&dispatcher, 1, 0min, 5min), 1);
+  EXPECT_EQ(Book(&dispatcher, 2, 0min, 5min), 2);
+  // Stations 1 and 2 have 5 minutes each, station 0 has 10
+  EXPECT_EQ(Book(&dispatcher, 3, 1min, 5min), 1);
+  EXPECT_EQ(Book(&dispatcher, 4, 1min, 5min), 2);
+  EXPECT_EQ(Book(&dispatcher, 5, 1min, 5min), 0);
+
+  // Queued behind station 1's bookings (until minute 10)
+  const auto [available, station_id] = dispatcher.Assign(6, 2min);
+  EXPECT_EQ(station_id, 1);
+  EXPECT_EQ(available, 10min);
+}
+
+TEST(TestStationDispatch, RoundRobinTakesStationsInTurn) {
+  RoundRobinDispatch dispatcher;
+  dispatcher.Initialize(3);
+  for (size_t i = 0; i < 7; ++i) {
+    EXPECT_EQ(Book(&dispatcher, i, 0min), i % 3);
+  }
+  const auto [available, station_id] = dispatcher.Assign(7, 0min);
+  EXPECT_EQ(station_id, 1);
+  EXPECT_EQ(available, 10min);  // Booked twice from minute 0
+}
+
+TEST(TestStationDispatch, AffinityKeepsTrucksAtTheirMine) {
+  AffinityDispatch dispatcher(2);
+  dispatcher.Initialize(5);  // Mine 0: stations 0-1, mine 1: stations 2-4
+  EXPECT_EQ(Book(&dispatcher, 0, 0min), 0);
+  EXPECT_EQ(Book(&dispatcher, 2, 0min), 1);
+  EXPECT_EQ(Book(&dispatcher, 4, 0min, 1min), 0);  // Waits for station 0
+  EXPECT_EQ(Book(&dispatcher, 1, 0min), 2);
+  EXPECT_EQ(Book(&dispatcher, 3, 0min), 3);
+  EXPECT_EQ(Book(&dispatcher, 5, 0min), 4);
+  EXPECT_EQ(Book(&dispatcher, 7, 0min, 1min), 2);
+  // Station 0 is free at 6, station 1 at 5
+  EXPECT_EQ(Book(&dispatcher, 6, 0min), 1);
+  EXPECT_EQ(dispatcher.Describe(), "affinity:2");
+
+  AffinityDispatch too_many_mines(6);
+  EXPECT_THROW(too_many_mines.Initialize(5), std::invalid_argument);
+}
+
+// Dispatchers pick up after Restore exactly where Save left them
+template <StationDispatcher Dispatch>
+void ExpectSaveRestoreRoundTrip(Dispatch dispatcher) {
+  dispatcher.Initialize(7);
+  for (size_t i = 0; i < 20; ++i) {
+    Book(&dispatcher, i, minutes_t(i), minutes_t(3 + i % 4));
+  }
+  Dispatch restored = dispatcher;
+  restored.Initialize(7);
+  restored.Restore(dispatcher.Save());
+  for (size_t i = 20; i < 40; ++i) {
+    const auto [available, station_id] = dispatcher.Assign(i, minutes_t(i));
+    EXPECT_EQ(restored.Assign(i, minutes_t(i)),
+              std::make_pair(available, station_id));
+    const minutes_t end = std::max(minutes_t(i), available) + 4min;
+    dispatcher.MarkAvailable(end, station_id);
+    restored.MarkAvailable(end, station_id);
+  }
+}
+
+TEST(TestStationDispatch, SaveRestoreRoundTrip) {
+  ExpectSaveRestoreRoundTrip(LeastLoadedDispatch());
+  ExpectSaveRestoreRoundTrip(RoundRobinDispatch());
+  ExpectSaveRestoreRoundTrip(AffinityDispatch(3));
+}
+
+TEST(TestStationDispatch, StationsUnloadOneAtATime) {
+  ExpectStationsUnloadOneAtATime(LeastLoadedDispatch());
+  ExpectStationsUnloadOneAtATime(RoundRobinDispatch());
+  ExpectStationsUnloadOneAtATime(AffinityDispatch(4));
+}
+
+TEST(TestStationDispatch, CheckpointResumesEachDispatcher) {
+  ExpectCheckpointResumes(LeastLoadedDispatch());
+  ExpectCheckpointResumes(RoundRobinDispatch());
+  ExpectCheckpointResumes(AffinityDispatch(4));
+}
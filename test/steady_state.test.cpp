@@ -0,0 +1,143 @@
+#include "steady_state.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "controller.h"
+#include "event_sink.h"
+
+namespace {
+
+using EventKey = std::tuple<int64_t, int64_t, EventType, size_t, size_t>;
+
+// Events as a sorted list: a staged run emits the events deferred at each
+// stage end later than a single run would, so only the set is the same
+std::vector<EventKey> SortedKeys(const std::vector<Event>& events) {
+  std::vector<EventKey> keys;
+  for (const Event& e : events) {
+    keys.emplace_back(e.start_time.count(), e.end_time.count(), e.type,
+                      e.truck_id, e.station_id.value_or(SIZE_MAX));
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+void ExpectSameMetrics(const MetricsStore& actual,
+                       const MetricsStore& expected) {
+  EXPECT_EQ(actual.trucks().mining_time, expected.trucks().mining_time);
+  EXPECT_EQ(actual.trucks().travel_time, expected.trucks().travel_time);
+  EXPECT_EQ(actual.trucks().queueing_time, expected.trucks().queueing_time);
+  EXPECT_EQ(actual.trucks().utilization, expected.trucks().utilization);
+  EXPECT_EQ(actual.stations().throughput, expected.stations().throughput);
+  EXPECT_EQ(actual.stations().queueing_time,
+            expected.stations().queueing_time);
+  EXPECT_EQ(actual.stations().utilization, expected.stations().utilization);
+}
+
+}  // namespace
+
+// A queue that builds up over the first groups and then holds steady: the
+// warm-up ends where the queue stops growing
+TEST(TestSteadyState, MserCutsTheTransient) {
+  SteadyStateMonitor monitor;
+  monitor.Reset({.interval = 10min, .relative_precision = 0.05}, 3000min, 2);
+  for (int64_t i = 0; i < 300; ++i) {
+    const minutes_t end(i * 10 + 5);
+    const minutes_t wait(i < 50 ? i : 50 + i % 3);  // Grows for 500 minutes
+    monitor.AddUnload(end, 5min, wait);
+    monitor.AddUnload(end, 5min, wait);
+  }
+  EXPECT_TRUE(monitor.Update(3000min));
+  const SteadyStateResult& result = monitor.result();
+  EXPECT_TRUE(result.converged);
+  EXPECT_GE(result.warmup, 450min);
+  EXPECT_LE(result.warmup, 1000min);
+  EXPECT_EQ(result.batches, 20u);
+  EXPECT_EQ(result.end, 3000min);
+  EXPECT_NEAR(result.avg_queueing_time.mean, 51.0, 0.1);
+  EXPECT_LT(result.avg_queueing_time.whole_run, 47.0);
+  // Two stations each busy 5 of every 10 minutes, 12 unloads an hour
+  EXPECT_DOUBLE_EQ(result.station_utilization.mean, 50.0);
+  EXPECT_DOUBLE_EQ(result.station_utilization.whole_run, 50.0);
+  EXPECT_DOUBLE_EQ(result.station_utilization.half_width, 0.0);
+  EXPECT_DOUBLE_EQ(result.throughput.mean, 12.0);
+
+  // Too few intervals for the batches, and no early stop at precision 0
+  EXPECT_FALSE(monitor.Update(900min));
+  EXPECT_EQ(monitor.result().batches, 0u);
+  EXPECT_TRUE(std::isinf(monitor.result().throughput.half_width));
+  monitor.Reset({.interval = 10min, .relative_precision = 0.0}, 3000min, 2);
+  monitor.AddUnload(3000min, 5min, 0min);
+  EXPECT_FALSE(monitor.Update(3000min));
+  EXPECT_EQ(monitor.result().batches, 20u);
+
+  EXPECT_THROW(monitor.Reset({.interval = 10min, .num_batches = 1}, 100min,
+                             2),
+               std::invalid_argument);
+}
+
+// A run that converges stops early, with the metrics, time series and
+// events of a run of that length, and its whole-run values are the
+// metrics' own
+TEST(TestSteadyState, ConvergedRunMatchesShorterRun) {
+  constexpr minutes_t kSimTime = 72 * 60min;
+  BasicController<VectorEventSink> monitored(1000, 30);
+  monitored.SetTimeSeriesInterval(60min);
+  monitored.SetSteadyState({.interval = 12min});
+  monitored.Simulate(kSimTime);
+  const SteadyStateResult& result = monitored.steady_state();
+  ASSERT_TRUE(result.converged);
+  ASSERT_LT(monitored.sim_time(), kSimTime);
+  EXPECT_EQ(result.end, monitored.sim_time());
+  EXPECT_GT(result.warmup, 0min);
+  EXPECT_EQ(monitored.sink().params().sim_time, monitored.sim_time());
+  EXPECT_EQ(monitored.time_series().sim_time(), monitored.sim_time());
+
+  BasicController<VectorEventSink> plain(1000, 30);
+  plain.SetTimeSeriesInterval(60min);
+  plain.Simulate(monitored.sim_time());
+  ExpectSameMetrics(monitored.metrics(), plain.metrics());
+  EXPECT_EQ(monitored.time_series().busy_minutes(),
+            plain.time_series().busy_minutes());
+  EXPECT_EQ(monitored.time_series().truck_minutes(),
+            plain.time_series().truck_minutes());
+  EXPECT_TRUE(SortedKeys(monitored.sink().events()) ==
+              SortedKeys(plain.sink().events()));
+
+  const MetricsStore& metrics = plain.metrics();
+  const auto& stations = metrics.stations();
+  const double unloads = std::accumulate(stations.throughput.begin(),
+                                         stations.throughput.end(), 0.0);
+  const double queueing = std::accumulate(stations.queueing_time.begin(),
+                                          stations.queueing_time.end(), 0.0);
+  EXPECT_NEAR(result.station_utilization.whole_run,
+              metrics.AverageStationUtilization(), 1e-9);
+  EXPECT_NEAR(result.avg_queueing_time.whole_run, queueing / unloads, 1e-9);
+  EXPECT_NEAR(result.throughput.whole_run,
+              unloads * 60.0 / static_cast<double>(result.end.count()),
+              1e-9);
+}
+
+// Without early stopping the run is the plain one, and monitoring does not
+// mix with checkpoints
+TEST(TestSteadyState, MonitoringWithoutStopping) {
+  BasicController<NullEventSink> monitored(200, 5);
+  monitored.SetSteadyState({.interval = 12min, .relative_precision = 0.0});
+  monitored.Simulate(3000min);
+  EXPECT_EQ(monitored.sim_time(), 3000min);
+  EXPECT_FALSE(monitored.steady_state().converged);
+  EXPECT_EQ(monitored.steady_state().end, 3000min);
+
+  BasicController<NullEventSink> plain(200, 5);
+  plain.Simulate(3000min);
+  ExpectSameMetrics(monitored.metrics(), plain.metrics());
+
+  monitored.SetCheckpointInterval(600min, "steady_state.test.bin");
+  EXPECT_THROW(monitored.Simulate(3000min), std::invalid_argument);
+}
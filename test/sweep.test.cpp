@@ -0,0 +1,98 @@
+#include "sweep.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "event_sink.h"
+
+TEST(TestSweep, ParseSweepRange) {
+  EXPECT_EQ(ParseSweepRange("7"), (std::vector<size_t>{7}));
+  EXPECT_EQ(ParseSweepRange("1:4"), (std::vector<size_t>{1, 2, 3, 4}));
+  EXPECT_EQ(ParseSweepRange("10:35:10"), (std::vector<size_t>{10, 20, 30}));
+  EXPECT_EQ(ParseSweepRange("1,5:6,100"), (std::vector<size_t>{1, 5, 6, 100}));
+
+  EXPECT_THROW(ParseSweepRange(""), std::invalid_argument);
+  EXPECT_THROW(ParseSweepRange("5:1"), std::invalid_argument);
+  EXPECT_THROW(ParseSweepRange("1:5:0"), std::invalid_argument);
+  EXPECT_THROW(ParseSweepRange("1:2:3:4"), std::invalid_argument);
+  EXPECT_THROW(ParseSweepRange("ten"), std::invalid_argument);
+  EXPECT_THROW(ParseSweepRange("10x"), std::invalid_argument);
+}
+
+// Cells come back in grid order and match standalone runs
+TEST(TestSweep, CellsMatchStandaloneRuns) {
+  SweepOptions options;
+  options.trucks = {1, 8, 40};
+  options.stations = {1, 3};
+  options.sim_times = {12 * 60min, 24 * 60min};
+  options.num_threads = 3;
+
+  const std::vector<SweepResult> results = RunSweep(options);
+  ASSERT_EQ(results.size(), 12u);
+
+  size_t index = 0;
+  for (size_t trucks : options.trucks) {
+    for (size_t stations : options.stations) {
+      for (minutes_t sim_time : options.sim_times) {
+        const SweepResult& r = results[index++];
+        EXPECT_EQ(r.num_trucks, trucks);
+        EXPECT_EQ(r.num_stations, stations);
+        EXPECT_EQ(r.sim_minutes, sim_time.count());
+
+        BasicController<NullEventSink> controller(trucks, stations,
+                                                  options.random_seed);
+        controller.Simulate(sim_time);
+        uint64_t throughput = 0;
+        double utilization = 0.0;
+        for (const auto& s : controller.station_metrics()) {
+          throughput += s.throughput;
+          utilization += s.utilization;
+        }
+        EXPECT_EQ(r.throughput, throughput);
+        EXPECT_DOUBLE_EQ(r.avg_station_utilization, utilization / stations);
+      }
+    }
+  }
+}
+
+TEST(TestSweep, TablesRoundTrip) {
+  SweepOptions options;
+  options.trucks = {5, 10};
+  options.stations = {2};
+  options.sim_times = {6 * 60min};
+  const std::vector<SweepResult> results = RunSweep(options);
+
+  const std::string bin_path = "test_sweep.bin";
+  WriteSweepBinary(bin_path, results);
+  const std::vector<SweepResult> read = ReadSweepBinary(bin_path);
+  ASSERT_EQ(read.size(), results.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    EXPECT_EQ(read[i].num_trucks, results[i].num_trucks);
+    EXPECT_EQ(read[i].trips_completed, results[i].trips_completed);
+    EXPECT_EQ(read[i].avg_truck_utilization,
+              results[i].avg_truck_utilization);
+  }
+  std::remove(bin_path.c_str());
+
+  const std::string csv_path = "test_sweep.csv";
+  WriteSweepCsv(csv_path, results);
+  std::ifstream csv(csv_path);
+  std::string line;
+  size_t lines = 0;
+  while (std::getline(csv, line)) ++lines;
+  EXPECT_EQ(lines, results.size() + 1);  // Header row
+  std::remove(csv_path.c_str());
+}
+
+TEST(TestSweep, RejectsZeroFleet) {
+  SweepOptions options;
+  options.trucks = {0};
+  options.stations = {1};
+  options.sim_times = {60min};
+  EXPECT_THROW(RunSweep(options), std::invalid_argument);
+}
@@ -0,0 +1,69 @@
+#include "thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Every submitted task runs exactly once before Wait() returns
+TEST(TestWorkStealingPool, RunsEveryTask) {
+  constexpr size_t kCount = 1000;
+  std::vector<std::atomic<int>> runs(kCount);
+  WorkStealingPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4u);
+  for (size_t i = 0; i < kCount; ++i) pool.Submit([&runs, i] { ++runs[i]; });
+  pool.Wait();
+  for (const auto& r : runs) EXPECT_EQ(r.load(), 1);
+}
+
+// Tasks may submit further tasks; Wait() covers those too
+TEST(TestWorkStealingPool, NestedSubmit) {
+  std::atomic<int> count{0};
+  WorkStealingPool pool(3);
+  for (int i = 0; i < 10; ++i) {
+    pool.Submit([&] {
+      for (int j = 0; j < 10; ++j) pool.Submit([&] { ++count; });
+    });
+  }
+  pool.Wait();
+  EXPECT_EQ(count.load(), 100);
+}
+
+// While one worker is stuck on a long task, the tasks dealt to its deque
+// are stolen and run by the others
+TEST(TestWorkStealingPool, IdleWorkersStealQueuedTasks) {
+  WorkStealingPool pool(2);
+  std::atomic<bool> release{false};
+  std::atomic<int> done{0};
+
+  // Round-robin dealing leaves about half of the quick tasks queued behind
+  // the blocking one
+  pool.Submit([&] { release.wait(false); });
+  for (int i = 0; i < 20; ++i) {
+    pool.Submit([&] { ++done; });
+  }
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (done.load() < 20 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(done.load(), 20);
+  release = true;
+  release.notify_all();
+  pool.Wait();
+}
+
+// The first exception thrown by a task surfaces from Wait()
+TEST(TestWorkStealingPool, WaitRethrowsTaskException) {
+  WorkStealingPool pool(2);
+  std::atomic<int> count{0};
+  pool.Submit([] { throw std::runtime_error("boom"); });
+  for (int i = 0; i < 10; ++i) pool.Submit([&] { ++count; });
+  EXPECT_THROW(pool.Wait(), std::runtime_error);
+  EXPECT_EQ(count.load(), 10);
+  pool.Wait();  // The error is reported once
+}
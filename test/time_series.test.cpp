@@ -0,0 +1,76 @@
+#include "time_series.h"
+
+#include <gtest/gtest.h>
+
+#include "controller.h"
+#include "event_sink.h"
+
+// Spans are split at bin boundaries and clipped to the run
+TEST(TestTimeSeries, SpreadsSpansOverBins) {
+  TimeSeries series;
+  series.Reset(15min, 40min, 2);
+  ASSERT_EQ(series.num_bins(), 3u);
+  EXPECT_EQ(series.BinLength(0), 15min);
+  EXPECT_EQ(series.BinLength(2), 10min);
+
+  series.AddTruckSpan(TruckState::Mining, 10min, 50min);
+  EXPECT_EQ(series.TruckMinutes(0, TruckState::Mining), 5);
+  EXPECT_EQ(series.TruckMinutes(1, TruckState::Mining), 15);
+  EXPECT_EQ(series.TruckMinutes(2, TruckState::Mining), 10);
+  EXPECT_EQ(series.TruckMinutes(0, TruckState::Traveling), 0);
+
+  series.AddStationBusy(1, 14min, 19min);
+  series.AddStationQueue(0, 0min, 15min);
+  series.AddStationQueue(0, 5min, 15min);
+  EXPECT_EQ(series.BusyMinutes(0, 1), 1);
+  EXPECT_EQ(series.BusyMinutes(1, 1), 4);
+  EXPECT_EQ(series.BusyMinutes(0, 0), 0);
+  EXPECT_EQ(series.QueueMinutes(0, 0), 25);
+}
+
+TEST(TestTimeSeries, DisabledRecordsNothing) {
+  TimeSeries series;
+  series.Reset(0min, 100min, 3);
+  EXPECT_FALSE(series.enabled());
+  EXPECT_EQ(series.num_bins(), 0u);
+  series.AddTruckSpan(TruckState::Mining, 0min, 50min);  // No-op
+}
+
+// Summed over bins, the series agrees with the whole-run metrics
+TEST(TestTimeSeries, BinsSumToRunTotals) {
+  BasicController<NullEventSink> controller(40, 3);
+  controller.SetTimeSeriesInterval(15min);
+  controller.Simulate(24 * 60min);
+  const TimeSeries& series = controller.time_series();
+  ASSERT_EQ(series.num_bins(), 96u);
+
+  int64_t mining = 0, traveling = 0, queueing = 0, unloading = 0;
+  for (const auto& t : controller.truck_metrics()) {
+    mining += t.mining_time.count();
+    traveling += t.travel_time.count();
+    queueing += t.queueing_time.count();
+    unloading += t.unloading_time.count();
+  }
+
+  int64_t binned[kNumTruckStates] = {};
+  for (size_t b = 0; b < series.num_bins(); ++b) {
+    for (size_t s = 0; s < kNumTruckStates; ++s) {
+      binned[s] += series.TruckMinutes(b, static_cast<TruckState>(s));
+    }
+  }
+  EXPECT_EQ(binned[0], mining);
+  EXPECT_EQ(binned[1], traveling);
+  EXPECT_EQ(binned[2], queueing);
+  EXPECT_EQ(binned[3], unloading);
+
+  for (size_t s = 0; s < series.num_stations(); ++s) {
+    int64_t busy = 0;
+    int64_t queue = 0;
+    for (size_t b = 0; b < series.num_bins(); ++b) {
+      busy += series.BusyMinutes(b, s);
+      queue += series.QueueMinutes(b, s);
+    }
+    EXPECT_EQ(busy, controller.station_metrics()[s].unloading_time.count());
+    EXPECT_EQ(queue, controller.station_metrics()[s].queueing_time.count());
+  }
+}